@@ -1,108 +1,243 @@
 #include "ApiServer.h"
 #include <QJsonParseError>
 #include <QUrlQuery>
+#include <QHttpHeaders>
+#include <QRandomGenerator>
+#include <QPromise>
+#include <QtConcurrent/QtConcurrent>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include "utils/Metrics.h"
+#include "ListStreamWriter.h"
+#include "ResponseStream.h"
+#include "ServiceBridgeBackend.h"
+
+static const int RESPONSE_CACHE_MAX_ENTRIES = 64;
+static const int MAX_BATCH_ITEMS = 100000;
+
+namespace {
+
+// Remembers accepted sockets by peer, so a streamed response can pace itself on
+// its connection's send buffer. Server thread only.
+class ConnectionTrackingServer : public QTcpServer
+{
+public:
+    using QTcpServer::QTcpServer;
+
+    QPointer<QTcpSocket> socketFor(const QHostAddress &address, quint16 port) const
+    {
+        QTcpSocket *socket = m_sockets.value(port);
+        if (socket && socket->peerAddress().isEqual(address, QHostAddress::TolerantConversion)) {
+            return socket;
+        }
+        return nullptr;
+    }
+
+protected:
+    void incomingConnection(qintptr handle) override
+    {
+        QTcpSocket *socket = new QTcpSocket(this);
+        if (!socket->setSocketDescriptor(handle)) {
+            delete socket;
+            return;
+        }
+        quint16 port = socket->peerPort();
+        m_sockets.insert(port, socket);
+        connect(socket, &QObject::destroyed, this, [this, port, socket]() {
+            if (m_sockets.value(port) == socket) {
+                m_sockets.remove(port);
+            }
+        });
+        addPendingConnection(socket);
+    }
+
+private:
+    QHash<quint16, QTcpSocket*> m_sockets;
+};
+
+} // namespace
 
 ApiServer::ApiServer(Database *database, DownloadEngine *downloadEngine, QObject *parent)
     : QObject(parent)
-    , m_tcpServer(new QTcpServer(this))
-    , m_httpServer(new QHttpServer(this))
+    , m_serverThread(new QThread(this))
+    , m_httpServer(new QHttpServer)
+    , m_tcpServer(new ConnectionTrackingServer(m_httpServer))
     , m_database(database)
     , m_downloadEngine(downloadEngine)
+    , m_service(new DownloadService(database, downloadEngine, this))
     , m_cache(new MetadataCache(this))
+    , m_events(new EventStream(downloadEngine, m_service))
+    , m_bridge(new BridgeServer(new ServiceBridgeBackend(m_service, downloadEngine, this), this))
+    , m_etagPrefix(QByteArray::number(QRandomGenerator::global()->generate(), 36))
 {
+    m_serverThread->setObjectName("ApiServer");
+    m_httpServer->moveToThread(m_serverThread);
+    m_events->moveToThread(m_serverThread);
+    connect(m_serverThread, &QThread::finished, m_httpServer, &QObject::deleteLater);
+    connect(m_serverThread, &QThread::finished, m_events, &QObject::deleteLater);
+
+    m_readPool.setMaxThreadCount(READ_POOL_THREADS);
 }
 
 ApiServer::~ApiServer()
 {
     stop();
+    m_serverThread->quit();
+    m_serverThread->wait();
+    m_readPool.waitForDone();
 }
 
 bool ApiServer::start(quint16 port)
 {
+    // Route handlers run on the server thread: reads are handed to the pool,
+    // anything that writes to the owner thread. List endpoints stream from the pool.
+
     // Downloads routes
-    m_httpServer->route("/api/v1/downloads", QHttpServerRequest::Method::Get, [this](const QHttpServerRequest &request) {
-        return handleGetDownloads(request);
+    m_httpServer->route("/api/v1/downloads", QHttpServerRequest::Method::Get,
+                        [this](const QHttpServerRequest &request, QHttpServerResponder &responder) {
+        streamList(request, responder, Database::DownloadsTable, &ApiServer::handleGetDownloads);
     });
     m_httpServer->route("/api/v1/downloads", QHttpServerRequest::Method::Post, [this](const QHttpServerRequest &request) {
-        return handlePostDownloads(request);
+        return runOnOwnerThread([this, request]() { return handlePostDownloads(request); });
+    });
+    m_httpServer->route("/api/v1/downloads:batch", QHttpServerRequest::Method::Post, [this](const QHttpServerRequest &request) {
+        return runOnOwnerThread([this, request]() { return handlePostDownloadsBatch(request); });
     });
     m_httpServer->route("/api/v1/downloads/<arg>", QHttpServerRequest::Method::Get, [this](int id, const QHttpServerRequest &request) {
-        return handleGetDownloadById(request, id);
+        return runOnReadPool([this, request, id]() { return handleGetDownloadById(request, id); });
     });
     m_httpServer->route("/api/v1/downloads/<arg>", QHttpServerRequest::Method::Put, [this](int id, const QHttpServerRequest &request) {
-        return handlePutDownloadById(request, id);
+        return runOnOwnerThread([this, request, id]() { return handlePutDownloadById(request, id); });
     });
     m_httpServer->route("/api/v1/downloads/<arg>", QHttpServerRequest::Method::Delete, [this](int id, const QHttpServerRequest &request) {
-        return handleDeleteDownloadById(request, id);
+        return runOnOwnerThread([this, request, id]() { return handleDeleteDownloadById(request, id); });
     });
     m_httpServer->route("/api/v1/downloads/<arg>/pause", QHttpServerRequest::Method::Post, [this](int id, const QHttpServerRequest &request) {
-        return handlePostDownloadPause(request, id);
+        return runOnOwnerThread([this, request, id]() { return handlePostDownloadPause(request, id); });
     });
     m_httpServer->route("/api/v1/downloads/<arg>/resume", QHttpServerRequest::Method::Post, [this](int id, const QHttpServerRequest &request) {
-        return handlePostDownloadResume(request, id);
+        return runOnOwnerThread([this, request, id]() { return handlePostDownloadResume(request, id); });
     });
 
     // Categories routes
-    m_httpServer->route("/api/v1/categories", QHttpServerRequest::Method::Get, [this](const QHttpServerRequest &request) {
-        return handleGetCategories(request);
+    m_httpServer->route("/api/v1/categories", QHttpServerRequest::Method::Get,
+                        [this](const QHttpServerRequest &request, QHttpServerResponder &responder) {
+        streamList(request, responder, Database::CategoriesTable, &ApiServer::handleGetCategories);
     });
     m_httpServer->route("/api/v1/categories", QHttpServerRequest::Method::Post, [this](const QHttpServerRequest &request) {
-        return handlePostCategories(request);
+        return runOnOwnerThread([this, request]() { return handlePostCategories(request); });
     });
     m_httpServer->route("/api/v1/categories/<arg>", QHttpServerRequest::Method::Get, [this](int id, const QHttpServerRequest &request) {
-        return handleGetCategoryById(request, id);
+        return runOnReadPool([this, request, id]() { return handleGetCategoryById(request, id); });
     });
     m_httpServer->route("/api/v1/categories/<arg>", QHttpServerRequest::Method::Put, [this](int id, const QHttpServerRequest &request) {
-        return handlePutCategoryById(request, id);
+        return runOnOwnerThread([this, request, id]() { return handlePutCategoryById(request, id); });
     });
     m_httpServer->route("/api/v1/categories/<arg>", QHttpServerRequest::Method::Delete, [this](int id, const QHttpServerRequest &request) {
-        return handleDeleteCategoryById(request, id);
+        return runOnOwnerThread([this, request, id]() { return handleDeleteCategoryById(request, id); });
     });
 
     // History routes
-    m_httpServer->route("/api/v1/history", QHttpServerRequest::Method::Get, [this](const QHttpServerRequest &request) {
-        return handleGetHistory(request);
+    m_httpServer->route("/api/v1/history", QHttpServerRequest::Method::Get,
+                        [this](const QHttpServerRequest &request, QHttpServerResponder &responder) {
+        streamList(request, responder, Database::HistoryTable, &ApiServer::handleGetHistory);
     });
 
     // Statistics routes
     m_httpServer->route("/api/v1/statistics", QHttpServerRequest::Method::Get, [this](const QHttpServerRequest &request) {
-        return handleGetStatistics(request);
+        return runOnReadPool([this, request]() { return handleGetStatistics(request); });
     });
 
     // Settings routes
     m_httpServer->route("/api/v1/settings", QHttpServerRequest::Method::Get, [this](const QHttpServerRequest &request) {
-        return handleGetSettings(request);
+        return runOnReadPool([this, request]() { return handleGetSettings(request); });
     });
     m_httpServer->route("/api/v1/settings", QHttpServerRequest::Method::Put, [this](const QHttpServerRequest &request) {
-        return handlePutSettings(request);
+        return runOnOwnerThread([this, request]() { return handlePutSettings(request); });
+    });
+
+    // Live progress: server-sent events, resumable through Last-Event-ID
+    m_httpServer->route("/api/v1/events", QHttpServerRequest::Method::Get,
+                        [this](const QHttpServerRequest &request, QHttpServerResponder &responder) {
+        m_events->subscribe(request, responder);
+    });
+
+    // Metrics route; rendering is cheap and lock-free, so it stays on the server thread
+    m_httpServer->route("/metrics", QHttpServerRequest::Method::Get, [this](const QHttpServerRequest &request) {
+        return handleGetMetrics(request);
     });
 
-    return m_httpServer->bind(m_tcpServer) && m_tcpServer->listen(QHostAddress::Any, port);
+    // The browser bridge is optional; without it the HTTP API still serves
+    m_bridge->listen();
+
+    m_serverThread->start();
+    bool listening = false;
+    QMetaObject::invokeMethod(m_httpServer, [this, port, &listening]() {
+        listening = m_tcpServer->listen(QHostAddress::Any, port) && m_httpServer->bind(m_tcpServer);
+    }, Qt::BlockingQueuedConnection);
+    return listening;
 }
 
 void ApiServer::stop()
 {
-    if (m_tcpServer) {
-        m_tcpServer->close();
+    m_bridge->close();
+    if (m_serverThread->isRunning()) {
+        QMetaObject::invokeMethod(m_httpServer, [this]() {
+            m_tcpServer->close();
+        }, Qt::BlockingQueuedConnection);
     }
 }
 
-QHttpServerResponse ApiServer::handleGetDownloads(const QHttpServerRequest &request)
+QFuture<QHttpServerResponse> ApiServer::runOnReadPool(std::function<QHttpServerResponse()> handler)
+{
+    return QtConcurrent::run(&m_readPool, std::move(handler));
+}
+
+QFuture<QHttpServerResponse> ApiServer::runOnOwnerThread(std::function<QHttpServerResponse()> handler)
+{
+    auto promise = std::make_shared<QPromise<QHttpServerResponse>>();
+    QFuture<QHttpServerResponse> future = promise->future();
+    promise->start();
+    QMetaObject::invokeMethod(this, [promise, handler = std::move(handler)]() {
+        promise->addResult(handler());
+        promise->finish();
+    }, Qt::QueuedConnection);
+    return future;
+}
+
+Database *ApiServer::readDatabase()
+{
+    if (QThread::currentThread() == thread()) {
+        return m_database;
+    }
+
+    // QSqlDatabase connections are bound to the thread that opened them
+    if (!m_readers.hasLocalData()) {
+        static std::atomic<int> readerCount{0};
+        Database *reader = new Database;
+        reader->openReader(m_database->databasePath(), QString("ldm-api-reader-%1").arg(++readerCount));
+        m_readers.setLocalData(reader);
+    }
+    return m_readers.localData();
+}
+
+void ApiServer::handleGetDownloads(const QHttpServerRequest &request, ListStreamWriter &writer)
 {
     QUrlQuery query(request.url());
     QString status = query.queryItemValue("status");
-    QVariantList downloads = m_database->getDownloads(status);
-    
-    QJsonArray jsonArray;
-    for (const QVariant &variant : downloads) {
-        jsonArray.append(downloadToJson(variant.toMap()));
-    }
-    
-    QJsonObject response;
-    response["downloads"] = jsonArray;
-    response["total"] = downloads.size();
-    
-    return createJsonResponse(QJsonDocument(response));
+
+    int total = 0;
+    writer.beginObject();
+    writer.beginArray("downloads");
+    m_service->forEachDownload(status, readDatabase(), [this, &writer, &total](const QVariantMap &download) {
+        writer.writeValue(downloadToJson(download));
+        ++total;
+        return true;
+    });
+    writer.endArray();
+    writer.writeField("total", total);
+    writer.endObject();
 }
 
 QHttpServerResponse ApiServer::handlePostDownloads(const QHttpServerRequest &request)
@@ -114,20 +249,21 @@ QHttpServerResponse ApiServer::handlePostDownloads(const QHttpServerRequest &req
     }
     
     QVariantMap downloadData = jsonToDownload(doc.object());
-    int id = m_database->insertDownload(downloadData);
+    int id = m_service->createDownload(downloadData);
     if (id == -1) {
         return createErrorResponse("Failed to create download", 500);
     }
 
     // Get the created download
-    QVariantMap created = m_database->getDownload(id);
+    QVariantMap created = m_service->download(id);
     
     return createJsonResponse(QJsonDocument(downloadToJson(created)), 201);
 }
 
 QHttpServerResponse ApiServer::handleGetDownloadById(const QHttpServerRequest &request, int id)
 {
-    QVariantMap download = m_database->getDownload(id);
+    // Active downloads are answered from the service's live counters, not the table
+    QVariantMap download = m_service->download(id, readDatabase());
     if (download.isEmpty()) {
         return createErrorResponse("Download not found", 404);
     }
@@ -155,17 +291,17 @@ QHttpServerResponse ApiServer::handlePutDownloadById(const QHttpServerRequest &r
         updateData["category_id"] = json["category_id"].toInt();
     }
     
-    if (!m_database->updateDownload(id, updateData)) {
+    if (!m_service->updateDownload(id, updateData)) {
         return createErrorResponse("Failed to update download", 500);
     }
     
-    QVariantMap updated = m_database->getDownload(id);
+    QVariantMap updated = m_service->download(id);
     return createJsonResponse(QJsonDocument(downloadToJson(updated)));
 }
 
 QHttpServerResponse ApiServer::handleDeleteDownloadById(const QHttpServerRequest &request, int id)
 {
-    if (!m_database->deleteDownload(id)) {
+    if (!m_service->deleteDownload(id)) {
         return createErrorResponse("Failed to delete download", 500);
     }
     
@@ -174,28 +310,173 @@ QHttpServerResponse ApiServer::handleDeleteDownloadById(const QHttpServerRequest
 
 QHttpServerResponse ApiServer::handlePostDownloadPause(const QHttpServerRequest &request, int id)
 {
-    m_downloadEngine->pauseDownload(id);
+    m_service->pauseDownload(id);
     
     return QHttpServerResponse(QHttpServerResponse::StatusCode::Ok);
 }
 
 QHttpServerResponse ApiServer::handlePostDownloadResume(const QHttpServerRequest &request, int id)
 {
-    m_downloadEngine->resumeDownload(id);
+    m_service->resumeDownload(id);
     
     return QHttpServerResponse(QHttpServerResponse::StatusCode::Ok);
 }
 
-QHttpServerResponse ApiServer::handleGetCategories(const QHttpServerRequest &request)
+QHttpServerResponse ApiServer::handlePostDownloadsBatch(const QHttpServerRequest &request)
 {
-    QVariantList categories = m_database->getCategories();
-    
-    QJsonArray jsonArray;
-    for (const QVariant &variant : categories) {
-        jsonArray.append(categoryToJson(variant.toMap()));
+    struct BatchItem {
+        QString op;
+        QJsonObject json;
+        int id = -1;
+        int row = -1;           // index into the rows handed to insertDownloads
+        int status = 200;
+        QString error;
+    };
+
+    // "op" on the query string is the default for items that do not name one
+    QString defaultOp = QUrlQuery(request.url()).queryItemValue("op");
+    if (defaultOp.isEmpty()) {
+        defaultOp = "create";
     }
-    
-    return createJsonResponse(QJsonDocument(jsonArray));
+
+    // NDJSON is parsed line by line, so a large import never exists as one JSON document
+    QList<BatchItem> items;
+    auto addItem = [&](const QJsonValue &value) {
+        BatchItem item;
+        if (!value.isObject()) {
+            item.status = 400;
+            item.error = "Invalid JSON";
+        } else {
+            item.json = value.toObject();
+            item.op = item.json.value("op").toString(defaultOp);
+            item.id = item.json.value("id").toInt(-1);
+            if (item.op != "create" && item.op != "pause" && item.op != "resume" && item.op != "delete") {
+                item.status = 400;
+                item.error = "Unknown op";
+            } else if (item.op == "create" ? item.json.value("url").toString().isEmpty() : item.id <= 0) {
+                item.status = 400;
+                item.error = item.op == "create" ? "Missing url" : "Missing id";
+            }
+        }
+        items.append(item);
+    };
+
+    const QByteArray body = request.body();
+    QByteArray contentType = request.headers().value(QHttpHeaders::WellKnownHeader::ContentType).toByteArray();
+    if (contentType.startsWith("application/x-ndjson") || contentType.startsWith("application/jsonl")) {
+        for (qsizetype start = 0; start < body.size() && items.size() <= MAX_BATCH_ITEMS;) {
+            qsizetype end = body.indexOf('\n', start);
+            if (end < 0) {
+                end = body.size();
+            }
+            QByteArray line = body.mid(start, end - start).trimmed();
+            start = end + 1;
+            if (!line.isEmpty()) {
+                QJsonDocument doc = QJsonDocument::fromJson(line);
+                addItem(doc.isObject() ? QJsonValue(doc.object()) : QJsonValue());
+            }
+        }
+    } else {
+        QJsonParseError error;
+        QJsonDocument doc = QJsonDocument::fromJson(body, &error);
+        if (error.error != QJsonParseError::NoError || !doc.isArray()) {
+            return createErrorResponse("Expected a JSON array or NDJSON", 400);
+        }
+        const QJsonArray array = doc.array();
+        if (array.size() > MAX_BATCH_ITEMS) {
+            return createErrorResponse(QString("Batch exceeds %1 items").arg(MAX_BATCH_ITEMS), 413);
+        }
+        for (const QJsonValue &value : array) {
+            addItem(value);
+        }
+    }
+
+    if (items.isEmpty()) {
+        return createErrorResponse("Empty batch", 400);
+    }
+    if (items.size() > MAX_BATCH_ITEMS) {
+        return createErrorResponse(QString("Batch exceeds %1 items").arg(MAX_BATCH_ITEMS), 413);
+    }
+
+    // Database work shares one transaction: all creates go through one prepared statement,
+    // and the service hands them to the queue in one pass once the batch commits
+    if (!m_service->beginBatch()) {
+        return createErrorResponse("Failed to start transaction", 500);
+    }
+
+    QVariantList createRows;
+    for (BatchItem &item : items) {
+        if (item.status != 200) {
+            continue;
+        }
+        if (item.op == "create") {
+            item.row = createRows.size();
+            createRows.append(jsonToDownload(item.json));
+        } else if (item.op == "delete" && !m_service->deleteDownload(item.id)) {
+            item.status = 500;
+            item.error = "Failed to delete download";
+        } else if (item.op == "pause" && !m_service->pauseDownload(item.id)) {
+            item.status = 409;
+            item.error = "Download is not active";
+        } else if (item.op == "resume" && !m_service->resumeDownload(item.id)) {
+            item.status = 409;
+            item.error = "Download cannot be resumed";
+        }
+    }
+
+    QList<int> createdIds = m_service->createDownloads(createRows);
+    for (BatchItem &item : items) {
+        if (item.row < 0) {
+            continue;
+        }
+        item.id = createdIds.at(item.row);
+        item.status = item.id > 0 ? 201 : 500;
+        if (item.id <= 0) {
+            item.error = "Failed to create download";
+        }
+    }
+
+    if (!m_service->commitBatch()) {
+        for (BatchItem &item : items) {
+            if (item.status < 400 && (item.op == "create" || item.op == "delete")) {
+                item.status = 500;
+                item.error = "Transaction failed";
+            }
+        }
+    }
+
+    QJsonArray results;
+    int failed = 0;
+    for (int i = 0; i < items.size(); ++i) {
+        const BatchItem &item = items.at(i);
+        QJsonObject result;
+        result["index"] = i;
+        result["status"] = item.status;
+        if (item.id > 0) {
+            result["id"] = item.id;
+        }
+        if (!item.error.isEmpty()) {
+            result["error"] = item.error;
+            ++failed;
+        }
+        results.append(result);
+    }
+
+    QJsonObject response;
+    response["results"] = results;
+    response["succeeded"] = int(items.size()) - failed;
+    response["failed"] = failed;
+    return createJsonResponse(QJsonDocument(response));
+}
+
+void ApiServer::handleGetCategories(const QHttpServerRequest &request, ListStreamWriter &writer)
+{
+    Q_UNUSED(request)
+    writer.beginArray();
+    for (const QVariant &variant : readDatabase()->getCategories()) {
+        writer.writeValue(categoryToJson(variant.toMap()));
+    }
+    writer.endArray();
 }
 
 QHttpServerResponse ApiServer::handlePostCategories(const QHttpServerRequest &request)
@@ -220,7 +501,7 @@ QHttpServerResponse ApiServer::handlePostCategories(const QHttpServerRequest &re
 
 QHttpServerResponse ApiServer::handleGetCategoryById(const QHttpServerRequest &request, int id)
 {
-    QVariantMap category = m_database->getCategory(id);
+    QVariantMap category = readDatabase()->getCategory(id);
     if (category.isEmpty()) {
         return createErrorResponse("Category not found", 404);
     }
@@ -265,24 +546,41 @@ QHttpServerResponse ApiServer::handleDeleteCategoryById(const QHttpServerRequest
     return QHttpServerResponse(QHttpServerResponse::StatusCode::NoContent);
 }
 
-QHttpServerResponse ApiServer::handleGetHistory(const QHttpServerRequest &request)
+void ApiServer::handleGetHistory(const QHttpServerRequest &request, ListStreamWriter &writer)
 {
     QUrlQuery query(request.url());
     int limit = query.queryItemValue("limit").isEmpty() ? 100 : query.queryItemValue("limit").toInt();
     int offset = query.queryItemValue("offset").isEmpty() ? 0 : query.queryItemValue("offset").toInt();
-    
-    QVariantList history = m_database->getDownloadHistory(limit, offset);
-    
-    QJsonArray jsonArray;
-    for (const QVariant &variant : history) {
-        jsonArray.append(historyToJson(variant.toMap()));
+
+    int total = 0;
+    QVariantMap last;
+    auto visit = [this, &writer, &total, &last](const QVariantMap &history) {
+        writer.writeValue(historyToJson(history));
+        ++total;
+        last = history;
+        return true;
+    };
+
+    writer.beginObject();
+    writer.beginArray("history");
+    // "before"/"before_id" select keyset paging, which stays fast however deep the client pages
+    if (query.hasQueryItem("before")) {
+        // Without before_id the cursor covers every row at that timestamp, not id 0
+        qint64 beforeId = query.hasQueryItem("before_id") ? query.queryItemValue("before_id").toLongLong()
+                                                           : std::numeric_limits<qint64>::max();
+        readDatabase()->forEachDownloadHistoryPage(query.queryItemValue("before"), beforeId, limit, visit);
+    } else {
+        readDatabase()->forEachDownloadHistory(limit, offset, visit);
     }
-    
-    QJsonObject response;
-    response["history"] = jsonArray;
-    response["total"] = history.size();
-    
-    return createJsonResponse(QJsonDocument(response));
+    writer.endArray();
+    writer.writeField("total", total);
+    if (total > 0) {
+        QJsonObject cursor;
+        cursor["before"] = last["completed_at"].toString();
+        cursor["before_id"] = last["id"].toLongLong();
+        writer.writeField("next_cursor", cursor);
+    }
+    writer.endObject();
 }
 
 QHttpServerResponse ApiServer::handleGetStatistics(const QHttpServerRequest &request)
@@ -290,8 +588,9 @@ QHttpServerResponse ApiServer::handleGetStatistics(const QHttpServerRequest &req
     QString cacheKey = "statistics";
     
     // Check cache first
-    if (m_cache->contains(cacheKey)) {
-        QVariantMap cachedStats = m_cache->retrieve(cacheKey);
+    // One lookup: the entry may be evicted between a contains() and a retrieve()
+    QVariantMap cachedStats = m_cache->retrieve(cacheKey);
+    if (!cachedStats.isEmpty()) {
         QJsonObject stats;
         for (auto it = cachedStats.begin(); it != cachedStats.end(); ++it) {
             stats[it.key()] = QJsonValue::fromVariant(it.value());
@@ -299,9 +598,9 @@ QHttpServerResponse ApiServer::handleGetStatistics(const QHttpServerRequest &req
         return createJsonResponse(QJsonDocument(stats));
     }
     
-    // Compute statistics
-    QVariantList downloads = m_database->getDownloads();
-    QVariantList history = m_database->getDownloadHistory(1000, 0);
+    // Compute statistics from the live view, so active downloads report current speed
+    QVariantList downloads = m_service->downloads(QString(), readDatabase());
+    QVariantList history = readDatabase()->getDownloadHistory(1000, 0);
     
     int totalDownloads = downloads.size();
     qint64 totalSize = 0;
@@ -353,7 +652,7 @@ QHttpServerResponse ApiServer::handleGetSettings(const QHttpServerRequest &reque
     QUrlQuery query(request.url());
     QString category = query.queryItemValue("category");
     
-    QVariantList settings = m_database->getSettings(category);
+    QVariantList settings = readDatabase()->getSettings(category);
     
     QJsonObject jsonSettings;
     for (const QVariant &variant : settings) {
@@ -380,6 +679,13 @@ QHttpServerResponse ApiServer::handlePutSettings(const QHttpServerRequest &reque
     return QHttpServerResponse(QHttpServerResponse::StatusCode::Ok);
 }
 
+QHttpServerResponse ApiServer::handleGetMetrics(const QHttpServerRequest &request)
+{
+    static Metrics::Counter *scrapes = Metrics::instance().counter("ldm_metrics_scrapes_total", "Requests to /metrics");
+    scrapes->increment();
+    return QHttpServerResponse("text/plain; version=0.0.4; charset=utf-8", Metrics::instance().prometheusText());
+}
+
 QJsonObject ApiServer::downloadToJson(const QVariantMap &download)
 {
     QJsonObject obj;
@@ -450,7 +756,9 @@ QVariantMap ApiServer::jsonToCategory(const QJsonObject &json)
 
 QHttpServerResponse ApiServer::createJsonResponse(const QJsonDocument &doc, int status)
 {
-    return QHttpServerResponse("application/json", doc.toJson(), QHttpServerResponse::StatusCode(status));
+    QByteArray body = doc.toJson();
+    recordResponse(status, body.size());
+    return QHttpServerResponse("application/json", body, QHttpServerResponse::StatusCode(status));
 }
 
 QHttpServerResponse ApiServer::createErrorResponse(const QString &message, int status)
@@ -459,5 +767,151 @@ QHttpServerResponse ApiServer::createErrorResponse(const QString &message, int s
     error["error"] = message;
     QJsonObject errorObj;
     errorObj["error"] = message;
-    return QHttpServerResponse("application/json", QJsonDocument(errorObj).toJson(), QHttpServerResponse::StatusCode(status));
+    QByteArray body = QJsonDocument(errorObj).toJson();
+    recordResponse(status, body.size());
+    return QHttpServerResponse("application/json", body, QHttpServerResponse::StatusCode(status));
+}
+
+void ApiServer::streamList(const QHttpServerRequest &request, QHttpServerResponder &responder,
+                           Database::Table table, ListWriter write)
+{
+    // The responder is only ever touched on the server thread; the pool posts writes to it
+    auto shared = std::make_shared<QHttpServerResponder>(std::move(responder));
+    QPointer<QTcpSocket> socket = static_cast<ConnectionTrackingServer *>(m_tcpServer)
+                                      ->socketFor(request.remoteAddress(), request.remotePort());
+    m_readPool.start([this, request, shared, socket, table, write]() mutable {
+        sendList(request, std::move(shared), std::move(socket), table, write);
+    });
+}
+
+void ApiServer::sendList(const QHttpServerRequest &request, std::shared_ptr<QHttpServerResponder> responder,
+                         QPointer<QTcpSocket> socket, Database::Table table, ListWriter write)
+{
+    static Metrics::Counter *notModified = Metrics::instance().counter(
+        "ldm_api_cache_total", "Cacheable API list requests by outcome", Metrics::label("result", "not_modified"));
+    static Metrics::Counter *hits = Metrics::instance().counter(
+        "ldm_api_cache_total", "Cacheable API list requests by outcome", Metrics::label("result", "hit"));
+    static Metrics::Counter *misses = Metrics::instance().counter(
+        "ldm_api_cache_total", "Cacheable API list requests by outcome", Metrics::label("result", "miss"));
+
+    // The version is read before building, so a write landing mid-build leaves the
+    // entry behind the counter and the next request rebuilds rather than serving stale bytes.
+    // Live progress changes the downloads list without touching the table, so it counts too.
+    quint64 version = m_database->changeCounter(table);
+    if (table == Database::DownloadsTable) {
+        version += m_service->liveGeneration();
+    }
+    QByteArray etag = "W/\"" + m_etagPrefix + '-' + QByteArray::number(int(table)) + '-'
+                      + QByteArray::number(version) + '"';
+
+    QHttpHeaders headers;
+    headers.append(QHttpHeaders::WellKnownHeader::ETag, etag);
+    if (etagMatches(request.headers().value(QHttpHeaders::WellKnownHeader::IfNoneMatch).toByteArray(), etag)) {
+        notModified->increment();
+        recordResponse(304, 0);
+        ResponseStream::send(std::move(responder), m_httpServer, headers, QByteArray(), 304);
+        return;
+    }
+
+    ListStreamWriter::Format format = ListStreamWriter::Json;
+    if (acceptsToken(request.headers().value(QHttpHeaders::WellKnownHeader::Accept).toByteArray(), "application/cbor")) {
+        format = ListStreamWriter::Cbor;
+    }
+    bool gzip = acceptsToken(request.headers().value(QHttpHeaders::WellKnownHeader::AcceptEncoding).toByteArray(), "gzip");
+
+    headers.append(QHttpHeaders::WellKnownHeader::ContentType, ListStreamWriter::contentType(format));
+    if (gzip) {
+        headers.append(QHttpHeaders::WellKnownHeader::ContentEncoding, "gzip");
+    }
+    headers.append(QHttpHeaders::WellKnownHeader::Vary, "Accept, Accept-Encoding");
+    // Clients may keep the body but must revalidate; a 304 costs no query or serialization
+    headers.append(QHttpHeaders::WellKnownHeader::CacheControl, "no-cache");
+
+    // Entries hold the encoded bytes, so each representation is cached separately
+    QString key = request.url().path() + '?' + request.url().query(QUrl::FullyEncoded) + ' '
+                  + QString::fromLatin1(ListStreamWriter::contentType(format)) + (gzip ? " gzip" : "");
+    QByteArray body;
+    {
+        QMutexLocker locker(&m_responseCacheMutex);
+        auto cached = m_responseCache.constFind(key);
+        if (cached != m_responseCache.constEnd() && cached->version == version) {
+            body = cached->body;
+        }
+    }
+    if (!body.isNull()) {
+        hits->increment();
+        recordResponse(200, body.size());
+        ResponseStream::send(std::move(responder), m_httpServer, headers, body);
+        return;
+    }
+
+    // Rows go out as they come off the cursor; only bodies small enough to be sent
+    // whole come back from finish() to be cached. Two threads missing together both build.
+    misses->increment();
+    ResponseStream stream(std::move(responder), m_httpServer, std::move(socket), headers, gzip);
+    ListStreamWriter writer(&stream, format);
+    (this->*write)(request, writer);
+    body = stream.finish();
+    recordResponse(200, stream.bytesSent());
+    if (body.isNull()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_responseCacheMutex);
+    // Paged history queries make the key space open-ended; start over rather than track recency
+    if (!m_responseCache.contains(key) && m_responseCache.size() >= RESPONSE_CACHE_MAX_ENTRIES) {
+        m_responseCache.clear();
+    }
+    auto cached = m_responseCache.constFind(key);
+    if (cached == m_responseCache.constEnd() || cached->version < version) {
+        m_responseCache.insert(key, CachedResponse{version, etag, body});
+    }
+}
+
+bool ApiServer::acceptsToken(const QByteArray &header, const QByteArray &token)
+{
+    // Parameters other than an explicit q=0 do not matter here
+    for (const QByteArray &item : header.split(',')) {
+        QList<QByteArray> parts = item.split(';');
+        if (parts.first().trimmed().compare(token, Qt::CaseInsensitive) != 0) {
+            continue;
+        }
+        for (int i = 1; i < parts.size(); ++i) {
+            QByteArray parameter = parts.at(i).trimmed();
+            if (parameter.startsWith("q=") && parameter.mid(2).toDouble() == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+bool ApiServer::etagMatches(const QByteArray &ifNoneMatch, const QByteArray &etag)
+{
+    // If-None-Match uses the weak comparison, so W/ prefixes are ignored on both sides
+    auto opaque = [](const QByteArray &tag) { return tag.startsWith("W/") ? tag.mid(2) : tag; };
+    QByteArray wanted = opaque(etag);
+    for (const QByteArray &candidate : ifNoneMatch.split(',')) {
+        QByteArray tag = candidate.trimmed();
+        if (tag == "*" || opaque(tag) == wanted) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ApiServer::recordResponse(int status, qint64 bytes)
+{
+    static Metrics::Counter *sentBytes = Metrics::instance().counter("ldm_api_sent_bytes_total", "API response body bytes");
+    // One counter per status class keeps the label set small
+    static Metrics::Counter *byClass[] = {
+        Metrics::instance().counter("ldm_api_responses_total", "API responses by status class", Metrics::label("code", "2xx")),
+        Metrics::instance().counter("ldm_api_responses_total", "API responses by status class", Metrics::label("code", "3xx")),
+        Metrics::instance().counter("ldm_api_responses_total", "API responses by status class", Metrics::label("code", "4xx")),
+        Metrics::instance().counter("ldm_api_responses_total", "API responses by status class", Metrics::label("code", "5xx")),
+    };
+
+    byClass[qBound(2, status / 100, 5) - 2]->increment();
+    sentBytes->increment(quint64(bytes));
 }
\ No newline at end of file
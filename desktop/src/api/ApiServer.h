@@ -4,14 +4,35 @@
 #include <QObject>
 #include <QHttpServer>
 #include <QTcpServer>
+#include <QTcpSocket>
+#include <QPointer>
 #include <QHttpServerResponse>
+#include <QHttpServerResponder>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QHash>
+#include <QFuture>
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <functional>
+#include <memory>
 #include "core/Database.h"
 #include "core/DownloadEngine.h"
+#include "core/DownloadService.h"
 #include "utils/MetadataCache.h"
+#include "BridgeServer.h"
+#include "EventStream.h"
+#include "ListStreamWriter.h"
 
+// The HTTP server, its sockets and the event streams run on a dedicated
+// thread, so a slow request never delays engine signal delivery. Read-only
+// handlers run on a small pool, each thread with its own read-only database
+// connection and the service's lock-protected live state. Handlers that
+// change anything hop to the thread that owns the engine and the service,
+// where the native messaging bridge also runs.
 class ApiServer : public QObject
 {
     Q_OBJECT
@@ -23,26 +44,27 @@ public:
     bool start(quint16 port = 8080);
     void stop();
 
+    EventStream *eventStream() const { return m_events; }
+    DownloadService *downloadService() const { return m_service; }
+    BridgeServer *bridgeServer() const { return m_bridge; }
+
 private slots:
     // Downloads endpoints
-    QHttpServerResponse handleGetDownloads(const QHttpServerRequest &request);
     QHttpServerResponse handlePostDownloads(const QHttpServerRequest &request);
     QHttpServerResponse handleGetDownloadById(const QHttpServerRequest &request, int id);
     QHttpServerResponse handlePutDownloadById(const QHttpServerRequest &request, int id);
     QHttpServerResponse handleDeleteDownloadById(const QHttpServerRequest &request, int id);
     QHttpServerResponse handlePostDownloadPause(const QHttpServerRequest &request, int id);
     QHttpServerResponse handlePostDownloadResume(const QHttpServerRequest &request, int id);
+    // JSON array or NDJSON of {"op": create|pause|resume|delete, ...}; one transaction, per-item results
+    QHttpServerResponse handlePostDownloadsBatch(const QHttpServerRequest &request);
 
     // Categories endpoints
-    QHttpServerResponse handleGetCategories(const QHttpServerRequest &request);
     QHttpServerResponse handlePostCategories(const QHttpServerRequest &request);
     QHttpServerResponse handleGetCategoryById(const QHttpServerRequest &request, int id);
     QHttpServerResponse handlePutCategoryById(const QHttpServerRequest &request, int id);
     QHttpServerResponse handleDeleteCategoryById(const QHttpServerRequest &request, int id);
 
-    // History endpoints
-    QHttpServerResponse handleGetHistory(const QHttpServerRequest &request);
-
     // Statistics endpoints
     QHttpServerResponse handleGetStatistics(const QHttpServerRequest &request);
 
@@ -50,12 +72,42 @@ private slots:
     QHttpServerResponse handleGetSettings(const QHttpServerRequest &request);
     QHttpServerResponse handlePutSettings(const QHttpServerRequest &request);
 
+    // Prometheus scrape endpoint
+    QHttpServerResponse handleGetMetrics(const QHttpServerRequest &request);
+
 private:
-    QTcpServer *m_tcpServer;
-    QHttpServer *m_httpServer;
-    Database *m_database;
+    // List endpoints write rows as they are read; see streamList()
+    using ListWriter = void (ApiServer::*)(const QHttpServerRequest &request, ListStreamWriter &writer);
+    void handleGetDownloads(const QHttpServerRequest &request, ListStreamWriter &writer);
+    void handleGetCategories(const QHttpServerRequest &request, ListStreamWriter &writer);
+    void handleGetHistory(const QHttpServerRequest &request, ListStreamWriter &writer);
+
+    QThread *m_serverThread;
+    QHttpServer *m_httpServer;              // lives on m_serverThread
+    QTcpServer *m_tcpServer;                // child of m_httpServer, tracks accepted sockets
+    Database *m_database;                   // write connection, owner thread only
     DownloadEngine *m_downloadEngine;
+    DownloadService *m_service;             // all download reads and commands
     MetadataCache *m_cache;
+    EventStream *m_events;                  // lives on m_serverThread
+    BridgeServer *m_bridge;                 // native messaging host endpoint, owner thread
+    QThreadStorage<Database*> m_readers;    // one read-only connection per pool thread
+    QThreadPool m_readPool;
+
+    // Encoded list responses keyed by path, query and representation, valid
+    // while the table's change counter still equals the version they were built at
+    struct CachedResponse {
+        quint64 version = 0;
+        QByteArray etag;
+        QByteArray body;
+    };
+    QHash<QString, CachedResponse> m_responseCache;
+    QMutex m_responseCacheMutex;
+    QByteArray m_etagPrefix;   // per instance, so tags from a previous run never match
+
+    QFuture<QHttpServerResponse> runOnReadPool(std::function<QHttpServerResponse()> handler);
+    QFuture<QHttpServerResponse> runOnOwnerThread(std::function<QHttpServerResponse()> handler);
+    Database *readDatabase();               // the calling thread's connection
 
     QJsonObject downloadToJson(const QVariantMap &download);
     QJsonObject categoryToJson(const QVariantMap &category);
@@ -64,6 +116,18 @@ private:
     QVariantMap jsonToCategory(const QJsonObject &json);
     QHttpServerResponse createJsonResponse(const QJsonDocument &doc, int status = 200);
     QHttpServerResponse createErrorResponse(const QString &message, int status = 400);
+    // Serves a list from the read pool: 304 when If-None-Match carries the current
+    // tag, cached bytes when the table is unchanged, otherwise write() streams the
+    // rows as JSON or CBOR (Accept), gzipped when Accept-Encoding allows it
+    void streamList(const QHttpServerRequest &request, QHttpServerResponder &responder,
+                    Database::Table table, ListWriter write);
+    void sendList(const QHttpServerRequest &request, std::shared_ptr<QHttpServerResponder> responder,
+                  QPointer<QTcpSocket> socket, Database::Table table, ListWriter write);
+    static bool acceptsToken(const QByteArray &header, const QByteArray &token);
+    static bool etagMatches(const QByteArray &ifNoneMatch, const QByteArray &etag);
+    static void recordResponse(int status, qint64 bytes);
+
+    static const int READ_POOL_THREADS = 4;
 };
 
 #endif // APISERVER_H
\ No newline at end of file
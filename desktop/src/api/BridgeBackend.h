@@ -0,0 +1,32 @@
+#ifndef BRIDGEBACKEND_H
+#define BRIDGEBACKEND_H
+
+#include <QObject>
+#include <QList>
+#include <QVariantList>
+#include <QVariantMap>
+
+// What BridgeServer needs from the application that owns the downloads.
+// ldm-cli and the API server adapt DownloadService (ServiceBridgeBackend);
+// the GUI adapts its own engine so captured downloads appear in the window.
+class BridgeBackend : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BridgeBackend(QObject *parent = nullptr) : QObject(parent) {}
+
+    // Rows carry url, filename, referrer and user_agent; one id per row, -1 where it failed
+    virtual QList<int> createDownloads(const QVariantList &rows) = 0;
+    virtual bool cancelDownload(int downloadId) = 0;
+    // filename, status, downloaded_size and total_size; empty when unknown
+    virtual QVariantMap download(int downloadId) const = 0;
+
+signals:
+    // Expected to be coalesced by the backend, not emitted per network read
+    void downloadProgressChanged(int downloadId, qint64 downloaded, qint64 total, qint64 speed);
+    void downloadCompleted(int downloadId);
+    void downloadFailed(int downloadId, const QString &error);
+};
+
+#endif // BRIDGEBACKEND_H
\ No newline at end of file
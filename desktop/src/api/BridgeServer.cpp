@@ -0,0 +1,286 @@
+#include "BridgeServer.h"
+#include "BridgeBackend.h"
+#include "MessageParser.h"
+#include <QDir>
+#include <QJsonArray>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStandardPaths>
+#include <QDebug>
+
+BridgeServer::BridgeServer(BridgeBackend *backend, QObject *parent)
+    : QObject(parent)
+    , m_server(new QLocalServer(this))
+    , m_backend(backend)
+{
+    // Only the user running LDM may hand it downloads
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &BridgeServer::onNewConnection);
+
+    connect(m_backend, &BridgeBackend::downloadProgressChanged, this, &BridgeServer::onProgress);
+    connect(m_backend, &BridgeBackend::downloadCompleted, this, [this](int id) {
+        push(id, "completed", QJsonObject());
+    });
+    connect(m_backend, &BridgeBackend::downloadFailed, this, [this](int id, const QString &error) {
+        push(id, "failed", QJsonObject{{"error", error}});
+    });
+}
+
+BridgeServer::~BridgeServer()
+{
+    close();
+}
+
+bool BridgeServer::listen(const QString &name)
+{
+    if (m_server->listen(name)) {
+        return true;
+    }
+    if (m_server->serverError() != QAbstractSocket::AddressInUseError) {
+        qWarning() << "Bridge server failed to listen on" << name << ":" << m_server->errorString();
+        return false;
+    }
+
+    // A socket file left behind by a crashed instance accepts no connections
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(100)) {
+        qWarning() << "Bridge server" << name << "is already served by another instance";
+        return false;
+    }
+    QLocalServer::removeServer(name);
+    return m_server->listen(name);
+}
+
+void BridgeServer::close()
+{
+    m_server->close();
+    const QList<QLocalSocket*> sockets = m_connections.keys();
+    for (QLocalSocket *socket : sockets) {
+        socket->abort();
+    }
+    m_connections.clear();
+}
+
+QString BridgeServer::serverName() const
+{
+    return m_server->fullServerName();
+}
+
+QString BridgeServer::defaultServerName()
+{
+    // The runtime directory is private to the user; elsewhere Qt picks a per-platform location
+    QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (runtimeDir.isEmpty()) {
+        return "ldm-bridge";
+    }
+    return QDir(runtimeDir).filePath("ldm-bridge");
+}
+
+void BridgeServer::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        MessageParser *parser = new MessageParser(socket);
+        m_connections.insert(socket, Connection{parser, {}, {}});
+        connect(parser, &MessageParser::messageReceived, this, [this, socket](const QJsonObject &message) {
+            m_connections[socket].requests.append(message);
+        });
+        connect(parser, &MessageParser::frameError, socket, [socket](const QString &error) {
+            qWarning() << "Bridge" << error << "- dropping the connection";
+            socket->abort();
+        });
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            readRequests(socket);
+        });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            m_connections.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void BridgeServer::onProgress(int downloadId, qint64 downloaded, qint64 total, qint64 speed)
+{
+    push(downloadId, "progress", QJsonObject{
+        {"bytesReceived", downloaded},
+        {"bytesTotal", total},
+        {"speed", speed}
+    });
+}
+
+void BridgeServer::readRequests(QLocalSocket *socket)
+{
+    auto connection = m_connections.find(socket);
+    if (connection == m_connections.end()) {
+        return;
+    }
+
+    // Everything that arrived together is handled together, so bursts batch naturally
+    connection->parser->parseMessage(socket->readAll());
+
+    // A frame error aborts the socket, which may already have dropped the connection
+    connection = m_connections.find(socket);
+    if (connection == m_connections.end()) {
+        return;
+    }
+    QList<QJsonObject> requests = std::exchange(connection->requests, {});
+    if (socket->state() == QLocalSocket::ConnectedState) {
+        handleRequests(socket, requests);
+    }
+}
+
+void BridgeServer::handleRequests(QLocalSocket *socket, const QList<QJsonObject> &requests)
+{
+    // Runs of start_download are inserted as one batch; anything else ends the run
+    // first, so a cancel never overtakes the start it refers to
+    QList<QJsonObject> starts;
+    for (const QJsonObject &request : requests) {
+        QString action = request.value("action").toString();
+        if (action == "start_download") {
+            starts.append(request);
+            continue;
+        }
+        startDownloads(socket, std::exchange(starts, {}));
+
+        QJsonValue id = request.value("id");
+        QJsonObject data = request.value("data").toObject();
+        int downloadId = data.value("downloadId").toInt();
+        if (action == "start_downloads") {
+            // One request carrying every item; the reply lists the ids in item order, -1 where it failed
+            QList<QJsonObject> items;
+            for (const QJsonValue &item : data.value("items").toArray()) {
+                items.append(item.toObject());
+            }
+            QJsonArray downloadIds;
+            for (int created : createDownloads(socket, items)) {
+                downloadIds.append(created);
+            }
+            reply(socket, id, QJsonObject{{"downloadIds", downloadIds}});
+        } else if (action == "cancel_download") {
+            if (m_backend->cancelDownload(downloadId)) {
+                m_connections[socket].downloads.remove(downloadId);
+                reply(socket, id, QJsonObject{{"downloadId", downloadId}});
+            } else {
+                replyError(socket, id, "Download not found");
+            }
+        } else if (action == "get_status") {
+            QJsonObject status = downloadStatus(downloadId);
+            if (status.isEmpty()) {
+                replyError(socket, id, "Download not found");
+            } else {
+                m_connections[socket].downloads.insert(downloadId);
+                reply(socket, id, status);
+            }
+        } else {
+            replyError(socket, id, "Unknown action: " + action);
+        }
+    }
+    startDownloads(socket, starts);
+}
+
+void BridgeServer::startDownloads(QLocalSocket *socket, const QList<QJsonObject> &requests)
+{
+    if (requests.isEmpty()) {
+        return;
+    }
+
+    QList<QJsonObject> items;
+    items.reserve(requests.size());
+    for (const QJsonObject &request : requests) {
+        items.append(request.value("data").toObject());
+    }
+    QList<int> ids = createDownloads(socket, items);
+
+    for (int i = 0; i < requests.size(); ++i) {
+        QJsonValue id = requests.at(i).value("id");
+        if (ids.at(i) <= 0) {
+            replyError(socket, id, "Failed to create download");
+            continue;
+        }
+        reply(socket, id, QJsonObject{
+            {"downloadId", ids.at(i)},
+            {"filename", m_backend->download(ids.at(i)).value("filename").toString()}
+        });
+    }
+}
+
+QList<int> BridgeServer::createDownloads(QLocalSocket *socket, const QList<QJsonObject> &items)
+{
+    // One insert for every item with a url; the rest stay -1
+    QList<int> ids(items.size(), -1);
+    QList<int> positions;
+    QVariantList rows;
+    for (int i = 0; i < items.size(); ++i) {
+        QVariantMap row = downloadRow(items.at(i));
+        if (!row.value("url").toString().isEmpty()) {
+            positions.append(i);
+            rows.append(row);
+        }
+    }
+
+    QList<int> created = m_backend->createDownloads(rows);
+    QSet<int> &downloads = m_connections[socket].downloads;
+    for (int i = 0; i < positions.size(); ++i) {
+        ids[positions.at(i)] = created.value(i, -1);
+        if (created.value(i, -1) > 0) {
+            downloads.insert(created.at(i));
+        }
+    }
+    return ids;
+}
+
+QVariantMap BridgeServer::downloadRow(const QJsonObject &item)
+{
+    // Field names follow the extension's messages
+    QVariantMap row;
+    row["url"] = item.value("url").toString();
+    row["filename"] = item.value("filename").toString();
+    row["referrer"] = item.value("referrer").toString();
+    row["user_agent"] = item.value("userAgent").toString();
+    return row;
+}
+
+QJsonObject BridgeServer::downloadStatus(int downloadId) const
+{
+    QVariantMap download = m_backend->download(downloadId);
+    if (download.isEmpty()) {
+        return QJsonObject();
+    }
+    qint64 received = download.value("downloaded_size").toLongLong();
+    qint64 total = download.value("total_size").toLongLong();
+    return QJsonObject{
+        {"downloadId", downloadId},
+        {"status", download.value("status").toString()},
+        {"bytesReceived", received},
+        {"bytesTotal", total},
+        {"progress", total > 0 ? received * 100.0 / total : 0.0}
+    };
+}
+
+void BridgeServer::push(int downloadId, const QString &event, const QJsonObject &data)
+{
+    QJsonObject payload = data;
+    payload["downloadId"] = downloadId;
+    QJsonObject message{{"event", event}, {"data", payload}};
+    for (auto it = m_connections.constBegin(); it != m_connections.constEnd(); ++it) {
+        if (it->downloads.contains(downloadId)) {
+            sendFrame(it.key(), message);
+        }
+    }
+}
+
+void BridgeServer::reply(QLocalSocket *socket, const QJsonValue &id, const QJsonObject &data)
+{
+    sendFrame(socket, QJsonObject{{"reply", id}, {"ok", true}, {"data", data}});
+}
+
+void BridgeServer::replyError(QLocalSocket *socket, const QJsonValue &id, const QString &error)
+{
+    sendFrame(socket, QJsonObject{{"reply", id}, {"ok", false}, {"error", error}});
+}
+
+void BridgeServer::sendFrame(QLocalSocket *socket, const QJsonObject &message)
+{
+    // Written into the socket buffer; a burst of replies leaves in as few writes as the OS allows
+    socket->write(MessageParser::frame(message));
+}
\ No newline at end of file
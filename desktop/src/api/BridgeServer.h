@@ -0,0 +1,76 @@
+#ifndef BRIDGESERVER_H
+#define BRIDGESERVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QSet>
+#include <QVariantMap>
+
+class BridgeBackend;
+class MessageParser;
+class QLocalServer;
+class QLocalSocket;
+
+// Local-socket endpoint for the browser native messaging host. Frames are a
+// little-endian quint32 length followed by a compact JSON object, the same
+// framing browsers use on the host's stdio, decoded by the host's own
+// MessageParser (the ldm-messaging library):
+//
+//     request  {"id": 7, "action": "start_download", "data": {...}}
+//     reply    {"reply": 7, "ok": true, "data": {...}}  or  {"reply": 7, "ok": false, "error": "..."}
+//     push     {"event": "progress" | "completed" | "failed", "data": {"downloadId": ..., ...}}
+//
+// A host may keep any number of requests outstanding; replies carry the
+// request id and need not follow request order. start_download requests that
+// arrive together are inserted as one batch, so a page full of links costs
+// one transaction. Connections receive pushes for the downloads they started
+// or asked about, progress coalesced by the backend to one frame per
+// download per tick. The backend owns the downloads: DownloadService in
+// ldm-cli, the window's engine in the GUI.
+class BridgeServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BridgeServer(BridgeBackend *backend, QObject *parent = nullptr);
+    ~BridgeServer();
+
+    // Refuses a name another live instance is serving; a stale socket file is replaced
+    bool listen(const QString &name = defaultServerName());
+    void close();
+    QString serverName() const;
+    int connectionCount() const { return m_connections.size(); }
+
+    static QString defaultServerName();
+
+private slots:
+    void onNewConnection();
+    void onProgress(int downloadId, qint64 downloaded, qint64 total, qint64 speed);
+
+private:
+    struct Connection {
+        MessageParser *parser;              // child of the socket
+        QList<QJsonObject> requests;        // decoded from the current read
+        QSet<int> downloads;                // pushes go to connections that know the id
+    };
+
+    QLocalServer *m_server;
+    BridgeBackend *m_backend;
+    QHash<QLocalSocket*, Connection> m_connections;
+
+    void readRequests(QLocalSocket *socket);
+    void handleRequests(QLocalSocket *socket, const QList<QJsonObject> &requests);
+    void startDownloads(QLocalSocket *socket, const QList<QJsonObject> &requests);
+    QList<int> createDownloads(QLocalSocket *socket, const QList<QJsonObject> &items);   // -1 where it failed
+    QJsonObject downloadStatus(int downloadId) const;
+    static QVariantMap downloadRow(const QJsonObject &item);
+    void push(int downloadId, const QString &event, const QJsonObject &data);
+    static void reply(QLocalSocket *socket, const QJsonValue &id, const QJsonObject &data);
+    static void replyError(QLocalSocket *socket, const QJsonValue &id, const QString &error);
+    static void sendFrame(QLocalSocket *socket, const QJsonObject &message);
+};
+
+#endif // BRIDGESERVER_H
\ No newline at end of file
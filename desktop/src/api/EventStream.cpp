@@ -0,0 +1,224 @@
+#include "EventStream.h"
+#include "core/DownloadEngine.h"
+#include "core/DownloadService.h"
+#include <QHttpServerRequest>
+#include <QHttpServerResponder>
+#include <QHttpHeaders>
+#include <QJsonDocument>
+#include <QUrlQuery>
+#include <QRandomGenerator>
+#include <algorithm>
+
+EventStream::EventStream(DownloadEngine *engine, DownloadService *service, QObject *parent)
+    : QObject(parent)
+    , m_sequence(0)
+    , m_epoch(QByteArray::number(QRandomGenerator::global()->generate(), 36))
+    , m_tickTimer(new QTimer(this))
+    , m_heartbeatTimer(new QTimer(this))
+{
+    // The tick only runs while something is pending, the heartbeat only while streams are open
+    m_tickTimer->setSingleShot(true);
+    m_tickTimer->setInterval(TICK_MS);
+    connect(m_tickTimer, &QTimer::timeout, this, &EventStream::flush);
+    m_heartbeatTimer->setInterval(HEARTBEAT_MS);
+    connect(m_heartbeatTimer, &QTimer::timeout, this, &EventStream::onHeartbeat);
+
+    // The engine's own progress signal carries one segment's counters, so progress comes from the service
+    if (service) {
+        connect(service, &DownloadService::downloadProgressChanged, this, &EventStream::onProgress);
+    }
+    if (!engine) {
+        return;
+    }
+    connect(engine, &DownloadEngine::downloadStarted, this, [this](int id) {
+        queueTransition(id, "downloading");
+    });
+    connect(engine, &DownloadEngine::downloadResumed, this, [this](int id) {
+        queueTransition(id, "downloading");
+    });
+    connect(engine, &DownloadEngine::downloadPaused, this, [this](int id) {
+        queueTransition(id, "paused");
+    });
+    connect(engine, &DownloadEngine::downloadCancelled, this, [this](int id) {
+        queueTransition(id, "cancelled");
+    });
+    connect(engine, &DownloadEngine::downloadCompleted, this, [this](int id) {
+        queueTransition(id, "completed");
+    });
+    connect(engine, &DownloadEngine::downloadFailed, this, [this](int id, const QString &error) {
+        queueTransition(id, "failed", error);
+    });
+}
+
+EventStream::~EventStream()
+{
+    while (!m_streams.isEmpty()) {
+        closeStream(0);
+    }
+}
+
+void EventStream::subscribe(const QHttpServerRequest &request, QHttpServerResponder &responder)
+{
+    // New clients start from now; EventSource reconnects send Last-Event-ID
+    QByteArray lastEventId = request.headers().value("Last-Event-ID").toByteArray();
+    if (lastEventId.isEmpty()) {
+        lastEventId = QUrlQuery(request.url()).queryItemValue("since").toLatin1();
+    }
+
+    if (m_streams.size() >= MAX_STREAMS) {
+        closeStream(0);
+    }
+
+    Stream stream;
+    stream.responder = std::make_shared<QHttpServerResponder>(std::move(responder));
+    stream.age.start();
+
+    QHttpHeaders headers;
+    headers.append(QHttpHeaders::WellKnownHeader::ContentType, "text/event-stream");
+    headers.append(QHttpHeaders::WellKnownHeader::CacheControl, "no-cache");
+    stream.responder->writeBeginChunked(headers);
+    stream.responder->writeChunk("retry: 2000\n\n" + (lastEventId.isEmpty() ? QByteArray() : eventsSince(lastEventId)));
+
+    m_streams.append(stream);
+    if (!m_heartbeatTimer->isActive()) {
+        m_heartbeatTimer->start();
+    }
+}
+
+QByteArray EventStream::eventsSince(quint64 sequence) const
+{
+    if (sequence == m_sequence) {
+        return QByteArray();
+    }
+
+    quint64 oldest = m_history.empty() ? m_sequence + 1 : m_history.front().sequence;
+    if (sequence > m_sequence || sequence + 1 < oldest) {
+        // Unknown position (history trimmed): client must reload
+        return resetEvent();
+    }
+
+    QByteArray text;
+    for (auto it = m_history.begin() + (sequence + 1 - oldest); it != m_history.end(); ++it) {
+        text += it->text;
+    }
+    return text;
+}
+
+QByteArray EventStream::eventsSince(const QByteArray &lastEventId) const
+{
+    // A bare or foreign-epoch id may be from a previous run, whose sequence restarted at 0
+    int dash = lastEventId.lastIndexOf('-');
+    bool ok = false;
+    quint64 sequence = dash > 0 ? lastEventId.mid(dash + 1).toULongLong(&ok) : 0;
+    if (!ok || lastEventId.left(dash) != m_epoch) {
+        return resetEvent();
+    }
+    return eventsSince(sequence);
+}
+
+QByteArray EventStream::eventId(quint64 sequence) const
+{
+    return m_epoch + '-' + QByteArray::number(sequence);
+}
+
+void EventStream::flush()
+{
+    if (m_pendingProgress.isEmpty() && m_pendingTransitions.isEmpty()) {
+        return;
+    }
+
+    // Progress first (latest value per download), then transitions in arrival order
+    QByteArray chunk;
+    QList<int> ids = m_pendingProgress.keys();
+    std::sort(ids.begin(), ids.end());
+    for (int id : ids) {
+        const Progress &progress = m_pendingProgress.value(id);
+        QJsonObject payload;
+        payload["id"] = id;
+        payload["downloaded"] = double(progress.downloaded);
+        payload["total"] = double(progress.total);
+        payload["speed"] = double(progress.speed);
+        chunk += appendEvent("progress", payload);
+    }
+    for (const Transition &transition : std::as_const(m_pendingTransitions)) {
+        QJsonObject payload;
+        payload["id"] = transition.downloadId;
+        payload["status"] = transition.status;
+        if (!transition.error.isEmpty()) {
+            payload["error"] = transition.error;
+        }
+        chunk += appendEvent("state", payload);
+    }
+    m_pendingProgress.clear();
+    m_pendingTransitions.clear();
+
+    // One write per stream per tick
+    expireStreams();
+    for (const Stream &stream : std::as_const(m_streams)) {
+        stream.responder->writeChunk(chunk);
+    }
+}
+
+void EventStream::onProgress(int downloadId, qint64 downloaded, qint64 total, qint64 speed)
+{
+    m_pendingProgress.insert(downloadId, Progress{downloaded, total, speed});
+    if (!m_tickTimer->isActive()) {
+        m_tickTimer->start();
+    }
+}
+
+void EventStream::onHeartbeat()
+{
+    expireStreams();
+    for (const Stream &stream : std::as_const(m_streams)) {
+        stream.responder->writeChunk(": ping\n\n");
+    }
+    if (m_streams.isEmpty()) {
+        m_heartbeatTimer->stop();
+    }
+}
+
+void EventStream::queueTransition(int downloadId, const QString &status, const QString &error)
+{
+    m_pendingTransitions.append(Transition{downloadId, status, error});
+    if (!m_tickTimer->isActive()) {
+        m_tickTimer->start();
+    }
+}
+
+QByteArray EventStream::appendEvent(const char *type, QJsonObject payload)
+{
+    quint64 sequence = ++m_sequence;
+    payload["seq"] = double(sequence);
+
+    QByteArray text = "id: " + eventId(sequence) + "\nevent: " + type + "\ndata: "
+        + QJsonDocument(payload).toJson(QJsonDocument::Compact) + "\n\n";
+    m_history.push_back(Event{sequence, text});
+    if (m_history.size() > size_t(HISTORY_SIZE)) {
+        m_history.pop_front();
+    }
+    return text;
+}
+
+QByteArray EventStream::resetEvent() const
+{
+    QJsonObject payload;
+    payload["seq"] = double(m_sequence);
+    return "id: " + eventId(m_sequence) + "\nevent: reset\ndata: "
+        + QJsonDocument(payload).toJson(QJsonDocument::Compact) + "\n\n";
+}
+
+void EventStream::closeStream(int index)
+{
+    m_streams.at(index).responder->writeEndChunked(QByteArray());
+    m_streams.removeAt(index);
+}
+
+void EventStream::expireStreams()
+{
+    for (int i = m_streams.size() - 1; i >= 0; --i) {
+        if (m_streams.at(i).age.hasExpired(MAX_STREAM_AGE_MS)) {
+            closeStream(i);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#ifndef EVENTSTREAM_H
+#define EVENTSTREAM_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QTimer>
+#include <deque>
+#include <memory>
+
+class DownloadEngine;
+class DownloadService;
+class QHttpServerRequest;
+class QHttpServerResponder;
+
+// Server-sent events feed for /api/v1/events. Whole-download progress from
+// the DownloadService and engine transitions are coalesced per tick (progress
+// keeps only the latest value per download, transitions are kept in order),
+// numbered with a monotonically increasing sequence and written to every open
+// stream as one chunk. Each event's SSE id is "<epoch>-<sequence>", the epoch
+// being random per instance, so a reconnecting EventSource resumes via
+// Last-Event-ID from the in-memory history; clients too far behind, or
+// holding an id from a previous run, get a "reset" event and should reload
+// the full list.
+//
+// Responders expose no disconnect notification, so streams are closed after
+// MAX_STREAM_AGE_MS and the oldest is evicted past MAX_STREAMS; EventSource
+// reconnects and resumes without losing events.
+class EventStream : public QObject
+{
+    Q_OBJECT
+
+public:
+    EventStream(DownloadEngine *engine, DownloadService *service, QObject *parent = nullptr);
+    ~EventStream();
+
+    void subscribe(const QHttpServerRequest &request, QHttpServerResponder &responder);
+
+    quint64 lastSequence() const { return m_sequence; }
+    QByteArray eventId(quint64 sequence) const;
+    int streamCount() const { return m_streams.size(); }
+    // SSE text of every retained event after sequence, or a reset event when they are gone
+    QByteArray eventsSince(quint64 sequence) const;
+    // Same, for an SSE id; ids from another epoch always get a reset event
+    QByteArray eventsSince(const QByteArray &lastEventId) const;
+
+    static const int TICK_MS = 250;
+    static const int HEARTBEAT_MS = 15000;
+    static const int MAX_STREAMS = 32;
+    static const int MAX_STREAM_AGE_MS = 5 * 60 * 1000;
+    static const int HISTORY_SIZE = 4096;
+
+public slots:
+    void flush();
+
+private slots:
+    void onProgress(int downloadId, qint64 downloaded, qint64 total, qint64 speed);
+    void onHeartbeat();
+
+private:
+    struct Progress {
+        qint64 downloaded;
+        qint64 total;
+        qint64 speed;
+    };
+
+    struct Transition {
+        int downloadId;
+        QString status;
+        QString error;
+    };
+
+    struct Event {
+        quint64 sequence;
+        QByteArray text;        // complete SSE message
+    };
+
+    struct Stream {
+        std::shared_ptr<QHttpServerResponder> responder;
+        QElapsedTimer age;
+    };
+
+    QHash<int, Progress> m_pendingProgress;
+    QList<Transition> m_pendingTransitions;
+    std::deque<Event> m_history;
+    QList<Stream> m_streams;
+    quint64 m_sequence;
+    QByteArray m_epoch;         // per instance, so ids from a previous run never resume
+    QTimer *m_tickTimer;
+    QTimer *m_heartbeatTimer;
+
+    void queueTransition(int downloadId, const QString &status, const QString &error = QString());
+    QByteArray appendEvent(const char *type, QJsonObject payload);
+    QByteArray resetEvent() const;
+    void closeStream(int index);
+    void expireStreams();
+};
+
+#endif // EVENTSTREAM_H
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "ListStreamWriter.h"
+#include <QCborValue>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+ListStreamWriter::ListStreamWriter(QIODevice *device, Format format)
+    : m_device(device)
+    , m_format(format)
+    , m_cbor(device)
+{
+}
+
+void ListStreamWriter::beginObject(const QString &key)
+{
+    if (m_format == Cbor) {
+        if (!key.isNull()) {
+            m_cbor.append(key);
+        }
+        m_cbor.startMap();
+        return;
+    }
+    beginJsonItem(key);
+    m_device->write("{");
+    m_empty.append(true);
+}
+
+void ListStreamWriter::endObject()
+{
+    if (m_format == Cbor) {
+        m_cbor.endMap();
+        return;
+    }
+    m_empty.removeLast();
+    m_device->write("}");
+}
+
+void ListStreamWriter::beginArray(const QString &key)
+{
+    if (m_format == Cbor) {
+        if (!key.isNull()) {
+            m_cbor.append(key);
+        }
+        m_cbor.startArray();
+        return;
+    }
+    beginJsonItem(key);
+    m_device->write("[");
+    m_empty.append(true);
+}
+
+void ListStreamWriter::endArray()
+{
+    if (m_format == Cbor) {
+        m_cbor.endArray();
+        return;
+    }
+    m_empty.removeLast();
+    m_device->write("]");
+}
+
+void ListStreamWriter::writeField(const QString &key, const QJsonValue &value)
+{
+    if (m_format == Cbor) {
+        if (!key.isNull()) {
+            m_cbor.append(key);
+        }
+        QCborValue::fromJsonValue(value).toCbor(m_cbor);
+        return;
+    }
+    beginJsonItem(key);
+    m_device->write(jsonScalar(value));
+}
+
+void ListStreamWriter::writeValue(const QJsonValue &value)
+{
+    writeField(QString(), value);
+}
+
+QByteArray ListStreamWriter::contentType(Format format)
+{
+    return format == Cbor ? "application/cbor" : "application/json";
+}
+
+void ListStreamWriter::beginJsonItem(const QString &key)
+{
+    if (!m_empty.isEmpty()) {
+        if (!m_empty.last()) {
+            m_device->write(",");
+        }
+        m_empty.last() = false;
+    }
+    if (!key.isNull()) {
+        m_device->write(jsonScalar(key));
+        m_device->write(":");
+    }
+}
+
+QByteArray ListStreamWriter::jsonScalar(const QJsonValue &value)
+{
+    if (value.isObject()) {
+        return QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact);
+    }
+    if (value.isArray()) {
+        return QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact);
+    }
+    // QJsonDocument only serializes containers; unwrap a one-element array
+    QByteArray wrapped = QJsonDocument(QJsonArray{value}).toJson(QJsonDocument::Compact);
+    return wrapped.mid(1, wrapped.size() - 2);
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef LISTSTREAMWRITER_H
+#define LISTSTREAMWRITER_H
+
+#include <QByteArray>
+#include <QCborStreamWriter>
+#include <QIODevice>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QList>
+#include <QString>
+
+// Writes a list response into a device one row at a time, as compact JSON or
+// as CBOR, so no document tree for the whole list is ever built. Containers
+// nest as in QJsonDocument; CBOR containers are indefinite-length since the
+// row count is only known at the end.
+//
+//     writer.beginObject();
+//     writer.beginArray("downloads");
+//     writer.writeValue(row);        // per row
+//     writer.endArray();
+//     writer.writeField("total", n);
+//     writer.endObject();
+class ListStreamWriter
+{
+public:
+    enum Format { Json, Cbor };
+
+    ListStreamWriter(QIODevice *device, Format format);
+
+    void beginObject(const QString &key = QString());
+    void endObject();
+    void beginArray(const QString &key = QString());
+    void endArray();
+    void writeField(const QString &key, const QJsonValue &value);
+    void writeValue(const QJsonValue &value);      // an array element
+
+    Format format() const { return m_format; }
+    static QByteArray contentType(Format format);
+
+private:
+    QIODevice *m_device;
+    Format m_format;
+    QCborStreamWriter m_cbor;
+    QList<bool> m_empty;                            // per open JSON container, whether a separator is due
+
+    void beginJsonItem(const QString &key);
+    static QByteArray jsonScalar(const QJsonValue &value);
+};
+
+#endif // LISTSTREAMWRITER_H
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "ResponseStream.h"
+#include <QHttpServerResponder>
+#include <QMetaObject>
+#include "utils/Metrics.h"
+
+ResponseStream::ResponseStream(std::shared_ptr<QHttpServerResponder> responder, QObject *server,
+                               QPointer<QTcpSocket> socket, const QHttpHeaders &headers, bool gzip)
+    : m_responder(std::move(responder))
+    , m_server(server)
+    , m_socket(std::move(socket))
+    , m_headers(headers)
+    , m_gzip(gzip)
+    , m_deflate()
+    , m_chunked(false)
+    , m_finished(false)
+    , m_aborted(false)
+    , m_bytesSent(0)
+    , m_inFlight(std::make_shared<QSemaphore>(MAX_CHUNKS_IN_FLIGHT))
+{
+    // windowBits 15 + 16 selects the gzip wrapper rather than zlib's own
+    if (m_gzip && deflateInit2(&m_deflate, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        m_gzip = false;
+    }
+    open(QIODevice::WriteOnly);
+}
+
+ResponseStream::~ResponseStream()
+{
+    finish();
+    if (m_gzip) {
+        deflateEnd(&m_deflate);
+    }
+}
+
+QByteArray ResponseStream::finish()
+{
+    if (m_finished) {
+        return QByteArray();
+    }
+    m_finished = true;
+    if (m_gzip) {
+        compress(nullptr, 0, Z_FINISH);
+    }
+
+    QByteArray body = std::exchange(m_buffer, QByteArray());
+    if (m_aborted) {
+        // No terminating chunk: a cut-off body must not read as a complete, shorter list.
+        // The responder is released on its own thread, then the connection is dropped.
+        QMetaObject::invokeMethod(m_server, [responder = std::move(m_responder), socket = m_socket]() mutable {
+            responder.reset();
+            if (socket) {
+                socket->abort();
+            }
+        }, Qt::QueuedConnection);
+        return QByteArray();
+    }
+    m_bytesSent += body.size();
+    if (m_chunked) {
+        // The last reference travels with the final write, so the responder dies on its own thread
+        QMetaObject::invokeMethod(m_server, [responder = std::move(m_responder), body]() {
+            responder->writeEndChunked(body);
+        }, Qt::QueuedConnection);
+        return QByteArray();
+    }
+    send(std::move(m_responder), m_server, m_headers, body);
+    return body;
+}
+
+void ResponseStream::send(std::shared_ptr<QHttpServerResponder> responder, QObject *server,
+                          const QHttpHeaders &headers, const QByteArray &body, int status)
+{
+    QMetaObject::invokeMethod(server, [responder = std::move(responder), headers, body, status]() {
+        auto code = QHttpServerResponder::StatusCode(status);
+        if (body.isEmpty()) {
+            responder->write(headers, code);
+        } else {
+            responder->write(body, headers, code);
+        }
+    }, Qt::QueuedConnection);
+}
+
+qint64 ResponseStream::readData(char *data, qint64 maxSize)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    return -1;
+}
+
+qint64 ResponseStream::writeData(const char *data, qint64 size)
+{
+    if (m_finished) {
+        return -1;
+    }
+    if (m_gzip) {
+        compress(data, size, Z_NO_FLUSH);
+    } else {
+        append(data, size);
+    }
+    return size;
+}
+
+void ResponseStream::compress(const char *data, qint64 size, int flush)
+{
+    char out[16 * 1024];
+    m_deflate.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    m_deflate.avail_in = uInt(size);
+    do {
+        m_deflate.next_out = reinterpret_cast<Bytef *>(out);
+        m_deflate.avail_out = sizeof(out);
+        ::deflate(&m_deflate, flush);
+        append(out, qint64(sizeof(out)) - m_deflate.avail_out);
+    } while (m_deflate.avail_out == 0);
+}
+
+void ResponseStream::append(const char *data, qint64 size)
+{
+    if (m_aborted) {
+        return;
+    }
+    m_buffer.append(data, size);
+
+    if (!m_chunked && m_buffer.size() > BUFFER_LIMIT) {
+        m_chunked = true;
+        QHttpHeaders headers = m_headers;
+        post([headers](QHttpServerResponder &responder) {
+            responder.writeBeginChunked(headers);
+        });
+    }
+    if (m_chunked && m_buffer.size() >= CHUNK_SIZE) {
+        QByteArray chunk = std::exchange(m_buffer, QByteArray());
+        m_bytesSent += chunk.size();
+        post([chunk](QHttpServerResponder &responder) {
+            responder.writeChunk(chunk);
+        }, chunk.size());
+    }
+}
+
+void ResponseStream::post(std::function<void(QHttpServerResponder &)> write, qint64 bytes)
+{
+    static Metrics::Counter *written = Metrics::instance().counter(
+        "ldm_api_stream_written_bytes_total", "Streamed list bytes handed to client sockets");
+
+    // Waiting here is the back-pressure: the producer runs at most a few chunks
+    // ahead of what the client has actually taken
+    if (!m_inFlight->tryAcquire(1, CHUNK_TIMEOUT_MS)) {
+        m_aborted = true;
+        m_buffer.clear();
+        return;
+    }
+    QMetaObject::invokeMethod(m_server, [responder = m_responder, socket = m_socket, inFlight = m_inFlight, bytes,
+                                         write = std::move(write)]() {
+        write(*responder);
+        written->increment(quint64(bytes));
+        if (!socket || socket->bytesToWrite() <= SOCKET_HIGH_WATER) {
+            inFlight->release();
+            return;
+        }
+
+        // writeChunk() only appends to the socket's buffer; the slot frees once it drains
+        QTcpSocket *client = socket.data();
+        auto drained = std::make_shared<QMetaObject::Connection>();
+        *drained = QObject::connect(client, &QTcpSocket::bytesWritten, client, [client, inFlight, drained]() {
+            if (client->bytesToWrite() <= SOCKET_HIGH_WATER) {
+                QObject::disconnect(*drained);
+                inFlight->release();
+            }
+        });
+    }, Qt::QueuedConnection);
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef RESPONSESTREAM_H
+#define RESPONSESTREAM_H
+
+#include <QByteArray>
+#include <QHttpHeaders>
+#include <QIODevice>
+#include <QPointer>
+#include <QSemaphore>
+#include <QTcpSocket>
+#include <functional>
+#include <memory>
+#include <zlib.h>
+
+class QHttpServerResponder;
+
+// Write-only device that delivers a 200 response body from a worker thread
+// to a responder living on the server thread. Bodies that stay under
+// BUFFER_LIMIT go out whole with a Content-Length; past that the response
+// switches to chunked transfer and is forwarded in CHUNK_SIZE pieces. A
+// chunk's slot is only freed once the client socket has drained below
+// SOCKET_HIGH_WATER, and at most MAX_CHUNKS_IN_FLIGHT slots exist, so memory
+// per response is bounded however many rows are written and however slowly
+// the client reads. With gzip the body is deflated as it is written and the
+// limits apply to the compressed bytes.
+//
+// The producer holds a pool thread (and its read cursor) while it waits, so
+// a client that stops reading costs that thread CHUNK_TIMEOUT_MS per chunk
+// before the stream gives up and drops the connection without the
+// terminating chunk.
+class ResponseStream : public QIODevice
+{
+public:
+    // server is any object living on the responder's thread
+    // socket is the client connection, if known; without it chunks are paced by the server thread only
+    ResponseStream(std::shared_ptr<QHttpServerResponder> responder, QObject *server, QPointer<QTcpSocket> socket,
+                   const QHttpHeaders &headers, bool gzip);
+    ~ResponseStream();
+
+    // Completes the response. Returns the encoded body if it was sent whole, so
+    // the caller can cache it, or a null array if it went out chunked.
+    QByteArray finish();
+    qint64 bytesSent() const { return m_bytesSent; }
+
+    bool isSequential() const override { return true; }
+
+    // Sends a complete response without streaming, e.g. a cached body or a 304
+    static void send(std::shared_ptr<QHttpServerResponder> responder, QObject *server, const QHttpHeaders &headers,
+                     const QByteArray &body, int status = 200);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+
+private:
+    std::shared_ptr<QHttpServerResponder> m_responder;
+    QObject *m_server;
+    QPointer<QTcpSocket> m_socket;                  // only dereferenced on the server thread
+    QHttpHeaders m_headers;
+    QByteArray m_buffer;
+    bool m_gzip;
+    z_stream m_deflate;
+    bool m_chunked;
+    bool m_finished;
+    bool m_aborted;                                 // the server thread stopped taking chunks
+    qint64 m_bytesSent;
+    std::shared_ptr<QSemaphore> m_inFlight;
+
+    void compress(const char *data, qint64 size, int flush);
+    void append(const char *data, qint64 size);
+    void post(std::function<void(QHttpServerResponder &)> write, qint64 bytes = 0);
+
+    static const int BUFFER_LIMIT = 256 * 1024;
+    static const int CHUNK_SIZE = 64 * 1024;
+    static const int MAX_CHUNKS_IN_FLIGHT = 4;
+    static const int CHUNK_TIMEOUT_MS = 5000;
+    static const int SOCKET_HIGH_WATER = 2 * CHUNK_SIZE;
+};
+
+#endif // RESPONSESTREAM_H
\ No newline at end of file
@@ -0,0 +1,31 @@
+#include "ServiceBridgeBackend.h"
+#include "core/DownloadEngine.h"
+#include "core/DownloadService.h"
+
+ServiceBridgeBackend::ServiceBridgeBackend(DownloadService *service, DownloadEngine *engine, QObject *parent)
+    : BridgeBackend(parent)
+    , m_service(service)
+{
+    // Whole-download progress; the engine's own progress signal carries one segment's counters
+    connect(m_service, &DownloadService::downloadProgressChanged, this, &BridgeBackend::downloadProgressChanged);
+    if (!engine) {
+        return;
+    }
+    connect(engine, &DownloadEngine::downloadCompleted, this, &BridgeBackend::downloadCompleted);
+    connect(engine, &DownloadEngine::downloadFailed, this, &BridgeBackend::downloadFailed);
+}
+
+QList<int> ServiceBridgeBackend::createDownloads(const QVariantList &rows)
+{
+    return m_service->createDownloads(rows);
+}
+
+bool ServiceBridgeBackend::cancelDownload(int downloadId)
+{
+    return m_service->deleteDownload(downloadId);
+}
+
+QVariantMap ServiceBridgeBackend::download(int downloadId) const
+{
+    return m_service->download(downloadId);
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef SERVICEBRIDGEBACKEND_H
+#define SERVICEBRIDGEBACKEND_H
+
+#include "BridgeBackend.h"
+
+class DownloadEngine;
+class DownloadService;
+
+// Bridge backend over DownloadService, as used by ApiServer and ldm-cli.
+// Progress comes from the service, already coalesced per tick; completion
+// and failure come from the engine.
+class ServiceBridgeBackend : public BridgeBackend
+{
+    Q_OBJECT
+
+public:
+    ServiceBridgeBackend(DownloadService *service, DownloadEngine *engine, QObject *parent = nullptr);
+
+    QList<int> createDownloads(const QVariantList &rows) override;
+    bool cancelDownload(int downloadId) override;
+    QVariantMap download(int downloadId) const override;
+
+private:
+    DownloadService *m_service;
+};
+
+#endif // SERVICEBRIDGEBACKEND_H
\ No newline at end of file
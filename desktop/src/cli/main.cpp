@@ -6,11 +6,13 @@
 #include <QStandardPaths>
 #include <QSqlDatabase>
 #include <QSqlError>
+#include <memory>
 
 #include "core/Database.h"
 #include "core/DownloadEngine.h"
 #include "core/DownloadItem.h"
 #include "core/NetworkManager.h"
+#include "api/ApiServer.h"
 
 int main(int argc, char *argv[])
 {
@@ -32,6 +34,10 @@ int main(int argc, char *argv[])
     QCommandLineOption cancelOption("cancel", "Cancel download", "id");
     QCommandLineOption statusOption("status", "Show download status", "id");
     QCommandLineOption historyOption("history", "Show download history");
+    QCommandLineOption archiveHistoryOption("archive-history", "Archive history older than the given number of days", "days");
+    QCommandLineOption compactDatabaseOption("compact-database",
+                                             "Rewrite the database once so archival can release free pages (blocks other writers)");
+    QCommandLineOption serveOption("serve", "Serve the REST API and the browser bridge until interrupted", "port", "8080");
 
     parser.addOption(addOption);
     parser.addOption(listOption);
@@ -40,6 +46,9 @@ int main(int argc, char *argv[])
     parser.addOption(cancelOption);
     parser.addOption(statusOption);
     parser.addOption(historyOption);
+    parser.addOption(archiveHistoryOption);
+    parser.addOption(compactDatabaseOption);
+    parser.addOption(serveOption);
 
     parser.process(app);
 
@@ -48,19 +57,16 @@ int main(int argc, char *argv[])
     QDir().mkpath(dataDir);
     QString dbPath = dataDir + "/ldm.db";
 
+    // open() also brings the schema up to date
     Database database;
     if (!database.open(dbPath)) {
         qCritical() << "Failed to open database";
         return 1;
     }
 
-    if (!database.createTables()) {
-        qCritical() << "Failed to create database tables";
-        return 1;
-    }
-
     // Initialize download engine
     DownloadEngine downloadEngine;
+    std::unique_ptr<ApiServer> apiServer;       // --serve only; goes before the engine and database
 
     // Process commands
     if (parser.isSet(addOption)) {
@@ -154,6 +160,41 @@ int main(int argc, char *argv[])
                        .arg(entry["completed_at"].toString())
                        .arg(entry["size"].toLongLong());
         }
+    } else if (parser.isSet(archiveHistoryOption)) {
+        bool ok = false;
+        int days = parser.value(archiveHistoryOption).toInt(&ok);
+        if (!ok || days < 0) {
+            qCritical() << "Valid number of days required for --archive-history";
+            return 1;
+        }
+        int archived = database.archiveDownloadHistory(days, dataDir + "/archive");
+        if (archived < 0) {
+            qCritical() << "Failed to archive download history";
+            return 1;
+        }
+        qInfo() << QString("Archived %1 history entries to %2").arg(archived).arg(dataDir + "/archive");
+        return 0;
+    } else if (parser.isSet(compactDatabaseOption)) {
+        if (!database.enableIncrementalVacuum()) {
+            qCritical() << "Failed to compact database";
+            return 1;
+        }
+        qInfo() << "Database compacted; archival now releases free pages incrementally";
+        return 0;
+    } else if (parser.isSet(serveOption)) {
+        // The API server also opens the native messaging bridge socket
+        bool ok = false;
+        quint16 port = parser.value(serveOption).toUShort(&ok);
+        if (!ok) {
+            qCritical() << "Invalid port";
+            return 1;
+        }
+        apiServer = std::make_unique<ApiServer>(&database, &downloadEngine);
+        if (!apiServer->start(port)) {
+            qCritical() << "Failed to listen on port" << port;
+            return 1;
+        }
+        qInfo() << "Serving on port" << port << "and bridge" << apiServer->bridgeServer()->serverName();
     } else {
         parser.showHelp();
         return 0;
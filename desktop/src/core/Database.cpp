@@ -4,6 +4,33 @@
 #include <QVariant>
 #include <QDebug>
 #include <QDir>
+#include <QDateTime>
+#include <QThread>
+#include "SchemaMigrator.h"
+#include "utils/HistoryArchive.h"
+#include "utils/Metrics.h"
+#include <QElapsedTimer>
+
+static const int HISTORY_ARCHIVE_BATCH_SIZE = 5000;
+static const int ID_LIST_CHUNK_SIZE = 500;   // stays under SQLite's bound parameter limit
+
+// Times one statement, failures included
+static bool execTimed(QSqlQuery &q)
+{
+    static Metrics::Histogram *latency = Metrics::instance().histogram(
+        "ldm_sqlite_query_seconds", "SQLite statement execution time", 1e-6);
+    static Metrics::Counter *errors = Metrics::instance().counter(
+        "ldm_sqlite_errors_total", "SQLite statements that failed");
+
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = q.exec();
+    latency->record(timer.nsecsElapsed() / 1000);
+    if (!ok) {
+        errors->increment();
+    }
+    return ok;
+}
 
 Database::Database(QObject *parent)
     : QObject(parent)
@@ -12,12 +39,19 @@ Database::Database(QObject *parent)
 
 Database::~Database()
 {
+    if (m_migrationThread) {
+        m_migrationThread->requestInterruption();
+        m_migrationThread->quit();
+        m_migrationThread->wait();
+    }
     close();
 }
 
-bool Database::open(const QString &databasePath)
+bool Database::open(const QString &databasePath, const QString &connectionName)
 {
-    m_database = QSqlDatabase::addDatabase("QSQLITE");
+    // A named connection lets a worker thread read the same file without sharing this handle
+    m_database = connectionName.isEmpty() ? QSqlDatabase::addDatabase("QSQLITE")
+                                          : QSqlDatabase::addDatabase("QSQLITE", connectionName);
     m_database.setDatabaseName(databasePath);
 
     if (!m_database.open()) {
@@ -25,6 +59,12 @@ bool Database::open(const QString &databasePath)
         return false;
     }
 
+    // Only takes effect on a fresh file; existing databases switch via enableIncrementalVacuum()
+    executeQuery("PRAGMA auto_vacuum = INCREMENTAL");
+    // WAL lets background migrations and loaders write without blocking readers
+    executeQuery("PRAGMA journal_mode = WAL");
+    executeQuery("PRAGMA busy_timeout = 5000");
+
     if (!createTables()) {
         close();
         return false;
@@ -33,6 +73,19 @@ bool Database::open(const QString &databasePath)
     return true;
 }
 
+bool Database::openReader(const QString &databasePath, const QString &connectionName)
+{
+    m_database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    m_database.setDatabaseName(databasePath);
+    m_database.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+
+    if (!m_database.open()) {
+        emit databaseError(m_database.lastError().text());
+        return false;
+    }
+    return true;
+}
+
 void Database::close()
 {
     if (m_database.isOpen()) {
@@ -45,152 +98,174 @@ bool Database::isOpen() const
     return m_database.isOpen();
 }
 
+int Database::schemaVersion()
+{
+    return executeSingleRowQuery("PRAGMA user_version").value("user_version").toInt();
+}
+
+int Database::latestSchemaVersion()
+{
+    return SchemaMigrator::defaultLatestVersion();
+}
+
 bool Database::createTables()
 {
-    QStringList queries = {
-        "CREATE TABLE IF NOT EXISTS downloads ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "url TEXT NOT NULL,"
-        "filename TEXT,"
-        "filepath TEXT,"
-        "status TEXT NOT NULL CHECK (status IN ('queued', 'downloading', 'paused', 'completed', 'failed', 'cancelled')),"
-        "progress REAL CHECK (progress >= 0.0 AND progress <= 1.0),"
-        "total_size INTEGER,"
-        "downloaded_size INTEGER DEFAULT 0,"
-        "speed INTEGER,"
-        "eta INTEGER,"
-        "error_message TEXT,"
-        "created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
-        "started_at DATETIME,"
-        "completed_at DATETIME,"
-        "category_id INTEGER,"
-        "checksum TEXT,"
-        "checksum_type TEXT,"
-        "priority INTEGER DEFAULT 1,"
-        "segments INTEGER DEFAULT 1 CHECK (segments >= 1 AND segments <= 32),"
-        "referrer TEXT,"
-        "user_agent TEXT,"
-        "authentication TEXT,"
-        "proxy TEXT,"
-        "resume_supported BOOLEAN DEFAULT 1,"
-        "antivirus_scanned BOOLEAN DEFAULT 0,"
-        "antivirus_result TEXT,"
-        "encrypted BOOLEAN DEFAULT 0,"
-        "metadata TEXT,"
-        "FOREIGN KEY (category_id) REFERENCES categories(id)"
-        ")",
-        "CREATE TABLE IF NOT EXISTS categories ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "name TEXT NOT NULL UNIQUE,"
-        "description TEXT,"
-        "default_path TEXT,"
-        "color TEXT,"
-        "icon TEXT,"
-        "created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
-        "updated_at DATETIME DEFAULT CURRENT_TIMESTAMP"
-        ")",
-        "CREATE TABLE IF NOT EXISTS download_segments ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "download_id INTEGER NOT NULL,"
-        "segment_index INTEGER NOT NULL,"
-        "start_offset INTEGER NOT NULL,"
-        "end_offset INTEGER NOT NULL,"
-        "downloaded_size INTEGER DEFAULT 0,"
-        "status TEXT DEFAULT 'pending',"
-        "FOREIGN KEY (download_id) REFERENCES downloads(id) ON DELETE CASCADE"
-        ")",
-        "CREATE TABLE IF NOT EXISTS download_history ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "download_id INTEGER,"
-        "url TEXT,"
-        "filename TEXT,"
-        "filepath TEXT,"
-        "size INTEGER,"
-        "completed_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
-        "duration INTEGER,"
-        "average_speed INTEGER,"
-        "category_name TEXT,"
-        "success BOOLEAN DEFAULT 1,"
-        "FOREIGN KEY (download_id) REFERENCES downloads(id)"
-        ")",
-        "CREATE TABLE IF NOT EXISTS settings ("
-        "key TEXT PRIMARY KEY,"
-        "value TEXT,"
-        "type TEXT CHECK (type IN ('string', 'int', 'bool', 'json')),"
-        "category TEXT,"
-        "description TEXT"
-        ")",
-        "CREATE TABLE IF NOT EXISTS browser_extensions ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "browser TEXT NOT NULL,"
-        "enabled BOOLEAN DEFAULT 1,"
-        "settings TEXT"
-        ")",
-        "CREATE TABLE IF NOT EXISTS plugins ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "name TEXT NOT NULL UNIQUE,"
-        "version TEXT,"
-        "type TEXT,"
-        "enabled BOOLEAN DEFAULT 1,"
-        "settings TEXT,"
-        "installed_at DATETIME DEFAULT CURRENT_TIMESTAMP"
-        ")",
-        "CREATE TABLE IF NOT EXISTS password_entries ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "domain TEXT NOT NULL,"
-        "username TEXT,"
-        "password TEXT NOT NULL,"
-        "created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
-        "last_used DATETIME"
-        ")",
-        "CREATE TABLE IF NOT EXISTS favorite_sites ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "name TEXT,"
-        "url TEXT NOT NULL,"
-        "category TEXT,"
-        "added_at DATETIME DEFAULT CURRENT_TIMESTAMP"
-        ")",
-        "CREATE INDEX IF NOT EXISTS idx_downloads_status ON downloads(status)",
-        "CREATE INDEX IF NOT EXISTS idx_downloads_category ON downloads(category_id)",
-        "CREATE INDEX IF NOT EXISTS idx_downloads_created ON downloads(created_at)",
-        "CREATE INDEX IF NOT EXISTS idx_history_completed ON download_history(completed_at)",
-        "CREATE INDEX IF NOT EXISTS idx_segments_download ON download_segments(download_id)",
-        "CREATE VIRTUAL TABLE IF NOT EXISTS downloads_fts USING fts5(url, filename, filepath, content=downloads)"
-    };
-
-    for (const QString &query : queries) {
-        if (!executeQuery(query)) {
-            return false;
-        }
+    // The migrations are idempotent but not free; skip them entirely when the file is already current
+    if (schemaVersion() == latestSchemaVersion()) {
+        return true;
     }
 
+    SchemaMigrator migrator;
+    if (!migrator.migrate(m_database)) {
+        emit databaseError(migrator.lastError());
+        return false;
+    }
     return true;
 }
 
+bool Database::hasPendingMigrations()
+{
+    return !SchemaMigrator().pendingVersions(m_database).isEmpty();
+}
+
+bool Database::startOnlineMigrations()
+{
+    if (m_migrationThread || !hasPendingMigrations()) {
+        return false;
+    }
+
+    SchemaMigrator *migrator = new SchemaMigrator();
+    m_migrationThread = new QThread(this);
+    migrator->moveToThread(m_migrationThread);
+
+    QString path = databasePath();
+    connect(m_migrationThread, &QThread::started, migrator, [migrator, path]() {
+        migrator->runOnline(path);
+    });
+    connect(migrator, &SchemaMigrator::migrationProgress, this, &Database::migrationProgress);
+    connect(migrator, &SchemaMigrator::finished, this, &Database::migrationsFinished);
+    connect(migrator, &SchemaMigrator::finished, m_migrationThread, &QThread::quit);
+    connect(m_migrationThread, &QThread::finished, migrator, &QObject::deleteLater);
+    connect(m_migrationThread, &QThread::finished, m_migrationThread, &QObject::deleteLater);
+
+    m_migrationThread->start(QThread::LowPriority);
+    return true;
+}
+
+static const char *INSERT_DOWNLOAD_SQL =
+    "INSERT INTO downloads (url, filename, filepath, status, progress, total_size, "
+    "downloaded_size, speed, eta, error_message, started_at, completed_at, category_id, "
+    "checksum, checksum_type, priority, segments, referrer, user_agent, authentication, "
+    "proxy, resume_supported, antivirus_scanned, antivirus_result, encrypted, metadata) "
+    "VALUES (:url, :filename, :filepath, :status, :progress, :total_size, "
+    ":downloaded_size, :speed, :eta, :error_message, :started_at, :completed_at, :category_id, "
+    ":checksum, :checksum_type, :priority, :segments, :referrer, :user_agent, :authentication, "
+    ":proxy, :resume_supported, :antivirus_scanned, :antivirus_result, :encrypted, :metadata)";
+
+static const char *const INSERT_DOWNLOAD_COLUMNS[] = {
+    "url", "filename", "filepath", "status", "progress", "total_size", "downloaded_size", "speed", "eta",
+    "error_message", "started_at", "completed_at", "category_id", "checksum", "checksum_type", "priority",
+    "segments", "referrer", "user_agent", "authentication", "proxy", "resume_supported", "antivirus_scanned",
+    "antivirus_result", "encrypted", "metadata"
+};
+
 int Database::insertDownload(const QVariantMap &downloadData)
 {
     QSqlQuery q(m_database);
-    q.prepare("INSERT INTO downloads (url, filename, filepath, status, progress, total_size, "
-              "downloaded_size, speed, eta, error_message, started_at, completed_at, category_id, "
-              "checksum, checksum_type, priority, segments, referrer, user_agent, authentication, "
-              "proxy, resume_supported, antivirus_scanned, antivirus_result, encrypted, metadata) "
-              "VALUES (:url, :filename, :filepath, :status, :progress, :total_size, "
-              ":downloaded_size, :speed, :eta, :error_message, :started_at, :completed_at, :category_id, "
-              ":checksum, :checksum_type, :priority, :segments, :referrer, :user_agent, :authentication, "
-              ":proxy, :resume_supported, :antivirus_scanned, :antivirus_result, :encrypted, :metadata)");
+    q.prepare(INSERT_DOWNLOAD_SQL);
 
     for (auto it = downloadData.begin(); it != downloadData.end(); ++it) {
         q.bindValue(":" + it.key(), it.value());
     }
 
-    if (!q.exec()) {
+    if (!execTimed(q)) {
         emit databaseError(q.lastError().text());
         return -1;
     }
 
+    markChanged(DownloadsTable, true);
     return q.lastInsertId().toInt();
 }
 
+QList<int> Database::insertDownloads(const QVariantList &downloads)
+{
+    QList<int> ids(downloads.size(), -1);
+    if (downloads.isEmpty()) {
+        return ids;
+    }
+
+    bool ownTransaction = !m_inBatch;
+    if (ownTransaction && !m_database.transaction()) {
+        emit databaseError(m_database.lastError().text());
+        return ids;
+    }
+
+    QSqlQuery q(m_database);
+    q.prepare(INSERT_DOWNLOAD_SQL);
+    bool inserted = false;
+    for (int i = 0; i < downloads.size(); ++i) {
+        // Every placeholder is rebound, otherwise a row would inherit the previous row's values
+        QVariantMap row = downloads.at(i).toMap();
+        for (const char *column : INSERT_DOWNLOAD_COLUMNS) {
+            q.bindValue(QLatin1Char(':') + QLatin1String(column), row.value(QLatin1String(column)));
+        }
+        if (execTimed(q)) {
+            ids[i] = q.lastInsertId().toInt();
+            inserted = true;
+        }
+    }
+
+    if (ownTransaction && !m_database.commit()) {
+        emit databaseError(m_database.lastError().text());
+        m_database.rollback();
+        ids.fill(-1);
+        return ids;
+    }
+
+    markChanged(DownloadsTable, inserted);
+    return ids;
+}
+
+bool Database::beginBatch()
+{
+    if (m_inBatch || !m_database.transaction()) {
+        return false;
+    }
+    m_inBatch = true;
+    m_batchChanges = 0;
+    return true;
+}
+
+bool Database::commitBatch()
+{
+    if (!m_inBatch) {
+        return false;
+    }
+    m_inBatch = false;
+    if (!m_database.commit()) {
+        emit databaseError(m_database.lastError().text());
+        m_database.rollback();
+        return false;
+    }
+
+    // Counters move only now, so a reader on another connection never caches
+    // pre-commit data under the new version
+    for (int table = 0; table < TableCount; ++table) {
+        if (m_batchChanges & (1 << table)) {
+            markChanged(Table(table), true);
+        }
+    }
+    return true;
+}
+
+void Database::rollbackBatch()
+{
+    if (m_inBatch) {
+        m_inBatch = false;
+        m_database.rollback();
+    }
+}
+
 bool Database::updateDownload(int id, const QVariantMap &downloadData)
 {
     QString query = "UPDATE downloads SET url=:url, filename=:filename, filepath=:filepath, status=:status, "
@@ -201,15 +276,19 @@ bool Database::updateDownload(int id, const QVariantMap &downloadData)
                     "proxy=:proxy, resume_supported=:resume_supported, antivirus_scanned=:antivirus_scanned, "
                     "antivirus_result=:antivirus_result, encrypted=:encrypted, metadata=:metadata WHERE id=:id";
 
-    QVariantMap params = downloadData;
+    // Bound from the column list, so callers may pass whole rows (id, created_at, ...) back in
+    QVariantMap params;
+    for (const char *column : INSERT_DOWNLOAD_COLUMNS) {
+        params[QLatin1String(column)] = downloadData.value(QLatin1String(column));
+    }
     params["id"] = id;
 
-    return executeQuery(query, params);
+    return markChanged(DownloadsTable, executeQuery(query, params));
 }
 
 bool Database::deleteDownload(int id)
 {
-    return executeQuery("DELETE FROM downloads WHERE id=:id", {{"id", id}});
+    return markChanged(DownloadsTable, executeQuery("DELETE FROM downloads WHERE id=:id", {{"id", id}}));
 }
 
 QVariantMap Database::getDownload(int id)
@@ -218,6 +297,16 @@ QVariantMap Database::getDownload(int id)
 }
 
 QVariantList Database::getDownloads(const QString &status)
+{
+    QVariantList results;
+    forEachDownload(status, [&results](const QVariantMap &row) {
+        results.append(row);
+        return true;
+    });
+    return results;
+}
+
+bool Database::forEachDownload(const QString &status, const RowVisitor &visit)
 {
     QString query = "SELECT * FROM downloads";
     QVariantMap params;
@@ -226,7 +315,7 @@ QVariantList Database::getDownloads(const QString &status)
         params["status"] = status;
     }
     query += " ORDER BY created_at DESC";
-    return executeSelectQuery(query, params);
+    return executeSelectQuery(query, params, visit);
 }
 
 QVariantList Database::getDownloadsByCategory(int categoryId)
@@ -235,11 +324,34 @@ QVariantList Database::getDownloadsByCategory(int categoryId)
                               {{"category_id", categoryId}});
 }
 
+QVariantList Database::getDownloadsPage(int beforeId, int limit)
+{
+    if (beforeId <= 0) {
+        return executeSelectQuery("SELECT * FROM downloads ORDER BY id DESC LIMIT :limit", {{"limit", limit}});
+    }
+    return executeSelectQuery("SELECT * FROM downloads WHERE id < :before_id ORDER BY id DESC LIMIT :limit",
+                              {{"before_id", beforeId}, {"limit", limit}});
+}
+
+bool Database::updateDownloadState(int id, const QString &status, qint64 downloadedSize, qint64 totalSize)
+{
+    QVariantMap params;
+    params["id"] = id;
+    params["status"] = status;
+    params["downloaded_size"] = downloadedSize;
+    params["total_size"] = totalSize;
+    params["progress"] = totalSize > 0 ? qBound(0.0, double(downloadedSize) / totalSize, 1.0) : 0.0;
+    return markChanged(DownloadsTable,
+                       executeQuery("UPDATE downloads SET status=:status, downloaded_size=:downloaded_size, "
+                                    "total_size=:total_size, progress=:progress WHERE id=:id",
+                                    params));
+}
+
 bool Database::insertCategory(const QVariantMap &categoryData)
 {
     QString query = "INSERT INTO categories (name, description, default_path, color, icon) "
                     "VALUES (:name, :description, :default_path, :color, :icon)";
-    return executeQuery(query, categoryData);
+    return markChanged(CategoriesTable, executeQuery(query, categoryData));
 }
 
 bool Database::updateCategory(int id, const QVariantMap &categoryData)
@@ -248,12 +360,12 @@ bool Database::updateCategory(int id, const QVariantMap &categoryData)
                     "color=:color, icon=:icon, updated_at=CURRENT_TIMESTAMP WHERE id=:id";
     QVariantMap params = categoryData;
     params["id"] = id;
-    return executeQuery(query, params);
+    return markChanged(CategoriesTable, executeQuery(query, params));
 }
 
 bool Database::deleteCategory(int id)
 {
-    return executeQuery("DELETE FROM categories WHERE id=:id", {{"id", id}});
+    return markChanged(CategoriesTable, executeQuery("DELETE FROM categories WHERE id=:id", {{"id", id}}));
 }
 
 QVariantMap Database::getCategory(int id)
@@ -266,6 +378,49 @@ QVariantList Database::getCategories()
     return executeSelectQuery("SELECT * FROM categories ORDER BY name");
 }
 
+int Database::insertSchedule(const QVariantMap &scheduleData)
+{
+    QSqlQuery q(m_database);
+    q.prepare("INSERT INTO schedules (name, url, start_time, rule, window_start, window_end, options, active, last_run) "
+              "VALUES (:name, :url, :start_time, :rule, :window_start, :window_end, :options, :active, :last_run)");
+    for (auto it = scheduleData.begin(); it != scheduleData.end(); ++it) {
+        q.bindValue(":" + it.key(), it.value());
+    }
+
+    if (!execTimed(q)) {
+        emit databaseError(q.lastError().text());
+        return -1;
+    }
+
+    return q.lastInsertId().toInt();
+}
+
+bool Database::updateSchedule(int id, const QVariantMap &scheduleData)
+{
+    QString query = "UPDATE schedules SET name=:name, url=:url, start_time=:start_time, rule=:rule, "
+                    "window_start=:window_start, window_end=:window_end, options=:options, active=:active, "
+                    "last_run=:last_run WHERE id=:id";
+    QVariantMap params = scheduleData;
+    params["id"] = id;
+    return executeQuery(query, params);
+}
+
+bool Database::deleteSchedules(const QList<int> &ids)
+{
+    return executeForIds("DELETE FROM schedules WHERE id IN (%1)", ids);
+}
+
+bool Database::markSchedulesRun(const QList<int> &ids, const QDateTime &runAt)
+{
+    return executeForIds("UPDATE schedules SET last_run=:last_run, active=(rule IS NOT NULL AND rule != '') "
+                         "WHERE id IN (%1)", ids, {{"last_run", runAt}});
+}
+
+QVariantList Database::getSchedules()
+{
+    return executeSelectQuery("SELECT * FROM schedules ORDER BY id");
+}
+
 bool Database::setSetting(const QString &key, const QVariant &value, const QString &type)
 {
     QString query = "INSERT OR REPLACE INTO settings (key, value, type) VALUES (:key, :value, :type)";
@@ -294,23 +449,183 @@ bool Database::insertDownloadHistory(const QVariantMap &historyData)
     QString query = "INSERT INTO download_history (download_id, url, filename, filepath, size, duration, "
                     "average_speed, category_name, success) VALUES (:download_id, :url, :filename, :filepath, "
                     ":size, :duration, :average_speed, :category_name, :success)";
-    return executeQuery(query, historyData);
+    return markChanged(HistoryTable, executeQuery(query, historyData));
 }
 
 QVariantList Database::getDownloadHistory(int limit, int offset)
+{
+    QVariantList results;
+    forEachDownloadHistory(limit, offset, [&results](const QVariantMap &row) {
+        results.append(row);
+        return true;
+    });
+    return results;
+}
+
+bool Database::forEachDownloadHistory(int limit, int offset, const RowVisitor &visit)
 {
     QString query = "SELECT * FROM download_history ORDER BY completed_at DESC LIMIT :limit OFFSET :offset";
-    return executeSelectQuery(query, {{"limit", limit}, {"offset", offset}});
+    return executeSelectQuery(query, {{"limit", limit}, {"offset", offset}}, visit);
+}
+
+QVariantList Database::getDownloadHistoryPage(const QString &beforeCompletedAt, qint64 beforeId, int limit)
+{
+    QVariantList results;
+    forEachDownloadHistoryPage(beforeCompletedAt, beforeId, limit, [&results](const QVariantMap &row) {
+        results.append(row);
+        return true;
+    });
+    return results;
+}
+
+bool Database::forEachDownloadHistoryPage(const QString &beforeCompletedAt, qint64 beforeId, int limit,
+                                          const RowVisitor &visit)
+{
+    // Row-value comparison walks idx_history_completed (completed_at, rowid) without skipping rows
+    if (beforeCompletedAt.isEmpty()) {
+        return executeSelectQuery("SELECT * FROM download_history ORDER BY completed_at DESC, id DESC LIMIT :limit",
+                                  {{"limit", limit}}, visit);
+    }
+    return executeSelectQuery("SELECT * FROM download_history WHERE (completed_at, id) < (:completed_at, :id) "
+                              "ORDER BY completed_at DESC, id DESC LIMIT :limit",
+                              {{"completed_at", beforeCompletedAt}, {"id", beforeId}, {"limit", limit}}, visit);
+}
+
+int Database::archiveDownloadHistory(int olderThanDays, const QString &archiveDir)
+{
+    if (olderThanDays < 0 || !QDir().mkpath(archiveDir)) {
+        return -1;
+    }
+
+    // completed_at is stored by CURRENT_TIMESTAMP, i.e. UTC "yyyy-MM-dd hh:mm:ss"
+    QString cutoff = QDateTime::currentDateTimeUtc().addDays(-olderThanDays).toString("yyyy-MM-dd hh:mm:ss");
+    int archived = 0;
+
+    while (true) {
+        QVariantList rows = executeSelectQuery("SELECT * FROM download_history WHERE completed_at < :cutoff "
+                                               "ORDER BY id LIMIT :limit",
+                                               {{"cutoff", cutoff}, {"limit", HISTORY_ARCHIVE_BATCH_SIZE}});
+        if (rows.isEmpty()) {
+            break;
+        }
+
+        QMap<QString, QVariantList> rowsByMonth;
+        for (const QVariant &variant : rows) {
+            QVariantMap row = variant.toMap();
+            rowsByMonth[row["completed_at"].toString().left(7)].append(row);
+        }
+
+        QVariantMap range;
+        range["first"] = rows.first().toMap().value("id");
+        range["last"] = rows.last().toMap().value("id");
+        range["cutoff"] = cutoff;
+
+        // Archive files are written before the rows are deleted, so a crash can at worst
+        // duplicate a block in the archive but never lose history. The compression and
+        // file I/O stay outside the transaction so the write lock only covers the delete
+        for (auto it = rowsByMonth.begin(); it != rowsByMonth.end(); ++it) {
+            QDate month = QDate::fromString(it.key() + "-01", "yyyy-MM-dd");
+            if (!month.isValid() || !HistoryArchive::appendRows(HistoryArchive::archivePath(archiveDir, month), it.value())) {
+                emit databaseError("Failed to write history archive for " + it.key());
+                return -1;
+            }
+        }
+
+        if (!m_database.transaction()) {
+            emit databaseError(m_database.lastError().text());
+            return -1;
+        }
+
+        bool ok = executeQuery("INSERT INTO history_daily_stats (day, downloads, successes, total_bytes, total_duration) "
+                               "SELECT date(completed_at), COUNT(*), SUM(success), SUM(size), SUM(duration) "
+                               "FROM download_history WHERE id BETWEEN :first AND :last AND completed_at < :cutoff "
+                               "GROUP BY date(completed_at) "
+                               "ON CONFLICT(day) DO UPDATE SET downloads = downloads + excluded.downloads, "
+                               "successes = successes + excluded.successes, "
+                               "total_bytes = total_bytes + excluded.total_bytes, "
+                               "total_duration = total_duration + excluded.total_duration",
+                               range)
+                  && executeQuery("DELETE FROM download_history WHERE id BETWEEN :first AND :last "
+                                  "AND completed_at < :cutoff",
+                                  range);
+
+        if (!ok || !m_database.commit()) {
+            m_database.rollback();
+            return -1;
+        }
+
+        markChanged(HistoryTable, true);
+        archived += rows.size();
+    }
+
+    if (archived > 0) {
+        incrementalVacuum();
+    }
+
+    return archived;
+}
+
+QVariantList Database::getHistoryAggregates(const QDate &from, const QDate &to)
+{
+    // Archived days come from history_daily_stats, recent days are aggregated from the live table
+    QString query = "SELECT day, SUM(downloads) AS downloads, SUM(successes) AS successes, "
+                    "SUM(total_bytes) AS total_bytes, SUM(total_duration) AS total_duration FROM ("
+                    "SELECT day, downloads, successes, total_bytes, total_duration FROM history_daily_stats "
+                    "WHERE day BETWEEN :stats_from AND :stats_to "
+                    "UNION ALL "
+                    "SELECT date(completed_at), COUNT(*), SUM(success), SUM(size), SUM(duration) FROM download_history "
+                    "WHERE completed_at >= :live_from AND completed_at < date(:live_to, '+1 day') "
+                    "GROUP BY date(completed_at)"
+                    ") GROUP BY day ORDER BY day";
+
+    QString fromDay = from.toString("yyyy-MM-dd");
+    QString toDay = to.toString("yyyy-MM-dd");
+    return executeSelectQuery(query, {{"stats_from", fromDay}, {"stats_to", toDay},
+                                      {"live_from", fromDay}, {"live_to", toDay}});
+}
+
+bool Database::incrementalVacuum(int pages)
+{
+    // Never converts here: that needs a full VACUUM, which would block every writer
+    QVariantMap mode = executeSingleRowQuery("PRAGMA auto_vacuum");
+    if (mode.value("auto_vacuum").toInt() != 2) {
+        return true;
+    }
+
+    if (pages > 0) {
+        return executeQuery(QString("PRAGMA incremental_vacuum(%1)").arg(pages));
+    }
+    return executeQuery("PRAGMA incremental_vacuum");
+}
+
+bool Database::enableIncrementalVacuum()
+{
+    QVariantMap mode = executeSingleRowQuery("PRAGMA auto_vacuum");
+    if (mode.value("auto_vacuum").toInt() == 2) {
+        return true;
+    }
+    // Switching an existing database to incremental mode needs one full VACUUM
+    return executeQuery("PRAGMA auto_vacuum = INCREMENTAL") && executeQuery("VACUUM");
+}
+
+bool Database::markChanged(Table table, bool ok)
+{
+    if (ok && m_inBatch) {
+        m_batchChanges |= 1 << table;
+    } else if (ok) {
+        m_changeCounters[table].fetch_add(1, std::memory_order_release);
+    }
+    return ok;
 }
 
 bool Database::executeQuery(const QString &query, const QVariantMap &params)
 {
-    QSqlQuery q;
+    QSqlQuery q(m_database);
     q.prepare(query);
     for (auto it = params.begin(); it != params.end(); ++it) {
         q.bindValue(":" + it.key(), it.value());
     }
-    if (!q.exec()) {
+    if (!execTimed(q)) {
         emit databaseError(q.lastError().text());
         return false;
     }
@@ -319,26 +634,65 @@ bool Database::executeQuery(const QString &query, const QVariantMap &params)
 
 QVariantList Database::executeSelectQuery(const QString &query, const QVariantMap &params)
 {
-    QSqlQuery q;
+    QVariantList results;
+    executeSelectQuery(query, params, [&results](const QVariantMap &row) {
+        results.append(row);
+        return true;
+    });
+    return results;
+}
+
+bool Database::executeSelectQuery(const QString &query, const QVariantMap &params, const RowVisitor &visit)
+{
+    QSqlQuery q(m_database);
+    q.setForwardOnly(true);
     q.prepare(query);
     for (auto it = params.begin(); it != params.end(); ++it) {
         q.bindValue(":" + it.key(), it.value());
     }
-    if (!q.exec()) {
+    if (!execTimed(q)) {
         emit databaseError(q.lastError().text());
-        return QVariantList();
+        return false;
     }
 
-    QVariantList results;
+    QSqlRecord record = q.record();
     while (q.next()) {
         QVariantMap row;
-        QSqlRecord record = q.record();
         for (int i = 0; i < record.count(); ++i) {
             row[record.fieldName(i)] = q.value(i);
         }
-        results.append(row);
+        if (!visit(row)) {
+            break;
+        }
     }
-    return results;
+    return true;
+}
+
+bool Database::executeForIds(const QString &query, const QList<int> &ids, const QVariantMap &params)
+{
+    // One transaction and one statement per chunk instead of one per id
+    bool ownTransaction = !m_inBatch;
+    bool ok = !ownTransaction || m_database.transaction();
+    for (int first = 0; ok && first < ids.size(); first += ID_LIST_CHUNK_SIZE) {
+        QStringList placeholders;
+        QVariantMap chunkParams = params;
+        int last = qMin(first + ID_LIST_CHUNK_SIZE, int(ids.size()));
+        for (int i = first; i < last; ++i) {
+            QString name = QString("id%1").arg(i - first);
+            placeholders.append(":" + name);
+            chunkParams[name] = ids.at(i);
+        }
+        ok = executeQuery(query.arg(placeholders.join(',')), chunkParams);
+    }
+
+    if (!ownTransaction) {
+        return ok;
+    }
+    if (!ok) {
+        m_database.rollback();
+        return false;
+    }
+    return m_database.commit();
 }
 
 QVariantMap Database::executeSingleRowQuery(const QString &query, const QVariantMap &params)
@@ -7,18 +7,30 @@
 #include <QVariantList>
 #include <QSqlRecord>
 #include <QSqlQuery>
+#include <QDate>
+#include <QDateTime>
+#include <QPointer>
+#include <QThread>
+#include <atomic>
+#include <functional>
 
 class Database : public QObject
 {
     Q_OBJECT
 
 public:
+    // Called once per row as the cursor advances; return false to stop early
+    using RowVisitor = std::function<bool(const QVariantMap &row)>;
+
     explicit Database(QObject *parent = nullptr);
     ~Database();
 
-    bool open(const QString &databasePath);
+    bool open(const QString &databasePath, const QString &connectionName = QString());
+    // Read-only handle on an existing file for another thread; no pragmas or migrations
+    bool openReader(const QString &databasePath, const QString &connectionName);
     void close();
     bool isOpen() const;
+    QString databasePath() const { return m_database.databaseName(); }
 
     // Download operations
     int insertDownload(const QVariantMap &downloadData);
@@ -26,7 +38,20 @@ public:
     bool deleteDownload(int id);
     QVariantMap getDownload(int id);
     QVariantList getDownloads(const QString &status = QString());
+    bool forEachDownload(const QString &status, const RowVisitor &visit);
     QVariantList getDownloadsByCategory(int categoryId);
+    // Keyset paging by descending id; beforeId <= 0 returns the newest page
+    QVariantList getDownloadsPage(int beforeId = 0, int limit = 100);
+    bool updateDownloadState(int id, const QString &status, qint64 downloadedSize, qint64 totalSize);
+    // One prepared statement for all rows; returns the new id per row, -1 where the row failed
+    QList<int> insertDownloads(const QVariantList &downloads);
+
+    // Writes issued between beginBatch() and commitBatch() share one transaction.
+    // Batches do not nest; multi-row helpers open their own transaction outside one.
+    bool beginBatch();
+    bool commitBatch();
+    void rollbackBatch();
+    bool inBatch() const { return m_inBatch; }
 
     // Category operations
     bool insertCategory(const QVariantMap &categoryData);
@@ -35,6 +60,13 @@ public:
     QVariantMap getCategory(int id);
     QVariantList getCategories();
 
+    // Schedule operations
+    int insertSchedule(const QVariantMap &scheduleData);
+    bool updateSchedule(int id, const QVariantMap &scheduleData);
+    bool deleteSchedules(const QList<int> &ids);
+    bool markSchedulesRun(const QList<int> &ids, const QDateTime &runAt);
+    QVariantList getSchedules();
+
     // Settings operations
     bool setSetting(const QString &key, const QVariant &value, const QString &type = "string");
     QVariant getSetting(const QString &key);
@@ -43,18 +75,52 @@ public:
     // History operations
     bool insertDownloadHistory(const QVariantMap &historyData);
     QVariantList getDownloadHistory(int limit = 100, int offset = 0);
+    bool forEachDownloadHistory(int limit, int offset, const RowVisitor &visit);
+    // Keyset paging: rows strictly older than (beforeCompletedAt, beforeId); empty cursor = first page
+    QVariantList getDownloadHistoryPage(const QString &beforeCompletedAt = QString(), qint64 beforeId = 0, int limit = 100);
+    bool forEachDownloadHistoryPage(const QString &beforeCompletedAt, qint64 beforeId, int limit, const RowVisitor &visit);
+
+    // History archival and compaction
+    int archiveDownloadHistory(int olderThanDays, const QString &archiveDir);
+    QVariantList getHistoryAggregates(const QDate &from, const QDate &to);
+    // Releases free pages; a no-op until the file is in incremental auto-vacuum mode
+    bool incrementalVacuum(int pages = 0);
+    // Maintenance step: rewrites the whole file (blocking VACUUM) to enable incremental mode
+    bool enableIncrementalVacuum();
 
     // Initialization
     bool createTables();
+    int schemaVersion();
+    bool hasPendingMigrations();
+    // Runs deferred (online) migrations on a worker thread with its own connection
+    bool startOnlineMigrations();
+
+    // Highest version in SchemaMigrator::defaultMigrations()
+    static int latestSchemaVersion();
+
+    // Per-table write counters, bumped once a successful write through this object
+    // is committed; readers compare them to tell whether a cached result is still current
+    enum Table { DownloadsTable, CategoriesTable, HistoryTable, TableCount };
+    quint64 changeCounter(Table table) const { return m_changeCounters[table].load(std::memory_order_acquire); }
 
 signals:
     void databaseError(const QString &error);
+    void migrationProgress(int version, qint64 rowsDone, qint64 rowsTotal);
+    void migrationsFinished(bool success);
 
 private:
     QSqlDatabase m_database;
+    QPointer<QThread> m_migrationThread;
+    std::atomic<quint64> m_changeCounters[TableCount] = {};
+    bool m_inBatch = false;
+    int m_batchChanges = 0;                 // tables written inside the open batch, as bits
+    bool markChanged(Table table, bool ok);
     bool executeQuery(const QString &query, const QVariantMap &params = QVariantMap());
     QVariantList executeSelectQuery(const QString &query, const QVariantMap &params = QVariantMap());
+    // Forward-only, so rows are not retained by the driver as the cursor moves
+    bool executeSelectQuery(const QString &query, const QVariantMap &params, const RowVisitor &visit);
     QVariantMap executeSingleRowQuery(const QString &query, const QVariantMap &params = QVariantMap());
+    bool executeForIds(const QString &query, const QList<int> &ids, const QVariantMap &params = QVariantMap());
 };
 
 #endif // DATABASE_H
\ No newline at end of file
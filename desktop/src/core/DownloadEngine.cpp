@@ -1,12 +1,44 @@
 #include "DownloadEngine.h"
 #include <QDebug>
 #include <QDir>
+#include <QMimeDatabase>
+#include "PartialFileDevice.h"
+#include "utils/Metrics.h"
+
+namespace {
+
+struct EngineMetrics {
+    Metrics::Counter *started;
+    Metrics::Counter *completed;
+    Metrics::Counter *failed;
+    Metrics::Counter *cancelled;
+    Metrics::Gauge *running;
+
+    EngineMetrics() {
+        Metrics &metrics = Metrics::instance();
+        started = metrics.counter("ldm_downloads_started_total", "Downloads handed to the engine");
+        completed = metrics.counter("ldm_downloads_completed_total", "Downloads that finished successfully");
+        failed = metrics.counter("ldm_downloads_failed_total", "Downloads that failed");
+        cancelled = metrics.counter("ldm_downloads_cancelled_total", "Downloads cancelled while running");
+        running = metrics.gauge("ldm_downloads_running", "Downloads currently transferring");
+    }
+};
+
+EngineMetrics &engineMetrics()
+{
+    static EngineMetrics metrics;
+    return metrics;
+}
+
+}
 
 DownloadEngine::DownloadEngine(QObject *parent)
     : QObject(parent)
     , m_threadPool(new QThreadPool(this))
     , m_maxConcurrentDownloads(3)
     , m_maxSegmentsPerDownload(4) // Increased for better parallel processing
+    , m_maxConnectionsPerHost(8)
+    , m_sequentialMediaDownloads(true)
 {
     m_threadPool->setMaxThreadCount(m_maxConcurrentDownloads);
 }
@@ -22,13 +54,14 @@ bool DownloadEngine::startDownload(DownloadItem *item)
         return false;
     }
 
-    // Create segment manager for this download
+    // Create segment manager for this download, within the origin's connection budget
     SegmentManager *segmentManager = new SegmentManager(
         QUrl(item->getUrl()),
         item->getFilepath(),
-        m_maxSegmentsPerDownload,
+        reserveConnections(item),
         this
     );
+    segmentManager->setSequentialLayout(m_sequentialMediaDownloads && isStreamableMedia(item->getFilepath()));
 
     // Connect signals
     connect(segmentManager, &SegmentManager::segmentProgress,
@@ -39,15 +72,24 @@ bool DownloadEngine::startDownload(DownloadItem *item)
             this, &DownloadEngine::onSegmentFailed);
     connect(segmentManager, &SegmentManager::allSegmentsCompleted,
             [this, item]() {
+                releaseConnections(item->getId());
+                markFinished(item->getId());
+                engineMetrics().completed->increment();
                 emit downloadCompleted(item->getId());
             });
     connect(segmentManager, &SegmentManager::downloadFailed,
             [this, item](const QString &error) {
+                releaseConnections(item->getId());
+                markFinished(item->getId());
+                engineMetrics().failed->increment();
                 emit downloadFailed(item->getId(), error);
             });
 
     m_downloads[item->getId()] = item;
     m_segmentManagers[item->getId()] = segmentManager;
+    m_running.insert(item->getId());
+    engineMetrics().started->increment();
+    engineMetrics().running->add(1);
 
     // Use Qt Concurrent for asynchronous download start
     QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
@@ -100,12 +142,23 @@ void DownloadEngine::cancelDownload(int downloadId)
     }
 
     if (m_segmentManagers.contains(downloadId)) {
+        if (m_running.contains(downloadId)) {
+            engineMetrics().cancelled->increment();
+        }
         m_segmentManagers[downloadId]->cancelDownload();
         cleanupDownload(downloadId);
         emit downloadCancelled(downloadId);
     }
 }
 
+void DownloadEngine::releaseDownload(int downloadId)
+{
+    if (m_running.contains(downloadId) || m_downloadWatchers.contains(downloadId)) {
+        return;
+    }
+    cleanupDownload(downloadId);
+}
+
 void DownloadEngine::stopAllDownloads()
 {
     // Cancel all concurrent operations first
@@ -122,6 +175,10 @@ void DownloadEngine::stopAllDownloads()
     m_downloads.clear();
     m_segmentManagers.clear();
     m_networkManagers.clear();
+    m_hostConnections.clear();
+    m_downloadConnections.clear();
+    engineMetrics().running->add(-m_running.size());
+    m_running.clear();
 }
 
 void DownloadEngine::setMaxConcurrentDownloads(int max)
@@ -145,6 +202,31 @@ int DownloadEngine::getMaxSegmentsPerDownload() const
     return m_maxSegmentsPerDownload;
 }
 
+void DownloadEngine::setMaxConnectionsPerHost(int max)
+{
+    m_maxConnectionsPerHost = max;
+}
+
+int DownloadEngine::getMaxConnectionsPerHost() const
+{
+    return m_maxConnectionsPerHost;
+}
+
+int DownloadEngine::connectionsForHost(const QString &origin) const
+{
+    return m_hostConnections.value(origin, 0);
+}
+
+void DownloadEngine::setSequentialMediaDownloads(bool enabled)
+{
+    m_sequentialMediaDownloads = enabled;
+}
+
+bool DownloadEngine::sequentialMediaDownloads() const
+{
+    return m_sequentialMediaDownloads;
+}
+
 QList<DownloadItem*> DownloadEngine::getActiveDownloads() const
 {
     return m_downloads.values();
@@ -160,6 +242,32 @@ bool DownloadEngine::isDownloading(int id) const
     return m_segmentManagers.contains(id) && !m_segmentManagers[id]->isCompleted();
 }
 
+SegmentManager* DownloadEngine::getSegmentManager(int id) const
+{
+    return m_segmentManagers.value(id, nullptr);
+}
+
+QIODevice* DownloadEngine::openPreviewDevice(int id, QObject *parent)
+{
+    SegmentManager *segmentManager = m_segmentManagers.value(id, nullptr);
+    if (!segmentManager) {
+        return nullptr;
+    }
+
+    PartialFileDevice *device = new PartialFileDevice(segmentManager->rangeAvailability(), parent);
+    if (!device->open(QIODevice::ReadOnly)) {
+        delete device;
+        return nullptr;
+    }
+
+    // Sequential scheduling only while someone is actually watching
+    segmentManager->attachPreviewReader();
+    connect(device, &QObject::destroyed, segmentManager, [segmentManager]() {
+        segmentManager->detachPreviewReader();
+    });
+    return device;
+}
+
 void DownloadEngine::onSegmentProgress(int segmentIndex, qint64 bytesReceived, qint64 bytesTotal)
 {
     // Find which download this belongs to
@@ -170,6 +278,7 @@ void DownloadEngine::onSegmentProgress(int segmentIndex, qint64 bytesReceived, q
 
     for (auto it = m_segmentManagers.begin(); it != m_segmentManagers.end(); ++it) {
         if (it.value() == sender) {
+            emit segmentProgress(it.key(), segmentIndex, bytesReceived, bytesTotal);
             emit downloadProgress(it.key(), bytesReceived, bytesTotal);
             break;
         }
@@ -192,11 +301,49 @@ void DownloadEngine::cleanupDownload(int downloadId)
         delete m_segmentManagers[downloadId];
         m_segmentManagers.remove(downloadId);
     }
+    releaseConnections(downloadId);
+    markFinished(downloadId);
     m_downloads.remove(downloadId);
     m_networkManagers.remove(downloadId);
     m_downloadWatchers.remove(downloadId);
 }
 
+int DownloadEngine::reserveConnections(DownloadItem *item)
+{
+    QString origin = item->getOrigin();
+    int segments = m_maxSegmentsPerDownload;
+    if (m_maxConnectionsPerHost > 0) {
+        // A download always gets one connection; the queue's per-host limit bounds how many start
+        int remaining = m_maxConnectionsPerHost - m_hostConnections.value(origin, 0);
+        segments = qBound(1, remaining, m_maxSegmentsPerDownload);
+    }
+
+    m_hostConnections[origin] += segments;
+    m_downloadConnections.insert(item->getId(), qMakePair(origin, segments));
+    return segments;
+}
+
+void DownloadEngine::markFinished(int downloadId)
+{
+    if (m_running.remove(downloadId)) {
+        engineMetrics().running->add(-1);
+    }
+}
+
+void DownloadEngine::releaseConnections(int downloadId)
+{
+    auto reserved = m_downloadConnections.find(downloadId);
+    if (reserved == m_downloadConnections.end()) {
+        return;
+    }
+
+    auto host = m_hostConnections.find(reserved->first);
+    if (host != m_hostConnections.end() && (*host -= reserved->second) <= 0) {
+        m_hostConnections.erase(host);
+    }
+    m_downloadConnections.erase(reserved);
+}
+
 void DownloadEngine::startDownloadSegments(DownloadItem *item)
 {
     // For basic implementation, handled in startDownload
@@ -205,4 +352,10 @@ void DownloadEngine::startDownloadSegments(DownloadItem *item)
 void DownloadEngine::updateDownloadProgress(int downloadId)
 {
     // For basic implementation, progress is updated via signals
+}
+
+bool DownloadEngine::isStreamableMedia(const QString &filepath)
+{
+    QString mimeType = QMimeDatabase().mimeTypeForFile(filepath, QMimeDatabase::MatchExtension).name();
+    return mimeType.startsWith("video/") || mimeType.startsWith("audio/");
 }
\ No newline at end of file
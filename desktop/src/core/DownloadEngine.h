@@ -10,6 +10,7 @@
 #include <QtConcurrent/QtConcurrent>
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QSet>
 #include "DownloadItem.h"
 #include "NetworkManager.h"
 #include "SegmentManager.h"
@@ -27,6 +28,9 @@ public:
     void pauseDownload(int downloadId);
     void resumeDownload(int downloadId);
     void cancelDownload(int downloadId);
+    // Drops a finished or failed download's segment manager and item pointer
+    // without signalling; running downloads are left alone
+    void releaseDownload(int downloadId);
     void stopAllDownloads();
 
     // Configuration
@@ -34,14 +38,28 @@ public:
     void setMaxSegmentsPerDownload(int max);
     int getMaxConcurrentDownloads() const;
     int getMaxSegmentsPerDownload() const;
+    // Total segments open to one origin across its downloads; 0 means unlimited
+    void setMaxConnectionsPerHost(int max);
+    int getMaxConnectionsPerHost() const;
+    int connectionsForHost(const QString &origin) const;
+    // New audio/video downloads are laid out so they can be previewed; they are
+    // fetched head first only while a preview device is open
+    void setSequentialMediaDownloads(bool enabled);
+    bool sequentialMediaDownloads() const;
 
     // Status
     QList<DownloadItem*> getActiveDownloads() const;
     DownloadItem* getDownload(int id) const;
     bool isDownloading(int id) const;
+    // For UI views that read per-segment stats; null when the download has no segments
+    SegmentManager* getSegmentManager(int id) const;
+    // Blocking reader over the bytes downloaded so far; null for unknown ids
+    QIODevice* openPreviewDevice(int id, QObject *parent = nullptr);
 
 signals:
     void downloadStarted(int downloadId);
+    // Counters of the one segment that moved; downloadProgress carries the same values
+    void segmentProgress(int downloadId, int segmentIndex, qint64 bytesReceived, qint64 bytesTotal);
     void downloadProgress(int downloadId, qint64 bytesReceived, qint64 bytesTotal);
     void downloadCompleted(int downloadId);
     void downloadFailed(int downloadId, const QString &error);
@@ -64,10 +82,19 @@ private:
     QWaitCondition m_waitCondition;
     int m_maxConcurrentDownloads;
     int m_maxSegmentsPerDownload;
+    int m_maxConnectionsPerHost;
+    bool m_sequentialMediaDownloads;
+    QHash<QString, int> m_hostConnections;
+    QHash<int, QPair<QString, int>> m_downloadConnections;   // id -> (origin, segments)
+    QSet<int> m_running;                                     // started and not yet finished
 
     void cleanupDownload(int downloadId);
+    int reserveConnections(DownloadItem *item);
+    void releaseConnections(int downloadId);
+    void markFinished(int downloadId);
     void startDownloadSegments(DownloadItem *item);
     void updateDownloadProgress(int downloadId);
+    static bool isStreamableMedia(const QString &filepath);
 };
 
 #endif // DOWNLOADENGINE_H
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "DownloadItem.h"
+#include <QUrl>
 
 DownloadItem::DownloadItem(QObject *parent)
     : QObject(parent)
@@ -37,6 +38,13 @@ DownloadItem::DownloadItem(int id, const QString &url, const QString &filename,
     m_createdAt = QDateTime::currentDateTime();
 }
 
+QString DownloadItem::getOrigin() const
+{
+    QUrl url(m_url);
+    return QString("%1://%2:%3").arg(url.scheme().toLower(), url.host().toLower())
+        .arg(url.port(url.scheme().compare("https", Qt::CaseInsensitive) == 0 ? 443 : 80));
+}
+
 double DownloadItem::getProgress() const
 {
     if (m_totalSize <= 0) {
@@ -43,6 +43,8 @@ public:
     QString getAntivirusResult() const { return m_antivirusResult; }
     bool getEncrypted() const { return m_encrypted; }
     QString getMetadata() const { return m_metadata; }
+    // scheme://host:port of the URL, used to group downloads per server
+    QString getOrigin() const;
 
     // Setters
     void setId(int id) { m_id = id; }
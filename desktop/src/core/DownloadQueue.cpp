@@ -1,93 +1,123 @@
 #include "DownloadQueue.h"
+#include "SpeedCalculator.h"
+#include "utils/Metrics.h"
 #include <QDebug>
 #include <algorithm>
 
+static Metrics::Gauge *queueDepthGauge()
+{
+    static Metrics::Gauge *gauge = Metrics::instance().gauge("ldm_queue_depth", "Downloads waiting in the queue");
+    return gauge;
+}
+
 DownloadQueue::DownloadQueue(QObject *parent)
     : QObject(parent)
+    , m_roundRobinCursor(0)
+    , m_nextSequence(0)
     , m_maxConcurrentDownloads(3)
+    , m_maxDownloadsPerHost(DEFAULT_DOWNLOADS_PER_HOST)
     , m_bandwidthLimit(0) // 0 means no limit
     , m_queueTimer(new QTimer(this))
+    , m_throughputMeter(nullptr)
+    , m_windowStartMs(0)
+    , m_windowStartBytes(0)
+    , m_lastWindowRate(0.0)
+    , m_probeBaseline(0.0)
+    , m_probeActiveCount(0)
+    , m_admittedDownloads(0)
+    , m_saturatedUntilMs(0)
+    , m_probeIntervalMs(DEFAULT_PROBE_INTERVAL_MS)
 {
+    m_admissionClock.start();
     m_queueTimer->setSingleShot(true);
-    connect(m_queueTimer, &QTimer::timeout, this, &DownloadQueue::checkQueue);
+    connect(m_queueTimer, &QTimer::timeout, this, &DownloadQueue::evaluateAdmission);
 }
 
 DownloadQueue::~DownloadQueue()
 {
+    queueDepthGauge()->add(-m_queueIndex.size());
 }
 
 void DownloadQueue::addDownload(DownloadItem *item)
 {
-    if (!item) {
+    if (!watchAndEnqueue(item)) {
         return;
     }
 
-    // Connect signals
-    connect(item, &DownloadItem::downloadCompleted, this, &DownloadQueue::onDownloadCompleted);
-    connect(item, &DownloadItem::statusChanged, this, [this, item](const QString &status) {
-        if (status == "failed") {
-            onDownloadFailed(item, item->getErrorMessage());
-        }
-    });
+    checkQueue();
+    emit queueUpdated();
+}
+
+void DownloadQueue::addDownloads(const QList<DownloadItem*> &items)
+{
+    bool added = false;
+    for (DownloadItem *item : items) {
+        added |= watchAndEnqueue(item);
+    }
+    if (!added) {
+        return;
+    }
 
-    m_queue.append(item);
-    sortQueueByPriority();
     checkQueue();
     emit queueUpdated();
 }
 
+bool DownloadQueue::watchAndEnqueue(DownloadItem *item)
+{
+    if (!item || m_queueIndex.contains(item->getId()) || m_activeIndex.contains(item->getId())) {
+        return false;
+    }
+
+    // Connect signals; an item that comes back after a pause is not connected twice.
+    // Failures arrive through finishDownload() from the service, never from the item.
+    disconnect(item, nullptr, this, nullptr);
+    connect(item, &DownloadItem::downloadCompleted, this, &DownloadQueue::onDownloadCompleted);
+
+    enqueue(item);
+    return true;
+}
+
 void DownloadQueue::removeDownload(int id)
 {
-    // Remove from queue
-    for (int i = 0; i < m_queue.size(); ++i) {
-        if (m_queue[i]->getId() == id) {
-            m_queue.removeAt(i);
-            emit queueUpdated();
-            return;
-        }
+    if (takeQueued(id)) {
+        emit queueUpdated();
+        return;
     }
 
-    // Remove from active
-    for (int i = 0; i < m_activeDownloads.size(); ++i) {
-        if (m_activeDownloads[i]->getId() == id) {
-            m_activeDownloads[i]->setStatus("cancelled");
-            m_activeDownloads.removeAt(i);
-            checkQueue();
-            emit queueUpdated();
-            return;
-        }
+    if (DownloadItem *item = takeActive(id)) {
+        item->setStatus("cancelled");
+        checkQueue();
+        emit queueUpdated();
     }
 }
 
 void DownloadQueue::pauseDownload(int id)
 {
-    for (auto *item : m_activeDownloads) {
-        if (item->getId() == id) {
-            item->setStatus("paused");
-            m_activeDownloads.removeOne(item);
-            m_queue.append(item);
-            sortQueueByPriority();
-            checkQueue();
-            emit queueUpdated();
-            return;
-        }
+    DownloadItem *item = takeActive(id);
+    if (!item) {
+        return;
     }
+
+    item->setStatus("paused");
+    enqueue(item);
+    checkQueue();
+    emit queueUpdated();
 }
 
 void DownloadQueue::resumeDownload(int id)
 {
-    for (auto *item : m_queue) {
-        if (item->getId() == id) {
-            if (canStartDownload()) {
-                m_queue.removeOne(item);
-                m_activeDownloads.append(item);
-                item->setStatus("downloading");
-                emit downloadStarted(item);
-                emit queueUpdated();
-            }
-            return;
-        }
+    auto entry = m_queueIndex.constFind(id);
+    if (entry == m_queueIndex.constEnd() || !canStartDownload()) {
+        return;
+    }
+
+    DownloadItem *item = m_hosts.constFind(entry->origin)->queue.at(entry->key);
+    if (!canStartItem(item, entry->origin)) {
+        return;
     }
+
+    startItem(takeQueued(id));
+    emit queueUpdated();
 }
 
 void DownloadQueue::cancelDownload(int id)
@@ -95,6 +125,25 @@ void DownloadQueue::cancelDownload(int id)
     removeDownload(id);
 }
 
+bool DownloadQueue::setPriority(int id, int priority)
+{
+    DownloadItem *item = takeQueued(id);
+    if (!item) {
+        auto active = m_activeIndex.constFind(id);
+        if (active != m_activeIndex.constEnd()) {
+            active->item->setPriority(priority);
+            return true;
+        }
+        return false;
+    }
+
+    item->setPriority(priority);
+    enqueue(item);
+    checkQueue();
+    emit queueUpdated();
+    return true;
+}
+
 void DownloadQueue::setMaxConcurrentDownloads(int max)
 {
     m_maxConcurrentDownloads = max;
@@ -106,6 +155,58 @@ int DownloadQueue::getMaxConcurrentDownloads() const
     return m_maxConcurrentDownloads;
 }
 
+void DownloadQueue::setMaxDownloadsPerHost(int max)
+{
+    m_maxDownloadsPerHost = max;
+    checkQueue();
+}
+
+int DownloadQueue::getMaxDownloadsPerHost() const
+{
+    return m_maxDownloadsPerHost;
+}
+
+void DownloadQueue::setHostLimit(const QString &origin, int max)
+{
+    if (max < 0) {
+        m_hostLimits.remove(origin);
+    } else {
+        m_hostLimits.insert(origin, max);
+    }
+    checkQueue();
+}
+
+void DownloadQueue::setCategoryLimit(int categoryId, int max)
+{
+    if (max <= 0) {
+        m_categoryLimits.remove(categoryId);
+    } else {
+        m_categoryLimits.insert(categoryId, max);
+    }
+    checkQueue();
+}
+
+void DownloadQueue::setThroughputMeter(SpeedCalculator *meter)
+{
+    m_throughputMeter = meter;
+    m_probeActiveCount = 0;
+    m_admittedDownloads = m_activeDownloads.size();
+    m_saturatedUntilMs = 0;
+    m_queueTimer->stop();
+    restartWindow();
+    checkQueue();
+}
+
+void DownloadQueue::setAdmissionProbeInterval(int msecs)
+{
+    m_probeIntervalMs = qMax(1, msecs);
+}
+
+int DownloadQueue::admittedDownloads() const
+{
+    return m_admittedDownloads;
+}
+
 void DownloadQueue::setBandwidthLimit(qint64 bytesPerSecond)
 {
     m_bandwidthLimit = bytesPerSecond;
@@ -124,28 +225,44 @@ QList<DownloadItem*> DownloadQueue::getActiveDownloads() const
 
 QList<DownloadItem*> DownloadQueue::getQueuedDownloads() const
 {
-    return m_queue;
+    std::vector<std::pair<QueueKey, DownloadItem*>> entries;
+    entries.reserve(m_queueIndex.size());
+    for (const HostBucket &bucket : m_hosts) {
+        entries.insert(entries.end(), bucket.queue.begin(), bucket.queue.end());
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    QList<DownloadItem*> queued;
+    queued.reserve(int(entries.size()));
+    for (const auto &entry : entries) {
+        queued.append(entry.second);
+    }
+    return queued;
 }
 
-void DownloadQueue::onDownloadCompleted()
+int DownloadQueue::queuedCount() const
 {
-    DownloadItem *item = qobject_cast<DownloadItem*>(sender());
-    if (item) {
-        m_activeDownloads.removeOne(item);
-        emit downloadCompleted(item);
-        checkQueue();
-        emit queueUpdated();
-    }
+    return m_queueIndex.size();
+}
+
+bool DownloadQueue::isQueued(int id) const
+{
+    return m_queueIndex.contains(id);
+}
+
+int DownloadQueue::activeCountForHost(const QString &origin) const
+{
+    auto bucket = m_hosts.constFind(origin);
+    return bucket == m_hosts.constEnd() ? 0 : bucket->active;
 }
 
-void DownloadQueue::onDownloadFailed(const QString &error)
+void DownloadQueue::onDownloadCompleted()
 {
     DownloadItem *item = qobject_cast<DownloadItem*>(sender());
     if (item) {
-        m_activeDownloads.removeOne(item);
-        emit downloadFailed(item, error);
-        checkQueue();
-        emit queueUpdated();
+        finishDownload(item->getId(), true);
     }
 }
 
@@ -154,24 +271,238 @@ void DownloadQueue::checkQueue()
     startNextDownloads();
 }
 
-void DownloadQueue::sortQueueByPriority()
+void DownloadQueue::evaluateAdmission()
 {
-    std::sort(m_queue.begin(), m_queue.end(), [](DownloadItem *a, DownloadItem *b) {
-        return a->getPriority() > b->getPriority(); // Higher priority first
-    });
+    if (m_probeActiveCount == 0) {
+        return;
+    }
+
+    double rate = windowRate();
+    int active = m_activeDownloads.size();
+    if (active < m_probeActiveCount) {
+        // A transfer ended during the window, so the sample says nothing about the probe
+        m_admittedDownloads = qMin(m_admittedDownloads, active);
+    } else if (rate <= 0.0) {
+        // Nothing arrived (stalled or still connecting): inconclusive, so hold the
+        // current level and keep the last real rate instead of ramping up
+        m_saturatedUntilMs = m_admissionClock.elapsed() + REPROBE_INTERVAL_MS;
+    } else if (rate >= m_probeBaseline * (1.0 + PROBE_MIN_GAIN)) {
+        m_admittedDownloads = active;
+    } else {
+        // Link saturated: hold below the probe and let the running transfers finish
+        m_admittedDownloads = qMax(1, m_probeActiveCount - 1);
+        m_saturatedUntilMs = m_admissionClock.elapsed() + REPROBE_INTERVAL_MS;
+    }
+
+    m_probeActiveCount = 0;
+    if (rate > 0.0) {
+        m_lastWindowRate = rate;
+    }
+    restartWindow();
+    checkQueue();
+}
+
+void DownloadQueue::enqueue(DownloadItem *item)
+{
+    QueuedEntry entry{QueueKey{item->getPriority(), m_nextSequence++}, item->getOrigin()};
+    HostBucket &bucket = m_hosts[entry.origin];
+    if (bucket.queue.empty()) {
+        m_roundRobin.append(entry.origin);
+    }
+    bucket.queue.emplace(entry.key, item);
+    m_queueIndex.insert(item->getId(), entry);
+    queueDepthGauge()->add(1);
+}
+
+DownloadItem *DownloadQueue::takeQueued(int id)
+{
+    auto index = m_queueIndex.find(id);
+    if (index == m_queueIndex.end()) {
+        return nullptr;
+    }
+
+    const QString origin = index->origin;
+    HostBucket &bucket = m_hosts[origin];
+    auto entry = bucket.queue.find(index->key);
+    DownloadItem *item = entry->second;
+    bucket.queue.erase(entry);
+    m_queueIndex.erase(index);
+    queueDepthGauge()->add(-1);
+
+    if (bucket.queue.empty()) {
+        // An origin with nothing waiting leaves the rotation and forfeits its deficit
+        bucket.deficit = 0;
+        int position = m_roundRobin.indexOf(origin);
+        m_roundRobin.removeAt(position);
+        if (position < m_roundRobinCursor) {
+            --m_roundRobinCursor;
+        }
+        if (m_roundRobinCursor >= m_roundRobin.size()) {
+            m_roundRobinCursor = 0;
+        }
+        if (bucket.active == 0) {
+            m_hosts.remove(origin);
+        }
+    }
+    return item;
+}
+
+DownloadItem *DownloadQueue::takeActive(int id)
+{
+    auto active = m_activeIndex.find(id);
+    if (active == m_activeIndex.end()) {
+        return nullptr;
+    }
+
+    ActiveEntry entry = active.value();
+    m_activeIndex.erase(active);
+    // Bounded by the concurrency limit, so this scan stays short
+    m_activeDownloads.removeOne(entry.item);
+
+    auto bucket = m_hosts.find(entry.origin);
+    if (bucket != m_hosts.end() && --bucket->active == 0 && bucket->queue.empty()) {
+        m_hosts.erase(bucket);
+    }
+    if (--m_categoryActive[entry.categoryId] <= 0) {
+        m_categoryActive.remove(entry.categoryId);
+    }
+    return entry.item;
+}
+
+void DownloadQueue::startItem(DownloadItem *item)
+{
+    ActiveEntry entry{item, item->getOrigin(), item->getCategoryId()};
+    m_activeDownloads.append(item);
+    m_activeIndex.insert(item->getId(), entry);
+    ++m_hosts[entry.origin].active;
+    ++m_categoryActive[entry.categoryId];
+
+    item->setStatus("downloading");
+    emit downloadStarted(item);
+}
+
+void DownloadQueue::finishDownload(int id, bool success, const QString &error)
+{
+    DownloadItem *item = takeActive(id);
+    if (!item) {
+        return;
+    }
+
+    if (success) {
+        emit downloadCompleted(item);
+    } else {
+        emit downloadFailed(item, error);
+    }
+    checkQueue();
+    emit queueUpdated();
 }
 
 void DownloadQueue::startNextDownloads()
 {
-    while (!m_queue.isEmpty() && canStartDownload()) {
-        DownloadItem *item = m_queue.takeFirst();
-        m_activeDownloads.append(item);
-        item->setStatus("downloading");
-        emit downloadStarted(item);
+    while (canStartDownload() && !m_roundRobin.isEmpty() && admissionAllows()) {
+        // Only origins able to start their next download compete, and only
+        // those whose next download has the highest waiting priority
+        bool found = false;
+        int topPriority = 0;
+        for (const QString &origin : std::as_const(m_roundRobin)) {
+            const auto &head = *m_hosts[origin].queue.begin();
+            if (canStartItem(head.second, origin) && (!found || head.first.priority > topPriority)) {
+                topPriority = head.first.priority;
+                found = true;
+            }
+        }
+        if (!found) {
+            break;
+        }
+
+        // Deficit round-robin: each visit tops an origin's deficit up by one
+        // quantum when it cannot cover the next download, starts at most one
+        // download, then moves on. Costlier downloads wait proportionally longer.
+        for (;;) {
+            const QString origin = m_roundRobin.at(m_roundRobinCursor);
+            m_roundRobinCursor = (m_roundRobinCursor + 1) % m_roundRobin.size();
+
+            HostBucket &bucket = m_hosts[origin];
+            DownloadItem *head = bucket.queue.begin()->second;
+            if (bucket.queue.begin()->first.priority != topPriority || !canStartItem(head, origin)) {
+                continue;
+            }
+
+            int cost = connectionCost(head);
+            if (bucket.deficit < cost) {
+                bucket.deficit += ROUND_ROBIN_QUANTUM;
+            }
+            if (bucket.deficit >= cost) {
+                bucket.deficit -= cost;
+                startItem(takeQueued(head->getId()));
+                if (m_throughputMeter && m_activeDownloads.size() > m_admittedDownloads) {
+                    beginProbe();
+                }
+                break;
+            }
+        }
     }
 }
 
 bool DownloadQueue::canStartDownload() const
 {
     return m_activeDownloads.size() < m_maxConcurrentDownloads;
+}
+
+bool DownloadQueue::admissionAllows() const
+{
+    if (!m_throughputMeter || m_activeDownloads.size() < m_admittedDownloads) {
+        return true;            // no meter, or refilling up to the proven level
+    }
+    if (m_probeActiveCount > 0 || m_admissionClock.elapsed() < m_saturatedUntilMs) {
+        return false;
+    }
+    return m_bandwidthLimit <= 0 || m_lastWindowRate < m_bandwidthLimit * BANDWIDTH_LIMIT_HEADROOM;
+}
+
+void DownloadQueue::beginProbe()
+{
+    // The last full window is the baseline, or the current one if it has run that long
+    bool windowComplete = m_admissionClock.elapsed() - m_windowStartMs >= m_probeIntervalMs;
+    double baseline = windowComplete ? windowRate() : m_lastWindowRate;
+    m_probeBaseline = m_activeDownloads.size() > 1 ? baseline : 0.0;
+    m_probeActiveCount = m_activeDownloads.size();
+    restartWindow();
+    m_queueTimer->start(m_probeIntervalMs);
+}
+
+double DownloadQueue::windowRate() const
+{
+    qint64 elapsed = m_admissionClock.elapsed() - m_windowStartMs;
+    if (!m_throughputMeter || elapsed <= 0) {
+        return 0.0;
+    }
+    return (m_throughputMeter->getTotalDownloaded() - m_windowStartBytes) * 1000.0 / elapsed;
+}
+
+void DownloadQueue::restartWindow()
+{
+    m_windowStartMs = m_admissionClock.elapsed();
+    m_windowStartBytes = m_throughputMeter ? m_throughputMeter->getTotalDownloaded() : 0;
+}
+
+bool DownloadQueue::hostHasCapacity(const QString &origin) const
+{
+    int limit = m_hostLimits.value(origin, m_maxDownloadsPerHost);
+    return limit <= 0 || activeCountForHost(origin) < limit;
+}
+
+bool DownloadQueue::canStartItem(DownloadItem *item, const QString &origin) const
+{
+    if (!hostHasCapacity(origin)) {
+        return false;
+    }
+    int categoryLimit = m_categoryLimits.value(item->getCategoryId(), 0);
+    return categoryLimit <= 0 || m_categoryActive.value(item->getCategoryId(), 0) < categoryLimit;
+}
+
+int DownloadQueue::connectionCost(const DownloadItem *item)
+{
+    // Capped so any eligible origin starts something within two rounds
+    return qBound(1, item->getSegments(), 2 * ROUND_ROBIN_QUANTUM);
 }
\ No newline at end of file
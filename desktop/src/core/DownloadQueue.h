@@ -2,11 +2,30 @@
 #define DOWNLOADQUEUE_H
 
 #include <QObject>
-#include <QQueue>
 #include <QList>
+#include <QHash>
+#include <QStringList>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <map>
 #include "DownloadItem.h"
 
+class SpeedCalculator;
+
+// Waiting downloads are grouped per origin (DownloadItem::getOrigin), each
+// origin holding an ordered map keyed by (priority desc, arrival sequence)
+// with an id -> key index beside it. Insert, remove and reprioritize are
+// O(log n) and equal priorities start in FIFO order.
+//
+// Free slots go to the highest waiting priority; origins tied at that
+// priority share slots by deficit round-robin, charged by the segments
+// each download asks for, subject to per-origin and per-category limits.
+//
+// With a throughput meter attached, a download beyond the proven level is a
+// probe: it is kept only if aggregate throughput over the next window rises
+// by PROBE_MIN_GAIN, otherwise the queue holds at the level below it until
+// REPROBE_INTERVAL_MS has passed and lets the running transfers finish. A
+// window with no throughput at all is inconclusive and holds the level too.
 class DownloadQueue : public QObject
 {
     Q_OBJECT
@@ -16,19 +35,39 @@ public:
     ~DownloadQueue();
 
     void addDownload(DownloadItem *item);
+    // Enqueues all items, then fills free slots and notifies once
+    void addDownloads(const QList<DownloadItem*> &items);
     void removeDownload(int id);
     void pauseDownload(int id);
     void resumeDownload(int id);
     void cancelDownload(int id);
+    // Moves a waiting download to the back of its new priority level
+    bool setPriority(int id, int priority);
+    // Frees an active download's slot and emits downloadCompleted or downloadFailed
+    void finishDownload(int id, bool success, const QString &error = QString());
 
     void setMaxConcurrentDownloads(int max);
     int getMaxConcurrentDownloads() const;
 
+    // Simultaneous downloads per origin; 0 means unlimited
+    void setMaxDownloadsPerHost(int max);
+    int getMaxDownloadsPerHost() const;
+    void setHostLimit(const QString &origin, int max);      // overrides the default; -1 clears
+    void setCategoryLimit(int categoryId, int max);         // 0 or less clears
+
+    // Aggregate meter fed with the total bytes of all active downloads
+    void setThroughputMeter(SpeedCalculator *meter);
+    void setAdmissionProbeInterval(int msecs);
+    int admittedDownloads() const;
+
     void setBandwidthLimit(qint64 bytesPerSecond);
     qint64 getBandwidthLimit() const;
 
     QList<DownloadItem*> getActiveDownloads() const;
-    QList<DownloadItem*> getQueuedDownloads() const;
+    QList<DownloadItem*> getQueuedDownloads() const;   // in priority order; O(n log n)
+    int queuedCount() const;
+    bool isQueued(int id) const;
+    int activeCountForHost(const QString &origin) const;
 
 signals:
     void downloadStarted(DownloadItem *item);
@@ -38,19 +77,86 @@ signals:
 
 private slots:
     void onDownloadCompleted();
-    void onDownloadFailed(const QString &error);
     void checkQueue();
+    void evaluateAdmission();
 
 private:
-    QList<DownloadItem*> m_queue;
-    QList<DownloadItem*> m_activeDownloads;
+    struct QueueKey {
+        int priority;
+        quint64 sequence;
+
+        bool operator<(const QueueKey &other) const {
+            if (priority != other.priority) {
+                return priority > other.priority;     // higher priority first
+            }
+            return sequence < other.sequence;          // then arrival order
+        }
+    };
+
+    struct HostBucket {
+        std::map<QueueKey, DownloadItem*> queue;
+        int active = 0;
+        int deficit = 0;        // connection credit carried between visits
+    };
+
+    struct QueuedEntry {
+        QueueKey key;
+        QString origin;
+    };
+
+    struct ActiveEntry {
+        DownloadItem *item;
+        QString origin;
+        int categoryId;
+    };
+
+    QHash<QString, HostBucket> m_hosts;
+    QStringList m_roundRobin;                       // origins with waiting downloads
+    int m_roundRobinCursor;
+    QHash<int, QueuedEntry> m_queueIndex;
+    QList<DownloadItem*> m_activeDownloads;          // at most m_maxConcurrentDownloads entries
+    QHash<int, ActiveEntry> m_activeIndex;
+    QHash<QString, int> m_hostLimits;
+    QHash<int, int> m_categoryLimits;
+    QHash<int, int> m_categoryActive;
+    quint64 m_nextSequence;
     int m_maxConcurrentDownloads;
+    int m_maxDownloadsPerHost;
     qint64 m_bandwidthLimit;
-    QTimer *m_queueTimer;
+    QTimer *m_queueTimer;                           // fires at the end of a probe window
 
-    void sortQueueByPriority();
+    SpeedCalculator *m_throughputMeter;
+    QElapsedTimer m_admissionClock;
+    qint64 m_windowStartMs;
+    qint64 m_windowStartBytes;
+    double m_lastWindowRate;                        // bytes per second over the last window
+    double m_probeBaseline;
+    int m_probeActiveCount;                         // 0 when no probe is pending
+    int m_admittedDownloads;
+    qint64 m_saturatedUntilMs;
+    int m_probeIntervalMs;
+
+    bool watchAndEnqueue(DownloadItem *item);
+    void enqueue(DownloadItem *item);
+    DownloadItem *takeQueued(int id);
+    DownloadItem *takeActive(int id);
+    void startItem(DownloadItem *item);
     void startNextDownloads();
     bool canStartDownload() const;
+    bool admissionAllows() const;
+    void beginProbe();
+    double windowRate() const;
+    void restartWindow();
+    bool hostHasCapacity(const QString &origin) const;
+    bool canStartItem(DownloadItem *item, const QString &origin) const;
+    static int connectionCost(const DownloadItem *item);
+
+    static const int DEFAULT_DOWNLOADS_PER_HOST = 4;
+    static const int ROUND_ROBIN_QUANTUM = 4;       // connection credit per origin per visit
+    static const int DEFAULT_PROBE_INTERVAL_MS = 5000;
+    static const int REPROBE_INTERVAL_MS = 60000;
+    static constexpr double PROBE_MIN_GAIN = 0.15;
+    static constexpr double BANDWIDTH_LIMIT_HEADROOM = 0.9;
 };
 
 #endif // DOWNLOADQUEUE_H
\ No newline at end of file
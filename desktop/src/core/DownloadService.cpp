@@ -0,0 +1,581 @@
+#include "DownloadService.h"
+#include "SegmentManager.h"
+#include "SpeedCalculator.h"
+#include <QDir>
+#include <QUrl>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <utility>
+
+DownloadService::DownloadService(Database *database, DownloadEngine *engine, QObject *parent)
+    : QObject(parent)
+    , m_database(database)
+    , m_engine(engine)
+    , m_queue(new DownloadQueue(this))
+    , m_throughput(new SpeedCalculator(this))
+    , m_flushTimer(new QTimer(this))
+    , m_progressTimer(new QTimer(this))
+    , m_inBatch(false)
+    , m_liveGeneration(0)
+{
+    // Armed by the first dirty row, so an idle service never wakes up
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(DEFAULT_FLUSH_INTERVAL_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, &DownloadService::flush);
+
+    m_progressTimer->setSingleShot(true);
+    m_progressTimer->setInterval(PROGRESS_TICK_MS);
+    connect(m_progressTimer, &QTimer::timeout, this, &DownloadService::flushProgress);
+
+    // Downloads beyond the proven concurrency are admitted only while they add throughput
+    m_throughput->start();
+    m_queue->setThroughputMeter(m_throughput);
+
+    connect(m_queue, &DownloadQueue::downloadStarted, this, &DownloadService::onQueueStarted);
+    connect(m_engine, &DownloadEngine::segmentProgress, this, &DownloadService::onSegmentProgress);
+    connect(m_engine, &DownloadEngine::downloadProgress, this, &DownloadService::onDownloadProgress);
+    connect(m_engine, &DownloadEngine::downloadCompleted, this, &DownloadService::onDownloadCompleted);
+    connect(m_engine, &DownloadEngine::downloadFailed, this, &DownloadService::onDownloadFailed);
+}
+
+DownloadService::~DownloadService()
+{
+    if (m_database->isOpen()) {
+        flush();
+    }
+}
+
+int DownloadService::createDownload(const QVariantMap &downloadData)
+{
+    return createDownloads({downloadData}).first();
+}
+
+QList<int> DownloadService::createDownloads(const QVariantList &downloads)
+{
+    QVariantList rows;
+    rows.reserve(downloads.size());
+    for (const QVariant &download : downloads) {
+        rows.append(withDefaults(download.toMap()));
+    }
+
+    QList<int> ids = m_database->insertDownloads(rows);
+    QList<DownloadItem*> items;
+    for (int i = 0; i < ids.size(); ++i) {
+        if (ids.at(i) > 0) {
+            items.append(adopt(ids.at(i), rows.at(i).toMap()));
+        }
+    }
+
+    if (m_inBatch) {
+        m_pendingStarts += items;
+    } else {
+        m_queue->addDownloads(items);
+    }
+    return ids;
+}
+
+bool DownloadService::updateDownload(int id, const QVariantMap &fields)
+{
+    QVariantMap changes = fields;
+    QString status = changes.value("status").toString();
+    if (status == "paused" || status == "queued" || status == "downloading") {
+        // State changes go through the engine; the status follows from what it did
+        changes.remove("status");
+        if (status == "paused") {
+            pauseDownload(id);
+        } else {
+            resumeDownload(id);
+        }
+    }
+    if (changes.contains("priority")) {
+        m_queue->setPriority(id, changes.value("priority").toInt());
+    }
+
+    QSharedPointer<LiveDownload> download = live(id);
+    if (!download) {
+        // Not held in memory: merge into the stored row so unspecified columns survive
+        QVariantMap row = m_database->getDownload(id);
+        if (row.isEmpty()) {
+            return false;
+        }
+        for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+            row[it.key()] = it.value();
+        }
+        return m_database->updateDownload(id, row);
+    }
+
+    if (changes.contains("category_id")) {
+        download->item->setCategoryId(changes.value("category_id").toInt());
+    }
+    {
+        QWriteLocker locker(&m_lock);
+        for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+            download->row[it.key()] = it.value();
+        }
+    }
+    m_liveGeneration.fetch_add(1, std::memory_order_release);
+    markDirty(id);
+    return true;
+}
+
+bool DownloadService::pauseDownload(int id)
+{
+    QSharedPointer<LiveDownload> download = live(id);
+    if (!download || download->finished) {
+        return false;
+    }
+
+    m_queue->removeDownload(id);
+    m_engine->pauseDownload(id);
+    download->speed.store(0, std::memory_order_relaxed);
+    setStatus(id, "paused");
+    return true;
+}
+
+bool DownloadService::resumeDownload(int id)
+{
+    QSharedPointer<LiveDownload> download = live(id);
+    if (!download) {
+        QVariantMap row = m_database->getDownload(id);
+        if (row.isEmpty() || row.value("status").toString() == "completed") {
+            return false;
+        }
+        // A failed transfer may still sit in the engine; start it afresh
+        if (m_engine->getDownload(id)) {
+            m_engine->cancelDownload(id);
+        }
+        DownloadItem *item = adopt(id, row);
+        setStatus(id, "queued");
+        m_queue->addDownload(item);
+        return true;
+    }
+
+    QString status;
+    {
+        QReadLocker locker(&m_lock);
+        status = download->row.value("status").toString();
+    }
+    if (status == "queued" || status == "downloading") {
+        return true;
+    }
+    if (status == "completed") {
+        return false;
+    }
+
+    if (status == "failed") {
+        m_engine->cancelDownload(id);
+    }
+    download->finished = false;
+    setStatus(id, "queued", {{"error_message", QVariant()}});
+    m_queue->addDownload(download->item);
+    return true;
+}
+
+bool DownloadService::deleteDownload(int id)
+{
+    if (QSharedPointer<LiveDownload> download = live(id)) {
+        m_queue->removeDownload(id);
+        m_engine->cancelDownload(id);
+        m_pendingStarts.removeOne(download->item);
+        m_dirty.remove(id);
+        {
+            QWriteLocker locker(&m_lock);
+            m_live.remove(id);
+        }
+        download->item->deleteLater();
+        m_liveGeneration.fetch_add(1, std::memory_order_release);
+    }
+    return m_database->deleteDownload(id);
+}
+
+bool DownloadService::beginBatch()
+{
+    if (m_inBatch || !m_database->beginBatch()) {
+        return false;
+    }
+    m_inBatch = true;
+    return true;
+}
+
+bool DownloadService::commitBatch()
+{
+    if (!m_inBatch) {
+        return false;
+    }
+    m_inBatch = false;
+
+    QList<DownloadItem*> created = std::exchange(m_pendingStarts, {});
+    if (!m_database->commitBatch()) {
+        // The inserts were rolled back, so the downloads created in the batch never existed
+        QWriteLocker locker(&m_lock);
+        for (DownloadItem *item : created) {
+            m_live.remove(item->getId());
+            m_dirty.remove(item->getId());
+            item->deleteLater();
+        }
+        return false;
+    }
+
+    m_queue->addDownloads(created);
+    if (!m_dirty.isEmpty() && !m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+    return true;
+}
+
+QVariantMap DownloadService::download(int id, Database *database) const
+{
+    {
+        QReadLocker locker(&m_lock);
+        auto it = m_live.constFind(id);
+        if (it != m_live.constEnd()) {
+            return withLiveCounters(**it);
+        }
+    }
+    return (database ? database : m_database)->getDownload(id);
+}
+
+QVariantList DownloadService::downloads(const QString &status, Database *database) const
+{
+    QVariantList result;
+    forEachDownload(status, database, [&result](const QVariantMap &row) {
+        result.append(row);
+        return true;
+    });
+    return result;
+}
+
+bool DownloadService::forEachDownload(const QString &status, Database *database,
+                                      const Database::RowVisitor &visit) const
+{
+    if (!database) {
+        database = m_database;
+    }
+
+    bool anyLive;
+    {
+        QReadLocker locker(&m_lock);
+        anyLive = !m_live.isEmpty();
+    }
+    if (!anyLive) {
+        return database->forEachDownload(status, visit);
+    }
+
+    // Live rows may be ahead of the table, so the status filter runs after the overlay.
+    // The lock is taken per row; visitors may block on a slow client.
+    return database->forEachDownload(QString(), [this, &status, &visit](const QVariantMap &stored) {
+        QVariantMap row = stored;
+        {
+            QReadLocker locker(&m_lock);
+            auto it = m_live.constFind(row.value("id").toInt());
+            if (it != m_live.constEnd()) {
+                row = withLiveCounters(**it);
+            }
+        }
+        if (!status.isEmpty() && row.value("status").toString() != status) {
+            return true;
+        }
+        return visit(row);
+    });
+}
+
+bool DownloadService::isLive(int id) const
+{
+    QReadLocker locker(&m_lock);
+    return m_live.contains(id);
+}
+
+void DownloadService::setFlushInterval(int msecs)
+{
+    m_flushTimer->setInterval(qMax(0, msecs));
+}
+
+void DownloadService::flush()
+{
+    if (m_dirty.isEmpty() || m_inBatch) {
+        return;
+    }
+
+    QList<QPair<int, QVariantMap>> rows;
+    QList<int> finished;
+    {
+        QReadLocker locker(&m_lock);
+        for (int id : std::as_const(m_dirty)) {
+            auto it = m_live.constFind(id);
+            if (it == m_live.constEnd()) {
+                continue;
+            }
+            rows.append(qMakePair(id, withLiveCounters(**it)));
+            if ((*it)->finished) {
+                finished.append(id);
+            }
+        }
+    }
+    m_dirty.clear();
+
+    // Every row changed since the last flush lands in one transaction
+    bool ownBatch = m_database->beginBatch();
+    for (const auto &row : std::as_const(rows)) {
+        m_database->updateDownload(row.first, row.second);
+    }
+    if (ownBatch) {
+        m_database->commitBatch();
+    }
+
+    // Finished downloads are no longer hot; later reads go to the table
+    if (finished.isEmpty()) {
+        return;
+    }
+
+    QList<QSharedPointer<LiveDownload>> released;
+    {
+        QWriteLocker locker(&m_lock);
+        for (int id : std::as_const(finished)) {
+            released.append(m_live.take(id));
+        }
+    }
+    for (const QSharedPointer<LiveDownload> &download : std::as_const(released)) {
+        int id = download->item->getId();
+        m_queue->removeDownload(id);
+        m_engine->releaseDownload(id);
+        download->item->deleteLater();
+    }
+    m_liveGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void DownloadService::onQueueStarted(DownloadItem *item)
+{
+    int id = item->getId();
+    QSharedPointer<LiveDownload> download = live(id);
+    if (!download) {
+        return;
+    }
+
+    // Paused downloads keep their segment manager, so they resume instead of restarting
+    if (m_engine->getDownload(id)) {
+        m_engine->resumeDownload(id);
+    } else {
+        download->segmentBytes.clear();
+        m_engine->startDownload(item);
+    }
+
+    QVariantMap extra;
+    {
+        QReadLocker locker(&m_lock);
+        if (download->row.value("started_at").isNull()) {
+            extra["started_at"] = QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss");
+        }
+    }
+    setStatus(id, "downloading", extra);
+}
+
+void DownloadService::onSegmentProgress(int downloadId, int segmentIndex, qint64 bytesReceived, qint64 bytesTotal)
+{
+    Q_UNUSED(bytesTotal);
+    QSharedPointer<LiveDownload> download = live(downloadId);
+    if (!download) {
+        return;
+    }
+
+    // The engine reports one segment at a time; the download is the sum of all of them
+    download->segmentBytes.insert(segmentIndex, bytesReceived);
+    qint64 downloaded = 0;
+    for (qint64 bytes : std::as_const(download->segmentBytes)) {
+        downloaded += bytes;
+    }
+
+    SegmentManager *segments = m_engine->getSegmentManager(downloadId);
+    qint64 total = qMax(download->total.load(std::memory_order_relaxed), segments ? segments->getTotalSize() : 0);
+    updateCounters(downloadId, *download, downloaded, total);
+}
+
+void DownloadService::onDownloadProgress(int downloadId, qint64 bytesReceived, qint64 bytesTotal)
+{
+    // Segmented transfers are counted by onSegmentProgress; here the signal carries only one segment
+    QSharedPointer<LiveDownload> download = live(downloadId);
+    if (!download || !download->segmentBytes.isEmpty()) {
+        return;
+    }
+    updateCounters(downloadId, *download, bytesReceived, bytesTotal);
+}
+
+void DownloadService::onDownloadCompleted(int downloadId)
+{
+    QSharedPointer<LiveDownload> download = live(downloadId);
+    if (!download) {
+        return;
+    }
+
+    qint64 total = download->total.load(std::memory_order_relaxed);
+    if (total > 0) {
+        download->downloaded.store(total, std::memory_order_relaxed);
+    }
+    download->speed.store(0, std::memory_order_relaxed);
+    download->finished = true;
+    emitProgress(downloadId, *download);
+    setStatus(downloadId, "completed",
+              {{"completed_at", QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss")}});
+
+    // Frees the download's queue slot
+    m_queue->finishDownload(downloadId, true);
+}
+
+void DownloadService::onDownloadFailed(int downloadId, const QString &error)
+{
+    QSharedPointer<LiveDownload> download = live(downloadId);
+    if (!download) {
+        return;
+    }
+
+    download->speed.store(0, std::memory_order_relaxed);
+    download->finished = true;
+    emitProgress(downloadId, *download);
+    setStatus(downloadId, "failed", {{"error_message", error}});
+
+    // The queue is told here and only here
+    download->item->setErrorMessage(error);
+    download->item->setStatus("failed");
+    m_queue->finishDownload(downloadId, false, error);
+}
+
+QSharedPointer<DownloadService::LiveDownload> DownloadService::live(int id) const
+{
+    QReadLocker locker(&m_lock);
+    return m_live.value(id);
+}
+
+DownloadItem *DownloadService::adopt(int id, const QVariantMap &row)
+{
+    DownloadItem *item = new DownloadItem(id, row.value("url").toString(), row.value("filename").toString(), this);
+    item->setFilepath(row.value("filepath").toString());
+    if (row.contains("category_id")) {
+        item->setCategoryId(row.value("category_id").toInt());
+    }
+    if (row.contains("priority")) {
+        item->setPriority(row.value("priority").toInt());
+    }
+    if (row.contains("segments")) {
+        item->setSegments(row.value("segments").toInt());
+    }
+
+    QSharedPointer<LiveDownload> download(new LiveDownload);
+    download->row = row;
+    download->row["id"] = id;
+    if (!download->row.contains("created_at")) {
+        // Same UTC format as the table's CURRENT_TIMESTAMP default
+        download->row["created_at"] = QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss");
+    }
+    download->item = item;
+    download->downloaded.store(row.value("downloaded_size").toLongLong(), std::memory_order_relaxed);
+    download->total.store(row.value("total_size").toLongLong(), std::memory_order_relaxed);
+
+    QWriteLocker locker(&m_lock);
+    m_live.insert(id, download);
+    return item;
+}
+
+void DownloadService::setStatus(int id, const QString &status, const QVariantMap &extra)
+{
+    {
+        QWriteLocker locker(&m_lock);
+        auto it = m_live.find(id);
+        if (it == m_live.end()) {
+            return;
+        }
+        (*it)->row["status"] = status;
+        for (auto field = extra.constBegin(); field != extra.constEnd(); ++field) {
+            (*it)->row[field.key()] = field.value();
+        }
+    }
+    m_liveGeneration.fetch_add(1, std::memory_order_release);
+    markDirty(id);
+}
+
+void DownloadService::markDirty(int id)
+{
+    m_dirty.insert(id);
+    if (!m_inBatch && !m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void DownloadService::updateCounters(int id, LiveDownload &download, qint64 downloaded, qint64 total)
+{
+    qint64 speed = download.speed.load(std::memory_order_relaxed);
+    SegmentManager *segments = m_engine->getSegmentManager(id);
+    QVector<SegmentSnapshot> snapshot = segments ? segments->segmentSnapshot() : QVector<SegmentSnapshot>();
+    if (!snapshot.isEmpty()) {
+        // Per-connection rates over the engine's last publish interval
+        speed = 0;
+        for (const SegmentSnapshot &segment : std::as_const(snapshot)) {
+            speed += segment.speed;
+        }
+    }
+
+    qint64 previous = download.downloaded.exchange(downloaded, std::memory_order_relaxed);
+    download.total.store(total, std::memory_order_relaxed);
+    download.speed.store(speed, std::memory_order_relaxed);
+    // A restarted transfer goes backwards; only forward progress counts as throughput
+    if (downloaded > previous) {
+        m_throughput->addBytes(downloaded - previous);
+    }
+    m_liveGeneration.fetch_add(1, std::memory_order_release);
+    markDirty(id);
+
+    m_progressPending.insert(id);
+    if (!m_progressTimer->isActive()) {
+        m_progressTimer->start();
+    }
+}
+
+void DownloadService::flushProgress()
+{
+    const QSet<int> pending = std::exchange(m_progressPending, {});
+    for (int id : pending) {
+        if (QSharedPointer<LiveDownload> download = live(id)) {
+            emitProgress(id, *download);
+        }
+    }
+}
+
+void DownloadService::emitProgress(int id, const LiveDownload &download)
+{
+    m_progressPending.remove(id);
+    emit downloadProgressChanged(id, download.downloaded.load(std::memory_order_relaxed),
+                                 download.total.load(std::memory_order_relaxed),
+                                 download.speed.load(std::memory_order_relaxed));
+}
+
+QVariantMap DownloadService::withLiveCounters(const LiveDownload &download)
+{
+    QVariantMap row = download.row;
+    qint64 downloaded = download.downloaded.load(std::memory_order_relaxed);
+    qint64 total = download.total.load(std::memory_order_relaxed);
+    qint64 speed = download.speed.load(std::memory_order_relaxed);
+    row["downloaded_size"] = downloaded;
+    row["total_size"] = total;
+    row["speed"] = speed;
+    row["progress"] = total > 0 ? qBound(0.0, double(downloaded) / total, 1.0) : 0.0;
+    row["eta"] = speed > 0 && total > downloaded ? int((total - downloaded) / speed) : 0;
+    return row;
+}
+
+QVariantMap DownloadService::withDefaults(const QVariantMap &downloadData)
+{
+    QVariantMap row = downloadData;
+    QString fileName = row.value("filename").toString();
+    if (fileName.isEmpty()) {
+        fileName = QUrl(row.value("url").toString()).fileName();
+        if (fileName.isEmpty()) {
+            fileName = "download_" + QString::number(QDateTime::currentMSecsSinceEpoch());
+        }
+        row["filename"] = fileName;
+    }
+    if (row.value("filepath").toString().isEmpty()) {
+        row["filepath"] = QDir(QStandardPaths::writableLocation(QStandardPaths::DownloadLocation)).filePath(fileName);
+    }
+    if (!row.contains("status")) {
+        row["status"] = "queued";
+    }
+    return row;
+}
\ No newline at end of file
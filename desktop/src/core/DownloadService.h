@@ -0,0 +1,117 @@
+#ifndef DOWNLOADSERVICE_H
+#define DOWNLOADSERVICE_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QVariantMap>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+#include <QTimer>
+#include <atomic>
+#include "Database.h"
+#include "DownloadEngine.h"
+#include "DownloadQueue.h"
+#include "DownloadItem.h"
+
+class SpeedCalculator;
+
+// The one command path for downloads. Commands act on the queue and engine
+// first; rows of downloads the service holds in memory are marked dirty and
+// written back in one transaction per flush interval. Reads of those
+// downloads come from memory (the last known row plus atomic counters
+// refreshed from engine signals) and never touch SQLite; only downloads the
+// service does not hold fall through to the database.
+//
+// Commands run on the service's thread. Reads are safe from any thread when
+// given a connection owned by the calling thread for the database fallback.
+class DownloadService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DownloadService(Database *database, DownloadEngine *engine, QObject *parent = nullptr);
+    ~DownloadService();
+
+    // Commands. Creates are inserted synchronously since the caller needs the id.
+    int createDownload(const QVariantMap &downloadData);            // -1 on failure
+    QList<int> createDownloads(const QVariantList &downloads);      // one id per row, -1 where it failed
+    bool updateDownload(int id, const QVariantMap &fields);
+    bool pauseDownload(int id);
+    bool resumeDownload(int id);
+    bool deleteDownload(int id);
+
+    // Commands between beginBatch() and commitBatch() share one database
+    // transaction; downloads created inside reach the queue only after the commit
+    bool beginBatch();
+    bool commitBatch();
+
+    // Reads; database defaults to the service's own connection
+    QVariantMap download(int id, Database *database = nullptr) const;        // empty when unknown
+    QVariantList downloads(const QString &status = QString(), Database *database = nullptr) const;
+    // Same rows as downloads(), handed over one at a time as the cursor advances
+    bool forEachDownload(const QString &status, Database *database, const Database::RowVisitor &visit) const;
+    bool isLive(int id) const;
+    quint64 liveGeneration() const { return m_liveGeneration.load(std::memory_order_acquire); }
+
+    DownloadQueue *queue() const { return m_queue; }
+    // Aggregate bytes of every live download; drives the queue's admission control
+    SpeedCalculator *throughputMeter() const { return m_throughput; }
+    void setFlushInterval(int msecs);
+    void flush();
+
+    static const int PROGRESS_TICK_MS = 250;
+
+signals:
+    // Whole-download counters, at most once per PROGRESS_TICK_MS per download,
+    // plus a final one when the download completes or fails
+    void downloadProgressChanged(int downloadId, qint64 downloaded, qint64 total, qint64 speed);
+
+private slots:
+    void onQueueStarted(DownloadItem *item);
+    void onSegmentProgress(int downloadId, int segmentIndex, qint64 bytesReceived, qint64 bytesTotal);
+    void onDownloadProgress(int downloadId, qint64 bytesReceived, qint64 bytesTotal);
+    void onDownloadCompleted(int downloadId);
+    void onDownloadFailed(int downloadId, const QString &error);
+
+private:
+    struct LiveDownload {
+        QVariantMap row;                    // guarded by m_lock
+        DownloadItem *item = nullptr;
+        std::atomic<qint64> downloaded{0};
+        std::atomic<qint64> total{0};
+        std::atomic<qint64> speed{0};
+        QHash<int, qint64> segmentBytes;    // per-segment received bytes; service thread only
+        bool finished = false;              // dropped from memory once flushed
+    };
+
+    Database *m_database;
+    DownloadEngine *m_engine;
+    DownloadQueue *m_queue;
+    SpeedCalculator *m_throughput;
+    QTimer *m_flushTimer;
+    QTimer *m_progressTimer;
+
+    mutable QReadWriteLock m_lock;          // guards m_live and the rows in it
+    QHash<int, QSharedPointer<LiveDownload>> m_live;
+    QSet<int> m_dirty;
+    QSet<int> m_progressPending;            // counters changed since the last progress tick
+    QList<DownloadItem*> m_pendingStarts;   // created inside an open batch
+    bool m_inBatch;
+    std::atomic<quint64> m_liveGeneration;
+
+    QSharedPointer<LiveDownload> live(int id) const;
+    DownloadItem *adopt(int id, const QVariantMap &row);
+    void setStatus(int id, const QString &status, const QVariantMap &extra = QVariantMap());
+    void markDirty(int id);
+    void updateCounters(int id, LiveDownload &download, qint64 downloaded, qint64 total);
+    void flushProgress();
+    void emitProgress(int id, const LiveDownload &download);
+    static QVariantMap withLiveCounters(const LiveDownload &download);
+    static QVariantMap withDefaults(const QVariantMap &downloadData);
+
+    static const int DEFAULT_FLUSH_INTERVAL_MS = 1000;
+};
+
+#endif // DOWNLOADSERVICE_H
\ No newline at end of file
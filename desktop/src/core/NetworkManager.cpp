@@ -7,6 +7,40 @@
 #include <QTimer>
 #include <QDebug>
 
+namespace {
+
+struct NetworkMetrics {
+    Metrics::Counter *bytesReceived;
+    Metrics::Counter *bytesWritten;
+    Metrics::Counter *requests;
+    Metrics::Counter *retries;
+    Metrics::Counter *failures;
+    Metrics::Gauge *activeConnections;
+    Metrics::Histogram *timeToFirstByte;
+
+    NetworkMetrics() {
+        Metrics &metrics = Metrics::instance();
+        bytesReceived = metrics.counter("ldm_network_received_bytes_total", "Bytes received from servers");
+        bytesWritten = metrics.counter("ldm_disk_written_bytes_total", "Downloaded bytes written to disk");
+        requests = metrics.counter("ldm_network_requests_total", "HTTP requests issued, retries included");
+        retries = metrics.counter("ldm_network_retries_total", "Requests retried after a failure");
+        failures = metrics.counter("ldm_network_failures_total", "Requests that failed after all retries");
+        activeConnections = metrics.gauge("ldm_network_active_connections", "HTTP requests currently in flight");
+        timeToFirstByte = metrics.histogram("ldm_network_ttfb_seconds", "Time from request to first body byte", 1e-6);
+    }
+};
+
+// Hosts beyond this share host="other", so crawling many servers can't grow /metrics without bound
+const int MAX_HOST_SERIES = 32;
+
+NetworkMetrics &networkMetrics()
+{
+    static NetworkMetrics metrics;
+    return metrics;
+}
+
+}
+
 NetworkManager::NetworkManager(QObject *parent)
     : QObject(parent)
     , m_networkManager(new QNetworkAccessManager(this))
@@ -22,6 +56,9 @@ NetworkManager::NetworkManager(QObject *parent)
     , m_currentRetry(0)
     , m_retryTimer(new QTimer(this))
     , m_mappedFile(new MemoryMappedFile(this))
+    , m_awaitingFirstByte(false)
+    , m_connectionOpen(false)
+    , m_hostBytes(nullptr)
 {
     connect(m_networkManager, &QNetworkAccessManager::finished, this, &NetworkManager::onFinished);
     connect(m_retryTimer, &QTimer::timeout, this, &NetworkManager::retryDownload);
@@ -33,6 +70,7 @@ NetworkManager::~NetworkManager()
         m_currentReply->abort();
         m_currentReply->deleteLater();
     }
+    endRequest();
 }
 
 bool NetworkManager::downloadFile(const QUrl &url, const QString &filepath)
@@ -53,6 +91,7 @@ bool NetworkManager::downloadFile(const QUrl &url, const QString &filepath)
     }
 
     m_currentReply = m_networkManager->get(request);
+    beginRequest(url);
     connect(m_currentReply, &QNetworkReply::downloadProgress, this, &NetworkManager::onDownloadProgress);
     connect(m_currentReply, &QNetworkReply::readyRead, this, &NetworkManager::onReadyRead);
 
@@ -83,6 +122,7 @@ bool NetworkManager::downloadRange(const QUrl &url, const QString &filepath, qin
     }
 
     m_currentReply = m_networkManager->get(request);
+    beginRequest(url);
     connect(m_currentReply, &QNetworkReply::downloadProgress, this, &NetworkManager::onDownloadProgress);
     connect(m_currentReply, &QNetworkReply::readyRead, this, &NetworkManager::onReadyRead);
 
@@ -125,6 +165,11 @@ int NetworkManager::getMaxRetries() const
     return m_maxRetries;
 }
 
+int NetworkManager::getCurrentRetry() const
+{
+    return m_currentRetry;
+}
+
 bool NetworkManager::supportsResume(const QUrl &url)
 {
     // Simplified: assume resume is supported
@@ -216,6 +261,14 @@ void NetworkManager::onReadyRead()
 
     QByteArray data = m_currentReply->readAll();
     if (!data.isEmpty()) {
+        NetworkMetrics &metrics = networkMetrics();
+        if (m_awaitingFirstByte) {
+            m_awaitingFirstByte = false;
+            metrics.timeToFirstByte->record(m_requestTimer.nsecsElapsed() / 1000);
+        }
+        metrics.bytesReceived->increment(data.size());
+        m_hostBytes->increment(data.size());
+
         // For large files, use memory mapping
         if (m_totalBytes > 10 * 1024 * 1024) { // 10MB threshold
             if (!m_mappedFile->isOpen()) {
@@ -231,6 +284,7 @@ void NetworkManager::onReadyRead()
                 // Copy data to mapped memory
                 memcpy((void*)(m_mappedFile->data() + m_downloadedBytes - data.size()), data.constData(), data.size());
                 m_mappedFile->flush();
+                metrics.bytesWritten->increment(data.size());
             }
         } else {
             // For small files, use regular QFile
@@ -240,7 +294,7 @@ void NetworkManager::onReadyRead()
                 mode = QIODevice::WriteOnly;
             }
             if (file.open(mode)) {
-                file.write(data);
+                metrics.bytesWritten->increment(qMax<qint64>(file.write(data), 0));
                 file.close();
             }
         }
@@ -270,7 +324,9 @@ void NetworkManager::onFinished()
                 mode |= QIODevice::Append;
             }
             if (file.open(mode)) {
-                file.write(m_currentReply->readAll());
+                QByteArray remaining = m_currentReply->readAll();
+                networkMetrics().bytesReceived->increment(remaining.size());
+                networkMetrics().bytesWritten->increment(qMax<qint64>(file.write(remaining), 0));
                 file.close();
                 success = true;
             } else {
@@ -283,8 +339,10 @@ void NetworkManager::onFinished()
 
     m_currentReply->deleteLater();
     m_currentReply = nullptr;
+    endRequest();
 
     if (!success && m_currentRetry < m_maxRetries) {
+        networkMetrics().retries->increment();
         m_currentRetry++;
         m_retryTimer->start(1000 * m_currentRetry); // Exponential backoff
         return;
@@ -292,9 +350,36 @@ void NetworkManager::onFinished()
 
     m_isDownloading = false;
     m_currentRetry = 0;
+    if (!success) {
+        networkMetrics().failures->increment();
+    }
     emit downloadFinished(success, errorMessage);
 }
 
+void NetworkManager::beginRequest(const QUrl &url)
+{
+    NetworkMetrics &metrics = networkMetrics();
+    metrics.requests->increment();
+    if (!m_connectionOpen) {
+        metrics.activeConnections->add(1);
+        m_connectionOpen = true;
+    }
+
+    m_hostBytes = Metrics::instance().boundedCounter("ldm_host_received_bytes_total", "Bytes received per server",
+                                                     "host", url.host().toLower(), MAX_HOST_SERIES);
+    m_awaitingFirstByte = true;
+    m_requestTimer.start();
+}
+
+void NetworkManager::endRequest()
+{
+    if (m_connectionOpen) {
+        networkMetrics().activeConnections->add(-1);
+        m_connectionOpen = false;
+    }
+    m_awaitingFirstByte = false;
+}
+
 void NetworkManager::retryDownload()
 {
     // Retry the download
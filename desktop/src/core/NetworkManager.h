@@ -7,7 +7,9 @@
 #include <QNetworkProxy>
 #include <QNetworkReply>
 #include <QTimer>
+#include <QElapsedTimer>
 #include "utils/MemoryMappedFile.h"
+#include "utils/Metrics.h"
 
 class NetworkManager : public QObject
 {
@@ -26,6 +28,7 @@ public:
     // Retry configuration
     void setMaxRetries(int retries);
     int getMaxRetries() const;
+    int getCurrentRetry() const;
 
     // Configuration
     void setProxy(const QNetworkProxy &proxy);
@@ -75,6 +78,15 @@ private:
     int m_currentRetry;
     QTimer *m_retryTimer;
     MemoryMappedFile *m_mappedFile;
+
+    // Metrics for the request in flight
+    QElapsedTimer m_requestTimer;
+    bool m_awaitingFirstByte;
+    bool m_connectionOpen;
+    Metrics::Counter *m_hostBytes;
+
+    void beginRequest(const QUrl &url);
+    void endRequest();
 };
 
 #endif // NETWORKMANAGER_H
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "PartialFileDevice.h"
+#include <QDeadlineTimer>
+#include <QFile>
+
+PartialFileDevice::PartialFileDevice(QSharedPointer<RangeAvailability> availability, QObject *parent)
+    : QIODevice(parent)
+    , m_availability(availability)
+    , m_position(0)
+    , m_readTimeout(DEFAULT_READ_TIMEOUT)
+    , m_closing(false)
+{
+}
+
+PartialFileDevice::~PartialFileDevice()
+{
+    close();
+}
+
+bool PartialFileDevice::open(OpenMode mode)
+{
+    if (mode & WriteOnly) {
+        setErrorString("PartialFileDevice is read-only");
+        return false;
+    }
+
+    // Unbuffered so QIODevice never reads ahead into bytes that are not there yet
+    m_position = 0;
+    m_closing = false;
+    return QIODevice::open(mode | Unbuffered);
+}
+
+void PartialFileDevice::close()
+{
+    m_closing = true;
+    QIODevice::close();
+}
+
+bool PartialFileDevice::isSequential() const
+{
+    return false;
+}
+
+bool PartialFileDevice::seek(qint64 pos)
+{
+    if (pos < 0 || !QIODevice::seek(pos)) {
+        return false;
+    }
+    m_position = pos;
+    return true;
+}
+
+qint64 PartialFileDevice::size() const
+{
+    return qMax<qint64>(0, m_availability->totalSize());
+}
+
+qint64 PartialFileDevice::bytesAvailable() const
+{
+    return m_availability->contiguousFrom(m_position) + QIODevice::bytesAvailable();
+}
+
+bool PartialFileDevice::atEnd() const
+{
+    // Missing bytes are not the end, nor is a size not known yet; only the real file size is
+    qint64 total = m_availability->totalSize();
+    return !isOpen() || (total >= 0 && m_position >= total);
+}
+
+void PartialFileDevice::setReadTimeout(int timeoutMs)
+{
+    m_readTimeout = timeoutMs;
+}
+
+qint64 PartialFileDevice::readData(char *data, qint64 maxSize)
+{
+    if (maxSize <= 0) {
+        return 0;
+    }
+    if (atEnd()) {
+        return -1;
+    }
+
+    // Waits through an unknown size too, so a player opening early is not handed EOF
+    QDeadlineTimer deadline(m_readTimeout);
+    while (!m_availability->waitForData(m_position, WAIT_SLICE)) {
+        if (m_closing || m_availability->isAborted() || atEnd()) {
+            return -1;
+        }
+        if (deadline.hasExpired()) {
+            return 0;
+        }
+    }
+
+    RangeAvailability::Location location;
+    if (!m_availability->beginRead(m_position, maxSize, &location)) {
+        return m_availability->isAborted() ? -1 : 0;
+    }
+
+    // Opened per read so no handle outlives markCompleted() removing the parts
+    qint64 bytesRead = -1;
+    QFile file(location.path);
+    if (file.open(QIODevice::ReadOnly) && file.seek(location.fileOffset)) {
+        bytesRead = file.read(data, location.length);
+    }
+    file.close();
+    m_availability->endRead();
+
+    if (bytesRead > 0) {
+        m_position += bytesRead;
+    }
+    return bytesRead;
+}
+
+qint64 PartialFileDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
\ No newline at end of file
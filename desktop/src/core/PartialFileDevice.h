@@ -0,0 +1,49 @@
+#ifndef PARTIALFILEDEVICE_H
+#define PARTIALFILEDEVICE_H
+
+#include <QIODevice>
+#include <QSharedPointer>
+#include <atomic>
+#include "SegmentManager.h"
+
+// Random-access, read-only view of a download in progress. Reads block until
+// the requested bytes are on disk, then come straight from the .part file (or
+// the merged file once the download completes). size() is 0 until the
+// download's size is known, but reads made before then wait rather than
+// report EOF. Meant for a media player's demuxer thread; never read it from
+// the GUI thread.
+class PartialFileDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit PartialFileDevice(QSharedPointer<RangeAvailability> availability, QObject *parent = nullptr);
+    ~PartialFileDevice();
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override;
+    bool seek(qint64 pos) override;
+    qint64 size() const override;
+    qint64 bytesAvailable() const override;
+    bool atEnd() const override;
+
+    // How long a read may wait for data before returning 0 (ms)
+    void setReadTimeout(int timeoutMs);
+    int readTimeout() const { return m_readTimeout; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    QSharedPointer<RangeAvailability> m_availability;
+    qint64 m_position;
+    int m_readTimeout;
+    std::atomic<bool> m_closing;
+
+    static const int DEFAULT_READ_TIMEOUT = 30000;
+    static const int WAIT_SLICE = 100;      // ms between checks for close()
+};
+
+#endif // PARTIALFILEDEVICE_H
\ No newline at end of file
@@ -1,12 +1,193 @@
 #include "Scheduler.h"
 #include "Database.h"
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QDebug>
+#include <algorithm>
+
+static const char *WINDOW_TIME_FORMAT = "HH:mm:ss";
+
+// Orders the std heap functions as a min-heap on the due time
+static bool laterEntry(qint64 a, qint64 b)
+{
+    return a > b;
+}
+
+static int nextBit(quint64 bits, int from, int maximum)
+{
+    for (int i = from; i <= maximum; ++i) {
+        if (bits & (quint64(1) << i)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+ScheduleRule::ScheduleRule()
+    : m_seconds(0)
+    , m_minutes(0)
+    , m_hours(0)
+    , m_days(0)
+    , m_months(0)
+    , m_weekdays(0)
+    , m_anyDay(true)
+    , m_anyWeekday(true)
+    , m_valid(false)
+{
+}
+
+ScheduleRule ScheduleRule::parse(const QString &expression, QString *error)
+{
+    ScheduleRule rule;
+    rule.m_expression = expression.simplified();
+
+    QStringList fields = rule.m_expression.split(' ', Qt::SkipEmptyParts);
+    if (fields.size() == 5) {
+        fields.prepend("0");
+    }
+    if (fields.size() != 6) {
+        if (error) *error = "Expected 5 or 6 fields";
+        return rule;
+    }
+
+    quint64 seconds, minutes, hours, days, months, weekdays;
+    bool any;
+    if (!parseField(fields[0], 0, 59, &seconds, &any)
+        || !parseField(fields[1], 0, 59, &minutes, &any)
+        || !parseField(fields[2], 0, 23, &hours, &any)
+        || !parseField(fields[3], 1, 31, &days, &rule.m_anyDay)
+        || !parseField(fields[4], 1, 12, &months, &any)
+        || !parseField(fields[5], 0, 7, &weekdays, &rule.m_anyWeekday)) {
+        if (error) *error = "Invalid field in \"" + rule.m_expression + "\"";
+        return rule;
+    }
+
+    // 7 is an alias for Sunday
+    if (weekdays & (quint64(1) << 7)) {
+        weekdays = (weekdays | 1) & ~(quint64(1) << 7);
+    }
+
+    rule.m_seconds = seconds;
+    rule.m_minutes = minutes;
+    rule.m_hours = quint32(hours);
+    rule.m_days = quint32(days);
+    rule.m_months = quint32(months);
+    rule.m_weekdays = quint32(weekdays);
+    rule.m_valid = true;
+    return rule;
+}
+
+bool ScheduleRule::parseField(const QString &field, int minimum, int maximum, quint64 *bits, bool *any)
+{
+    *bits = 0;
+    *any = field == "*";
+
+    for (const QString &part : field.split(',')) {
+        int step = 1;
+        QString range = part;
+        int slash = part.indexOf('/');
+        bool ok = true;
+        if (slash >= 0) {
+            step = part.mid(slash + 1).toInt(&ok);
+            if (!ok || step <= 0) {
+                return false;
+            }
+            range = part.left(slash);
+        }
+
+        int low;
+        int high;
+        if (range == "*") {
+            low = minimum;
+            high = maximum;
+        } else if (range.contains('-')) {
+            bool okHigh = true;
+            low = range.section('-', 0, 0).toInt(&ok);
+            high = range.section('-', 1, 1).toInt(&okHigh);
+            ok = ok && okHigh;
+        } else {
+            low = range.toInt(&ok);
+            high = slash >= 0 ? maximum : low;
+        }
+
+        if (!ok || low < minimum || high > maximum || low > high) {
+            return false;
+        }
+        for (int value = low; value <= high; value += step) {
+            *bits |= quint64(1) << value;
+        }
+    }
+    return *bits != 0;
+}
+
+bool ScheduleRule::matchesDate(const QDate &date) const
+{
+    bool dayMatches = m_days & (quint32(1) << date.day());
+    bool weekdayMatches = m_weekdays & (quint32(1) << (date.dayOfWeek() % 7));
+
+    // Cron semantics: when both are restricted either one may match
+    if (!m_anyDay && !m_anyWeekday) {
+        return dayMatches || weekdayMatches;
+    }
+    return dayMatches && weekdayMatches;
+}
+
+QDateTime ScheduleRule::nextAfter(const QDateTime &time) const
+{
+    if (!m_valid || !time.isValid()) {
+        return QDateTime();
+    }
+
+    QDateTime local = time.toLocalTime();
+    QDate date = local.date();
+    int hour = local.time().hour();
+    int minute = local.time().minute();
+    int second = local.time().second() + 1;
+    if (second > 59) { second = 0; ++minute; }
+    if (minute > 59) { minute = 0; ++hour; }
+    if (hour > 23) { hour = 0; date = date.addDays(1); }
+
+    // Whole months and days are skipped before any time-of-day search
+    QDate limit = date.addYears(5);
+    while (date <= limit) {
+        if (!(m_months & (quint32(1) << date.month()))) {
+            date = QDate(date.year(), date.month(), 1).addMonths(1);
+            hour = minute = second = 0;
+            continue;
+        }
+        if (!matchesDate(date)) {
+            date = date.addDays(1);
+            hour = minute = second = 0;
+            continue;
+        }
+
+        for (int h = nextBit(m_hours, hour, 23); h >= 0; h = nextBit(m_hours, h + 1, 23)) {
+            int minuteFrom = h == hour ? minute : 0;
+            for (int m = nextBit(m_minutes, minuteFrom, 59); m >= 0; m = nextBit(m_minutes, m + 1, 59)) {
+                int secondFrom = (h == hour && m == minute) ? second : 0;
+                int s = nextBit(m_seconds, secondFrom, 59);
+                if (s >= 0) {
+                    return QDateTime(date, QTime(h, m, s));
+                }
+            }
+        }
+
+        date = date.addDays(1);
+        hour = minute = second = 0;
+    }
+    return QDateTime();
+}
 
 Scheduler::Scheduler(Database *database, QObject *parent)
     : QObject(parent)
     , m_database(database)
     , m_checkTimer(new QTimer(this))
+    , m_staleEntries(0)
+    , m_nextId(1)
+    , m_running(false)
 {
+    m_checkTimer->setSingleShot(true);
+    m_checkTimer->setTimerType(Qt::PreciseTimer);
     connect(m_checkTimer, &QTimer::timeout, this, &Scheduler::checkSchedules);
     loadSchedules();
 }
@@ -18,58 +199,121 @@ Scheduler::~Scheduler()
 
 bool Scheduler::addSchedule(const QString &name, const QDateTime &startTime, const QString &url, const QVariantMap &options)
 {
-    QVariantMap schedule;
-    schedule["id"] = m_schedules.size() + 1; // Simple ID generation
-    schedule["name"] = name;
-    schedule["startTime"] = startTime;
-    schedule["url"] = url;
-    schedule["options"] = options;
-    schedule["active"] = true;
+    Schedule schedule;
+    schedule.name = name;
+    schedule.url = url;
+    schedule.options = options;
+    schedule.startTime = startTime;
+    schedule.active = true;
+    return registerSchedule(schedule) > 0;
+}
 
-    m_schedules.append(schedule);
-    saveSchedules();
+int Scheduler::addRecurringSchedule(const QString &name, const QString &rule, const QString &url,
+                                    const QVariantMap &options, const QDateTime &startTime)
+{
+    QString error;
+    Schedule schedule;
+    schedule.rule = ScheduleRule::parse(rule, &error);
+    if (!schedule.rule.isValid()) {
+        emit scheduleError(-1, error);
+        return -1;
+    }
 
-    return true;
+    schedule.name = name;
+    schedule.url = url;
+    schedule.options = options;
+    schedule.startTime = startTime;
+    schedule.active = true;
+    return registerSchedule(schedule);
 }
 
 bool Scheduler::removeSchedule(int scheduleId)
 {
-    for (int i = 0; i < m_schedules.size(); ++i) {
-        if (m_schedules[i]["id"].toInt() == scheduleId) {
-            m_schedules.removeAt(i);
-            saveSchedules();
-            return true;
-        }
+    auto it = m_schedules.find(scheduleId);
+    if (it == m_schedules.end()) {
+        return false;
     }
-    return false;
+
+    // Its heap entries stay behind and are dropped when they surface
+    m_staleEntries += (it->nextFire.isValid() ? 1 : 0) + (it->windowEndMs > 0 ? 1 : 0);
+    m_schedules.erase(it);
+    if (m_database && m_database->isOpen()) {
+        m_database->deleteSchedules({scheduleId});
+    }
+
+    compactHeap();
+    armTimer();
+    return true;
 }
 
 bool Scheduler::updateSchedule(int scheduleId, const QDateTime &newTime)
 {
-    for (QVariantMap &schedule : m_schedules) {
-        if (schedule["id"].toInt() == scheduleId) {
-            schedule["startTime"] = newTime;
-            saveSchedules();
-            return true;
-        }
+    auto it = m_schedules.find(scheduleId);
+    if (it == m_schedules.end()) {
+        return false;
+    }
+
+    it->startTime = newTime;
+    it->lastRun = QDateTime();
+    it->active = true;
+    persistSchedule(*it);
+    reschedule(*it, QDateTime::currentDateTime());
+    armTimer();
+    return true;
+}
+
+bool Scheduler::setScheduleWindow(int scheduleId, const QTime &start, const QTime &end)
+{
+    auto it = m_schedules.find(scheduleId);
+    if (it == m_schedules.end()) {
+        return false;
     }
-    return false;
+
+    it->windowStart = start;
+    it->windowEnd = end;
+    if (it->windowEndMs > 0) {
+        it->windowEndMs = 0;
+        ++m_staleEntries;
+    }
+    persistSchedule(*it);
+    reschedule(*it, QDateTime::currentDateTime());
+    armTimer();
+    return true;
 }
 
 QList<QVariantMap> Scheduler::getSchedules() const
 {
-    return m_schedules;
+    QList<int> ids = m_schedules.keys();
+    std::sort(ids.begin(), ids.end());
+
+    QList<QVariantMap> schedules;
+    schedules.reserve(ids.size());
+    for (int id : ids) {
+        schedules.append(toVariantMap(m_schedules.value(id)));
+    }
+    return schedules;
+}
+
+QDateTime Scheduler::nextFireTime(int scheduleId) const
+{
+    auto it = m_schedules.constFind(scheduleId);
+    return it != m_schedules.constEnd() ? it->nextFire : QDateTime();
+}
+
+int Scheduler::scheduleCount() const
+{
+    return m_schedules.size();
 }
 
 void Scheduler::start()
 {
-    if (!m_checkTimer->isActive()) {
-        m_checkTimer->start(60000); // Check every minute
-    }
+    m_running = true;
+    armTimer();
 }
 
 void Scheduler::stop()
 {
+    m_running = false;
     if (m_checkTimer->isActive()) {
         m_checkTimer->stop();
     }
@@ -77,38 +321,319 @@ void Scheduler::stop()
 
 bool Scheduler::isRunning() const
 {
-    return m_checkTimer->isActive();
+    return m_running;
 }
 
 void Scheduler::checkSchedules()
 {
-    QDateTime now = QDateTime::currentDateTime();
+    qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    QDateTime now = QDateTime::fromMSecsSinceEpoch(nowMs);
+    QList<int> finished;
+    QList<int> ran;
 
-    for (int i = m_schedules.size() - 1; i >= 0; --i) {
-        QVariantMap schedule = m_schedules[i];
-        if (!schedule["active"].toBool()) continue;
+    auto later = [](const TimerEntry &a, const TimerEntry &b) { return laterEntry(a.dueMs, b.dueMs); };
+    while (!m_heap.empty() && m_heap.front().dueMs <= nowMs) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), later);
+        TimerEntry entry = m_heap.back();
+        m_heap.pop_back();
 
-        QDateTime startTime = schedule["startTime"].toDateTime();
-        if (startTime <= now) {
-            emit scheduleTriggered(schedule["id"].toInt(), schedule["url"].toString(), schedule["options"].toMap());
-            // Remove one-time schedule
-            m_schedules.removeAt(i);
-            saveSchedules();
+        if (isStale(entry)) {
+            m_staleEntries = qMax(0, m_staleEntries - 1);
+            continue;
         }
+
+        int id = entry.scheduleId;
+        Schedule &schedule = m_schedules[id];
+        if (!entry.windowEnd) {
+            schedule.nextFire = QDateTime();     // this entry has just left the heap
+        }
+
+        if (entry.windowEnd) {
+            schedule.windowEndMs = 0;
+            // A one-shot schedule is kept only until its window closes
+            if (!schedule.rule.isValid() && !schedule.active) {
+                m_schedules.remove(id);
+                finished.append(id);
+            }
+            emit scheduleWindowEnded(id);
+            continue;
+        }
+
+        // State is settled before emitting; receivers may add or remove schedules
+        QString url = schedule.url;
+        QVariantMap options = schedule.options;
+        schedule.lastRun = now;
+
+        if (hasWindow(schedule)) {
+            qint64 closeMs = windowClose(schedule, now).toMSecsSinceEpoch();
+            if (schedule.windowEndMs != closeMs) {
+                // The close entry already in the heap no longer matches windowEndMs
+                if (schedule.windowEndMs > 0) {
+                    ++m_staleEntries;
+                }
+                schedule.windowEndMs = closeMs;
+                pushEntry(closeMs, schedule, true);
+            }
+        }
+
+        if (schedule.rule.isValid()) {
+            reschedule(schedule, now);
+            ran.append(id);
+        } else if (hasWindow(schedule)) {
+            schedule.active = false;
+            reschedule(schedule, now);
+            ran.append(id);
+        } else {
+            m_schedules.remove(id);
+            finished.append(id);
+        }
+
+        emit scheduleTriggered(id, url, options);
     }
+
+    // One statement per kind of change, however many schedules fired this second
+    if (m_database && m_database->isOpen()) {
+        if (!finished.isEmpty()) {
+            m_database->deleteSchedules(finished);
+        }
+        if (!ran.isEmpty()) {
+            m_database->markSchedulesRun(ran, now);
+        }
+    }
+
+    compactHeap();
+    armTimer();
 }
 
 void Scheduler::loadSchedules()
 {
-    // TODO: Load from database
-    // m_schedules = m_database->getSchedules();
     m_schedules.clear();
+    m_heap.clear();
+    m_staleEntries = 0;
+
+    if (!m_database || !m_database->isOpen()) {
+        return;
+    }
+
+    QDateTime now = QDateTime::currentDateTime();
+    QList<int> expired;
+    const QVariantList rows = m_database->getSchedules();
+    m_heap.reserve(rows.size());
+    for (const QVariant &row : rows) {
+        QVariantMap data = row.toMap();
+        Schedule schedule;
+        schedule.id = data.value("id").toInt();
+        schedule.name = data.value("name").toString();
+        schedule.url = data.value("url").toString();
+        schedule.options = QJsonDocument::fromJson(data.value("options").toByteArray()).object().toVariantMap();
+        schedule.startTime = data.value("start_time").toDateTime();
+        schedule.windowStart = QTime::fromString(data.value("window_start").toString(), WINDOW_TIME_FORMAT);
+        schedule.windowEnd = QTime::fromString(data.value("window_end").toString(), WINDOW_TIME_FORMAT);
+        schedule.active = data.value("active").toBool();
+        schedule.lastRun = data.value("last_run").toDateTime();
+        schedule.windowEndMs = 0;
+        schedule.generation = 0;
+
+        QString rule = data.value("rule").toString();
+        if (!rule.isEmpty()) {
+            schedule.rule = ScheduleRule::parse(rule);
+            if (!schedule.rule.isValid()) {
+                qWarning() << "Skipping schedule" << schedule.id << "with invalid rule" << rule;
+                continue;
+            }
+        }
+
+        m_nextId = qMax(m_nextId, schedule.id + 1);
+        // A one-shot that fired but was waiting for its window to close has nothing left to do
+        if (!schedule.rule.isValid() && !schedule.active) {
+            expired.append(schedule.id);
+            continue;
+        }
+        reschedule(m_schedules.insert(schedule.id, schedule).value(), now);
+    }
+
+    if (!expired.isEmpty()) {
+        m_database->deleteSchedules(expired);
+    }
+}
+
+int Scheduler::persistSchedule(const Schedule &schedule)
+{
+    if (!m_database || !m_database->isOpen()) {
+        return schedule.id > 0 ? schedule.id : m_nextId++;
+    }
+
+    QVariantMap data;
+    data["name"] = schedule.name;
+    data["url"] = schedule.url;
+    data["start_time"] = schedule.startTime;
+    data["rule"] = schedule.rule.expression();
+    data["window_start"] = schedule.windowStart.isValid() ? schedule.windowStart.toString(WINDOW_TIME_FORMAT) : QVariant();
+    data["window_end"] = schedule.windowEnd.isValid() ? schedule.windowEnd.toString(WINDOW_TIME_FORMAT) : QVariant();
+    data["options"] = QJsonDocument(QJsonObject::fromVariantMap(schedule.options)).toJson(QJsonDocument::Compact);
+    data["active"] = schedule.active;
+    data["last_run"] = schedule.lastRun;
+
+    if (schedule.id > 0) {
+        return m_database->updateSchedule(schedule.id, data) ? schedule.id : -1;
+    }
+    return m_database->insertSchedule(data);
+}
+
+int Scheduler::registerSchedule(Schedule schedule)
+{
+    schedule.id = 0;
+    schedule.generation = 0;
+    schedule.windowEndMs = 0;
+
+    int id = persistSchedule(schedule);
+    if (id <= 0) {
+        emit scheduleError(-1, "Failed to save schedule " + schedule.name);
+        return -1;
+    }
+
+    schedule.id = id;
+    reschedule(m_schedules.insert(id, schedule).value(), QDateTime::currentDateTime());
+    armTimer();
+    return id;
+}
+
+void Scheduler::reschedule(Schedule &schedule, const QDateTime &after)
+{
+    if (schedule.nextFire.isValid()) {
+        ++m_staleEntries;
+    }
+
+    ++schedule.generation;
+    schedule.nextFire = schedule.active ? computeNextFire(schedule, after) : QDateTime();
+    if (schedule.nextFire.isValid()) {
+        pushEntry(schedule.nextFire.toMSecsSinceEpoch(), schedule, false);
+    }
+}
+
+QDateTime Scheduler::computeNextFire(const Schedule &schedule, const QDateTime &after) const
+{
+    if (!schedule.rule.isValid()) {
+        // One-shot: an overdue start fires now, deferred to the window if it has one
+        if (schedule.lastRun.isValid() || !schedule.startTime.isValid()) {
+            return QDateTime();
+        }
+        QDateTime candidate = schedule.startTime < after ? after : schedule.startTime;
+        return hasWindow(schedule) ? nextWindowOpen(schedule, candidate) : candidate;
+    }
+
+    QDateTime from = after;
+    if (schedule.startTime.isValid() && schedule.startTime.addSecs(-1) > from) {
+        from = schedule.startTime.addSecs(-1);
+    }
+
+    QDateTime candidate = schedule.rule.nextAfter(from);
+    for (int probe = 0; candidate.isValid() && hasWindow(schedule) && !inWindow(schedule, candidate); ++probe) {
+        if (probe >= MAX_WINDOW_PROBES) {
+            return QDateTime();
+        }
+        candidate = schedule.rule.nextAfter(nextWindowOpen(schedule, candidate).addSecs(-1));
+    }
+    return candidate;
+}
+
+void Scheduler::pushEntry(qint64 dueMs, const Schedule &schedule, bool windowEnd)
+{
+    m_heap.push_back({dueMs, schedule.id, schedule.generation, windowEnd});
+    std::push_heap(m_heap.begin(), m_heap.end(), [](const TimerEntry &a, const TimerEntry &b) {
+        return laterEntry(a.dueMs, b.dueMs);
+    });
+}
+
+bool Scheduler::isStale(const TimerEntry &entry) const
+{
+    auto it = m_schedules.constFind(entry.scheduleId);
+    if (it == m_schedules.constEnd()) {
+        return true;
+    }
+    return entry.windowEnd ? it->windowEndMs != entry.dueMs : it->generation != entry.generation;
+}
+
+void Scheduler::compactHeap()
+{
+    // Lazy deletion keeps updates O(log n); rebuild once stale entries dominate
+    if (m_staleEntries < 1024 || m_staleEntries < int(m_heap.size() / 2)) {
+        return;
+    }
+
+    m_heap.erase(std::remove_if(m_heap.begin(), m_heap.end(), [this](const TimerEntry &entry) {
+        return isStale(entry);
+    }), m_heap.end());
+    std::make_heap(m_heap.begin(), m_heap.end(), [](const TimerEntry &a, const TimerEntry &b) {
+        return laterEntry(a.dueMs, b.dueMs);
+    });
+    m_staleEntries = 0;
+}
+
+void Scheduler::armTimer()
+{
+    auto later = [](const TimerEntry &a, const TimerEntry &b) { return laterEntry(a.dueMs, b.dueMs); };
+    while (!m_heap.empty() && isStale(m_heap.front())) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), later);
+        m_heap.pop_back();
+        m_staleEntries = qMax(0, m_staleEntries - 1);
+    }
+
+    if (!m_running || m_heap.empty()) {
+        m_checkTimer->stop();
+        return;
+    }
+
+    qint64 delay = m_heap.front().dueMs - QDateTime::currentMSecsSinceEpoch();
+    m_checkTimer->start(int(qBound<qint64>(0, delay, MAX_TIMER_INTERVAL)));
+}
+
+QVariantMap Scheduler::toVariantMap(const Schedule &schedule) const
+{
+    QVariantMap map;
+    map["id"] = schedule.id;
+    map["name"] = schedule.name;
+    map["startTime"] = schedule.startTime;
+    map["url"] = schedule.url;
+    map["options"] = schedule.options;
+    map["active"] = schedule.active;
+    map["rule"] = schedule.rule.expression();
+    map["windowStart"] = schedule.windowStart;
+    map["windowEnd"] = schedule.windowEnd;
+    map["lastRun"] = schedule.lastRun;
+    map["nextFire"] = schedule.nextFire;
+    return map;
+}
+
+bool Scheduler::hasWindow(const Schedule &schedule)
+{
+    return schedule.windowStart.isValid() && schedule.windowEnd.isValid()
+        && schedule.windowStart != schedule.windowEnd;
+}
+
+bool Scheduler::inWindow(const Schedule &schedule, const QDateTime &time)
+{
+    QTime t = time.toLocalTime().time();
+    if (schedule.windowStart < schedule.windowEnd) {
+        return t >= schedule.windowStart && t < schedule.windowEnd;
+    }
+    // Wraps midnight, e.g. 23:00-05:00
+    return t >= schedule.windowStart || t < schedule.windowEnd;
+}
+
+QDateTime Scheduler::nextWindowOpen(const Schedule &schedule, const QDateTime &time)
+{
+    if (inWindow(schedule, time)) {
+        return time;
+    }
+    QDateTime local = time.toLocalTime();
+    QDateTime open(local.date(), schedule.windowStart);
+    return open <= local ? open.addDays(1) : open;
 }
 
-void Scheduler::saveSchedules()
+QDateTime Scheduler::windowClose(const Schedule &schedule, const QDateTime &time)
 {
-    // TODO: Save to database
-    // for (const QVariantMap &schedule : m_schedules) {
-    //     m_database->insertSchedule(schedule);
-    // }
+    QDateTime local = time.toLocalTime();
+    QDateTime close(local.date(), schedule.windowEnd);
+    return close <= local ? close.addDays(1) : close;
 }
\ No newline at end of file
@@ -5,10 +5,47 @@
 #include <QTimer>
 #include <QDateTime>
 #include <QList>
+#include <QHash>
 #include <QVariantMap>
+#include <vector>
 
 class Database;
 
+// Cron-style recurrence, "sec min hour day month weekday" or the usual five
+// fields without seconds. Fields accept *, n, a-b, */n, a-b/n and comma lists;
+// weekday is 0-7 with both 0 and 7 meaning Sunday.
+class ScheduleRule
+{
+public:
+    ScheduleRule();
+
+    static ScheduleRule parse(const QString &expression, QString *error = nullptr);
+
+    bool isValid() const { return m_valid; }
+    QString expression() const { return m_expression; }
+
+    // First matching second strictly after time; invalid if none within five years
+    QDateTime nextAfter(const QDateTime &time) const;
+
+private:
+    quint64 m_seconds;
+    quint64 m_minutes;
+    quint32 m_hours;
+    quint32 m_days;         // bits 1-31
+    quint32 m_months;       // bits 1-12
+    quint32 m_weekdays;     // bits 0-6, Sunday = 0
+    bool m_anyDay;
+    bool m_anyWeekday;
+    bool m_valid;
+    QString m_expression;
+
+    bool matchesDate(const QDate &date) const;
+    static bool parseField(const QString &field, int minimum, int maximum, quint64 *bits, bool *any);
+};
+
+// Event-driven scheduler: schedules sit in a min-heap keyed by their next fire
+// time and a single precise timer is armed for the earliest one, so nothing is
+// scanned while idle and firing is exact to the second at any schedule count.
 class Scheduler : public QObject
 {
     Q_OBJECT
@@ -19,9 +56,17 @@ public:
 
     // Schedule management
     bool addSchedule(const QString &name, const QDateTime &startTime, const QString &url, const QVariantMap &options = QVariantMap());
+    // rule is a ScheduleRule expression; the first run is not before startTime. Returns the id or -1
+    int addRecurringSchedule(const QString &name, const QString &rule, const QString &url,
+                             const QVariantMap &options = QVariantMap(), const QDateTime &startTime = QDateTime());
     bool removeSchedule(int scheduleId);
     bool updateSchedule(int scheduleId, const QDateTime &newTime);
+    // Only fire between start and end (may wrap midnight); null times clear the window.
+    // scheduleWindowEnded() is emitted when a window a schedule fired in closes.
+    bool setScheduleWindow(int scheduleId, const QTime &start, const QTime &end);
     QList<QVariantMap> getSchedules() const;
+    QDateTime nextFireTime(int scheduleId) const;
+    int scheduleCount() const;
 
     // Control
     void start();
@@ -31,17 +76,61 @@ public:
 signals:
     void scheduleTriggered(int scheduleId, const QString &url, const QVariantMap &options);
     void scheduleError(int scheduleId, const QString &error);
+    void scheduleWindowEnded(int scheduleId);
 
 private slots:
     void checkSchedules();
 
 private:
+    struct Schedule {
+        int id;
+        QString name;
+        QString url;
+        QVariantMap options;
+        QDateTime startTime;
+        ScheduleRule rule;          // invalid for one-shot schedules
+        QTime windowStart;
+        QTime windowEnd;
+        bool active;
+        QDateTime lastRun;
+        QDateTime nextFire;
+        qint64 windowEndMs;         // pending window-close event, 0 if none
+        quint32 generation;         // bumped on every change; older heap entries are stale
+    };
+
+    struct TimerEntry {
+        qint64 dueMs;
+        int scheduleId;
+        quint32 generation;
+        bool windowEnd;
+    };
+
     Database *m_database;
     QTimer *m_checkTimer;
-    QList<QVariantMap> m_schedules;
+    QHash<int, Schedule> m_schedules;
+    std::vector<TimerEntry> m_heap;     // min-heap on dueMs, stale entries removed lazily
+    int m_staleEntries;
+    int m_nextId;
+    bool m_running;
+
+    static const int MAX_TIMER_INTERVAL = 60 * 60 * 1000;  // re-check wall clock hourly (DST, suspend)
+    static const int MAX_WINDOW_PROBES = 400;
 
     void loadSchedules();
-    void saveSchedules();
+    int persistSchedule(const Schedule &schedule);
+    int registerSchedule(Schedule schedule);
+    void reschedule(Schedule &schedule, const QDateTime &after);
+    QDateTime computeNextFire(const Schedule &schedule, const QDateTime &after) const;
+    void pushEntry(qint64 dueMs, const Schedule &schedule, bool windowEnd);
+    bool isStale(const TimerEntry &entry) const;
+    void compactHeap();
+    void armTimer();
+    QVariantMap toVariantMap(const Schedule &schedule) const;
+
+    static bool hasWindow(const Schedule &schedule);
+    static bool inWindow(const Schedule &schedule, const QDateTime &time);
+    static QDateTime nextWindowOpen(const Schedule &schedule, const QDateTime &time);
+    static QDateTime windowClose(const Schedule &schedule, const QDateTime &time);
 };
 
 #endif // SCHEDULER_H
\ No newline at end of file
@@ -0,0 +1,427 @@
+#include "SchemaMigrator.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QThread>
+#include <QVariant>
+#include <QDebug>
+#include <algorithm>
+
+static const char *MIGRATOR_CONNECTION = "ldm-schema-migrator";
+
+SchemaMigrator::SchemaMigrator(QObject *parent)
+    : SchemaMigrator(defaultMigrations(), parent)
+{
+}
+
+SchemaMigrator::SchemaMigrator(const QList<Migration> &migrations, QObject *parent)
+    : QObject(parent)
+    , m_migrations(migrations)
+    , m_batchSize(10000)
+    , m_cancelled(false)
+{
+    std::sort(m_migrations.begin(), m_migrations.end(), [](const Migration &a, const Migration &b) {
+        return a.version < b.version;
+    });
+}
+
+QList<SchemaMigrator::Migration> SchemaMigrator::defaultMigrations()
+{
+    QList<Migration> migrations;
+
+    // Baseline schema: everything created by createTables() before versioning existed
+    migrations.append({1, "Baseline schema", {
+        "CREATE TABLE IF NOT EXISTS downloads ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "url TEXT NOT NULL,"
+        "filename TEXT,"
+        "filepath TEXT,"
+        "status TEXT NOT NULL CHECK (status IN ('queued', 'downloading', 'paused', 'completed', 'failed', 'cancelled')),"
+        "progress REAL CHECK (progress >= 0.0 AND progress <= 1.0),"
+        "total_size INTEGER,"
+        "downloaded_size INTEGER DEFAULT 0,"
+        "speed INTEGER,"
+        "eta INTEGER,"
+        "error_message TEXT,"
+        "created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+        "started_at DATETIME,"
+        "completed_at DATETIME,"
+        "category_id INTEGER,"
+        "checksum TEXT,"
+        "checksum_type TEXT,"
+        "priority INTEGER DEFAULT 1,"
+        "segments INTEGER DEFAULT 1 CHECK (segments >= 1 AND segments <= 32),"
+        "referrer TEXT,"
+        "user_agent TEXT,"
+        "authentication TEXT,"
+        "proxy TEXT,"
+        "resume_supported BOOLEAN DEFAULT 1,"
+        "antivirus_scanned BOOLEAN DEFAULT 0,"
+        "antivirus_result TEXT,"
+        "encrypted BOOLEAN DEFAULT 0,"
+        "metadata TEXT,"
+        "FOREIGN KEY (category_id) REFERENCES categories(id)"
+        ")",
+        "CREATE TABLE IF NOT EXISTS categories ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "name TEXT NOT NULL UNIQUE,"
+        "description TEXT,"
+        "default_path TEXT,"
+        "color TEXT,"
+        "icon TEXT,"
+        "created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+        "updated_at DATETIME DEFAULT CURRENT_TIMESTAMP"
+        ")",
+        "CREATE TABLE IF NOT EXISTS download_segments ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "download_id INTEGER NOT NULL,"
+        "segment_index INTEGER NOT NULL,"
+        "start_offset INTEGER NOT NULL,"
+        "end_offset INTEGER NOT NULL,"
+        "downloaded_size INTEGER DEFAULT 0,"
+        "status TEXT DEFAULT 'pending',"
+        "FOREIGN KEY (download_id) REFERENCES downloads(id) ON DELETE CASCADE"
+        ")",
+        "CREATE TABLE IF NOT EXISTS download_history ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "download_id INTEGER,"
+        "url TEXT,"
+        "filename TEXT,"
+        "filepath TEXT,"
+        "size INTEGER,"
+        "completed_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+        "duration INTEGER,"
+        "average_speed INTEGER,"
+        "category_name TEXT,"
+        "success BOOLEAN DEFAULT 1,"
+        "FOREIGN KEY (download_id) REFERENCES downloads(id)"
+        ")",
+        "CREATE TABLE IF NOT EXISTS history_daily_stats ("
+        "day TEXT PRIMARY KEY,"
+        "downloads INTEGER DEFAULT 0,"
+        "successes INTEGER DEFAULT 0,"
+        "total_bytes INTEGER DEFAULT 0,"
+        "total_duration INTEGER DEFAULT 0"
+        ")",
+        "CREATE TABLE IF NOT EXISTS settings ("
+        "key TEXT PRIMARY KEY,"
+        "value TEXT,"
+        "type TEXT CHECK (type IN ('string', 'int', 'bool', 'json')),"
+        "category TEXT,"
+        "description TEXT"
+        ")",
+        "CREATE TABLE IF NOT EXISTS browser_extensions ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "browser TEXT NOT NULL,"
+        "enabled BOOLEAN DEFAULT 1,"
+        "settings TEXT"
+        ")",
+        "CREATE TABLE IF NOT EXISTS plugins ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "name TEXT NOT NULL UNIQUE,"
+        "version TEXT,"
+        "type TEXT,"
+        "enabled BOOLEAN DEFAULT 1,"
+        "settings TEXT,"
+        "installed_at DATETIME DEFAULT CURRENT_TIMESTAMP"
+        ")",
+        "CREATE TABLE IF NOT EXISTS password_entries ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "domain TEXT NOT NULL,"
+        "username TEXT,"
+        "password TEXT NOT NULL,"
+        "created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+        "last_used DATETIME"
+        ")",
+        "CREATE TABLE IF NOT EXISTS favorite_sites ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "name TEXT,"
+        "url TEXT NOT NULL,"
+        "category TEXT,"
+        "added_at DATETIME DEFAULT CURRENT_TIMESTAMP"
+        ")",
+        "CREATE INDEX IF NOT EXISTS idx_downloads_status ON downloads(status)",
+        "CREATE INDEX IF NOT EXISTS idx_downloads_category ON downloads(category_id)",
+        "CREATE INDEX IF NOT EXISTS idx_downloads_created ON downloads(created_at)",
+        "CREATE INDEX IF NOT EXISTS idx_history_completed ON download_history(completed_at)",
+        "CREATE INDEX IF NOT EXISTS idx_segments_download ON download_segments(download_id)",
+        "CREATE VIRTUAL TABLE IF NOT EXISTS downloads_fts USING fts5(url, filename, filepath, content=downloads)"
+    }, QString(), QString(), false});
+
+    // Lookup by URL for duplicate detection on imports; built in the background on large databases.
+    // CREATE INDEX would hold the write lock for the whole build, so the lookup is a keyed side
+    // table instead: triggers keep new writes in step and the existing rows are copied in batches
+    migrations.append({2, "Index downloads by URL", {
+        "CREATE TABLE IF NOT EXISTS download_urls ("
+        "url TEXT NOT NULL,"
+        "download_id INTEGER NOT NULL,"
+        "PRIMARY KEY (url, download_id)"
+        ") WITHOUT ROWID",
+        "CREATE TRIGGER IF NOT EXISTS download_urls_insert AFTER INSERT ON downloads BEGIN "
+        "INSERT OR IGNORE INTO download_urls (url, download_id) VALUES (new.url, new.id); END",
+        "CREATE TRIGGER IF NOT EXISTS download_urls_update AFTER UPDATE OF url ON downloads BEGIN "
+        "DELETE FROM download_urls WHERE url = old.url AND download_id = old.id; "
+        "INSERT OR IGNORE INTO download_urls (url, download_id) VALUES (new.url, new.id); END",
+        "CREATE TRIGGER IF NOT EXISTS download_urls_delete AFTER DELETE ON downloads BEGIN "
+        "DELETE FROM download_urls WHERE url = old.url AND download_id = old.id; END"
+    }, "downloads",
+       "INSERT OR IGNORE INTO download_urls (url, download_id) "
+       "SELECT url, id FROM downloads WHERE id BETWEEN :first AND :last", true});
+
+    // Persistent scheduler; rule is a cron-style expression, empty for one-shot schedules
+    migrations.append({3, "Add schedules table", {
+        "CREATE TABLE IF NOT EXISTS schedules ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "name TEXT,"
+        "url TEXT NOT NULL,"
+        "start_time DATETIME,"
+        "rule TEXT,"
+        "window_start TEXT,"
+        "window_end TEXT,"
+        "options TEXT,"
+        "active INTEGER DEFAULT 1,"
+        "last_run DATETIME,"
+        "created_at DATETIME DEFAULT CURRENT_TIMESTAMP"
+        ")"
+    }, QString(), QString(), false});
+
+    return migrations;
+}
+
+int SchemaMigrator::defaultLatestVersion()
+{
+    static const int version = SchemaMigrator().latestVersion();
+    return version;
+}
+
+int SchemaMigrator::latestVersion() const
+{
+    return m_migrations.isEmpty() ? 0 : m_migrations.last().version;
+}
+
+void SchemaMigrator::setBatchSize(int rows)
+{
+    m_batchSize = qMax(1, rows);
+}
+
+QString SchemaMigrator::lastError() const
+{
+    return m_lastError;
+}
+
+bool SchemaMigrator::migrate(QSqlDatabase database, bool includeOnline)
+{
+    if (!ensureVersionTable(database)) {
+        return false;
+    }
+
+    QSet<int> applied = appliedVersions(database);
+
+    // A brand-new file has no rows to migrate, so nothing is worth deferring
+    if (applied.isEmpty() && !database.tables().contains("downloads")) {
+        includeOnline = true;
+    }
+
+    for (const Migration &migration : m_migrations) {
+        if (applied.contains(migration.version) || (migration.online && !includeOnline)) {
+            continue;
+        }
+        if (!applyMigration(database, migration)) {
+            return false;
+        }
+        applied.insert(migration.version);
+    }
+
+    updateUserVersion(database, applied);
+    return true;
+}
+
+QList<int> SchemaMigrator::pendingVersions(QSqlDatabase database)
+{
+    QList<int> pending;
+    if (!ensureVersionTable(database)) {
+        return pending;
+    }
+
+    QSet<int> applied = appliedVersions(database);
+    for (const Migration &migration : m_migrations) {
+        if (!applied.contains(migration.version)) {
+            pending.append(migration.version);
+        }
+    }
+    return pending;
+}
+
+void SchemaMigrator::runOnline(const QString &databasePath)
+{
+    bool success = false;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", MIGRATOR_CONNECTION);
+        database.setDatabaseName(databasePath);
+        if (database.open()) {
+            // Share the file with the UI connection instead of failing on its short write locks
+            QSqlQuery(database).exec("PRAGMA busy_timeout = 5000");
+            success = migrate(database, true);
+            database.close();
+        } else {
+            m_lastError = database.lastError().text();
+        }
+    }
+    QSqlDatabase::removeDatabase(MIGRATOR_CONNECTION);
+
+    if (!success) {
+        qWarning() << "Schema migration stopped:" << m_lastError;
+    }
+    emit finished(success);
+}
+
+void SchemaMigrator::cancel()
+{
+    m_cancelled = true;
+}
+
+bool SchemaMigrator::ensureVersionTable(QSqlDatabase &database)
+{
+    QSqlQuery query(database);
+    if (!query.exec("CREATE TABLE IF NOT EXISTS schema_version ("
+                    "version INTEGER PRIMARY KEY,"
+                    "description TEXT,"
+                    "applied_at DATETIME DEFAULT CURRENT_TIMESTAMP"
+                    ")")) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QSet<int> SchemaMigrator::appliedVersions(QSqlDatabase &database)
+{
+    QSet<int> versions;
+    QSqlQuery query(database);
+    if (query.exec("SELECT version FROM schema_version")) {
+        while (query.next()) {
+            versions.insert(query.value(0).toInt());
+        }
+    }
+    return versions;
+}
+
+bool SchemaMigrator::applyMigration(QSqlDatabase &database, const Migration &migration)
+{
+    emit migrationStarted(migration.version, migration.description);
+
+    if (!database.transaction()) {
+        return fail(database, database.lastError().text());
+    }
+
+    QSqlQuery query(database);
+    for (const QString &statement : migration.statements) {
+        if (!query.exec(statement)) {
+            return fail(database, QString("Migration %1 failed: %2").arg(migration.version).arg(query.lastError().text()));
+        }
+    }
+
+    // Without a batch step the version is recorded atomically with the DDL
+    if (migration.batchStatement.isEmpty()) {
+        if (!recordVersion(database, migration) || !database.commit()) {
+            return fail(database, database.lastError().text());
+        }
+        emit migrationFinished(migration.version);
+        return true;
+    }
+
+    if (!database.commit()) {
+        return fail(database, database.lastError().text());
+    }
+
+    if (!runBatches(database, migration)) {
+        return false;
+    }
+
+    if (!database.transaction() || !recordVersion(database, migration) || !database.commit()) {
+        return fail(database, database.lastError().text());
+    }
+
+    emit migrationFinished(migration.version);
+    return true;
+}
+
+bool SchemaMigrator::runBatches(QSqlDatabase &database, const Migration &migration)
+{
+    QSqlQuery range(database);
+    if (!range.exec(QString("SELECT MIN(id), MAX(id) FROM %1").arg(migration.batchTable)) || !range.next()) {
+        m_lastError = range.lastError().text();
+        return false;
+    }
+    if (range.value(0).isNull()) {
+        return true;
+    }
+
+    qint64 minId = range.value(0).toLongLong();
+    qint64 maxId = range.value(1).toLongLong();
+    qint64 total = maxId - minId + 1;
+
+    // Short transactions keep the write lock brief so the UI connection is never starved
+    QSqlQuery batch(database);
+    batch.prepare(migration.batchStatement);
+    for (qint64 first = minId; first <= maxId; first += m_batchSize) {
+        if (isCancelled()) {
+            m_lastError = "Cancelled";
+            return false;
+        }
+
+        qint64 last = qMin(first + m_batchSize - 1, maxId);
+        database.transaction();
+        batch.bindValue(":first", first);
+        batch.bindValue(":last", last);
+        if (!batch.exec()) {
+            return fail(database, QString("Migration %1 failed at id %2: %3")
+                                  .arg(migration.version).arg(first).arg(batch.lastError().text()));
+        }
+        if (!database.commit()) {
+            return fail(database, database.lastError().text());
+        }
+
+        emit migrationProgress(migration.version, last - minId + 1, total);
+    }
+
+    return true;
+}
+
+bool SchemaMigrator::recordVersion(QSqlDatabase &database, const Migration &migration)
+{
+    QSqlQuery query(database);
+    query.prepare("INSERT OR REPLACE INTO schema_version (version, description) VALUES (:version, :description)");
+    query.bindValue(":version", migration.version);
+    query.bindValue(":description", migration.description);
+    if (!query.exec()) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void SchemaMigrator::updateUserVersion(QSqlDatabase &database, const QSet<int> &applied)
+{
+    // user_version is the highest version with no gaps below it, so a pending online
+    // migration keeps the fast path in Database::createTables() disabled
+    int contiguous = 0;
+    for (const Migration &migration : m_migrations) {
+        if (!applied.contains(migration.version)) {
+            break;
+        }
+        contiguous = migration.version;
+    }
+    QSqlQuery(database).exec(QString("PRAGMA user_version = %1").arg(contiguous));
+}
+
+bool SchemaMigrator::isCancelled() const
+{
+    return m_cancelled || QThread::currentThread()->isInterruptionRequested();
+}
+
+bool SchemaMigrator::fail(QSqlDatabase &database, const QString &error)
+{
+    database.rollback();
+    m_lastError = error;
+    return false;
+}
\ No newline at end of file
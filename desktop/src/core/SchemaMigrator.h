@@ -0,0 +1,68 @@
+#ifndef SCHEMAMIGRATOR_H
+#define SCHEMAMIGRATOR_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSet>
+#include <QSqlDatabase>
+#include <atomic>
+
+class SchemaMigrator : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Migration {
+        int version;
+        QString description;
+        QStringList statements;   // run once, in a single transaction
+        QString batchTable;       // optional: table whose id range drives batchStatement
+        QString batchStatement;   // optional: run per id range, binds :first and :last; must be idempotent
+        bool online;              // may be deferred to the background after open() returns
+    };
+
+    explicit SchemaMigrator(QObject *parent = nullptr);
+    explicit SchemaMigrator(const QList<Migration> &migrations, QObject *parent = nullptr);
+
+    static QList<Migration> defaultMigrations();
+    static int defaultLatestVersion();
+    int latestVersion() const;
+
+    // Applies pending migrations in version order. Online migrations are skipped unless
+    // includeOnline is set or the database is being created from scratch.
+    bool migrate(QSqlDatabase database, bool includeOnline = false);
+    QList<int> pendingVersions(QSqlDatabase database);
+    QString lastError() const;
+
+    void setBatchSize(int rows);
+
+public slots:
+    // Opens a private connection to databasePath; meant to run on a worker thread
+    void runOnline(const QString &databasePath);
+    void cancel();
+
+signals:
+    void migrationStarted(int version, const QString &description);
+    void migrationProgress(int version, qint64 rowsDone, qint64 rowsTotal);
+    void migrationFinished(int version);
+    void finished(bool success);
+
+private:
+    QList<Migration> m_migrations;
+    QString m_lastError;
+    int m_batchSize;
+    std::atomic<bool> m_cancelled;
+
+    bool ensureVersionTable(QSqlDatabase &database);
+    QSet<int> appliedVersions(QSqlDatabase &database);
+    bool applyMigration(QSqlDatabase &database, const Migration &migration);
+    bool runBatches(QSqlDatabase &database, const Migration &migration);
+    bool recordVersion(QSqlDatabase &database, const Migration &migration);
+    void updateUserVersion(QSqlDatabase &database, const QSet<int> &applied);
+    bool isCancelled() const;
+    bool fail(QSqlDatabase &database, const QString &error);
+};
+
+#endif // SCHEMAMIGRATOR_H
\ No newline at end of file
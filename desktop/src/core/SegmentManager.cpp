@@ -1,6 +1,264 @@
 #include "SegmentManager.h"
 #include <QDir>
 #include <QDebug>
+#include <QDeadlineTimer>
+#include <algorithm>
+#include <cstring>
+#include "utils/Metrics.h"
+
+SegmentStatsBuffer::SegmentStatsBuffer()
+    : m_generation(0)
+{
+    std::memset(m_slots, 0, sizeof(m_slots));
+}
+
+static SegmentSnapshot::State snapshotState(const QString &status)
+{
+    if (status == "downloading") return SegmentSnapshot::Downloading;
+    if (status == "paused") return SegmentSnapshot::Paused;
+    if (status == "completed") return SegmentSnapshot::Completed;
+    if (status == "failed") return SegmentSnapshot::Failed;
+    if (status == "cancelled") return SegmentSnapshot::Cancelled;
+    return SegmentSnapshot::Pending;
+}
+
+void SegmentStatsBuffer::publish(const QList<DownloadSegment> &segments, qint64 elapsedMs)
+{
+    quint64 generation = m_generation.load(std::memory_order_relaxed);
+    m_generation.store(generation + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Publication n lives in slot n & 1; readers of the other slot are untouched
+    Slot &slot = m_slots[(generation / 2 + 1) & 1];
+    slot.count = qMin(int(segments.size()), int(MAX_SEGMENTS));
+    for (int i = 0; i < slot.count; ++i) {
+        const DownloadSegment &segment = segments.at(i);
+        SegmentSnapshot &out = slot.segments[i];
+        out.index = segment.index;
+        out.startOffset = segment.startOffset;
+        out.endOffset = segment.endOffset;
+        out.downloadedSize = segment.downloadedSize;
+        out.speed = elapsedMs > 0 ? (segment.downloadedSize - segment.publishedSize) * 1000 / elapsedMs : 0;
+        out.retryCount = segment.networkManager ? segment.networkManager->getCurrentRetry() : 0;
+        out.state = snapshotState(segment.status);
+    }
+
+    m_generation.store(generation + 2, std::memory_order_release);
+}
+
+QVector<SegmentSnapshot> SegmentStatsBuffer::read() const
+{
+    QVector<SegmentSnapshot> result;
+    for (;;) {
+        quint64 before = m_generation.load(std::memory_order_acquire);
+        const Slot &slot = m_slots[(before / 2) & 1];
+        int count = qBound(0, slot.count, int(MAX_SEGMENTS));
+        result.resize(count);
+        std::memcpy(result.data(), slot.segments, count * sizeof(SegmentSnapshot));
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // The slot we copied is only rewritten two publications later
+        quint64 after = m_generation.load(std::memory_order_relaxed);
+        if (after <= (before | 1) + 1) {
+            return result;
+        }
+    }
+}
+
+RangeAvailability::RangeAvailability()
+    : m_totalSize(-1)
+    , m_requestedOffset(-1)
+    , m_activeReads(0)
+    , m_completed(false)
+    , m_aborted(false)
+{
+}
+
+void RangeAvailability::reset(const QList<DownloadSegment> &segments, qint64 totalSize, const QString &filepath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_ranges.clear();
+    for (const DownloadSegment &segment : segments) {
+        Range range;
+        range.start = segment.startOffset;
+        range.end = segment.endOffset < 0 ? totalSize : segment.endOffset + 1;
+        range.available = segment.downloadedSize;
+        m_ranges.append(range);
+    }
+    m_filepath = filepath;
+    m_totalSize = totalSize;
+    m_completed = false;
+    m_aborted = false;
+    m_dataChanged.wakeAll();
+}
+
+void RangeAvailability::setAvailable(int index, qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    if (index < 0 || index >= m_ranges.size()) {
+        return;
+    }
+
+    // A retried range restarts its counter; what is on disk does not go away
+    Range &range = m_ranges[index];
+    bytes = qMin(bytes, range.end - range.start);
+    if (bytes > range.available) {
+        range.available = bytes;
+        m_dataChanged.wakeAll();
+    }
+}
+
+void RangeAvailability::markCompleted()
+{
+    QMutexLocker locker(&m_mutex);
+    m_completed = true;
+    // Readers still inside a part file finish before the parts are removed
+    while (m_activeReads > 0) {
+        m_readsDrained.wait(&m_mutex);
+    }
+    m_dataChanged.wakeAll();
+}
+
+void RangeAvailability::abort()
+{
+    QMutexLocker locker(&m_mutex);
+    m_aborted = true;
+    m_dataChanged.wakeAll();
+}
+
+qint64 RangeAvailability::totalSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_totalSize;
+}
+
+qint64 RangeAvailability::contiguousFrom(qint64 offset) const
+{
+    QMutexLocker locker(&m_mutex);
+    return contiguousFromLocked(offset);
+}
+
+bool RangeAvailability::isAborted() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_aborted;
+}
+
+qint64 RangeAvailability::requestedOffset() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_requestedOffset;
+}
+
+int RangeAvailability::rangeIndexAt(qint64 offset) const
+{
+    QMutexLocker locker(&m_mutex);
+    return rangeAt(offset);
+}
+
+void RangeAvailability::setRequestHandler(std::function<void()> handler)
+{
+    QMutexLocker locker(&m_mutex);
+    m_requestHandler = std::move(handler);
+}
+
+bool RangeAvailability::waitForData(qint64 offset, int timeoutMs)
+{
+    QMutexLocker locker(&m_mutex);
+    QDeadlineTimer deadline(timeoutMs);
+    // An unknown size is not EOF: the reader waits until the segments are laid out
+    while (!m_aborted && (m_totalSize < 0 || (offset < m_totalSize && contiguousFromLocked(offset) == 0))) {
+        if (m_requestedOffset != offset) {
+            m_requestedOffset = offset;
+            if (m_requestHandler) {
+                m_requestHandler();
+            }
+        }
+        if (!m_dataChanged.wait(&m_mutex, deadline)) {
+            return false;
+        }
+    }
+
+    if (m_requestedOffset == offset) {
+        m_requestedOffset = -1;
+    }
+    return !m_aborted && offset < m_totalSize;
+}
+
+bool RangeAvailability::beginRead(qint64 offset, qint64 maxLength, Location *location)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_aborted) {
+        return false;
+    }
+
+    if (m_completed) {
+        location->path = m_filepath;
+        location->fileOffset = offset;
+        location->length = qMin(maxLength, m_totalSize - offset);
+    } else {
+        int index = rangeAt(offset);
+        if (index < 0) {
+            return false;
+        }
+        const Range &range = m_ranges.at(index);
+        location->path = m_filepath + ".part" + QString::number(index);
+        location->fileOffset = offset - range.start;
+        location->length = qMin(maxLength, range.available - location->fileOffset);
+    }
+
+    if (location->length <= 0) {
+        return false;
+    }
+    ++m_activeReads;
+    return true;
+}
+
+void RangeAvailability::endRead()
+{
+    QMutexLocker locker(&m_mutex);
+    if (--m_activeReads == 0) {
+        m_readsDrained.wakeAll();
+    }
+}
+
+int RangeAvailability::rangeAt(qint64 offset) const
+{
+    // Ranges are sorted and adjacent, so a binary search on start is enough
+    auto it = std::upper_bound(m_ranges.cbegin(), m_ranges.cend(), offset,
+                               [](qint64 value, const Range &range) { return value < range.start; });
+    if (it == m_ranges.cbegin()) {
+        return -1;
+    }
+    --it;
+    return offset < it->end ? int(it - m_ranges.cbegin()) : -1;
+}
+
+qint64 RangeAvailability::contiguousFromLocked(qint64 offset) const
+{
+    if (offset < 0 || offset >= m_totalSize) {
+        return 0;
+    }
+    if (m_completed) {
+        return m_totalSize - offset;
+    }
+
+    // A fully downloaded range carries on into the next one
+    qint64 contiguous = 0;
+    for (int index = rangeAt(offset); index >= 0 && index < m_ranges.size(); ++index) {
+        const Range &range = m_ranges.at(index);
+        qint64 from = qMax(offset, range.start);
+        qint64 availableEnd = range.start + range.available;
+        if (availableEnd <= from) {
+            break;
+        }
+        contiguous += availableEnd - from;
+        if (availableEnd < range.end) {
+            break;
+        }
+    }
+    return contiguous;
+}
 
 SegmentManager::SegmentManager(const QUrl &url, const QString &filepath, int numSegments, QObject *parent)
     : QObject(parent)
@@ -13,11 +271,24 @@ SegmentManager::SegmentManager(const QUrl &url, const QString &filepath, int num
     , m_isCompleted(false)
     , m_hasFailed(false)
     , m_sizeFetcher(new NetworkManager(this))
+    , m_statsTimer(new QTimer(this))
+    , m_sequentialLayout(false)
+    , m_previewReaders(0)
+    , m_availability(new RangeAvailability)
 {
+    m_statsTimer->setInterval(STATS_PUBLISH_INTERVAL);
+    connect(m_statsTimer, &QTimer::timeout, this, &SegmentManager::publishSegmentStats);
+
+    // A seek reschedules right away instead of when the next segment finishes
+    m_availability->setRequestHandler([this]() {
+        QMetaObject::invokeMethod(this, [this]() { scheduleSequentialSegments(); }, Qt::QueuedConnection);
+    });
 }
 
 SegmentManager::~SegmentManager()
 {
+    // Readers may outlive the manager; they must not post to it any more
+    m_availability->setRequestHandler(nullptr);
     cancelDownload();
     if (m_file.isOpen()) {
         m_file.close();
@@ -27,28 +298,72 @@ SegmentManager::~SegmentManager()
 void SegmentManager::initializeSegments(qint64 totalSize)
 {
     m_segments.clear();
-    qint64 segmentSize = totalSize / m_numSegments;
-    qint64 remainder = totalSize % m_numSegments;
-    qint64 start = 0;
-    for (int i = 0; i < m_numSegments; ++i) {
-        qint64 end = start + segmentSize - 1;
-        if (i < remainder) end++;
-        DownloadSegment segment;
-        segment.index = i;
-        segment.startOffset = start;
-        segment.endOffset = (i == m_numSegments - 1) ? -1 : end;
-        segment.downloadedSize = 0;
-        segment.status = "pending";
-        segment.networkManager = new NetworkManager(this);
-        connect(segment.networkManager, &NetworkManager::downloadProgress,
-                this, &SegmentManager::onNetworkProgress);
-        connect(segment.networkManager, &NetworkManager::downloadFinished,
-                this, &SegmentManager::onNetworkFinished);
-        m_segments.append(segment);
-        start = end + 1;
+    if (m_sequentialLayout) {
+        initializeSequentialSegments(totalSize);
+    } else {
+        qint64 segmentSize = totalSize / m_numSegments;
+        qint64 remainder = totalSize % m_numSegments;
+        qint64 start = 0;
+        for (int i = 0; i < m_numSegments; ++i) {
+            qint64 end = start + segmentSize - 1;
+            if (i < remainder) end++;
+            m_segments.append(createSegment(i, start, (i == m_numSegments - 1) ? -1 : end));
+            start = end + 1;
+        }
+    }
+    m_availability->reset(m_segments, totalSize, m_filepath);
+
+    // Segments may be initialised from a pool thread; the timer belongs to ours
+    QMetaObject::invokeMethod(m_statsTimer, [this]() {
+        m_statsClock.start();
+        m_statsTimer->start();
+    });
+}
+
+void SegmentManager::initializeSequentialSegments(qint64 totalSize)
+{
+    // Head and tail first so container headers are readable early, e.g. an MP4
+    // moov atom at the end; the middle is cut finer so the frontier advances steadily
+    qint64 head = qMin(SEQUENTIAL_HEAD_BYTES, totalSize);
+    qint64 tail = qMin(SEQUENTIAL_TAIL_BYTES, totalSize - head);
+    qint64 middle = totalSize - head - tail;
+
+    QList<qint64> starts;
+    starts.append(0);
+    if (middle > 0) {
+        qint64 maxPieces = qMin<qint64>(m_numSegments * 2, SegmentStatsBuffer::MAX_SEGMENTS - 2);
+        qint64 pieces = qBound<qint64>(1, middle / SEQUENTIAL_MIN_CHUNK, maxPieces);
+        for (qint64 i = 0; i < pieces; ++i) {
+            starts.append(head + middle * i / pieces);
+        }
+    }
+    if (tail > 0) {
+        starts.append(totalSize - tail);
+    }
+
+    for (int i = 0; i < starts.size(); ++i) {
+        qint64 end = i + 1 < starts.size() ? starts.at(i + 1) - 1 : -1;
+        m_segments.append(createSegment(i, starts.at(i), end));
     }
 }
 
+DownloadSegment SegmentManager::createSegment(int index, qint64 startOffset, qint64 endOffset)
+{
+    DownloadSegment segment;
+    segment.index = index;
+    segment.startOffset = startOffset;
+    segment.endOffset = endOffset;
+    segment.downloadedSize = 0;
+    segment.publishedSize = 0;
+    segment.status = "pending";
+    segment.networkManager = new NetworkManager(this);
+    connect(segment.networkManager, &NetworkManager::downloadProgress,
+            this, &SegmentManager::onNetworkProgress);
+    connect(segment.networkManager, &NetworkManager::downloadFinished,
+            this, &SegmentManager::onNetworkFinished);
+    return segment;
+}
+
 void SegmentManager::startDownload()
 {
     if (m_isDownloading || m_isCompleted || m_hasFailed) {
@@ -62,10 +377,14 @@ void SegmentManager::startDownload()
         fetchTotalSize();
     } else {
         initializeSegments(m_totalSize);
+        if (m_sequentialLayout) {
+            scheduleSequentialSegments();
+            return;
+        }
 
         // Use Qt Concurrent to start all segments in parallel
         QList<int> segmentIndices;
-        for (int i = 0; i < m_numSegments; ++i) {
+        for (int i = 0; i < m_segments.size(); ++i) {
             segmentIndices.append(i);
         }
 
@@ -97,6 +416,68 @@ void SegmentManager::startSegment(int index)
     segment.networkManager->downloadRange(m_url, partFile, segment.startOffset, segment.endOffset);
 }
 
+void SegmentManager::scheduleSequentialSegments()
+{
+    if (!m_sequentialLayout || !m_isDownloading || m_isPaused || m_isCompleted || m_hasFailed || m_segments.isEmpty()) {
+        return;
+    }
+
+    int active = 0;
+    for (const auto &segment : m_segments) {
+        if (segment.status == "downloading") {
+            ++active;
+        }
+    }
+
+    // The segment a previewing reader is blocked on (a seek) starts now, one
+    // connection over the window if need be, rather than when a slot frees up
+    bool previewing = m_previewReaders > 0;
+    qint64 wanted = previewing ? m_availability->requestedOffset() : -1;
+    int blocked = wanted >= 0 ? m_availability->rangeIndexAt(wanted) : -1;
+    if (blocked >= 0 && m_segments.at(blocked).status == "pending") {
+        startSegment(blocked);
+        ++active;
+    }
+
+    // A preview keeps the head from sharing bandwidth with everything else
+    // until it is in; otherwise every connection is used
+    int window = m_numSegments;
+    if (previewing && m_segments.at(0).status != "completed") {
+        window = qMin(window, SEQUENTIAL_WINDOW);
+    }
+
+    // Pending segments are taken in offset order, after the head and tail while previewing
+    int tail = m_segments.size() - 1;
+    while (active < window) {
+        int next = -1;
+        if (previewing && m_segments.at(0).status == "pending") {
+            next = 0;
+        } else if (previewing && m_segments.at(tail).status == "pending") {
+            next = tail;
+        } else {
+            for (int i = 0; i < m_segments.size(); ++i) {
+                if (m_segments.at(i).status != "pending") {
+                    continue;
+                }
+                qint64 end = m_segments.at(i).endOffset < 0 ? m_availability->totalSize() : m_segments.at(i).endOffset;
+                if (next < 0) {
+                    next = i;
+                }
+                if (wanted < 0 || end >= wanted) {
+                    next = i;
+                    break;
+                }
+            }
+        }
+
+        if (next < 0) {
+            return;
+        }
+        startSegment(next);
+        ++active;
+    }
+}
+
 void SegmentManager::pauseDownload()
 {
     if (!m_isDownloading || m_isPaused) {
@@ -131,10 +512,12 @@ void SegmentManager::resumeDownload()
             segment.networkManager->resumeDownload();
         }
     }
+    scheduleSequentialSegments();
 }
 
 void SegmentManager::cancelDownload()
 {
+    m_availability->abort();
     m_isDownloading = false;
     m_isPaused = false;
 
@@ -149,6 +532,8 @@ void SegmentManager::cancelDownload()
         segment.networkManager->cancelDownload();
         segment.status = "cancelled";
     }
+    publishSegmentStats();
+    m_statsTimer->stop();
     // Clean up part files
     for (int i = 0; i < m_segments.size(); ++i) {
         QString partFile = m_filepath + ".part" + QString::number(i);
@@ -180,6 +565,57 @@ bool SegmentManager::hasFailed() const
     return m_hasFailed;
 }
 
+QVector<SegmentSnapshot> SegmentManager::segmentSnapshot() const
+{
+    return m_stats.read();
+}
+
+quint64 SegmentManager::segmentSnapshotGeneration() const
+{
+    return m_stats.generation();
+}
+
+void SegmentManager::setSequentialLayout(bool enabled)
+{
+    m_sequentialLayout = enabled;
+}
+
+bool SegmentManager::isSequentialLayout() const
+{
+    return m_sequentialLayout;
+}
+
+void SegmentManager::attachPreviewReader()
+{
+    ++m_previewReaders;
+    scheduleSequentialSegments();
+}
+
+void SegmentManager::detachPreviewReader()
+{
+    m_previewReaders = qMax(0, m_previewReaders - 1);
+    scheduleSequentialSegments();
+}
+
+bool SegmentManager::isSequentialMode() const
+{
+    return m_previewReaders > 0;
+}
+
+QSharedPointer<RangeAvailability> SegmentManager::rangeAvailability() const
+{
+    return m_availability;
+}
+
+void SegmentManager::publishSegmentStats()
+{
+    qint64 elapsedMs = m_statsClock.isValid() ? m_statsClock.restart() : 0;
+    m_stats.publish(m_segments, elapsedMs);
+    for (auto &segment : m_segments) {
+        segment.publishedSize = segment.downloadedSize;
+    }
+}
+
 void SegmentManager::onNetworkProgress(qint64 bytesReceived, qint64 bytesTotal)
 {
     // Find which segment this is from
@@ -191,7 +627,11 @@ void SegmentManager::onNetworkProgress(qint64 bytesReceived, qint64 bytesTotal)
     for (int i = 0; i < m_segments.size(); ++i) {
         if (m_segments[i].networkManager == sender) {
             m_segments[i].downloadedSize = bytesReceived;
-            m_totalSize = bytesTotal;
+            m_availability->setAvailable(i, bytesReceived);
+            // bytesTotal is this segment's length; the file size came from fetchTotalSize()
+            if (m_totalSize <= 0) {
+                m_totalSize = bytesTotal;
+            }
             emit segmentProgress(i, bytesReceived, bytesTotal);
             break;
         }
@@ -209,11 +649,23 @@ void SegmentManager::onNetworkFinished(bool success, const QString &errorMessage
         if (m_segments[i].networkManager == sender) {
             if (success) {
                 m_segments[i].status = "completed";
+                const DownloadSegment &segment = m_segments.at(i);
+                qint64 end = segment.endOffset < 0 ? m_availability->totalSize() : segment.endOffset + 1;
+                m_availability->setAvailable(i, end - segment.startOffset);
+                static Metrics::Counter *completed = Metrics::instance().counter(
+                    "ldm_segments_completed_total", "Segments fully downloaded");
+                completed->increment();
                 emit segmentCompleted(i);
             } else {
                 m_segments[i].status = "failed";
+                static Metrics::Counter *failed = Metrics::instance().counter(
+                    "ldm_segments_failed_total", "Segments that failed after their retries");
+                failed->increment();
                 emit segmentFailed(i, errorMessage);
                 m_hasFailed = true;
+                m_availability->abort();
+                publishSegmentStats();
+                m_statsTimer->stop();
                 emit downloadFailed(errorMessage);
                 return;
             }
@@ -231,9 +683,13 @@ void SegmentManager::onNetworkFinished(bool success, const QString &errorMessage
     }
 
     if (allCompleted) {
+        publishSegmentStats();
+        m_statsTimer->stop();
         m_isCompleted = true;
         mergeSegments();
         emit allSegmentsCompleted();
+    } else if (m_sequentialLayout) {
+        scheduleSequentialSegments();
     }
 }
 
@@ -242,6 +698,7 @@ void SegmentManager::mergeSegments()
     QFile finalFile(m_filepath);
     if (!finalFile.open(QIODevice::WriteOnly)) {
         m_hasFailed = true;
+        m_availability->abort();
         emit downloadFailed("Failed to open final file for writing");
         return;
     }
@@ -250,15 +707,21 @@ void SegmentManager::mergeSegments()
         QFile part(partFile);
         if (!part.open(QIODevice::ReadOnly)) {
             m_hasFailed = true;
+            m_availability->abort();
             emit downloadFailed("Failed to open part file");
             finalFile.close();
             return;
         }
         finalFile.write(part.readAll());
         part.close();
-        part.remove();
     }
     finalFile.close();
+
+    // Preview readers move over to the merged file before the parts go away
+    m_availability->markCompleted();
+    for (int i = 0; i < m_segments.size(); ++i) {
+        QFile::remove(m_filepath + ".part" + QString::number(i));
+    }
 }
 
 void SegmentManager::fetchTotalSize()
@@ -281,7 +744,11 @@ void SegmentManager::onTotalSizeFetched(qint64 size)
     }
     m_totalSize = size;
     initializeSegments(m_totalSize);
-    for (int i = 0; i < m_numSegments; ++i) {
+    if (m_sequentialLayout) {
+        scheduleSequentialSegments();
+        return;
+    }
+    for (int i = 0; i < m_segments.size(); ++i) {
         startSegment(i);
     }
 }
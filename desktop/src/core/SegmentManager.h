@@ -10,6 +10,14 @@
 #include <QtConcurrent/QtConcurrent>
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSharedPointer>
+#include <atomic>
+#include <functional>
 #include "NetworkManager.h"
 
 struct DownloadSegment {
@@ -19,6 +27,108 @@ struct DownloadSegment {
     qint64 downloadedSize;
     QString status; // "pending", "downloading", "completed", "failed"
     NetworkManager *networkManager;
+    qint64 publishedSize;   // downloadedSize at the previous stats publish, for speed
+};
+
+// What the UI sees of a segment; plain values so it can be copied across threads
+struct SegmentSnapshot {
+    enum State {
+        Pending,
+        Downloading,
+        Paused,
+        Completed,
+        Failed,
+        Cancelled
+    };
+
+    int index;
+    qint64 startOffset;
+    qint64 endOffset;       // -1 for the open-ended last segment
+    qint64 downloadedSize;
+    qint64 speed;           // bytes/s over the last publish interval
+    int retryCount;
+    State state;
+};
+
+// Single-writer, lock-free double buffer. The writer fills the idle slot and
+// then bumps the generation; readers copy the published slot and retry only if
+// the writer lapped them while they were copying. Neither side ever blocks.
+class SegmentStatsBuffer
+{
+public:
+    static const int MAX_SEGMENTS = 32;
+
+    SegmentStatsBuffer();
+
+    void publish(const QList<DownloadSegment> &segments, qint64 elapsedMs);   // owning thread only
+    QVector<SegmentSnapshot> read() const;                                     // any thread
+    quint64 generation() const { return m_generation.load(std::memory_order_acquire); }
+
+private:
+    struct Slot {
+        int count;
+        SegmentSnapshot segments[MAX_SEGMENTS];
+    };
+
+    Slot m_slots[2];
+    std::atomic<quint64> m_generation;  // odd while a publish is in progress
+};
+
+// Which bytes of the final file are already on disk, per segment. Written by
+// the SegmentManager thread, read and waited on by preview readers on any
+// thread. Segment i's bytes live in <file>.part<i> until the merge, then in <file>.
+class RangeAvailability
+{
+public:
+    struct Location {
+        QString path;
+        qint64 fileOffset;
+        qint64 length;
+    };
+
+    RangeAvailability();
+
+    void reset(const QList<DownloadSegment> &segments, qint64 totalSize, const QString &filepath);
+    void setAvailable(int index, qint64 bytes);     // monotonic per segment
+    void markCompleted();                           // waits for in-flight reads of part files
+    void abort();
+
+    qint64 totalSize() const;
+    qint64 contiguousFrom(qint64 offset) const;     // readable bytes starting at offset
+    bool isAborted() const;
+    qint64 requestedOffset() const;                 // offset a reader is blocked on, or -1
+    int rangeIndexAt(qint64 offset) const;          // segment holding offset, or -1
+    // Called, with the lock held, whenever a reader blocks on a new offset; must not block
+    void setRequestHandler(std::function<void()> handler);
+
+    // Blocks until the byte at offset is readable, also while the size is still
+    // unknown; false on timeout, abort or EOF
+    bool waitForData(qint64 offset, int timeoutMs);
+    // Resolve a read to one file; every successful beginRead needs an endRead
+    bool beginRead(qint64 offset, qint64 maxLength, Location *location);
+    void endRead();
+
+private:
+    struct Range {
+        qint64 start;
+        qint64 end;         // exclusive
+        qint64 available;
+    };
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_dataChanged;
+    QWaitCondition m_readsDrained;
+    QVector<Range> m_ranges;
+    QString m_filepath;
+    qint64 m_totalSize;                             // -1 until the segments are laid out
+    qint64 m_requestedOffset;
+    std::function<void()> m_requestHandler;
+    int m_activeReads;
+    bool m_completed;
+    bool m_aborted;
+
+    int rangeAt(qint64 offset) const;
+    qint64 contiguousFromLocked(qint64 offset) const;
 };
 
 class SegmentManager : public QObject
@@ -40,6 +150,23 @@ public:
     bool isCompleted() const;
     bool hasFailed() const;
 
+    // Lock-free per-segment view for the UI; safe to call from any thread
+    QVector<SegmentSnapshot> segmentSnapshot() const;
+    quint64 segmentSnapshotGeneration() const;
+
+    // The sequential layout cuts the file into a head, a tail (container headers)
+    // and offset-ordered pieces so it can be previewed while it downloads. With
+    // no preview open the pieces still run on every connection. Set before startDownload().
+    void setSequentialLayout(bool enabled);
+    bool isSequentialLayout() const;
+    // While a preview reader is attached, the head and tail go first on at most
+    // SEQUENTIAL_WINDOW connections until the head is in, and the segment a
+    // blocked reader needs starts at once
+    void attachPreviewReader();
+    void detachPreviewReader();
+    bool isSequentialMode() const;
+    QSharedPointer<RangeAvailability> rangeAvailability() const;
+
 signals:
     void segmentProgress(int segmentIndex, qint64 bytesReceived, qint64 bytesTotal);
     void segmentCompleted(int segmentIndex);
@@ -52,6 +179,7 @@ private slots:
     void onNetworkProgress(qint64 bytesReceived, qint64 bytesTotal);
     void onNetworkFinished(bool success, const QString &errorMessage);
     void onTotalSizeFetched(qint64 size);
+    void publishSegmentStats();
 
 private:
     QUrl m_url;
@@ -66,9 +194,24 @@ private:
     bool m_hasFailed;
     NetworkManager *m_sizeFetcher;
     QList<QFutureWatcher<void>*> m_segmentWatchers;
+    SegmentStatsBuffer m_stats;
+    QTimer *m_statsTimer;
+    QElapsedTimer m_statsClock;
+    bool m_sequentialLayout;
+    int m_previewReaders;
+    QSharedPointer<RangeAvailability> m_availability;
+
+    static const int STATS_PUBLISH_INTERVAL = 250;  // ms
+    static const qint64 SEQUENTIAL_HEAD_BYTES = 4 * 1024 * 1024;
+    static const qint64 SEQUENTIAL_TAIL_BYTES = 2 * 1024 * 1024;
+    static const qint64 SEQUENTIAL_MIN_CHUNK = 1024 * 1024;
+    static const int SEQUENTIAL_WINDOW = 3;         // connections while a previewed head is missing
 
     void initializeSegments(qint64 totalSize);
+    void initializeSequentialSegments(qint64 totalSize);
+    DownloadSegment createSegment(int index, qint64 startOffset, qint64 endOffset);
     void startSegment(int index);
+    void scheduleSequentialSegments();
     void mergeSegments();
     bool supportsResume();
 };
@@ -1,11 +1,33 @@
 #include "SpeedCalculator.h"
 #include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// weight[k] for the bucket k + 1 back from the one filling, measured to its midpoint
+struct DecayWeights {
+    std::array<double, SpeedCalculator::BUCKET_COUNT> weight;
+
+    DecayWeights() {
+        for (int k = 0; k < SpeedCalculator::BUCKET_COUNT; ++k) {
+            double ageMs = (k + 0.5) * SpeedCalculator::BUCKET_MS;
+            weight[k] = std::exp(-ageMs / SpeedCalculator::EWMA_TIME_CONSTANT_MS);
+        }
+    }
+};
+
+const DecayWeights DECAY;
+
+}
 
 SpeedCalculator::SpeedCalculator(QObject *parent)
     : QObject(parent)
     , m_totalDownloaded(0)
+    , m_lastReported(0)
     , m_isRunning(false)
 {
+    clearBuckets();
 }
 
 SpeedCalculator::~SpeedCalculator()
@@ -16,9 +38,10 @@ void SpeedCalculator::start()
 {
     if (!m_isRunning) {
         m_timer.start();
-        m_isRunning = true;
-        m_progressHistory.clear();
+        clearBuckets();
         m_totalDownloaded = 0;
+        m_lastReported = 0;
+        m_isRunning = true;
     }
 }
 
@@ -29,64 +52,103 @@ void SpeedCalculator::stop()
 
 void SpeedCalculator::reset()
 {
-    m_progressHistory.clear();
+    clearBuckets();
     m_totalDownloaded = 0;
+    m_lastReported = 0;
     m_timer.restart();
 }
 
 void SpeedCalculator::updateProgress(qint64 bytesDownloaded)
 {
-    if (!m_isRunning) {
-        return;
+    // Totals that go backwards (a restarted transfer) only move the reference point
+    qint64 delta = bytesDownloaded - m_lastReported.exchange(bytesDownloaded, std::memory_order_relaxed);
+    if (delta > 0) {
+        addBytes(delta);
     }
+}
 
-    qint64 elapsed = m_timer.elapsed();
-    m_progressHistory.append(qMakePair(elapsed, bytesDownloaded));
-    m_totalDownloaded = bytesDownloaded;
-
-    // Keep only last HISTORY_SIZE entries
-    if (m_progressHistory.size() > HISTORY_SIZE) {
-        m_progressHistory.removeFirst();
+void SpeedCalculator::addBytes(qint64 bytes)
+{
+    if (!m_isRunning.load(std::memory_order_relaxed) || bytes <= 0) {
+        return;
     }
 
-    double currentSpeed = getCurrentSpeed();
-    double averageSpeed = getAverageSpeed();
-    emit speedUpdated(currentSpeed, averageSpeed);
+    m_totalDownloaded.fetch_add(bytes, std::memory_order_relaxed);
+
+    qint64 epoch = m_timer.elapsed() / BUCKET_MS;
+    std::atomic<quint64> &bucket = m_buckets[epoch % BUCKET_COUNT];
+    quint64 word = bucket.load(std::memory_order_relaxed);
+    bool opened;
+    quint64 updated;
+    do {
+        // Either add to the bucket's current epoch or claim it for a new one
+        opened = !holdsEpoch(word, epoch);
+        updated = opened ? pack(epoch, bytes) : word + quint64(bytes);
+    } while (!bucket.compare_exchange_weak(word, updated, std::memory_order_relaxed));
+
+    if (opened) {
+        emit speedUpdated(getCurrentSpeed(), getAverageSpeed());
+    }
 }
 
 double SpeedCalculator::getCurrentSpeed() const
 {
-    if (m_progressHistory.size() < 2) {
-        return 0.0;
+    qint64 epoch;
+    int buckets = completedBuckets(&epoch);
+    if (buckets == 0) {
+        return getAverageSpeed();
     }
 
-    // Calculate speed based on last two measurements
-    auto last = m_progressHistory.last();
-    auto secondLast = m_progressHistory.at(m_progressHistory.size() - 2);
-
-    qint64 timeDiff = last.first - secondLast.first;
-    qint64 bytesDiff = last.second - secondLast.second;
-
-    if (timeDiff == 0) {
-        return 0.0;
+    double weighted = 0.0;
+    double weights = 0.0;
+    for (int k = 0; k < buckets; ++k) {
+        weighted += DECAY.weight[k] * bucketRate(epoch - 1 - k);
+        weights += DECAY.weight[k];
     }
-
-    return (bytesDiff * 1000.0) / timeDiff; // bytes per second
+    return weighted / weights;
 }
 
 double SpeedCalculator::getAverageSpeed() const
 {
-    if (m_progressHistory.isEmpty() || m_timer.elapsed() == 0) {
+    qint64 elapsed = m_timer.isValid() ? m_timer.elapsed() : 0;
+    if (elapsed <= 0) {
         return 0.0;
     }
+    return (m_totalDownloaded.load(std::memory_order_relaxed) * 1000.0) / elapsed; // bytes per second
+}
+
+double SpeedCalculator::getPercentileSpeed(double percentile) const
+{
+    qint64 epoch;
+    int buckets = completedBuckets(&epoch);
+    if (buckets == 0) {
+        return getAverageSpeed();
+    }
 
-    qint64 totalTime = m_timer.elapsed();
-    return (m_totalDownloaded * 1000.0) / totalTime; // bytes per second
+    std::array<double, BUCKET_COUNT> rates;
+    for (int k = 0; k < buckets; ++k) {
+        rates[k] = bucketRate(epoch - 1 - k);
+    }
+    int rank = qBound(0, int(std::ceil(qBound(0.0, percentile, 100.0) / 100.0 * buckets)) - 1, buckets - 1);
+    std::nth_element(rates.begin(), rates.begin() + rank, rates.begin() + buckets);
+    return rates[rank];
+}
+
+int SpeedCalculator::getEta(qint64 remainingBytes) const
+{
+    if (remainingBytes <= 0) {
+        return 0;
+    }
+    double speed = getCurrentSpeed();
+    if (speed <= 0.0) {
+        return -1;
+    }
+    return int(std::ceil(remainingBytes / speed));
 }
 
 qint64 SpeedCalculator::getTotalDownloaded() const
 {
-    return m_totalDownloaded;
+    return m_totalDownloaded.load(std::memory_order_relaxed);
 }
 
 QString SpeedCalculator::getFormattedSpeed(double speed) const
@@ -100,4 +162,44 @@ QString SpeedCalculator::getFormattedSpeed(double speed) const
     } else {
         return QString("%1 GB/s").arg(speed / (1024 * 1024 * 1024), 0, 'f', 1);
     }
+}
+
+void SpeedCalculator::clearBuckets()
+{
+    // Slot i is stamped with the epoch one lap before its first use, so it reads as stale
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        m_buckets[i].store(pack(i - BUCKET_COUNT, 0), std::memory_order_relaxed);
+    }
+}
+
+int SpeedCalculator::completedBuckets(qint64 *currentEpoch) const
+{
+    if (!m_timer.isValid()) {
+        *currentEpoch = 0;
+        return 0;
+    }
+    *currentEpoch = m_timer.elapsed() / BUCKET_MS;
+    return int(qMin<qint64>(*currentEpoch, BUCKET_COUNT - 1));
+}
+
+double SpeedCalculator::bucketRate(qint64 epoch) const
+{
+    quint64 word = m_buckets[epoch % BUCKET_COUNT].load(std::memory_order_relaxed);
+    if (!holdsEpoch(word, epoch)) {
+        return 0.0;     // nothing arrived during that bucket
+    }
+    qint64 bytes = qint64(word & ((quint64(1) << BYTES_BITS) - 1));
+    return bytes * 1000.0 / BUCKET_MS;
+}
+
+quint64 SpeedCalculator::pack(qint64 epoch, qint64 bytes)
+{
+    const quint64 epochMask = (quint64(1) << EPOCH_BITS) - 1;
+    return ((quint64(epoch) & epochMask) << BYTES_BITS) | quint64(bytes);
+}
+
+bool SpeedCalculator::holdsEpoch(quint64 word, qint64 epoch)
+{
+    const quint64 epochMask = (quint64(1) << EPOCH_BITS) - 1;
+    return (word >> BYTES_BITS) == (quint64(epoch) & epochMask);
 }
\ No newline at end of file
@@ -3,9 +3,17 @@
 
 #include <QObject>
 #include <QElapsedTimer>
-#include <QList>
-#include <QPair>
+#include <array>
+#include <atomic>
 
+// Throughput estimator over a fixed ring of time buckets. Each bucket is one
+// atomic word holding (bucket epoch, bytes), so updateProgress()/addBytes()
+// are lock-free and safe to call from I/O threads, once per segment read.
+// Readers derive a time-decayed EWMA and windowed percentiles from the
+// completed buckets; the bucket still filling is never reported.
+//
+// start(), stop() and reset() belong to the owning thread and must not race
+// with updates.
 class SpeedCalculator : public QObject
 {
     Q_OBJECT
@@ -17,23 +25,41 @@ public:
     void start();
     void stop();
     void reset();
-    void updateProgress(qint64 bytesDownloaded);
+    void updateProgress(qint64 bytesDownloaded);    // running total; lock-free
+    void addBytes(qint64 bytes);                    // increment; lock-free
 
-    double getCurrentSpeed() const; // bytes per second
-    double getAverageSpeed() const; // bytes per second
+    double getCurrentSpeed() const; // bytes per second, time-decayed EWMA
+    double getAverageSpeed() const; // bytes per second since start()
+    double getPercentileSpeed(double percentile) const;    // over the window, 0..100
+    double getMedianSpeed() const { return getPercentileSpeed(50.0); }
+    double getP95Speed() const { return getPercentileSpeed(95.0); }
+    int getEta(qint64 remainingBytes) const;        // seconds, -1 when unknown
     qint64 getTotalDownloaded() const;
     QString getFormattedSpeed(double speed) const;
 
+    static const int BUCKET_MS = 250;
+    static const int BUCKET_COUNT = 64;             // 16 s window
+    static const int EWMA_TIME_CONSTANT_MS = 3000;
+
 signals:
+    // Emitted once per bucket while data flows, possibly from an I/O thread
     void speedUpdated(double currentSpeed, double averageSpeed);
 
 private:
     QElapsedTimer m_timer;
-    QList<QPair<qint64, qint64>> m_progressHistory; // time (ms), bytes
-    qint64 m_totalDownloaded;
-    bool m_isRunning;
+    std::array<std::atomic<quint64>, BUCKET_COUNT> m_buckets;
+    std::atomic<qint64> m_totalDownloaded;
+    std::atomic<qint64> m_lastReported;             // last updateProgress() total
+    std::atomic<bool> m_isRunning;
+
+    static const int EPOCH_BITS = 24;
+    static const int BYTES_BITS = 64 - EPOCH_BITS;
 
-    static const int HISTORY_SIZE = 10; // Keep last 10 measurements for current speed
+    void clearBuckets();
+    int completedBuckets(qint64 *currentEpoch) const;
+    double bucketRate(qint64 epoch) const;          // bytes per second, 0 when stale
+    static quint64 pack(qint64 epoch, qint64 bytes);
+    static bool holdsEpoch(quint64 word, qint64 epoch);
 };
 
 #endif // SPEEDCALCULATOR_H
\ No newline at end of file
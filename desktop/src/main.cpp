@@ -6,7 +6,9 @@
 #include <QFormLayout>
 #include <QToolBar>
 #include <QTreeWidget>
-#include <QTableWidget>
+#include <QTableView>
+#include <QSortFilterProxyModel>
+#include <QRegularExpression>
 #include <QGroupBox>
 #include <QLabel>
 #include <QPushButton>
@@ -15,7 +17,6 @@
 #include <QSplitter>
 #include <QHeaderView>
 #include <QTreeWidgetItem>
-#include <QTableWidgetItem>
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QSystemTrayIcon>
@@ -60,6 +61,17 @@
 #include <QPropertyAnimation>
 #include <QEasingCurve>
 #include <QGraphicsOpacityEffect>
+#include <QSqlDatabase>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <atomic>
+
+#include "core/Database.h"
+#include "core/SpeedCalculator.h"
+#include "api/BridgeBackend.h"
+#include "api/BridgeServer.h"
+#include "ui/DownloadTableModel.h"
+#include "ui/ThemeManager.h"
 
 // Forward declarations
 class DownloadItem;
@@ -86,7 +98,7 @@ public:
 
     explicit DownloadItem(QObject *parent = nullptr) : QObject(parent), 
         m_id(0), m_totalSize(0), m_downloadedSize(0), m_speed(0), m_eta(0),
-        m_status(Waiting), m_progress(0.0), m_connections(4), m_priority(1) {}
+        m_status(Waiting), m_connections(4), m_priority(1) {}
 
     // Getters and setters
     int id() const { return m_id; }
@@ -104,33 +116,37 @@ public:
     QString category() const { return m_category; }
     void setCategory(const QString &category) { m_category = category; }
     
+    // Transfer counters are written by the worker thread and read by the UI,
+    // so they are atomics; the engine publishes them at frame rate via the dirty flag
     qint64 totalSize() const { return m_totalSize; }
-    void setTotalSize(qint64 size) { m_totalSize = size; }
+    void setTotalSize(qint64 size) { m_totalSize = size; m_progressDirty = true; }
     
     qint64 downloadedSize() const { return m_downloadedSize; }
-    void setDownloadedSize(qint64 size) { 
-        m_downloadedSize = size; 
-        if (m_totalSize > 0) {
-            m_progress = (double)m_downloadedSize / m_totalSize * 100.0;
-        }
-        emit progressChanged();
-    }
+    void setDownloadedSize(qint64 size) { m_downloadedSize = size; m_progressDirty = true; }
     
-    double progress() const { return m_progress; }
+    double progress() const {
+        qint64 total = m_totalSize;
+        return total > 0 ? (double)m_downloadedSize / total * 100.0 : 0.0;
+    }
     
     int speed() const { return m_speed; }
-    void setSpeed(int speed) { m_speed = speed; emit speedChanged(); }
+    void setSpeed(int speed) { m_speed = speed; m_progressDirty = true; emit speedChanged(); }
     
     int eta() const { return m_eta; }
-    void setEta(int eta) { m_eta = eta; }
+    void setEta(int eta) { m_eta = eta; m_progressDirty = true; }
+    
+    // Returns whether counters changed since the last call and clears the flag
+    bool takeProgressDirty() { return m_progressDirty.exchange(false); }
     
+    // A status change is published with the next progress batch, so the row also
+    // catches up when it happens on the worker thread (e.g. a queued pause)
     Status status() const { return m_status; }
-    void setStatus(Status status) { m_status = status; emit statusChanged(); }
+    void setStatus(Status status) { m_status = status; m_progressDirty = true; emit statusChanged(); }
     
     QString statusString() const {
         switch (m_status) {
             case Waiting: return "Waiting";
-            case Downloading: return QString("Downloading %1%").arg(QString::number(m_progress, 'f', 1));
+            case Downloading: return QString("Downloading %1%").arg(QString::number(progress(), 'f', 1));
             case Paused: return "Paused";
             case Completed: return "Completed";
             case Failed: return "Failed";
@@ -146,7 +162,6 @@ public:
     void setPriority(int priority) { m_priority = priority; }
 
 signals:
-    void progressChanged();
     void statusChanged();
     void speedChanged();
     void completed();
@@ -158,12 +173,12 @@ private:
     QString m_fileName;
     QString m_savePath;
     QString m_category;
-    qint64 m_totalSize;
-    qint64 m_downloadedSize;
-    int m_speed;
-    int m_eta;
+    std::atomic<qint64> m_totalSize;
+    std::atomic<qint64> m_downloadedSize;
+    std::atomic<int> m_speed;
+    std::atomic<int> m_eta;
+    std::atomic<bool> m_progressDirty{false};
     Status m_status;
-    double m_progress;
     int m_connections;
     int m_priority;
 };
@@ -177,6 +192,7 @@ public:
     explicit DownloadWorker(DownloadItem *item, QObject *parent = nullptr)
         : QObject(parent), m_item(item), m_manager(nullptr),
           m_reply(nullptr), m_file(nullptr), m_speedTimer(nullptr),
+          m_speedMeter(new SpeedCalculator(this)),
           m_paused(false), m_cancelled(false) {}
 
     ~DownloadWorker() {
@@ -224,7 +240,8 @@ public slots:
                 this, &DownloadWorker::onReadyRead);
 
         m_item->setStatus(DownloadItem::Downloading);
-        m_startTime = QTime::currentTime();
+        m_speedMeter->stop();
+        m_speedMeter->start();
 
         // Start speed calculation timer
         m_speedTimer->start(1000); // Update every second
@@ -238,6 +255,7 @@ public slots:
         if (m_speedTimer) {
             m_speedTimer->stop();
         }
+        m_speedMeter->stop();
         m_item->setStatus(DownloadItem::Paused);
         emit paused();
     }
@@ -278,6 +296,7 @@ private slots:
         
         m_item->setTotalSize(bytesTotal);
         m_item->setDownloadedSize(bytesReceived);
+        m_speedMeter->updateProgress(bytesReceived);
         
         emit progress(bytesReceived, bytesTotal);
     }
@@ -311,18 +330,11 @@ private slots:
     void calculateSpeed() {
         if (m_paused || m_cancelled) return;
         
-        qint64 currentBytes = m_item->downloadedSize();
-        int elapsedSeconds = m_startTime.secsTo(QTime::currentTime());
-        
-        if (elapsedSeconds > 0) {
-            int speed = currentBytes / elapsedSeconds; // bytes per second
-            m_item->setSpeed(speed);
-            
-            if (speed > 0 && m_item->totalSize() > 0) {
-                qint64 remainingBytes = m_item->totalSize() - currentBytes;
-                int eta = remainingBytes / speed;
-                m_item->setEta(eta);
-            }
+        // Smoothed recent rate rather than bytes over the whole transfer
+        m_item->setSpeed(int(m_speedMeter->getCurrentSpeed()));
+        if (m_item->totalSize() > 0) {
+            int eta = m_speedMeter->getEta(m_item->totalSize() - m_item->downloadedSize());
+            m_item->setEta(qMax(eta, 0));
         }
     }
 
@@ -332,7 +344,7 @@ private:
     QNetworkReply *m_reply;
     QFile *m_file;
     QTimer *m_speedTimer;
-    QTime m_startTime;
+    SpeedCalculator *m_speedMeter;
     bool m_paused;
     bool m_cancelled;
 };
@@ -343,11 +355,28 @@ class DownloadEngine : public QObject
     Q_OBJECT
 
 public:
-    explicit DownloadEngine(QObject *parent = nullptr) : QObject(parent), m_nextId(1) {}
+    // Progress is published to the UI at most this often, however fast chunks arrive
+    static const int DEFAULT_UI_REFRESH_HZ = 20;
 
-    int addDownload(const QString &url, const QString &fileName, const QString &savePath, const QString &category = "All Downloads") {
+    explicit DownloadEngine(QObject *parent = nullptr) : QObject(parent), m_nextId(1) {
+        m_refreshTimer.setTimerType(Qt::CoarseTimer);
+        setUiRefreshRate(DEFAULT_UI_REFRESH_HZ);
+        connect(&m_refreshTimer, &QTimer::timeout, this, &DownloadEngine::publishProgress);
+    }
+
+    void setUiRefreshRate(int hz) {
+        m_refreshTimer.setInterval(1000 / qBound(10, hz, 30));
+    }
+
+    int addDownload(const QString &url, const QString &fileName, const QString &savePath, const QString &category = "All Downloads", int id = 0) {
         DownloadItem *item = new DownloadItem(this);
-        item->setId(m_nextId++);
+        // Persisted downloads keep their database id
+        if (id > 0) {
+            m_nextId = qMax(m_nextId, id + 1);
+        } else {
+            id = m_nextId++;
+        }
+        item->setId(id);
         item->setUrl(url);
         item->setFileName(fileName);
         item->setSavePath(savePath);
@@ -355,10 +384,6 @@ public:
 
         m_downloads[item->id()] = item;
 
-        connect(item, &DownloadItem::progressChanged, this, [this, item]() {
-            emit downloadProgress(item->id(), item->downloadedSize(), item->totalSize());
-        });
-
         connect(item, &DownloadItem::statusChanged, this, [this, item]() {
             if (item->status() == DownloadItem::Completed) {
                 emit downloadCompleted(item->id());
@@ -413,6 +438,10 @@ public:
         m_workers[id] = worker;
         thread->start();
 
+        if (!m_refreshTimer.isActive()) {
+            m_refreshTimer.start();
+        }
+
         emit downloadStarted(id);
     }
 
@@ -449,6 +478,16 @@ public:
         return m_downloads.values();
     }
 
+    QList<DownloadItem*> getActiveDownloads() {
+        QList<DownloadItem*> active;
+        for (auto it = m_workers.constBegin(); it != m_workers.constEnd(); ++it) {
+            if (DownloadItem *item = m_downloads.value(it.key(), nullptr)) {
+                active.append(item);
+            }
+        }
+        return active;
+    }
+
 signals:
     void downloadAdded(int id);
     void downloadStarted(int id);
@@ -456,10 +495,33 @@ signals:
     void downloadCompleted(int id);
     void downloadFailed(int id, const QString &error);
     void downloadCancelled(int id);
+    // One batch per frame with every download whose counters changed since the last one
+    void progressUpdated(const QList<int> &ids);
+
+private slots:
+    void publishProgress() {
+        QList<int> dirty;
+        for (auto it = m_workers.constBegin(); it != m_workers.constEnd(); ++it) {
+            DownloadItem *item = m_downloads.value(it.key(), nullptr);
+            if (item && item->takeProgressDirty()) {
+                dirty.append(item->id());
+                emit downloadProgress(item->id(), item->downloadedSize(), item->totalSize());
+            }
+        }
+
+        if (!dirty.isEmpty()) {
+            emit progressUpdated(dirty);
+        }
+
+        if (m_workers.isEmpty()) {
+            m_refreshTimer.stop();
+        }
+    }
 
 private:
     QHash<int, DownloadItem*> m_downloads;
     QHash<int, DownloadWorker*> m_workers;
+    QTimer m_refreshTimer;
     int m_nextId;
 };
 
@@ -528,6 +590,7 @@ public:
         
         m_themeComboBox = new QComboBox();
         m_themeComboBox->addItems({"Light", "Dark", "Classic IDM"});
+        m_themeComboBox->setCurrentIndex(ThemeManager::instance()->currentTheme());
         interfaceLayout->addRow("Theme:", m_themeComboBox);
         
         m_notificationsCheckBox = new QCheckBox("Show completion notifications");
@@ -549,6 +612,11 @@ public:
         mainLayout->addWidget(buttonBox);
     }
 
+    // Combo entries follow ThemeManager::Theme order
+    ThemeManager::Theme selectedTheme() const {
+        return static_cast<ThemeManager::Theme>(m_themeComboBox->currentIndex());
+    }
+
 private:
     QLineEdit *m_downloadPathEdit;
     QSpinBox *m_maxConnectionsSpinBox;
@@ -701,13 +769,105 @@ private:
     QListWidget *m_linksList;
 };
 
+// Streams the persisted download list from a private SQLite connection so the
+// main window can be shown as soon as the first page is on screen. Rows are
+// turned into engine state on the loader's thread; the window only applies it.
+class DownloadListLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    DownloadListLoader(const QString &databasePath, int beforeId, QObject *parent = nullptr)
+        : QObject(parent), m_databasePath(databasePath), m_beforeId(beforeId) {}
+
+    static const int BATCH_SIZE = 1000;
+
+    // Everything the engine needs to recreate a persisted download, already parsed
+    struct RestoredDownload {
+        int id = 0;
+        QString url;
+        QString fileName;
+        QString savePath;
+        QString category;
+        qint64 totalSize = 0;
+        qint64 downloadedSize = 0;
+        DownloadItem::Status status = DownloadItem::Waiting;
+        QDateTime createdAt;
+    };
+
+    // Pure function of the rows, so it runs on any thread
+    static QVector<RestoredDownload> restore(const QVariantList &rows) {
+        QVector<RestoredDownload> restored;
+        restored.reserve(rows.size());
+        for (const QVariant &variant : rows) {
+            QVariantMap download = variant.toMap();
+            RestoredDownload entry;
+            entry.id = download["id"].toInt();
+            entry.url = download["url"].toString();
+            entry.fileName = download["filename"].toString();
+            entry.savePath = QFileInfo(download["filepath"].toString()).path();
+            entry.category = QJsonDocument::fromJson(download["metadata"].toByteArray()).object()
+                             .value("category").toString("All Downloads");
+            entry.totalSize = download["total_size"].toLongLong();
+            entry.downloadedSize = download["downloaded_size"].toLongLong();
+            entry.createdAt = download["created_at"].toDateTime();
+
+            // A transfer that was running when the app exited has no worker any more
+            QString status = download["status"].toString();
+            if (status == "completed") {
+                entry.status = DownloadItem::Completed;
+            } else if (status == "failed") {
+                entry.status = DownloadItem::Failed;
+            } else if (status == "cancelled") {
+                entry.status = DownloadItem::Cancelled;
+            } else if (status == "downloading" || status == "paused") {
+                entry.status = DownloadItem::Paused;
+            }
+            restored.append(entry);
+        }
+        return restored;
+    }
+
+public slots:
+    void load() {
+        {
+            // Read-only: the full open() would re-run PRAGMAs and migrations and contend
+            // with the online index build for the write lock
+            Database database;
+            if (database.openReader(m_databasePath, "ldm-download-list-loader")) {
+                int beforeId = m_beforeId;
+                while (beforeId > 1 && !QThread::currentThread()->isInterruptionRequested()) {
+                    QVariantList rows = database.getDownloadsPage(beforeId, BATCH_SIZE);
+                    if (rows.isEmpty()) {
+                        break;
+                    }
+                    beforeId = rows.last().toMap().value("id").toInt();
+                    emit downloadsLoaded(restore(rows));
+                }
+                database.close();
+            }
+        }
+        QSqlDatabase::removeDatabase("ldm-download-list-loader");
+        emit finished();
+    }
+
+signals:
+    void downloadsLoaded(const QVector<DownloadListLoader::RestoredDownload> &downloads);
+    void finished();
+
+private:
+    QString m_databasePath;
+    int m_beforeId;
+};
+
 // Main Window
 class LDMMainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    LDMMainWindow(QWidget *parent = nullptr) : QMainWindow(parent)
+    LDMMainWindow(Database *database, QWidget *parent = nullptr)
+        : QMainWindow(parent), m_database(database)
     {
         setWindowTitle("LDM - Like Download Manager 1.0.1");
         setMinimumSize(1000, 700);
@@ -721,6 +881,23 @@ public:
         setupConnections();
         loadSettings();
 
+        // Only the first screenful is loaded before the window is shown; the rest is
+        // streamed in once the event loop is running
+        if (m_database) {
+            connect(m_database, &Database::migrationProgress, this, [this](int version, qint64 done, qint64 total) {
+                statusBar()->showMessage(QString("Upgrading database (step %1): %2%")
+                                         .arg(version).arg(total > 0 ? done * 100 / total : 100));
+            });
+            connect(m_database, &Database::migrationsFinished, this, [this](bool success) {
+                statusBar()->showMessage(success ? "Database upgrade complete" : "Database upgrade interrupted", 5000);
+            });
+        }
+
+        int lastLoadedId = loadFirstPage();
+        if (lastLoadedId > 1) {
+            QTimer::singleShot(0, this, [this, lastLoadedId]() { startBackgroundLoad(lastLoadedId); });
+        }
+
         // Fade in animation
         QPropertyAnimation *fadeIn = new QPropertyAnimation(this, "windowOpacity");
         fadeIn->setDuration(300);
@@ -731,6 +908,90 @@ public:
         statusBar()->showMessage("Ready - IDM-style interface loaded with download engine");
     }
 
+    ~LDMMainWindow()
+    {
+        if (m_loaderThread) {
+            m_loaderThread->requestInterruption();
+            m_loaderThread->quit();
+            m_loaderThread->wait();
+        }
+    }
+
+    DownloadEngine *downloadEngine() const { return m_downloadEngine; }
+
+    // Downloads handed over by the browser bridge: one insert for the whole burst,
+    // one model append, then each is started like a download added from the dialog
+    QList<int> addCapturedDownloads(const QVariantList &rows)
+    {
+        QString savePath = QStandardPaths::writableLocation(QStandardPaths::DownloadLocation);
+        QVariantList records;
+        records.reserve(rows.size());
+        for (const QVariant &variant : rows) {
+            QVariantMap record = variant.toMap();
+            QString fileName = record["filename"].toString();
+            if (fileName.isEmpty()) {
+                fileName = QUrl(record["url"].toString()).fileName();
+            }
+            if (fileName.isEmpty()) {
+                fileName = "download_" + QString::number(QDateTime::currentMSecsSinceEpoch());
+            }
+            record["filename"] = fileName;
+            record["filepath"] = QDir(savePath).filePath(fileName);
+            record["status"] = "queued";
+            record["progress"] = 0.0;
+            record["downloaded_size"] = 0;
+            records.append(record);
+        }
+
+        QList<int> persistedIds = m_database ? m_database->insertDownloads(records) : QList<int>();
+        QList<int> ids;
+        QVector<DownloadTableModel::Download> tableRows;
+        for (int i = 0; i < records.size(); ++i) {
+            int persistedId = persistedIds.value(i, 0);
+            if (m_database && persistedId <= 0) {
+                ids.append(-1);
+                continue;
+            }
+
+            QVariantMap record = records.at(i).toMap();
+            int downloadId = m_downloadEngine->addDownload(record["url"].toString(), record["filename"].toString(),
+                                                           savePath, "All Downloads", persistedId);
+            tableRows.append(tableRow(m_downloadEngine->getDownload(downloadId)));
+            ids.append(downloadId);
+        }
+
+        m_downloadsModel->appendDownloads(tableRows);
+        for (const DownloadTableModel::Download &row : tableRows) {
+            m_downloadEngine->startDownload(row.id);
+        }
+        if (!tableRows.isEmpty()) {
+            statusBar()->showMessage(QString("%1 download(s) added from the browser").arg(tableRows.size()));
+        }
+        return ids;
+    }
+
+    // Stops the transfer and forgets the download everywhere; false when it is unknown
+    bool removeDownload(int downloadId)
+    {
+        if (!m_downloadEngine->getDownload(downloadId)) {
+            return false;
+        }
+
+        m_downloadEngine->cancelDownload(downloadId);
+        if (m_database) {
+            m_database->deleteDownload(downloadId);
+        }
+        m_downloadsModel->removeDownload(downloadId);
+        updateDetailsPanel();
+        return true;
+    }
+
+    static QString statusName(DownloadItem::Status status)
+    {
+        static const char *statusNames[] = {"queued", "downloading", "paused", "completed", "failed", "cancelled"};
+        return statusNames[status];
+    }
+
 protected:
     void closeEvent(QCloseEvent *event) override
     {
@@ -827,7 +1088,20 @@ private slots:
                 }
             }
             
-            int downloadId = m_downloadEngine->addDownload(url, fileName, saveEdit->text(), categoryCombo->currentText());
+            int persistedId = 0;
+            if (m_database) {
+                QVariantMap downloadData;
+                downloadData["url"] = url;
+                downloadData["filename"] = fileName;
+                downloadData["filepath"] = QDir(saveEdit->text()).filePath(fileName);
+                downloadData["status"] = "queued";
+                downloadData["progress"] = 0.0;
+                downloadData["downloaded_size"] = 0;
+                downloadData["metadata"] = QString::fromUtf8(QJsonDocument(QJsonObject{{"category", categoryCombo->currentText()}}).toJson(QJsonDocument::Compact));
+                persistedId = qMax(0, m_database->insertDownload(downloadData));
+            }
+
+            int downloadId = m_downloadEngine->addDownload(url, fileName, saveEdit->text(), categoryCombo->currentText(), persistedId);
             addDownloadToTable(downloadId);
             
             if (startCheckBox->isChecked()) {
@@ -840,14 +1114,11 @@ private slots:
     
     void onResume()
     {
-        int currentRow = m_downloadsTable->currentRow();
-        if (currentRow >= 0) {
-            QTableWidgetItem *idItem = m_downloadsTable->item(currentRow, 7); // Hidden ID column
-            if (idItem) {
-                int downloadId = idItem->text().toInt();
-                m_downloadEngine->resumeDownload(downloadId);
-                statusBar()->showMessage("Resuming download...");
-            }
+        int downloadId = currentDownloadId();
+        if (downloadId >= 0) {
+            m_downloadEngine->resumeDownload(downloadId);
+            syncDownloadRow(downloadId);
+            statusBar()->showMessage("Resuming download...");
         } else {
             QMessageBox::information(this, "Resume", "Please select a download to resume.");
         }
@@ -855,14 +1126,11 @@ private slots:
     
     void onStop()
     {
-        int currentRow = m_downloadsTable->currentRow();
-        if (currentRow >= 0) {
-            QTableWidgetItem *idItem = m_downloadsTable->item(currentRow, 7); // Hidden ID column
-            if (idItem) {
-                int downloadId = idItem->text().toInt();
-                m_downloadEngine->pauseDownload(downloadId);
-                statusBar()->showMessage("Download paused");
-            }
+        int downloadId = currentDownloadId();
+        if (downloadId >= 0) {
+            m_downloadEngine->pauseDownload(downloadId);
+            syncDownloadRow(downloadId);
+            statusBar()->showMessage("Download paused");
         } else {
             QMessageBox::information(this, "Pause", "Please select a download to pause.");
         }
@@ -870,24 +1138,18 @@ private slots:
     
     void onDelete()
     {
-        int currentRow = m_downloadsTable->currentRow();
-        if (currentRow >= 0) {
-            QTableWidgetItem *nameItem = m_downloadsTable->item(currentRow, 0);
-            QString fileName = nameItem ? nameItem->text() : "Unknown";
+        int downloadId = currentDownloadId();
+        if (downloadId >= 0) {
+            const DownloadTableModel::Download *download = m_downloadsModel->download(downloadId);
+            QString fileName = download ? download->fileName : "Unknown";
             
             int ret = QMessageBox::question(this, "Delete Download",
                 QString("Are you sure you want to delete '%1'?").arg(fileName),
                 QMessageBox::Yes | QMessageBox::No);
                 
             if (ret == QMessageBox::Yes) {
-                QTableWidgetItem *idItem = m_downloadsTable->item(currentRow, 7);
-                if (idItem) {
-                    int downloadId = idItem->text().toInt();
-                    m_downloadEngine->cancelDownload(downloadId);
-                }
-                m_downloadsTable->removeRow(currentRow);
+                removeDownload(downloadId);
                 statusBar()->showMessage("Download deleted: " + fileName);
-                updateDetailsPanel();
             }
         } else {
             QMessageBox::information(this, "Delete", "Please select a download to delete.");
@@ -898,6 +1160,10 @@ private slots:
     {
         SettingsDialog dialog(this);
         if (dialog.exec() == QDialog::Accepted) {
+            ThemeManager::Theme theme = dialog.selectedTheme();
+            ThemeManager::instance()->setTheme(theme);
+            QSettings settings;
+            settings.setValue("interface/theme", ThemeManager::themeName(theme));
             QMessageBox::information(this, "Settings", "Settings saved successfully!");
         }
     }
@@ -966,10 +1232,14 @@ private slots:
         }
     }
     
-    void onDownloadProgress(int downloadId, qint64 bytesReceived, qint64 bytesTotal)
+    void onProgressUpdated(const QList<int> &downloadIds)
     {
-        updateDownloadInTable(downloadId, bytesReceived, bytesTotal);
-        updateDetailsPanel();
+        for (int downloadId : downloadIds) {
+            syncDownloadRow(downloadId);
+        }
+        if (downloadIds.contains(currentDownloadId())) {
+            updateDetailsPanel();
+        }
         updateGlobalProgress();
     }
     
@@ -977,7 +1247,8 @@ private slots:
     {
         DownloadItem *item = m_downloadEngine->getDownload(downloadId);
         if (item) {
-            updateDownloadInTable(downloadId, item->totalSize(), item->totalSize(), "Completed");
+            persistDownloadState(item);
+            syncDownloadRow(downloadId);
             showNotification("Download Completed", item->fileName() + " has been downloaded successfully.");
         }
         updateGlobalProgress();
@@ -987,18 +1258,23 @@ private slots:
     {
         DownloadItem *item = m_downloadEngine->getDownload(downloadId);
         if (item) {
-            updateDownloadInTable(downloadId, item->downloadedSize(), item->totalSize(), "Failed: " + error);
+            persistDownloadState(item);
+            syncDownloadRow(downloadId, error);
             showNotification("Download Failed", item->fileName() + " failed to download: " + error);
         }
         updateGlobalProgress();
     }
 
 private:
+    Database *m_database;
     DownloadEngine *m_downloadEngine;
+    QThread *m_loaderThread = nullptr;
     
     // UI Components
     QTreeWidget *m_categoriesTree;
-    QTableWidget *m_downloadsTable;
+    QTableView *m_downloadsView;
+    DownloadTableModel *m_downloadsModel;
+    QSortFilterProxyModel *m_downloadsProxy;
     QLabel *m_detailsUrlLabel;
     QLabel *m_detailsStatusLabel;
     QLabel *m_detailsSizeLabel;
@@ -1009,6 +1285,7 @@ private:
     QMenu *m_trayMenu;
     QLabel *m_globalSpeedLabel;
     QProgressBar *m_globalProgressBar;
+    QToolBar *m_mainToolBar;
     
     void setupUI()
     {
@@ -1045,6 +1322,7 @@ private:
     void setupToolBar()
     {
         QToolBar *toolbar = addToolBar("Main");
+        m_mainToolBar = toolbar;
         toolbar->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);
         
         toolbar->addAction("Add URL", this, &LDMMainWindow::onAddUrl);
@@ -1101,25 +1379,36 @@ private:
         QGroupBox *downloadsGroup = new QGroupBox("Downloads");
         QVBoxLayout *downloadsLayout = new QVBoxLayout(downloadsGroup);
         
-        m_downloadsTable = new QTableWidget();
-        m_downloadsTable->setColumnCount(8); // Added hidden ID column
-        QStringList headers = {"File Name", "Size", "Status", "Time left", "Transfer rate", "Last Try", "Description", "ID"};
-        m_downloadsTable->setHorizontalHeaderLabels(headers);
-        m_downloadsTable->setAlternatingRowColors(true);
-        m_downloadsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
-        m_downloadsTable->horizontalHeader()->setStretchLastSection(true);
-        m_downloadsTable->verticalHeader()->setVisible(false);
-        m_downloadsTable->hideColumn(7); // Hide ID column
+        // The view only asks the model for visible cells; rows carry no widgets or items
+        m_downloadsModel = new DownloadTableModel(this);
+        m_downloadsProxy = new QSortFilterProxyModel(this);
+        m_downloadsProxy->setSourceModel(m_downloadsModel);
+        m_downloadsProxy->setFilterRole(DownloadTableModel::CategoryRole);
+        m_downloadsProxy->setDynamicSortFilter(false); // category never changes after insert
+
+        m_downloadsView = new QTableView();
+        m_downloadsView->setModel(m_downloadsProxy);
+        m_downloadsView->setItemDelegateForColumn(DownloadTableModel::ColumnStatus,
+                                                  new DownloadProgressDelegate(m_downloadsView));
+        m_downloadsView->setAlternatingRowColors(true);
+        m_downloadsView->setSelectionBehavior(QAbstractItemView::SelectRows);
+        m_downloadsView->setSelectionMode(QAbstractItemView::SingleSelection);
+        m_downloadsView->setWordWrap(false);
+        m_downloadsView->horizontalHeader()->setStretchLastSection(true);
+        m_downloadsView->verticalHeader()->setVisible(false);
+        // Fixed row height so scrolling never measures rows
+        m_downloadsView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+        m_downloadsView->verticalHeader()->setDefaultSectionSize(m_downloadsView->fontMetrics().height() + 8);
         
         // Set column widths
-        m_downloadsTable->setColumnWidth(0, 200);
-        m_downloadsTable->setColumnWidth(1, 100);
-        m_downloadsTable->setColumnWidth(2, 120);
-        m_downloadsTable->setColumnWidth(3, 100);
-        m_downloadsTable->setColumnWidth(4, 120);
-        m_downloadsTable->setColumnWidth(5, 120);
+        m_downloadsView->setColumnWidth(DownloadTableModel::ColumnFileName, 200);
+        m_downloadsView->setColumnWidth(DownloadTableModel::ColumnSize, 100);
+        m_downloadsView->setColumnWidth(DownloadTableModel::ColumnStatus, 120);
+        m_downloadsView->setColumnWidth(DownloadTableModel::ColumnTimeLeft, 100);
+        m_downloadsView->setColumnWidth(DownloadTableModel::ColumnTransferRate, 120);
+        m_downloadsView->setColumnWidth(DownloadTableModel::ColumnLastTry, 120);
         
-        downloadsLayout->addWidget(m_downloadsTable);
+        downloadsLayout->addWidget(m_downloadsView);
         
         // Download details panel
         QGroupBox *detailsGroup = new QGroupBox("Download status");
@@ -1229,86 +1518,74 @@ private:
     {
         connect(m_categoriesTree, &QTreeWidget::currentItemChanged,
                 this, &LDMMainWindow::onCategoryChanged);
-        connect(m_downloadsTable, &QTableWidget::currentCellChanged,
+        connect(m_downloadsView->selectionModel(), &QItemSelectionModel::currentRowChanged,
                 this, &LDMMainWindow::onSelectionChanged);
         
         // Download engine connections
-        connect(m_downloadEngine, &DownloadEngine::downloadProgress,
-                this, &LDMMainWindow::onDownloadProgress);
+        connect(m_downloadEngine, &DownloadEngine::progressUpdated,
+                this, &LDMMainWindow::onProgressUpdated);
         connect(m_downloadEngine, &DownloadEngine::downloadCompleted,
                 this, &LDMMainWindow::onDownloadCompleted);
         connect(m_downloadEngine, &DownloadEngine::downloadFailed,
                 this, &LDMMainWindow::onDownloadFailed);
     }
     
+    static DownloadTableModel::Download tableRow(DownloadItem *item)
+    {
+        DownloadTableModel::Download row;
+        row.id = item->id();
+        row.fileName = item->fileName();
+        row.url = item->url();
+        row.category = item->category();
+        row.totalSize = item->totalSize();
+        row.downloadedSize = item->downloadedSize();
+        row.status = static_cast<DownloadTableModel::Status>(item->status());
+        row.lastTry = QDateTime::currentDateTime();
+        return row;
+    }
+
+    int currentDownloadId() const
+    {
+        QModelIndex current = m_downloadsView->currentIndex();
+        return current.isValid() ? current.data(DownloadTableModel::IdRole).toInt() : -1;
+    }
+
     void addDownloadToTable(int downloadId)
     {
         DownloadItem *item = m_downloadEngine->getDownload(downloadId);
         if (!item) return;
         
-        int row = m_downloadsTable->rowCount();
-        m_downloadsTable->insertRow(row);
-        
-        m_downloadsTable->setItem(row, 0, new QTableWidgetItem(item->fileName()));
-        m_downloadsTable->setItem(row, 1, new QTableWidgetItem("Unknown"));
-        m_downloadsTable->setItem(row, 2, new QTableWidgetItem(item->statusString()));
-        m_downloadsTable->setItem(row, 3, new QTableWidgetItem("Unknown"));
-        m_downloadsTable->setItem(row, 4, new QTableWidgetItem("0 KB/s"));
-        m_downloadsTable->setItem(row, 5, new QTableWidgetItem(QDateTime::currentDateTime().toString("MMM dd hh:mm")));
-        m_downloadsTable->setItem(row, 6, new QTableWidgetItem(item->url()));
-        m_downloadsTable->setItem(row, 7, new QTableWidgetItem(QString::number(downloadId))); // Hidden ID
+        int row = m_downloadsModel->addDownload(tableRow(item));
         
-        m_downloadsTable->selectRow(row);
+        QModelIndex index = m_downloadsProxy->mapFromSource(m_downloadsModel->index(row, 0));
+        if (index.isValid()) {
+            m_downloadsView->setCurrentIndex(index);
+        }
         updateDetailsPanel();
     }
     
-    void updateDownloadInTable(int downloadId, qint64 bytesReceived, qint64 bytesTotal, const QString &status = QString())
+    // O(1) lookup through the model's id index; only the changed cells repaint
+    void syncDownloadRow(int downloadId, const QString &error = QString())
     {
-        for (int row = 0; row < m_downloadsTable->rowCount(); ++row) {
-            QTableWidgetItem *idItem = m_downloadsTable->item(row, 7);
-            if (idItem && idItem->text().toInt() == downloadId) {
-                DownloadItem *item = m_downloadEngine->getDownload(downloadId);
-                if (!item) return;
-                
-                // Update size
-                QString sizeText = QString("%1 / %2").arg(formatFileSize(bytesReceived)).arg(formatFileSize(bytesTotal));
-                m_downloadsTable->setItem(row, 1, new QTableWidgetItem(sizeText));
-                
-                // Update status
-                QString statusText = status.isEmpty() ? item->statusString() : status;
-                m_downloadsTable->setItem(row, 2, new QTableWidgetItem(statusText));
-                
-                // Update speed
-                QString speedText = formatSpeed(item->speed());
-                m_downloadsTable->setItem(row, 4, new QTableWidgetItem(speedText));
-                
-                // Update ETA
-                QString etaText = formatTimeRemaining(item->eta());
-                m_downloadsTable->setItem(row, 3, new QTableWidgetItem(etaText));
-                
-                break;
-            }
-        }
+        DownloadItem *item = m_downloadEngine->getDownload(downloadId);
+        if (!item) return;
+        
+        m_downloadsModel->updateStatus(downloadId, static_cast<DownloadTableModel::Status>(item->status()), error);
+        m_downloadsModel->updateProgress(downloadId, item->downloadedSize(), item->totalSize(),
+                                         item->speed(), item->eta());
     }
     
     void updateDetailsPanel()
     {
-        int currentRow = m_downloadsTable->currentRow();
-        if (currentRow >= 0) {
-            QTableWidgetItem *idItem = m_downloadsTable->item(currentRow, 7);
-            if (idItem) {
-                int downloadId = idItem->text().toInt();
-                DownloadItem *item = m_downloadEngine->getDownload(downloadId);
-                if (item) {
-                    m_detailsUrlLabel->setText(item->url());
-                    m_detailsStatusLabel->setText(item->statusString());
-                    m_detailsSizeLabel->setText(formatFileSize(item->totalSize()));
-                    m_detailsSpeedLabel->setText(formatSpeed(item->speed()));
-                    m_detailsTimeLeftLabel->setText(formatTimeRemaining(item->eta()));
-                    m_detailsProgressBar->setValue(static_cast<int>(item->progress()));
-                    return;
-                }
-            }
+        DownloadItem *item = m_downloadEngine->getDownload(currentDownloadId());
+        if (item) {
+            m_detailsUrlLabel->setText(item->url());
+            m_detailsStatusLabel->setText(item->statusString());
+            m_detailsSizeLabel->setText(formatFileSize(item->totalSize()));
+            m_detailsSpeedLabel->setText(formatSpeed(item->speed()));
+            m_detailsTimeLeftLabel->setText(formatTimeRemaining(item->eta()));
+            m_detailsProgressBar->setValue(static_cast<int>(item->progress()));
+            return;
         }
         
         // Default values
@@ -1322,7 +1599,8 @@ private:
     
     void updateGlobalProgress()
     {
-        QList<DownloadItem*> downloads = m_downloadEngine->getAllDownloads();
+        // Only transfers with a worker contribute, so a frame costs the same with 100k rows restored
+        QList<DownloadItem*> downloads = m_downloadEngine->getActiveDownloads();
         if (downloads.isEmpty()) {
             m_globalProgressBar->setValue(0);
             m_globalSpeedLabel->setText("0 KB/s");
@@ -1351,20 +1629,9 @@ private:
     
     void filterDownloadsByCategory(const QString &category)
     {
-        for (int row = 0; row < m_downloadsTable->rowCount(); ++row) {
-            bool visible = true;
-            if (category != "All Downloads") {
-                QTableWidgetItem *idItem = m_downloadsTable->item(row, 7);
-                if (idItem) {
-                    int downloadId = idItem->text().toInt();
-                    DownloadItem *item = m_downloadEngine->getDownload(downloadId);
-                    if (item) {
-                        visible = (item->category() == category);
-                    }
-                }
-            }
-            m_downloadsTable->setRowHidden(row, !visible);
-        }
+        QString pattern = category == "All Downloads"
+            ? QString() : "^" + QRegularExpression::escape(category) + "$";
+        m_downloadsProxy->setFilterRegularExpression(pattern);
     }
     
     void showNotification(const QString &title, const QString &message)
@@ -1374,6 +1641,96 @@ private:
         }
     }
     
+    static const int FIRST_PAGE_SIZE = 50;
+
+    int loadFirstPage()
+    {
+        if (!m_database) {
+            return 0;
+        }
+
+        QVariantList rows = m_database->getDownloadsPage(0, FIRST_PAGE_SIZE);
+        appendPersistedDownloads(rows);
+        return rows.size() == FIRST_PAGE_SIZE ? rows.last().toMap().value("id").toInt() : 0;
+    }
+
+    void startBackgroundLoad(int beforeId)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        DownloadListLoader *loader = new DownloadListLoader(m_database->databasePath(), beforeId);
+        m_loaderThread = new QThread(this);
+        loader->moveToThread(m_loaderThread);
+
+        connect(m_loaderThread, &QThread::started, loader, &DownloadListLoader::load);
+        // Queued onto the GUI thread, which only creates the items and appends the rows
+        connect(loader, &DownloadListLoader::downloadsLoaded, this, &LDMMainWindow::applyRestoredDownloads,
+                Qt::QueuedConnection);
+        connect(loader, &DownloadListLoader::finished, m_loaderThread, &QThread::quit);
+        connect(m_loaderThread, &QThread::finished, loader, &QObject::deleteLater);
+        connect(m_loaderThread, &QThread::finished, this, [this, timer]() {
+            statusBar()->showMessage(QString("Loaded %1 downloads in %2 ms")
+                                     .arg(m_downloadsModel->rowCount()).arg(timer.elapsed()), 5000);
+            m_loaderThread->deleteLater();
+            m_loaderThread = nullptr;
+        });
+
+        m_loaderThread->start(QThread::LowPriority);
+    }
+
+    void appendPersistedDownloads(const QVariantList &rows)
+    {
+        applyRestoredDownloads(DownloadListLoader::restore(rows));
+    }
+
+    void applyRestoredDownloads(const QVector<DownloadListLoader::RestoredDownload> &downloads)
+    {
+        if (downloads.isEmpty()) {
+            return;
+        }
+
+        QVector<DownloadTableModel::Download> tableRows;
+        tableRows.reserve(downloads.size());
+
+        for (const DownloadListLoader::RestoredDownload &download : downloads) {
+            int downloadId = restoreDownload(download);
+
+            DownloadTableModel::Download row = tableRow(m_downloadEngine->getDownload(downloadId));
+            row.lastTry = download.createdAt;
+            tableRows.append(row);
+        }
+
+        m_downloadsModel->appendDownloads(tableRows);
+    }
+
+    int restoreDownload(const DownloadListLoader::RestoredDownload &download)
+    {
+        int downloadId = m_downloadEngine->addDownload(download.url, download.fileName, download.savePath,
+                                                       download.category, download.id);
+
+        // Nothing is listening for this item yet, so keep the restore silent
+        DownloadItem *item = m_downloadEngine->getDownload(downloadId);
+        QSignalBlocker blocker(item);
+        item->setTotalSize(download.totalSize);
+        item->setDownloadedSize(download.downloadedSize);
+        if (download.status != DownloadItem::Waiting) {
+            item->setStatus(download.status);
+        }
+
+        return downloadId;
+    }
+
+    void persistDownloadState(DownloadItem *item)
+    {
+        if (!m_database || !item) {
+            return;
+        }
+
+        m_database->updateDownloadState(item->id(), statusName(item->status()),
+                                        item->downloadedSize(), item->totalSize());
+    }
+
     void addDemoDownloads()
     {
         // Add some demo downloads
@@ -1398,69 +1755,30 @@ private:
     
     void applyIDMStyling()
     {
-        setStyleSheet(
-            "QMainWindow { background-color: #f0f0f0; }"
-            "QToolBar { background-color: #e8e8e8; border: 1px solid #ccc; spacing: 2px; padding: 2px; }"
-            "QTreeWidget { background-color: white; border: 1px solid #ccc; alternate-background-color: #f5f5f5; }"
-            "QTableWidget { background-color: white; border: 1px solid #ccc; gridline-color: #ddd; alternate-background-color: #f9f9f9; }"
-            "QGroupBox { font-weight: bold; border: 2px solid #ccc; border-radius: 5px; margin-top: 1ex; background-color: #fafafa; }"
-            "QGroupBox::title { subcontrol-origin: margin; left: 10px; padding: 0 5px 0 5px; }"
-            "QStatusBar { background-color: #e8e8e8; border-top: 1px solid #ccc; }"
-            "QProgressBar { border: 1px solid #ccc; border-radius: 3px; text-align: center; background-color: #f0f0f0; }"
-            "QProgressBar::chunk { background-color: #4CAF50; border-radius: 2px; }"
-            "QPushButton { padding: 5px 10px; border: 1px solid #ccc; border-radius: 3px; background-color: #f8f8f8; }"
-            "QPushButton:hover { background-color: #e8e8e8; }"
-            "QPushButton:pressed { background-color: #d8d8d8; }"
-        );
+        // Stylesheet and palettes are prebuilt; only these widgets carry theme rules
+        ThemeManager *themes = ThemeManager::instance();
+        themes->registerThemedWidget(m_mainToolBar);
+        themes->registerThemedWidget(statusBar());
+
+        QSettings settings;
+        QString themeName = settings.value("interface/theme",
+                                           ThemeManager::themeName(ThemeManager::ClassicIDM)).toString();
+        themes->setTheme(ThemeManager::themeFromName(themeName));
     }
     
     QString formatFileSize(qint64 bytes)
     {
-        if (bytes == 0) return "0 B";
-        
-        const char* units[] = {"B", "KB", "MB", "GB", "TB"};
-        int unitIndex = 0;
-        double size = bytes;
-        
-        while (size >= 1024 && unitIndex < 4) {
-            size /= 1024;
-            unitIndex++;
-        }
-        
-        return QString("%1 %2").arg(QString::number(size, 'f', 2)).arg(units[unitIndex]);
+        return DownloadTableModel::formatFileSize(bytes);
     }
     
     QString formatSpeed(qint64 bytesPerSecond)
     {
-        if (bytesPerSecond == 0) return "0 KB/s";
-        
-        const char* units[] = {"B/s", "KB/s", "MB/s", "GB/s"};
-        int unitIndex = 0;
-        double speed = bytesPerSecond;
-        
-        while (speed >= 1024 && unitIndex < 3) {
-            speed /= 1024;
-            unitIndex++;
-        }
-        
-        return QString("%1 %2").arg(QString::number(speed, 'f', 1)).arg(units[unitIndex]);
+        return DownloadTableModel::formatSpeed(bytesPerSecond);
     }
     
     QString formatTimeRemaining(qint64 seconds)
     {
-        if (seconds <= 0) return "Unknown";
-        
-        int hours = seconds / 3600;
-        int minutes = (seconds % 3600) / 60;
-        int secs = seconds % 60;
-        
-        if (hours > 0) {
-            return QString("%1h %2m").arg(hours).arg(minutes);
-        } else if (minutes > 0) {
-            return QString("%1m %2s").arg(minutes).arg(secs);
-        } else {
-            return QString("%1s").arg(secs);
-        }
+        return DownloadTableModel::formatTimeRemaining(seconds);
     }
     
     void loadSettings()
@@ -1478,6 +1796,58 @@ private:
     }
 };
 
+// Serves the browser bridge from the window's own engine, so captured
+// downloads are listed and driven exactly like ones added by hand
+class EngineBridgeBackend : public BridgeBackend
+{
+    Q_OBJECT
+
+public:
+    explicit EngineBridgeBackend(LDMMainWindow *window)
+        : BridgeBackend(window), m_window(window)
+    {
+        // The engine already batches progress once per UI frame
+        DownloadEngine *engine = window->downloadEngine();
+        connect(engine, &DownloadEngine::progressUpdated, this, [this, engine](const QList<int> &ids) {
+            for (int id : ids) {
+                if (DownloadItem *item = engine->getDownload(id)) {
+                    emit downloadProgressChanged(id, item->downloadedSize(), item->totalSize(), item->speed());
+                }
+            }
+        });
+        connect(engine, &DownloadEngine::downloadCompleted, this, &BridgeBackend::downloadCompleted);
+        connect(engine, &DownloadEngine::downloadFailed, this, &BridgeBackend::downloadFailed);
+    }
+
+    QList<int> createDownloads(const QVariantList &rows) override
+    {
+        return m_window->addCapturedDownloads(rows);
+    }
+
+    bool cancelDownload(int downloadId) override
+    {
+        return m_window->removeDownload(downloadId);
+    }
+
+    QVariantMap download(int downloadId) const override
+    {
+        DownloadItem *item = m_window->downloadEngine()->getDownload(downloadId);
+        if (!item) {
+            return QVariantMap();
+        }
+
+        QVariantMap row;
+        row["filename"] = item->fileName();
+        row["status"] = LDMMainWindow::statusName(item->status());
+        row["downloaded_size"] = item->downloadedSize();
+        row["total_size"] = item->totalSize();
+        return row;
+    }
+
+private:
+    LDMMainWindow *m_window;
+};
+
 #include "main.moc"
 
 int main(int argc, char *argv[])
@@ -1494,8 +1864,25 @@ int main(int argc, char *argv[])
     QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     QDir().mkpath(dataDir);
 
-    LDMMainWindow window;
+    // open() skips the schema DDL when the stored schema version is current
+    Database database;
+    bool databaseOpen = database.open(dataDir + "/ldm.db");
+    if (!databaseOpen) {
+        qWarning() << "Failed to open download database, downloads will not be persisted";
+    }
+
+    LDMMainWindow window(databaseOpen ? &database : nullptr);
     window.show();
 
+    // Downloads captured by the browser extension arrive through the native messaging host;
+    // if another LDM instance already serves the socket, this window just runs without it
+    BridgeServer bridge(new EngineBridgeBackend(&window));
+    bridge.listen();
+
+    // Index builds and backfills on large databases run after the window is up
+    if (databaseOpen) {
+        database.startOnlineMigrations();
+    }
+
     return app.exec();
 }
\ No newline at end of file
@@ -31,16 +31,16 @@
 #include <QScrollArea>
 #include <QSpacerItem>
 #include "SpeedChart.h"
+#include "SegmentMapWidget.h"
 
 // Forward declarations
-class SegmentViewer;
 class FilePreviewWidget;
 
 /**
  * Download details panel that reproduces IDM's bottom panel exactly
  * Features:
  * - Real-time speed chart (green line like IDM)
- * - Download segments visualization with colored bars
+ * - Live per-connection segment map read from the engine's lock-free snapshot
  * - Complete file information (name, URL, size, type)
  * - Download statistics (average speed, elapsed time, ETA)
  * - Action buttons (Resume, Pause, Restart, Open Folder)
@@ -212,7 +212,7 @@ private:
     // Segments tab
     QWidget *m_segmentsTab;
     QVBoxLayout *m_segmentsLayout;
-    SegmentViewer *m_segmentViewer;
+    SegmentMapWidget *m_segmentMap;
     QTableWidget *m_segmentTable;
     
     // General tab
@@ -278,7 +278,6 @@ private:
     void updateStatistics();
     void updateActionButtons();
     void updateSpeedChart();
-    void updateSegmentViewer();
     void updateLogDisplay();
     void refreshAllSections();
     
@@ -327,43 +326,6 @@ private:
     static const int TAB_SECTION_MIN_HEIGHT = 150;     // Tab section minimum height
 };
 
-/**
- * Download segments visualization widget
- */
-class SegmentViewer : public QWidget
-{
-    Q_OBJECT
-
-public:
-    explicit SegmentViewer(QWidget *parent = nullptr);
-    
-    void setSegments(const QList<QPair<qint64, qint64>> &segments, 
-                    const QList<bool> &status);
-    void setTotalSize(qint64 totalSize);
-    void updateProgress(const QList<qint64> &progress);
-
-protected:
-    void paintEvent(QPaintEvent *event) override;
-    void mouseMoveEvent(QMouseEvent *event) override;
-
-private:
-    struct Segment {
-        qint64 start;
-        qint64 end;
-        qint64 progress;
-        bool active;
-    };
-    
-    QList<Segment> m_segments;
-    qint64 m_totalSize;
-    QPoint m_mousePos;
-    
-    void drawSegmentBars(QPainter &painter);
-    void drawSegmentTooltip(QPainter &painter);
-    QColor getSegmentColor(const Segment &segment) const;
-    QString formatSegmentTooltip(const Segment &segment) const;
-};
-
 /**
  * File preview widget for supported file types
  */
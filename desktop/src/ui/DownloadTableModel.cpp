@@ -0,0 +1,308 @@
+#include "DownloadTableModel.h"
+#include "ProgressPixmapCache.h"
+#include <QApplication>
+#include <QPainter>
+#include <QStyle>
+
+DownloadTableModel::DownloadTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+int DownloadTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_downloads.size();
+}
+
+int DownloadTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant DownloadTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_downloads.size()) {
+        return QVariant();
+    }
+
+    const Download &download = m_downloads.at(index.row());
+
+    switch (role) {
+    case IdRole:
+        return download.id;
+    case CategoryRole:
+        return download.category;
+    case StatusRole:
+        return download.status;
+    case ProgressRole:
+        // Only active transfers get a bar; finished rows render as plain text
+        if (index.column() != ColumnStatus
+            || (download.status != Downloading && download.status != Paused)) {
+            return QVariant();
+        }
+        return download.totalSize > 0 ? double(download.downloadedSize) * 100.0 / download.totalSize : 0.0;
+    case Qt::ToolTipRole:
+        if (index.column() == ColumnStatus && download.status == Failed) {
+            return download.errorMessage;
+        }
+        return QVariant();
+    case Qt::DisplayRole:
+        break;
+    default:
+        return QVariant();
+    }
+
+    // Display text is built on demand for visible cells only
+    switch (index.column()) {
+    case ColumnFileName:
+        return download.fileName;
+    case ColumnSize:
+        return sizeText(download);
+    case ColumnStatus:
+        return statusText(download);
+    case ColumnTimeLeft:
+        return download.status == Downloading ? formatTimeRemaining(download.eta) : QString();
+    case ColumnTransferRate:
+        return download.status == Downloading ? formatSpeed(download.speed) : QString();
+    case ColumnLastTry:
+        return download.lastTry.toString("MMM dd hh:mm");
+    case ColumnDescription:
+        return download.url;
+    default:
+        return QVariant();
+    }
+}
+
+QVariant DownloadTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section) {
+    case ColumnFileName: return "File Name";
+    case ColumnSize: return "Size";
+    case ColumnStatus: return "Status";
+    case ColumnTimeLeft: return "Time left";
+    case ColumnTransferRate: return "Transfer rate";
+    case ColumnLastTry: return "Last Try";
+    case ColumnDescription: return "Description";
+    default: return QVariant();
+    }
+}
+
+int DownloadTableModel::addDownload(const Download &download)
+{
+    int existing = rowForId(download.id);
+    if (existing >= 0) {
+        m_downloads[existing] = download;
+        emit dataChanged(index(existing, 0), index(existing, ColumnCount - 1));
+        return existing;
+    }
+
+    int row = m_downloads.size();
+    beginInsertRows(QModelIndex(), row, row);
+    m_downloads.append(download);
+    m_rowById.insert(download.id, row);
+    endInsertRows();
+    return row;
+}
+
+void DownloadTableModel::appendDownloads(const QVector<Download> &downloads)
+{
+    if (downloads.isEmpty()) {
+        return;
+    }
+
+    // One insert notification per batch keeps the view from relaying out per row
+    int first = m_downloads.size();
+    beginInsertRows(QModelIndex(), first, first + downloads.size() - 1);
+    m_downloads.reserve(first + downloads.size());
+    for (const Download &download : downloads) {
+        m_rowById.insert(download.id, m_downloads.size());
+        m_downloads.append(download);
+    }
+    endInsertRows();
+}
+
+void DownloadTableModel::updateProgress(int id, qint64 downloadedSize, qint64 totalSize, qint64 speed, int eta)
+{
+    int row = rowForId(id);
+    if (row < 0) {
+        return;
+    }
+
+    Download &download = m_downloads[row];
+    bool sizeChanged = download.downloadedSize != downloadedSize || download.totalSize != totalSize;
+    bool rateChanged = download.speed != speed || download.eta != eta;
+    if (!sizeChanged && !rateChanged) {
+        return;
+    }
+
+    download.downloadedSize = downloadedSize;
+    download.totalSize = totalSize;
+    download.speed = speed;
+    download.eta = eta;
+
+    // Size and Status depend on the byte counts, Time left and Transfer rate on the rate
+    int firstColumn = sizeChanged ? ColumnSize : ColumnTimeLeft;
+    int lastColumn = rateChanged ? ColumnTransferRate : ColumnStatus;
+    emit dataChanged(index(row, firstColumn), index(row, lastColumn), {Qt::DisplayRole, ProgressRole});
+}
+
+void DownloadTableModel::updateStatus(int id, Status status, const QString &errorMessage)
+{
+    int row = rowForId(id);
+    if (row < 0) {
+        return;
+    }
+
+    Download &download = m_downloads[row];
+    if (download.status == status && download.errorMessage == errorMessage) {
+        return;
+    }
+
+    download.status = status;
+    download.errorMessage = errorMessage;
+    if (status == Downloading) {
+        download.lastTry = QDateTime::currentDateTime();
+    }
+
+    emit dataChanged(index(row, ColumnSize), index(row, ColumnLastTry));
+}
+
+void DownloadTableModel::removeDownload(int id)
+{
+    int row = rowForId(id);
+    if (row < 0) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_downloads.remove(row);
+    m_rowById.remove(id);
+    for (int i = row; i < m_downloads.size(); ++i) {
+        m_rowById[m_downloads.at(i).id] = i;
+    }
+    endRemoveRows();
+}
+
+int DownloadTableModel::rowForId(int id) const
+{
+    return m_rowById.value(id, -1);
+}
+
+const DownloadTableModel::Download *DownloadTableModel::download(int id) const
+{
+    int row = rowForId(id);
+    return row >= 0 ? &m_downloads.at(row) : nullptr;
+}
+
+QString DownloadTableModel::statusText(const Download &download) const
+{
+    switch (download.status) {
+    case Waiting: return "Waiting";
+    case Downloading: {
+        double progress = download.totalSize > 0 ? double(download.downloadedSize) * 100.0 / download.totalSize : 0.0;
+        return QString("Downloading %1%").arg(QString::number(progress, 'f', 1));
+    }
+    case Paused: return "Paused";
+    case Completed: return "Completed";
+    case Failed: return download.errorMessage.isEmpty() ? QString("Failed") : "Failed: " + download.errorMessage;
+    case Cancelled: return "Cancelled";
+    default: return "Unknown";
+    }
+}
+
+QString DownloadTableModel::sizeText(const Download &download) const
+{
+    if (download.totalSize <= 0) {
+        return "Unknown";
+    }
+    if (download.status == Completed || download.downloadedSize >= download.totalSize) {
+        return formatFileSize(download.totalSize);
+    }
+    return QString("%1 / %2").arg(formatFileSize(download.downloadedSize)).arg(formatFileSize(download.totalSize));
+}
+
+QString DownloadTableModel::formatFileSize(qint64 bytes)
+{
+    if (bytes == 0) return "0 B";
+
+    const char* units[] = {"B", "KB", "MB", "GB", "TB"};
+    int unitIndex = 0;
+    double size = bytes;
+
+    while (size >= 1024 && unitIndex < 4) {
+        size /= 1024;
+        unitIndex++;
+    }
+
+    return QString("%1 %2").arg(QString::number(size, 'f', 2)).arg(units[unitIndex]);
+}
+
+QString DownloadTableModel::formatSpeed(qint64 bytesPerSecond)
+{
+    if (bytesPerSecond == 0) return "0 KB/s";
+
+    const char* units[] = {"B/s", "KB/s", "MB/s", "GB/s"};
+    int unitIndex = 0;
+    double speed = bytesPerSecond;
+
+    while (speed >= 1024 && unitIndex < 3) {
+        speed /= 1024;
+        unitIndex++;
+    }
+
+    return QString("%1 %2").arg(QString::number(speed, 'f', 1)).arg(units[unitIndex]);
+}
+
+QString DownloadTableModel::formatTimeRemaining(qint64 seconds)
+{
+    if (seconds <= 0) return "Unknown";
+
+    int hours = seconds / 3600;
+    int minutes = (seconds % 3600) / 60;
+    int secs = seconds % 60;
+
+    if (hours > 0) {
+        return QString("%1h %2m").arg(hours).arg(minutes);
+    } else if (minutes > 0) {
+        return QString("%1m %2s").arg(minutes).arg(secs);
+    } else {
+        return QString("%1s").arg(secs);
+    }
+}
+
+DownloadProgressDelegate::DownloadProgressDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+void DownloadProgressDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+                                     const QModelIndex &index) const
+{
+    QVariant progress = index.data(DownloadTableModel::ProgressRole);
+    if (!progress.isValid()) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    QStyleOptionViewItem itemOption(option);
+    initStyleOption(&itemOption, index);
+    QStyle *style = itemOption.widget ? itemOption.widget->style() : QApplication::style();
+
+    // Background and selection first, then the bar with the status text on top
+    QString text = itemOption.text;
+    itemOption.text.clear();
+    style->drawControl(QStyle::CE_ItemViewItem, &itemOption, painter, itemOption.widget);
+
+    // Track and fill come from the shared pixmap cache; only the text is drawn per frame
+    ProgressPixmapCache::State state = index.data(DownloadTableModel::StatusRole).toInt() == DownloadTableModel::Paused
+        ? ProgressPixmapCache::Paused : ProgressPixmapCache::Active;
+    painter->save();
+    painter->setFont(option.font);
+    ProgressPixmapCache::paint(painter, option.rect.adjusted(2, 2, -2, -2), progress.toDouble() / 100.0,
+                               state, text, option.palette);
+    painter->restore();
+}
\ No newline at end of file
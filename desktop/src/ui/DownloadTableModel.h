@@ -0,0 +1,108 @@
+#ifndef DOWNLOADTABLEMODEL_H
+#define DOWNLOADTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QStyledItemDelegate>
+#include <QDateTime>
+#include <QHash>
+#include <QVector>
+
+/**
+ * Table model over a compact, contiguous download store.
+ * Rows are addressed through an id -> row index, so a progress update touches
+ * one row and emits dataChanged only for the cells it actually changed.
+ */
+class DownloadTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        ColumnFileName = 0,
+        ColumnSize,
+        ColumnStatus,
+        ColumnTimeLeft,
+        ColumnTransferRate,
+        ColumnLastTry,
+        ColumnDescription,
+        ColumnCount
+    };
+
+    // Same order as DownloadItem::Status in main.cpp
+    enum Status {
+        Waiting,
+        Downloading,
+        Paused,
+        Completed,
+        Failed,
+        Cancelled
+    };
+
+    enum Role {
+        IdRole = Qt::UserRole,
+        ProgressRole,
+        CategoryRole,
+        StatusRole
+    };
+
+    struct Download {
+        int id = 0;
+        QString fileName;
+        QString url;
+        QString category;
+        QString errorMessage;
+        QDateTime lastTry;
+        qint64 totalSize = 0;
+        qint64 downloadedSize = 0;
+        qint64 speed = 0;
+        int eta = 0;
+        Status status = Waiting;
+    };
+
+    explicit DownloadTableModel(QObject *parent = nullptr);
+
+    // QAbstractTableModel
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    // Store operations
+    int addDownload(const Download &download);
+    void appendDownloads(const QVector<Download> &downloads);
+    void updateProgress(int id, qint64 downloadedSize, qint64 totalSize, qint64 speed, int eta);
+    void updateStatus(int id, Status status, const QString &errorMessage = QString());
+    void removeDownload(int id);
+
+    int rowForId(int id) const;
+    const Download *download(int id) const;
+
+    // Shared formatting helpers
+    static QString formatFileSize(qint64 bytes);
+    static QString formatSpeed(qint64 bytesPerSecond);
+    static QString formatTimeRemaining(qint64 seconds);
+
+private:
+    QVector<Download> m_downloads;
+    QHash<int, int> m_rowById;
+
+    QString statusText(const Download &download) const;
+    QString sizeText(const Download &download) const;
+};
+
+/**
+ * Paints the status column as a progress bar straight from ProgressRole,
+ * so no per-row widgets exist and off-screen rows cost nothing.
+ */
+class DownloadProgressDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit DownloadProgressDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+               const QModelIndex &index) const override;
+};
+
+#endif // DOWNLOADTABLEMODEL_H
\ No newline at end of file
@@ -1,23 +1,36 @@
 #include "MediaPreviewWidget.h"
+#include "utils/ThumbnailCache.h"
 #include <QUrl>
 #include <QMessageBox>
+#include <QPixmap>
+#include <QTime>
 
 MediaPreviewWidget::MediaPreviewWidget(QWidget *parent)
     : QWidget(parent)
+    , m_device(nullptr)
 {
     m_mediaPlayer = new QMediaPlayer(this);
     m_videoWidget = new QVideoWidget(this);
     m_audioOutput = new QAudioOutput(this);
     m_layout = new QVBoxLayout(this);
+    m_stack = new QStackedWidget(this);
+    m_posterLabel = new QLabel(this);
+    m_infoLabel = new QLabel(this);
 
     m_mediaPlayer->setVideoOutput(m_videoWidget);
     m_mediaPlayer->setAudioOutput(m_audioOutput);
 
-    m_layout->addWidget(m_videoWidget);
+    m_posterLabel->setAlignment(Qt::AlignCenter);
+    m_stack->addWidget(m_posterLabel);
+    m_stack->addWidget(m_videoWidget);
+
+    m_layout->addWidget(m_stack);
+    m_layout->addWidget(m_infoLabel);
     setLayout(m_layout);
 
     connect(m_mediaPlayer, &QMediaPlayer::mediaStatusChanged, this, &MediaPreviewWidget::onMediaStatusChanged);
     connect(m_mediaPlayer, QOverload<QMediaPlayer::Error, const QString &>::of(&QMediaPlayer::errorOccurred), this, &MediaPreviewWidget::onErrorOccurred);
+    connect(ThumbnailCache::instance(), &ThumbnailCache::ready, this, &MediaPreviewWidget::onThumbnailReady);
 }
 
 MediaPreviewWidget::~MediaPreviewWidget()
@@ -27,11 +40,50 @@ MediaPreviewWidget::~MediaPreviewWidget()
 
 void MediaPreviewWidget::setMedia(const QString &filePath)
 {
-    m_mediaPlayer->setSource(QUrl::fromLocalFile(filePath));
+    m_filePath = filePath;
+    m_mediaPlayer->stop();
+    m_mediaPlayer->setSource(QUrl());
+    releaseDevice();
+    m_stack->setCurrentWidget(m_posterLabel);
+
+    // Show what is cached at once; the request revalidates it off the GUI thread
+    MediaProbe::Result result;
+    if (ThumbnailCache::instance()->lookup(filePath, &result)) {
+        showProbeResult(result);
+    } else {
+        m_posterLabel->clear();
+        m_infoLabel->setText("Loading preview...");
+    }
+    ThumbnailCache::instance()->request(filePath);
+}
+
+void MediaPreviewWidget::setMediaDevice(QIODevice *device, const QString &filePath)
+{
+    m_filePath = filePath;
+    m_mediaPlayer->stop();
+    m_mediaPlayer->setSource(QUrl());
+    releaseDevice();
+
+    m_device = device;
+    if (m_device) {
+        m_device->setParent(this);
+    }
+    m_stack->setCurrentWidget(m_posterLabel);
+    m_posterLabel->setText("Downloading - preview available");
+    m_infoLabel->clear();
 }
 
 void MediaPreviewWidget::play()
 {
+    if (m_mediaPlayer->source().isEmpty() && m_mediaPlayer->sourceDevice() == nullptr) {
+        // The URL only tells the backend the container type; bytes come from the device
+        if (m_device) {
+            m_mediaPlayer->setSourceDevice(m_device, QUrl::fromLocalFile(m_filePath));
+        } else if (!m_filePath.isEmpty()) {
+            m_mediaPlayer->setSource(QUrl::fromLocalFile(m_filePath));
+        }
+    }
+    m_stack->setCurrentWidget(m_videoWidget);
     m_mediaPlayer->play();
 }
 
@@ -43,6 +95,7 @@ void MediaPreviewWidget::pause()
 void MediaPreviewWidget::stop()
 {
     m_mediaPlayer->stop();
+    m_stack->setCurrentWidget(m_posterLabel);
 }
 
 void MediaPreviewWidget::onMediaStatusChanged(QMediaPlayer::MediaStatus status)
@@ -56,4 +109,52 @@ void MediaPreviewWidget::onMediaStatusChanged(QMediaPlayer::MediaStatus status)
 void MediaPreviewWidget::onErrorOccurred(QMediaPlayer::Error error, const QString &errorString)
 {
     QMessageBox::warning(this, "Media Error", QString("Error playing media: %1").arg(errorString));
+}
+
+void MediaPreviewWidget::onThumbnailReady(const QString &filePath, const MediaProbe::Result &result)
+{
+    if (filePath == m_filePath) {
+        showProbeResult(result);
+    }
+}
+
+void MediaPreviewWidget::releaseDevice()
+{
+    if (m_device) {
+        // Wakes a demuxer blocked in read() before the device goes away
+        m_device->close();
+        m_device->deleteLater();
+        m_device = nullptr;
+    }
+}
+
+void MediaPreviewWidget::showProbeResult(const MediaProbe::Result &result)
+{
+    if (!result.valid) {
+        m_posterLabel->setText("No preview available");
+        m_infoLabel->setText(result.error);
+        return;
+    }
+
+    if (result.thumbnail.isNull()) {
+        m_posterLabel->setText(result.audioCodec.isEmpty() ? "No preview available" : "Audio");
+    } else {
+        m_posterLabel->setPixmap(QPixmap::fromImage(result.thumbnail));
+    }
+
+    QStringList info;
+    if (result.durationMs > 0) {
+        QTime duration = QTime(0, 0).addMSecs(result.durationMs);
+        info << duration.toString(result.durationMs >= 3600000 ? "h:mm:ss" : "m:ss");
+    }
+    if (result.width > 0 && result.height > 0) {
+        info << QString("%1x%2").arg(result.width).arg(result.height);
+    }
+    if (!result.videoCodec.isEmpty()) {
+        info << result.videoCodec;
+    }
+    if (!result.audioCodec.isEmpty()) {
+        info << result.audioCodec;
+    }
+    m_infoLabel->setText(info.join("  |  "));
 }
\ No newline at end of file
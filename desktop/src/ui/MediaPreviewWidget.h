@@ -6,6 +6,9 @@
 #include <QVideoWidget>
 #include <QAudioOutput>
 #include <QVBoxLayout>
+#include <QStackedWidget>
+#include <QLabel>
+#include "utils/MediaProbe.h"
 
 class MediaPreviewWidget : public QWidget
 {
@@ -15,7 +18,12 @@ public:
     explicit MediaPreviewWidget(QWidget *parent = nullptr);
     ~MediaPreviewWidget();
 
+    // Shows the cached poster and media info at once; the player source is
+    // only loaded when playback is requested
     void setMedia(const QString &filePath);
+    // Plays a download in progress through a blocking reader such as
+    // DownloadEngine::openPreviewDevice(); the widget takes ownership
+    void setMediaDevice(QIODevice *device, const QString &filePath);
     void play();
     void pause();
     void stop();
@@ -23,12 +31,21 @@ public:
 private slots:
     void onMediaStatusChanged(QMediaPlayer::MediaStatus status);
     void onErrorOccurred(QMediaPlayer::Error error, const QString &errorString);
+    void onThumbnailReady(const QString &filePath, const MediaProbe::Result &result);
 
 private:
     QMediaPlayer *m_mediaPlayer;
     QVideoWidget *m_videoWidget;
     QAudioOutput *m_audioOutput;
     QVBoxLayout *m_layout;
+    QStackedWidget *m_stack;
+    QLabel *m_posterLabel;
+    QLabel *m_infoLabel;
+    QString m_filePath;
+    QIODevice *m_device;
+
+    void showProbeResult(const MediaProbe::Result &result);
+    void releaseDevice();
 };
 
 #endif // MEDIAPREVIEWWIDGET_H
\ No newline at end of file
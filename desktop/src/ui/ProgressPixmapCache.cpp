@@ -0,0 +1,115 @@
+#include "ProgressPixmapCache.h"
+#include <QPainter>
+#include <QPixmapCache>
+#include <QLinearGradient>
+
+static const int CORNER_RADIUS = 2;
+
+QPixmap ProgressPixmapCache::track(const QSize &size, qreal devicePixelRatio, const QPalette &palette)
+{
+    QString key = cacheKey("track", size, 0, devicePixelRatio, palette);
+    QPixmap pixmap;
+    if (QPixmapCache::find(key, &pixmap)) {
+        return pixmap;
+    }
+
+    pixmap = QPixmap(size * devicePixelRatio);
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    pixmap.fill(Qt::transparent);
+
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    QRectF rect(0.5, 0.5, size.width() - 1, size.height() - 1);
+    QColor base = palette.color(QPalette::Base);
+    QLinearGradient gradient(0, 0, 0, size.height());
+    gradient.setColorAt(0.0, base.darker(104));
+    gradient.setColorAt(1.0, base.darker(112));
+
+    painter.setPen(palette.color(QPalette::Mid));
+    painter.setBrush(gradient);
+    painter.drawRoundedRect(rect, CORNER_RADIUS, CORNER_RADIUS);
+    painter.end();
+
+    QPixmapCache::insert(key, pixmap);
+    return pixmap;
+}
+
+QPixmap ProgressPixmapCache::fill(const QSize &size, State state, qreal devicePixelRatio, const QPalette &palette)
+{
+    QString key = cacheKey("fill", size, state, devicePixelRatio, palette);
+    QPixmap pixmap;
+    if (QPixmapCache::find(key, &pixmap)) {
+        return pixmap;
+    }
+
+    pixmap = QPixmap(size * devicePixelRatio);
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    pixmap.fill(Qt::transparent);
+
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    QColor color = stateColor(state);
+    QLinearGradient gradient(0, 0, 0, size.height());
+    gradient.setColorAt(0.0, color.lighter(125));
+    gradient.setColorAt(0.5, color);
+    gradient.setColorAt(1.0, color.darker(115));
+
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(gradient);
+    painter.drawRoundedRect(QRectF(1, 1, size.width() - 2, size.height() - 2), CORNER_RADIUS, CORNER_RADIUS);
+    painter.end();
+
+    QPixmapCache::insert(key, pixmap);
+    return pixmap;
+}
+
+void ProgressPixmapCache::paint(QPainter *painter, const QRect &rect, qreal fraction, State state,
+                                const QString &text, const QPalette &palette)
+{
+    if (rect.isEmpty()) {
+        return;
+    }
+
+    qreal dpr = painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+    painter->drawPixmap(rect.topLeft(), track(rect.size(), dpr, palette));
+
+    // Only the done part of the fill pixmap is copied
+    int filledWidth = qRound(rect.width() * qBound<qreal>(0.0, fraction, 1.0));
+    if (filledWidth > 0) {
+        QPixmap fillPixmap = fill(rect.size(), state, dpr, palette);
+        painter->drawPixmap(QRectF(rect.x(), rect.y(), filledWidth, rect.height()), fillPixmap,
+                            QRectF(0, 0, filledWidth * dpr, rect.height() * dpr));
+    }
+
+    if (!text.isEmpty()) {
+        painter->setPen(palette.color(QPalette::Text));
+        painter->drawText(rect, Qt::AlignCenter, text);
+    }
+}
+
+QColor ProgressPixmapCache::stateColor(State state)
+{
+    switch (state) {
+    case Paused: return QColor(0xff, 0xb3, 0x00);
+    case Completed: return QColor(0x19, 0x76, 0xd2);
+    case Error: return QColor(0xd3, 0x2f, 0x2f);
+    case Active:
+    default: return QColor(0x4c, 0xaf, 0x50);
+    }
+}
+
+QString ProgressPixmapCache::cacheKey(const char *kind, const QSize &size, int state,
+                                      qreal devicePixelRatio, const QPalette &palette)
+{
+    // The theme enters the key through the colours the pixmaps are drawn from
+    return QString("ldm-progress-%1-%2x%3-%4-%5-%6-%7")
+        .arg(kind)
+        .arg(size.width())
+        .arg(size.height())
+        .arg(state)
+        .arg(devicePixelRatio)
+        .arg(palette.color(QPalette::Base).rgba())
+        .arg(palette.color(QPalette::Mid).rgba());
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef PROGRESSPIXMAPCACHE_H
+#define PROGRESSPIXMAPCACHE_H
+
+#include <QPixmap>
+#include <QPalette>
+#include <QSize>
+#include <QRect>
+#include <QString>
+
+class QPainter;
+
+// Pre-rendered progress bar pieces shared by every bar in the process.
+// The gradient track and the full-width fill are rendered once per
+// (size, state, theme, device pixel ratio) into QPixmapCache; painting a bar
+// is then two blits, the fill clipped to the done fraction, plus the text.
+class ProgressPixmapCache
+{
+public:
+    enum State {
+        Active,
+        Paused,
+        Completed,
+        Error
+    };
+
+    static QPixmap track(const QSize &size, qreal devicePixelRatio, const QPalette &palette);
+    static QPixmap fill(const QSize &size, State state, qreal devicePixelRatio, const QPalette &palette);
+
+    // fraction is 0..1; text is drawn centred on top and is the only per-frame work
+    static void paint(QPainter *painter, const QRect &rect, qreal fraction, State state,
+                      const QString &text, const QPalette &palette);
+
+    static QColor stateColor(State state);
+
+private:
+    static QString cacheKey(const char *kind, const QSize &size, int state,
+                            qreal devicePixelRatio, const QPalette &palette);
+};
+
+#endif // PROGRESSPIXMAPCACHE_H
\ No newline at end of file
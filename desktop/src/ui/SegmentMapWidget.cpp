@@ -0,0 +1,197 @@
+#include "SegmentMapWidget.h"
+#include <QPainter>
+#include <QHelpEvent>
+#include <QToolTip>
+
+SegmentMapWidget::SegmentMapWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_pollTimer(new QTimer(this))
+    , m_generation(0)
+    , m_totalSize(0)
+{
+    m_pollTimer->setInterval(POLL_INTERVAL);
+    connect(m_pollTimer, &QTimer::timeout, this, &SegmentMapWidget::poll);
+    setMinimumHeight(LANE_HEIGHT + 2 * LANE_SPACING);
+}
+
+void SegmentMapWidget::setSource(SegmentManager *manager)
+{
+    m_source = manager;
+    m_generation = 0;
+    m_segments.clear();
+
+    if (m_source) {
+        poll();
+        m_pollTimer->start();
+    } else {
+        m_pollTimer->stop();
+    }
+    update();
+}
+
+void SegmentMapWidget::setSnapshot(const QVector<SegmentSnapshot> &segments, qint64 totalSize)
+{
+    bool relayout = segments.size() != m_segments.size();
+    m_segments = segments;
+    m_totalSize = totalSize;
+
+    if (relayout) {
+        updateGeometry();
+    }
+    update();
+}
+
+void SegmentMapWidget::clear()
+{
+    setSource(nullptr);
+    m_totalSize = 0;
+}
+
+QSize SegmentMapWidget::sizeHint() const
+{
+    int lanes = qMax(1, int(m_segments.size()));
+    return QSize(300, lanes * (LANE_HEIGHT + LANE_SPACING) + LANE_SPACING);
+}
+
+void SegmentMapWidget::poll()
+{
+    if (!m_source) {
+        m_pollTimer->stop();
+        return;
+    }
+
+    // Nothing new since the last frame; skip the copy and the repaint
+    quint64 generation = m_source->segmentSnapshotGeneration();
+    if (generation == m_generation) {
+        return;
+    }
+
+    m_generation = generation;
+    setSnapshot(m_source->segmentSnapshot(), m_source->getTotalSize());
+}
+
+void SegmentMapWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+
+    if (m_segments.isEmpty()) {
+        return;
+    }
+
+    qint64 total = m_totalSize;
+    for (const SegmentSnapshot &segment : m_segments) {
+        total = qMax(total, segmentEnd(segment));
+    }
+    if (total <= 0) {
+        return;
+    }
+
+    double scale = double(width()) / total;
+    for (int lane = 0; lane < m_segments.size(); ++lane) {
+        const SegmentSnapshot &segment = m_segments.at(lane);
+        QRect laneArea = laneRect(lane);
+
+        int x = int(segment.startOffset * scale);
+        int rangeWidth = qMax(1, int((segmentEnd(segment) - segment.startOffset) * scale));
+        int doneWidth = int(segment.downloadedSize * scale);
+
+        QRect range(x, laneArea.top(), rangeWidth, laneArea.height());
+        QColor color = laneColor(segment);
+
+        painter.fillRect(range, color.lighter(170));
+        painter.fillRect(QRect(x, laneArea.top(), qMin(doneWidth, rangeWidth), laneArea.height()), color);
+
+        // Retried connections get an outline so they stand out from healthy ones
+        if (segment.retryCount > 0) {
+            painter.setPen(QPen(QColor(0xd3, 0x2f, 0x2f), 1, Qt::DashLine));
+            painter.drawRect(range.adjusted(0, 0, -1, -1));
+        }
+    }
+}
+
+bool SegmentMapWidget::event(QEvent *event)
+{
+    if (event->type() == QEvent::ToolTip) {
+        QHelpEvent *help = static_cast<QHelpEvent*>(event);
+        int lane = laneAt(help->pos());
+        if (lane >= 0) {
+            QToolTip::showText(help->globalPos(), laneTooltip(m_segments.at(lane)), this);
+        } else {
+            QToolTip::hideText();
+            event->ignore();
+        }
+        return true;
+    }
+    return QWidget::event(event);
+}
+
+int SegmentMapWidget::laneAt(const QPoint &pos) const
+{
+    for (int lane = 0; lane < m_segments.size(); ++lane) {
+        if (laneRect(lane).contains(0, pos.y())) {
+            return lane;
+        }
+    }
+    return -1;
+}
+
+QRect SegmentMapWidget::laneRect(int lane) const
+{
+    return QRect(0, LANE_SPACING + lane * (LANE_HEIGHT + LANE_SPACING), width(), LANE_HEIGHT);
+}
+
+QColor SegmentMapWidget::laneColor(const SegmentSnapshot &segment) const
+{
+    switch (segment.state) {
+    case SegmentSnapshot::Downloading:
+        // A running connection that moved no bytes since the last publish is stalled
+        return segment.speed > 0 ? QColor(0x4c, 0xaf, 0x50) : QColor(0xff, 0xa0, 0x00);
+    case SegmentSnapshot::Completed:
+        return QColor(0x19, 0x76, 0xd2);
+    case SegmentSnapshot::Failed:
+        return QColor(0xd3, 0x2f, 0x2f);
+    case SegmentSnapshot::Paused:
+    case SegmentSnapshot::Cancelled:
+        return QColor(0x9e, 0x9e, 0x9e);
+    case SegmentSnapshot::Pending:
+    default:
+        return QColor(0xbd, 0xbd, 0xbd);
+    }
+}
+
+QString SegmentMapWidget::laneTooltip(const SegmentSnapshot &segment) const
+{
+    static const char *states[] = {"Pending", "Downloading", "Paused", "Completed", "Failed", "Cancelled"};
+
+    QString text = QString("Connection %1: %2\n%3 - %4\n%5 done, %6/s")
+                       .arg(segment.index + 1)
+                       .arg(states[segment.state])
+                       .arg(formatSize(segment.startOffset))
+                       .arg(segment.endOffset >= 0 ? formatSize(segment.endOffset) : QString("end"))
+                       .arg(formatSize(segment.downloadedSize))
+                       .arg(formatSize(segment.speed));
+    if (segment.retryCount > 0) {
+        text += QString("\nRetries: %1").arg(segment.retryCount);
+    }
+    return text;
+}
+
+qint64 SegmentMapWidget::segmentEnd(const SegmentSnapshot &segment) const
+{
+    if (segment.endOffset >= 0) {
+        return segment.endOffset + 1;
+    }
+    // Open-ended last segment: extends to the file size once known
+    return m_totalSize > 0 ? m_totalSize : segment.startOffset + segment.downloadedSize;
+}
+
+QString SegmentMapWidget::formatSize(qint64 bytes) const
+{
+    if (bytes < 1024) return QString("%1 B").arg(bytes);
+    if (bytes < 1024 * 1024) return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+    if (bytes < 1024LL * 1024 * 1024) return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    return QString("%1 GB").arg(bytes / (1024.0 * 1024.0 * 1024.0), 0, 'f', 2);
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef SEGMENTMAPWIDGET_H
+#define SEGMENTMAPWIDGET_H
+
+#include <QWidget>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+#include "core/SegmentManager.h"
+
+// IDM-style connection map: one horizontal lane per segment showing its byte
+// range, how much of it is done, and whether the connection is stalled or
+// retrying. Reads SegmentManager's lock-free snapshot on its own timer, so it
+// never blocks the engine.
+class SegmentMapWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SegmentMapWidget(QWidget *parent = nullptr);
+
+    void setSource(SegmentManager *manager);
+    void setSnapshot(const QVector<SegmentSnapshot> &segments, qint64 totalSize);
+    void clear();
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    bool event(QEvent *event) override;
+
+private slots:
+    void poll();
+
+private:
+    QPointer<SegmentManager> m_source;
+    QTimer *m_pollTimer;
+    quint64 m_generation;
+    QVector<SegmentSnapshot> m_segments;
+    qint64 m_totalSize;
+
+    int laneAt(const QPoint &pos) const;
+    QRect laneRect(int lane) const;
+    QColor laneColor(const SegmentSnapshot &segment) const;
+    QString laneTooltip(const SegmentSnapshot &segment) const;
+    qint64 segmentEnd(const SegmentSnapshot &segment) const;
+    QString formatSize(qint64 bytes) const;
+
+    static const int POLL_INTERVAL = 250;   // ms, matches the engine's publish rate
+    static const int LANE_HEIGHT = 10;
+    static const int LANE_SPACING = 3;
+};
+
+#endif // SEGMENTMAPWIDGET_H
\ No newline at end of file
@@ -0,0 +1,1253 @@
+#include "SpeedChart.h"
+#include <QtMath>
+#include <limits>
+
+const QColor SpeedChart::IDM_GREEN(0x00, 0xc0, 0x00);
+const QColor SpeedChart::IDM_GRID_COLOR(0x00, 0x50, 0x00);
+const QColor SpeedChart::IDM_BACKGROUND(0x00, 0x00, 0x00);
+const QColor SpeedChart::IDM_TEXT_COLOR(0xc0, 0xc0, 0xc0);
+const QColor SpeedChart::IDM_PEAK_COLOR(0xff, 0x40, 0x40);
+const QColor SpeedChart::IDM_AVERAGE_COLOR(0xff, 0xd0, 0x00);
+
+namespace {
+
+// Rounds up to 1, 2 or 5 times a power of ten so axis labels stay readable
+qint64 niceCeil(qint64 value)
+{
+    if (value <= 0) {
+        return 1;
+    }
+
+    qint64 magnitude = 1;
+    while (magnitude * 10 <= value) {
+        magnitude *= 10;
+    }
+
+    for (qint64 factor : {1, 2, 5, 10}) {
+        if (factor * magnitude >= value) {
+            return factor * magnitude;
+        }
+    }
+    return 10 * magnitude;
+}
+
+}
+
+SpeedChart::SpeedChart(QWidget *parent)
+    : QWidget(parent)
+    , m_history(DEFAULT_MAX_DATA_POINTS)
+    , m_wallClockOffsetMs(0)
+    , m_viewEndMs(0)
+    , m_followLatest(true)
+    , m_timeRangeMinutes(DEFAULT_TIME_RANGE)
+    , m_maxSpeed(1024)
+    , m_minSpeed(0)
+    , m_autoScale(true)
+    , m_scalingMode(ScaleAutomatic)
+    , m_chartStyle(StyleIDM)
+    , m_showGrid(true)
+    , m_showLabels(true)
+    , m_showPeakIndicator(true)
+    , m_showAverageLine(true)
+    , m_animationEnabled(true)
+    , m_glowEffect(false)
+    , m_smoothCurves(false)
+    , m_updateTimer(nullptr)
+    , m_animationTimer(nullptr)
+    , m_mouseTracking(false)
+    , m_dragging(false)
+    , m_zoomLevel(0)
+    , m_geometryDirty(true)
+    , m_cachedAverageSpeed(0)
+    , m_cachedPeakSpeed(0)
+    , m_statsDirty(true)
+    , m_shadowEffect(nullptr)
+    , m_glowAnimation(nullptr)
+    , m_glowPhase(0)
+{
+    m_clock.start();
+    m_wallClockOffsetMs = QDateTime::currentMSecsSinceEpoch() - m_clock.elapsed();
+
+    setupUI();
+    setupVisualSettings();
+    setupTimers();
+    setupAnimations();
+}
+
+SpeedChart::~SpeedChart()
+{
+}
+
+// === DATA MANAGEMENT ===
+
+void SpeedChart::addSample(qint64 speedBytesPerSec)
+{
+    addSampleInternal(m_clock.elapsed(), speedBytesPerSec);
+    emit dataPointAdded(int(speedBytesPerSec), QDateTime::currentDateTime());
+}
+
+void SpeedChart::addDataPoint(int speedBytesPerSec, const QDateTime &timestamp)
+{
+    addSampleInternal(timestamp.toMSecsSinceEpoch() - m_wallClockOffsetMs, speedBytesPerSec);
+    emit dataPointAdded(speedBytesPerSec, timestamp);
+}
+
+void SpeedChart::addDataPoints(const QList<QPair<int, QDateTime>> &dataPoints)
+{
+    for (const QPair<int, QDateTime> &point : dataPoints) {
+        addSampleInternal(point.second.toMSecsSinceEpoch() - m_wallClockOffsetMs, point.first);
+    }
+}
+
+void SpeedChart::clearData()
+{
+    m_history.clear();
+    m_followLatest = true;
+    m_statsDirty = true;
+    update();
+}
+
+void SpeedChart::setMaxDataPoints(int maxPoints)
+{
+    m_history.setCapacity(qMax(1, maxPoints));
+    m_statsDirty = true;
+    update();
+}
+
+void SpeedChart::addSampleInternal(qint64 timeMs, qint64 speed)
+{
+    // The ring needs non-decreasing times; late wall-clock points join the newest one
+    if (!m_history.isEmpty()) {
+        timeMs = qMax(timeMs, m_history.lastTimeMs());
+    }
+
+    m_history.append(timeMs, qMax<qint64>(0, speed));
+    m_statsDirty = true;
+
+    if (m_followLatest) {
+        m_viewEndMs = timeMs;
+    }
+    if (m_animationEnabled) {
+        animateNewDataPoint();
+    }
+    update();
+}
+
+// === TIME RANGE AND SCALING ===
+
+void SpeedChart::setTimeRange(int minutes)
+{
+    minutes = qBound(1, minutes, 24 * 60);
+    if (minutes == m_timeRangeMinutes) {
+        return;
+    }
+
+    m_timeRangeMinutes = minutes;
+    m_zoomLevel = 0;
+    adjustTimeRange();
+    emit timeRangeChanged(minutes);
+    update();
+}
+
+void SpeedChart::setAutoScale(bool enabled)
+{
+    m_autoScale = enabled;
+    updateScaling();
+    update();
+}
+
+void SpeedChart::setMaxSpeed(int maxSpeedBytesPerSec)
+{
+    m_maxSpeed = maxSpeedBytesPerSec;
+    adjustSpeedRange();
+    update();
+}
+
+void SpeedChart::setMinSpeed(int minSpeedBytesPerSec)
+{
+    m_minSpeed = minSpeedBytesPerSec;
+    adjustSpeedRange();
+    update();
+}
+
+void SpeedChart::setScalingMode(ScalingMode mode)
+{
+    m_scalingMode = mode;
+    updateScaling();
+    update();
+}
+
+void SpeedChart::updateScaling()
+{
+    if (!m_autoScale || m_scalingMode == ScaleFixed) {
+        adjustSpeedRange();
+        return;
+    }
+
+    int previousMin = m_minSpeed;
+    int previousMax = m_maxSpeed;
+    calculateOptimalScale();
+    adjustSpeedRange();
+
+    if (m_minSpeed != previousMin || m_maxSpeed != previousMax) {
+        emit scaleChanged(m_minSpeed, m_maxSpeed);
+    }
+}
+
+void SpeedChart::calculateOptimalScale()
+{
+    // The pyramid answers the visible peak without walking the samples
+    QPair<qint64, qint64> range = getTimeRange();
+    qint64 target = niceCeil(qMax<qint64>(1024, m_history.peak(range.first, range.second) * 11 / 10));
+    target = qMin<qint64>(target, std::numeric_limits<int>::max());
+
+    m_minSpeed = 0;
+    if (m_scalingMode == ScaleAdaptive && m_maxSpeed > target) {
+        // Shrink gradually so a single quiet window doesn't make the axis jump
+        m_maxSpeed = int(qMax<qint64>(target, m_maxSpeed - (m_maxSpeed - target) / 4));
+    } else {
+        m_maxSpeed = int(target);
+    }
+}
+
+QPair<int, int> SpeedChart::getSpeedRange() const
+{
+    return qMakePair(m_minSpeed, m_maxSpeed);
+}
+
+QPair<qint64, qint64> SpeedChart::getTimeRange() const
+{
+    qint64 span = qint64(m_timeRangeMinutes) * 60000;
+    span = m_zoomLevel >= 0 ? span >> m_zoomLevel : span << -m_zoomLevel;
+    span = qMax<qint64>(span, 1000);
+
+    qint64 end = m_viewEndMs;
+    if (m_followLatest) {
+        end = qMax(m_clock.elapsed(), m_history.lastTimeMs());
+    }
+    return qMakePair(end - span, end + 1);
+}
+
+void SpeedChart::adjustTimeRange()
+{
+    if (m_followLatest || m_history.isEmpty()) {
+        return;
+    }
+
+    // Panning stops at either end of the retained history; reaching the newest resumes following
+    QPair<qint64, qint64> range = getTimeRange();
+    qint64 span = range.second - range.first - 1;
+    qint64 newest = qMax(m_clock.elapsed(), m_history.lastTimeMs());
+    m_viewEndMs = qMax(m_viewEndMs, m_history.firstTimeMs() + span);
+    if (m_viewEndMs >= newest) {
+        m_viewEndMs = newest;
+        m_followLatest = true;
+    }
+}
+
+void SpeedChart::adjustSpeedRange()
+{
+    m_minSpeed = qMax(0, m_minSpeed);
+    if (m_maxSpeed <= m_minSpeed) {
+        m_maxSpeed = m_minSpeed + 1024;
+    }
+}
+
+// === VISUAL CUSTOMIZATION ===
+
+void SpeedChart::setLineColor(const QColor &color)
+{
+    m_visual.lineColor = color;
+    updateVisualSettings();
+}
+
+void SpeedChart::setGridColor(const QColor &color)
+{
+    m_visual.gridColor = color;
+    updateVisualSettings();
+}
+
+void SpeedChart::setBackgroundColor(const QColor &color)
+{
+    m_visual.backgroundColor = color;
+    updateVisualSettings();
+}
+
+void SpeedChart::setTextColor(const QColor &color)
+{
+    m_visual.textColor = color;
+    updateVisualSettings();
+}
+
+void SpeedChart::setShowGrid(bool show)
+{
+    m_showGrid = show;
+    update();
+}
+
+void SpeedChart::setShowLabels(bool show)
+{
+    m_showLabels = show;
+    m_geometryDirty = true;
+    update();
+}
+
+void SpeedChart::setShowPeakIndicator(bool show)
+{
+    m_showPeakIndicator = show;
+    update();
+}
+
+void SpeedChart::setShowAverageLine(bool show)
+{
+    m_showAverageLine = show;
+    update();
+}
+
+void SpeedChart::setAnimationEnabled(bool enabled)
+{
+    m_animationEnabled = enabled;
+    if (!enabled) {
+        m_animationTimer->stop();
+        m_glowPhase = 0;
+    }
+    updateGlowEffect();
+}
+
+void SpeedChart::setGlowEffect(bool enabled)
+{
+    m_glowEffect = enabled;
+    updateGlowEffect();
+    update();
+}
+
+void SpeedChart::setSmoothCurves(bool enabled)
+{
+    m_smoothCurves = enabled;
+    update();
+}
+
+void SpeedChart::setChartStyle(ChartStyle style)
+{
+    m_chartStyle = style;
+    applyChartStyle();
+}
+
+// === STATISTICS ===
+
+int SpeedChart::getCurrentSpeed() const
+{
+    return int(m_history.last().bytesPerSecond);
+}
+
+int SpeedChart::getAverageSpeed() const
+{
+    updateStatistics();
+    return m_cachedAverageSpeed;
+}
+
+int SpeedChart::getPeakSpeed() const
+{
+    updateStatistics();
+    return m_cachedPeakSpeed;
+}
+
+QDateTime SpeedChart::getLastUpdateTime() const
+{
+    if (m_history.isEmpty()) {
+        return QDateTime();
+    }
+    return QDateTime::fromMSecsSinceEpoch(m_history.lastTimeMs() + m_wallClockOffsetMs);
+}
+
+int SpeedChart::getDataPointCount() const
+{
+    return m_history.size();
+}
+
+void SpeedChart::updateStatistics() const
+{
+    if (!m_statsDirty) {
+        return;
+    }
+
+    m_cachedAverageSpeed = int(m_history.average());
+    m_cachedPeakSpeed = int(m_history.peak(m_history.firstTimeMs(), m_history.lastTimeMs() + 1));
+    m_statsDirty = false;
+}
+
+SpeedHistory::Sample SpeedChart::findNearestSample(qint64 timeMs) const
+{
+    if (m_history.isEmpty()) {
+        return SpeedHistory::Sample{timeMs, 0};
+    }
+
+    int low = 0;
+    int high = m_history.size() - 1;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (m_history.at(mid).timeMs < timeMs) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low > 0 && timeMs - m_history.at(low - 1).timeMs < m_history.at(low).timeMs - timeMs) {
+        --low;
+    }
+    return m_history.at(low);
+}
+
+// === UTILITY ===
+
+void SpeedChart::saveSettings()
+{
+    QSettings settings;
+    settings.beginGroup("SpeedChart");
+    settings.setValue("timeRange", m_timeRangeMinutes);
+    settings.setValue("maxDataPoints", m_history.capacity());
+    settings.setValue("autoScale", m_autoScale);
+    settings.setValue("scalingMode", int(m_scalingMode));
+    settings.setValue("maxSpeed", m_maxSpeed);
+    settings.setValue("minSpeed", m_minSpeed);
+    settings.setValue("chartStyle", int(m_chartStyle));
+    settings.setValue("lineColor", m_visual.lineColor);
+    settings.setValue("gridColor", m_visual.gridColor);
+    settings.setValue("backgroundColor", m_visual.backgroundColor);
+    settings.setValue("textColor", m_visual.textColor);
+    settings.setValue("showGrid", m_showGrid);
+    settings.setValue("showLabels", m_showLabels);
+    settings.setValue("showPeakIndicator", m_showPeakIndicator);
+    settings.setValue("showAverageLine", m_showAverageLine);
+    settings.setValue("animationEnabled", m_animationEnabled);
+    settings.setValue("glowEffect", m_glowEffect);
+    settings.setValue("smoothCurves", m_smoothCurves);
+    settings.endGroup();
+}
+
+void SpeedChart::loadSettings()
+{
+    QSettings settings;
+    settings.beginGroup("SpeedChart");
+    setTimeRange(settings.value("timeRange", DEFAULT_TIME_RANGE).toInt());
+    setMaxDataPoints(settings.value("maxDataPoints", DEFAULT_MAX_DATA_POINTS).toInt());
+    m_autoScale = settings.value("autoScale", true).toBool();
+    m_scalingMode = ScalingMode(settings.value("scalingMode", int(ScaleAutomatic)).toInt());
+    m_maxSpeed = settings.value("maxSpeed", m_maxSpeed).toInt();
+    m_minSpeed = settings.value("minSpeed", m_minSpeed).toInt();
+    setChartStyle(ChartStyle(settings.value("chartStyle", int(StyleIDM)).toInt()));
+    m_visual.lineColor = settings.value("lineColor", m_visual.lineColor).value<QColor>();
+    m_visual.gridColor = settings.value("gridColor", m_visual.gridColor).value<QColor>();
+    m_visual.backgroundColor = settings.value("backgroundColor", m_visual.backgroundColor).value<QColor>();
+    m_visual.textColor = settings.value("textColor", m_visual.textColor).value<QColor>();
+    m_showGrid = settings.value("showGrid", true).toBool();
+    m_showLabels = settings.value("showLabels", true).toBool();
+    m_showPeakIndicator = settings.value("showPeakIndicator", true).toBool();
+    m_showAverageLine = settings.value("showAverageLine", true).toBool();
+    m_animationEnabled = settings.value("animationEnabled", true).toBool();
+    m_glowEffect = settings.value("glowEffect", false).toBool();
+    m_smoothCurves = settings.value("smoothCurves", false).toBool();
+    settings.endGroup();
+
+    adjustSpeedRange();
+    updateGlowEffect();
+    updateVisualSettings();
+}
+
+void SpeedChart::resetToDefaults()
+{
+    m_autoScale = true;
+    m_scalingMode = ScaleAutomatic;
+    m_minSpeed = 0;
+    m_maxSpeed = 1024;
+    m_showGrid = true;
+    m_showLabels = true;
+    m_showPeakIndicator = true;
+    m_showAverageLine = true;
+    m_animationEnabled = true;
+    m_glowEffect = false;
+    m_smoothCurves = false;
+    m_zoomLevel = 0;
+    m_followLatest = true;
+
+    setTimeRange(DEFAULT_TIME_RANGE);
+    setMaxDataPoints(DEFAULT_MAX_DATA_POINTS);
+    setChartStyle(StyleIDM);
+    updateGlowEffect();
+}
+
+QPixmap SpeedChart::exportChart(const QSize &size) const
+{
+    QPixmap pixmap(this->size());
+    pixmap.fill(m_visual.backgroundColor);
+    const_cast<SpeedChart *>(this)->render(&pixmap);
+
+    if (size.isValid() && size != pixmap.size()) {
+        return pixmap.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    return pixmap;
+}
+
+// === EVENTS ===
+
+void SpeedChart::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing, m_visual.antiAliasing);
+    paintChart(painter);
+}
+
+void SpeedChart::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    m_geometryDirty = true;
+}
+
+void SpeedChart::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        m_dragging = false;
+        m_dragStart = event->pos();
+        handleChartClick(event->pos());
+    }
+    QWidget::mousePressEvent(event);
+}
+
+void SpeedChart::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons() & Qt::LeftButton) {
+        m_dragging = true;
+        handleChartDrag(event->pos());
+    } else {
+        updateMouseTracking(event->pos());
+    }
+    QWidget::mouseMoveEvent(event);
+}
+
+void SpeedChart::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        m_dragging = false;
+    }
+    QWidget::mouseReleaseEvent(event);
+}
+
+void SpeedChart::wheelEvent(QWheelEvent *event)
+{
+    handleZoom(event->angleDelta().y());
+    event->accept();
+}
+
+void SpeedChart::leaveEvent(QEvent *event)
+{
+    m_mouseTracking = false;
+    QToolTip::hideText();
+    update();
+    QWidget::leaveEvent(event);
+}
+
+// === SLOTS ===
+
+void SpeedChart::onUpdateTimer()
+{
+    int previousPeak = m_cachedPeakSpeed;
+    int previousAverage = m_cachedAverageSpeed;
+    updateStatistics();
+
+    if (m_cachedPeakSpeed != previousPeak) {
+        emit peakSpeedChanged(m_cachedPeakSpeed);
+    }
+    if (m_cachedAverageSpeed != previousAverage) {
+        emit averageSpeedChanged(m_cachedAverageSpeed);
+    }
+
+    // Following the clock scrolls the window even when no sample arrived
+    if (m_followLatest) {
+        update();
+    }
+}
+
+void SpeedChart::onAnimationTimer()
+{
+    m_glowPhase += 10;
+    if (m_glowPhase >= 360) {
+        m_glowPhase = 0;
+        m_animationTimer->stop();
+    }
+    update();
+}
+
+// === SETUP ===
+
+void SpeedChart::setupUI()
+{
+    setMinimumSize(MIN_CHART_WIDTH, MIN_CHART_HEIGHT);
+    setMouseTracking(true);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setupGeometry();
+}
+
+void SpeedChart::setupTimers()
+{
+    m_updateTimer = new QTimer(this);
+    m_updateTimer->setInterval(DEFAULT_UPDATE_INTERVAL);
+    connect(m_updateTimer, &QTimer::timeout, this, &SpeedChart::onUpdateTimer);
+    m_updateTimer->start();
+
+    m_animationTimer = new QTimer(this);
+    m_animationTimer->setInterval(DEFAULT_ANIMATION_INTERVAL);
+    connect(m_animationTimer, &QTimer::timeout, this, &SpeedChart::onAnimationTimer);
+}
+
+void SpeedChart::setupVisualSettings()
+{
+    m_visual.labelFont = font();
+    m_visual.labelFont.setPointSize(qMax(7, font().pointSize() - 1));
+    m_visual.valueFont = font();
+    m_visual.valueFont.setBold(true);
+    m_visual.lineWidth = DEFAULT_LINE_WIDTH;
+    applyIDMStyle();
+}
+
+void SpeedChart::setupAnimations()
+{
+    createShadowEffect();
+    m_glowAnimation = new QPropertyAnimation(m_shadowEffect, "blurRadius", this);
+    m_glowAnimation->setStartValue(4.0);
+    m_glowAnimation->setKeyValueAt(0.5, 14.0);
+    m_glowAnimation->setEndValue(4.0);
+    m_glowAnimation->setDuration(2000);
+    m_glowAnimation->setEasingCurve(QEasingCurve::InOutSine);
+    m_glowAnimation->setLoopCount(-1);
+    updateGlowEffect();
+}
+
+void SpeedChart::applyIDMStyle()
+{
+    m_visual.lineColor = IDM_GREEN;
+    m_visual.gridColor = IDM_GRID_COLOR;
+    m_visual.backgroundColor = IDM_BACKGROUND;
+    m_visual.textColor = IDM_TEXT_COLOR;
+    m_visual.peakColor = IDM_PEAK_COLOR;
+    m_visual.averageColor = IDM_AVERAGE_COLOR;
+    updateVisualSettings();
+}
+
+void SpeedChart::setupGeometry()
+{
+    int left = m_showLabels ? SPEED_LABEL_WIDTH : m_geometry.marginRight;
+    int bottom = m_showLabels ? TIME_LABEL_HEIGHT + m_geometry.marginBottom / 3 : m_geometry.marginRight;
+    m_geometry.marginLeft = left;
+
+    m_geometry.chartRect = rect().adjusted(left, m_geometry.marginTop, -m_geometry.marginRight, -bottom);
+    m_geometry.gridRect = m_geometry.chartRect;
+    m_geometry.labelRect = QRect(0, m_geometry.chartRect.bottom(), width(), bottom);
+    m_geometryDirty = false;
+}
+
+// === PAINTING ===
+
+void SpeedChart::paintChart(QPainter &painter)
+{
+    if (m_geometryDirty) {
+        setupGeometry();
+    }
+
+    const QRect &chart = m_geometry.chartRect;
+    paintBackground(painter, rect());
+    if (chart.width() <= 0 || chart.height() <= 0) {
+        return;
+    }
+
+    // One decimation pass per frame; everything below reads the same columns
+    QPair<qint64, qint64> range = getTimeRange();
+    m_columns = m_history.decimate(range.first, range.second, chart.width());
+    updateScaling();
+
+    if (m_showGrid) {
+        paintGrid(painter, m_geometry.gridRect);
+    }
+    if (m_chartStyle != StyleMinimal) {
+        paintFillArea(painter, chart);
+    }
+    if (m_glowEffect) {
+        paintGlowEffect(painter, chart);
+    }
+    paintSpeedLine(painter, chart);
+    if (m_showAverageLine) {
+        paintAverageLine(painter, chart);
+    }
+    if (m_showPeakIndicator) {
+        paintPeakIndicator(painter, chart);
+    }
+    if (m_showLabels) {
+        paintLabels(painter, chart);
+    }
+    if (m_mouseTracking) {
+        paintTooltip(painter);
+    }
+}
+
+void SpeedChart::paintBackground(QPainter &painter, const QRect &rect)
+{
+    if (m_chartStyle == StyleModern) {
+        QLinearGradient gradient(rect.topLeft(), rect.bottomLeft());
+        gradient.setColorAt(0, m_visual.backgroundColor.lighter(130));
+        gradient.setColorAt(1, m_visual.backgroundColor);
+        painter.fillRect(rect, gradient);
+    } else {
+        painter.fillRect(rect, m_visual.backgroundColor);
+    }
+}
+
+void SpeedChart::paintGrid(QPainter &painter, const QRect &rect)
+{
+    drawGridLines(painter, rect);
+}
+
+void SpeedChart::paintSpeedLine(QPainter &painter, const QRect &rect)
+{
+    QPolygonF line = decimatedLine(rect);
+    if (line.size() < 2) {
+        return;
+    }
+
+    if (m_smoothCurves) {
+        line = createSmoothCurve(line);
+    }
+
+    painter.save();
+    painter.setClipRect(rect);
+    painter.setPen(QPen(m_visual.lineColor, m_visual.lineWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+    painter.drawPolyline(line);
+    painter.restore();
+}
+
+void SpeedChart::paintFillArea(QPainter &painter, const QRect &rect)
+{
+    QPolygonF line = decimatedLine(rect);
+    if (line.size() < 2) {
+        return;
+    }
+
+    QPolygonF area = line;
+    area.append(QPointF(line.last().x(), rect.bottom()));
+    area.append(QPointF(line.first().x(), rect.bottom()));
+
+    QLinearGradient gradient(rect.topLeft(), rect.bottomLeft());
+    gradient.setColorAt(0, m_visual.fillColor);
+    gradient.setColorAt(1, QColor(m_visual.fillColor.red(), m_visual.fillColor.green(), m_visual.fillColor.blue(), 0));
+
+    painter.save();
+    painter.setClipRect(rect);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(gradient);
+    painter.drawPolygon(area);
+    painter.restore();
+}
+
+void SpeedChart::paintLabels(QPainter &painter, const QRect &rect)
+{
+    drawSpeedLabels(painter, rect);
+    drawTimeLabels(painter, rect);
+}
+
+void SpeedChart::paintPeakIndicator(QPainter &painter, const QRect &rect)
+{
+    int peakColumn = -1;
+    for (int column = 0; column < m_columns.size(); ++column) {
+        if (m_columns.at(column).valid
+            && (peakColumn < 0 || m_columns.at(column).maxSpeed > m_columns.at(peakColumn).maxSpeed)) {
+            peakColumn = column;
+        }
+    }
+    if (peakColumn < 0 || m_columns.at(peakColumn).maxSpeed <= 0) {
+        return;
+    }
+
+    qint64 peak = m_columns.at(peakColumn).maxSpeed;
+    QPair<int, int> speedRange = getSpeedRange();
+    qreal y = rect.bottom() - qreal(peak - speedRange.first) / (speedRange.second - speedRange.first) * rect.height();
+    QPointF marker(rect.left() + peakColumn + 0.5, qMax<qreal>(rect.top(), y));
+
+    painter.save();
+    painter.setPen(QPen(m_visual.peakColor, 1));
+    painter.setBrush(m_visual.peakColor);
+    painter.drawEllipse(marker, PEAK_INDICATOR_SIZE / 2.0, PEAK_INDICATOR_SIZE / 2.0);
+    painter.setFont(m_visual.labelFont);
+    painter.drawText(QPointF(marker.x() + PEAK_INDICATOR_SIZE, marker.y() + PEAK_INDICATOR_SIZE / 2.0),
+                     formatSpeedShort(int(peak)));
+    painter.restore();
+}
+
+void SpeedChart::paintAverageLine(QPainter &painter, const QRect &rect)
+{
+    int average = getAverageSpeed();
+    QPair<int, int> speedRange = getSpeedRange();
+    if (average <= speedRange.first || average > speedRange.second) {
+        return;
+    }
+
+    qreal y = mapSampleToPoint(average, 0, rect).y();
+    painter.save();
+    painter.setPen(QPen(m_visual.averageColor, 1, Qt::DashLine));
+    painter.drawLine(QPointF(rect.left(), y), QPointF(rect.right(), y));
+    painter.restore();
+}
+
+void SpeedChart::paintTooltip(QPainter &painter)
+{
+    const QRect &chart = m_geometry.chartRect;
+    if (!chart.contains(m_mousePos) || m_history.isEmpty()) {
+        return;
+    }
+
+    QPair<qint64, qint64> hovered = mapPointToSample(m_mousePos, chart);
+    SpeedHistory::Sample sample = findNearestSample(hovered.second);
+    QPointF point = mapSampleToPoint(sample.bytesPerSecond, sample.timeMs, chart);
+
+    painter.save();
+    painter.setPen(QPen(m_visual.textColor, 1, Qt::DotLine));
+    painter.drawLine(QPointF(point.x(), chart.top()), QPointF(point.x(), chart.bottom()));
+    painter.setPen(QPen(m_visual.lineColor, 2));
+    painter.setBrush(m_visual.backgroundColor);
+    painter.drawEllipse(point, 3.0, 3.0);
+    painter.restore();
+}
+
+void SpeedChart::paintGlowEffect(QPainter &painter, const QRect &rect)
+{
+    QPolygonF line = decimatedLine(rect);
+    if (line.size() < 2) {
+        return;
+    }
+
+    QColor glow = m_visual.lineColor;
+    glow.setAlpha(70);
+
+    painter.save();
+    painter.setClipRect(rect);
+    painter.setPen(QPen(glow, GLOW_LINE_WIDTH, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+    painter.drawPolyline(line);
+
+    // Pulse on the newest point while the new-sample animation runs
+    if (m_animationTimer->isActive()) {
+        qreal pulse = qSin(qDegreesToRadians(qreal(m_glowPhase)) / 2);
+        glow.setAlpha(int(160 * (1 - pulse)));
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(glow);
+        painter.drawEllipse(line.last(), GLOW_LINE_WIDTH + 4 * pulse, GLOW_LINE_WIDTH + 4 * pulse);
+    }
+    painter.restore();
+}
+
+// === COORDINATE CONVERSION ===
+
+QPointF SpeedChart::mapSampleToPoint(qint64 speed, qint64 timeMs, const QRect &rect) const
+{
+    QPair<qint64, qint64> timeRange = getTimeRange();
+    QPair<int, int> speedRange = getSpeedRange();
+
+    qreal x = rect.left() + qreal(timeMs - timeRange.first) / (timeRange.second - timeRange.first) * rect.width();
+    qreal y = rect.bottom() - qreal(speed - speedRange.first) / (speedRange.second - speedRange.first) * rect.height();
+    return QPointF(x, y);
+}
+
+QPair<qint64, qint64> SpeedChart::mapPointToSample(const QPoint &point, const QRect &rect) const
+{
+    QPair<qint64, qint64> timeRange = getTimeRange();
+    QPair<int, int> speedRange = getSpeedRange();
+
+    qint64 timeMs = timeRange.first + (timeRange.second - timeRange.first) * (point.x() - rect.left()) / qMax(1, rect.width());
+    qint64 speed = speedRange.first + qint64(speedRange.second - speedRange.first) * (rect.bottom() - point.y()) / qMax(1, rect.height());
+    return qMakePair(speed, timeMs);
+}
+
+QPolygonF SpeedChart::decimatedLine(const QRect &rect) const
+{
+    QPair<int, int> speedRange = getSpeedRange();
+    qreal scale = qreal(rect.height()) / (speedRange.second - speedRange.first);
+    auto yFor = [&](qint64 speed) {
+        return rect.bottom() - (speed - speedRange.first) * scale;
+    };
+
+    QPolygonF line;
+    line.reserve(2 * m_columns.size());
+    for (int column = 0; column < m_columns.size(); ++column) {
+        const SpeedHistory::Column &c = m_columns.at(column);
+        if (!c.valid) {
+            continue;
+        }
+
+        // Draw the extreme further from the column's last sample first, so the
+        // line leaves the column at its last value and spikes keep their height
+        qreal x = rect.left() + column + 0.5;
+        if (c.minSpeed == c.maxSpeed) {
+            line.append(QPointF(x, yFor(c.lastSpeed)));
+        } else if (c.lastSpeed - c.minSpeed < c.maxSpeed - c.lastSpeed) {
+            line.append(QPointF(x, yFor(c.maxSpeed)));
+            line.append(QPointF(x, yFor(c.minSpeed)));
+        } else {
+            line.append(QPointF(x, yFor(c.minSpeed)));
+            line.append(QPointF(x, yFor(c.maxSpeed)));
+        }
+    }
+    return line;
+}
+
+QPolygonF SpeedChart::createSmoothCurve(const QPolygonF &points) const
+{
+    if (points.size() < 3) {
+        return points;
+    }
+
+    // Cardinal spline with a few subdivisions per segment; still O(pixels)
+    const int steps = 4;
+    QPolygonF curve;
+    curve.reserve(points.size() * steps);
+    for (int i = 0; i < points.size() - 1; ++i) {
+        QPointF p0 = points.at(qMax(0, i - 1));
+        QPointF p1 = points.at(i);
+        QPointF p2 = points.at(i + 1);
+        QPointF p3 = points.at(qMin(int(points.size()) - 1, i + 2));
+        QPointF m1 = (p2 - p0) * SMOOTH_CURVE_TENSION;
+        QPointF m2 = (p3 - p1) * SMOOTH_CURVE_TENSION;
+
+        for (int step = 0; step < steps; ++step) {
+            qreal t = qreal(step) / steps;
+            qreal t2 = t * t;
+            qreal t3 = t2 * t;
+            curve.append(p1 * (2 * t3 - 3 * t2 + 1) + m1 * (t3 - 2 * t2 + t)
+                         + p2 * (-2 * t3 + 3 * t2) + m2 * (t3 - t2));
+        }
+    }
+    curve.append(points.last());
+    return curve;
+}
+
+// === GRID AND LABELS ===
+
+void SpeedChart::drawTimeLabels(QPainter &painter, const QRect &rect)
+{
+    painter.save();
+    painter.setFont(m_visual.labelFont);
+    painter.setPen(m_visual.textColor);
+
+    QFontMetrics metrics(m_visual.labelFont);
+    int lastRight = rect.left() - LABEL_SPACING;
+    for (qint64 timeMs : getTimeGridPoints(rect)) {
+        QString label = formatTimeLabel(timeMs);
+        int x = int(mapSampleToPoint(0, timeMs, rect).x());
+        int labelWidth = metrics.horizontalAdvance(label);
+        int left = x - labelWidth / 2;
+        if (left < lastRight + LABEL_SPACING / 2) {
+            continue;
+        }
+        painter.drawText(QRect(left, rect.bottom() + 2, labelWidth, TIME_LABEL_HEIGHT), Qt::AlignCenter, label);
+        lastRight = left + labelWidth;
+    }
+    painter.restore();
+}
+
+void SpeedChart::drawSpeedLabels(QPainter &painter, const QRect &rect)
+{
+    painter.save();
+    painter.setFont(m_visual.labelFont);
+    painter.setPen(m_visual.textColor);
+
+    QFontMetrics metrics(m_visual.labelFont);
+    for (int speed : getSpeedGridPoints(rect)) {
+        int y = int(mapSampleToPoint(speed, 0, rect).y());
+        QRect labelRect(0, y - metrics.height() / 2, rect.left() - 4, metrics.height());
+        painter.drawText(labelRect, Qt::AlignRight | Qt::AlignVCenter, formatSpeedLabel(speed));
+    }
+    painter.restore();
+}
+
+void SpeedChart::drawGridLines(QPainter &painter, const QRect &rect)
+{
+    painter.save();
+    painter.setPen(QPen(m_visual.gridColor, m_visual.gridLineWidth));
+
+    for (qint64 timeMs : getTimeGridPoints(rect)) {
+        qreal x = mapSampleToPoint(0, timeMs, rect).x();
+        painter.drawLine(QPointF(x, rect.top()), QPointF(x, rect.bottom()));
+    }
+    for (int speed : getSpeedGridPoints(rect)) {
+        qreal y = mapSampleToPoint(speed, 0, rect).y();
+        painter.drawLine(QPointF(rect.left(), y), QPointF(rect.right(), y));
+    }
+
+    painter.drawRect(rect);
+    painter.restore();
+}
+
+QList<qint64> SpeedChart::getTimeGridPoints(const QRect &rect) const
+{
+    static const qint64 steps[] = {
+        1000, 5000, 10000, 30000, 60000, 2 * 60000, 5 * 60000, 10 * 60000, 15 * 60000,
+        30 * 60000, 3600000, 2 * 3600000, 3 * 3600000, 6 * 3600000, 12 * 3600000
+    };
+
+    QPair<qint64, qint64> range = getTimeRange();
+    qint64 span = range.second - range.first;
+    qint64 minStep = span * GRID_SPACING / qMax(1, rect.width());
+
+    qint64 step = steps[sizeof(steps) / sizeof(steps[0]) - 1];
+    for (qint64 candidate : steps) {
+        if (candidate >= minStep) {
+            step = candidate;
+            break;
+        }
+    }
+
+    // Align to wall-clock boundaries so labels read 12:05, 12:10 rather than arbitrary offsets
+    QList<qint64> points;
+    qint64 wallStart = range.first + m_wallClockOffsetMs;
+    qint64 first = (wallStart + step - 1) / step * step - m_wallClockOffsetMs;
+    for (qint64 timeMs = first; timeMs < range.second; timeMs += step) {
+        points.append(timeMs);
+    }
+    return points;
+}
+
+QList<int> SpeedChart::getSpeedGridPoints(const QRect &rect) const
+{
+    QPair<int, int> range = getSpeedRange();
+    int lines = qMax(1, rect.height() / GRID_SPACING);
+    qint64 step = niceCeil(qMax<qint64>(1, qint64(range.second - range.first) / lines));
+
+    QList<int> points;
+    for (qint64 speed = (range.first + step - 1) / step * step; speed <= range.second; speed += step) {
+        if (speed > range.first) {
+            points.append(int(speed));
+        }
+    }
+    return points;
+}
+
+QString SpeedChart::formatTimeLabel(qint64 timeMs) const
+{
+    QPair<qint64, qint64> range = getTimeRange();
+    QDateTime time = QDateTime::fromMSecsSinceEpoch(timeMs + m_wallClockOffsetMs);
+    return time.toString(range.second - range.first > 3600000 ? "HH:mm" : "HH:mm:ss");
+}
+
+QString SpeedChart::formatSpeedLabel(int speed) const
+{
+    return formatSpeedShort(speed);
+}
+
+// === VISUAL EFFECTS ===
+
+void SpeedChart::updateGlowEffect()
+{
+    bool active = m_glowEffect && m_animationEnabled;
+    if (m_shadowEffect) {
+        m_shadowEffect->setEnabled(m_glowEffect);
+    }
+    if (!m_glowAnimation) {
+        return;
+    }
+
+    if (active && m_glowAnimation->state() != QAbstractAnimation::Running) {
+        m_glowAnimation->start();
+    } else if (!active) {
+        m_glowAnimation->stop();
+    }
+}
+
+void SpeedChart::animateNewDataPoint()
+{
+    if (!m_glowEffect) {
+        return;
+    }
+    m_glowPhase = 0;
+    m_animationTimer->start();
+}
+
+void SpeedChart::createShadowEffect()
+{
+    m_shadowEffect = new QGraphicsDropShadowEffect(this);
+    m_shadowEffect->setOffset(0, 0);
+    m_shadowEffect->setBlurRadius(4);
+    m_shadowEffect->setColor(m_visual.lineColor);
+    m_shadowEffect->setEnabled(m_glowEffect);
+    setGraphicsEffect(m_shadowEffect);
+}
+
+void SpeedChart::updateVisualSettings()
+{
+    m_visual.fillColor = m_visual.lineColor;
+    m_visual.fillColor.setAlpha(m_chartStyle == StyleModern ? 110 : 60);
+    if (m_shadowEffect) {
+        m_shadowEffect->setColor(m_visual.lineColor);
+    }
+    update();
+}
+
+void SpeedChart::applyChartStyle()
+{
+    switch (m_chartStyle) {
+    case StyleIDM:
+        applyIDMStyle();
+        m_visual.lineWidth = DEFAULT_LINE_WIDTH;
+        break;
+    case StyleModern:
+        m_visual.lineColor = QColor(0x29, 0x9b, 0xf0);
+        m_visual.gridColor = QColor(0x3a, 0x3f, 0x4b);
+        m_visual.backgroundColor = QColor(0x22, 0x26, 0x30);
+        m_visual.textColor = QColor(0xd0, 0xd4, 0xdc);
+        m_visual.lineWidth = DEFAULT_LINE_WIDTH;
+        break;
+    case StyleMinimal:
+        m_visual.lineColor = palette().color(QPalette::Highlight);
+        m_visual.gridColor = palette().color(QPalette::Midlight);
+        m_visual.backgroundColor = palette().color(QPalette::Base);
+        m_visual.textColor = palette().color(QPalette::Text);
+        m_visual.lineWidth = 1;
+        break;
+    case StyleClassic:
+        m_visual.lineColor = QColor(0x00, 0x00, 0xc0);
+        m_visual.gridColor = QColor(0xc0, 0xc0, 0xc0);
+        m_visual.backgroundColor = Qt::white;
+        m_visual.textColor = Qt::black;
+        m_visual.lineWidth = 1;
+        break;
+    }
+    m_visual.peakColor = interpolateColor(m_visual.lineColor, IDM_PEAK_COLOR, 0.8);
+    m_visual.averageColor = interpolateColor(m_visual.lineColor, IDM_AVERAGE_COLOR, 0.8);
+    updateVisualSettings();
+}
+
+// === INTERACTION ===
+
+void SpeedChart::updateMouseTracking(const QPoint &pos)
+{
+    m_mousePos = pos;
+    m_mouseTracking = m_geometry.chartRect.contains(pos);
+    if (m_mouseTracking) {
+        showSpeedTooltip(pos);
+    } else {
+        QToolTip::hideText();
+    }
+    update();
+}
+
+void SpeedChart::showSpeedTooltip(const QPoint &pos)
+{
+    if (m_history.isEmpty()) {
+        return;
+    }
+
+    QPair<qint64, qint64> hovered = mapPointToSample(pos, m_geometry.chartRect);
+    SpeedHistory::Sample sample = findNearestSample(hovered.second);
+    QString text = QString("%1\n%2")
+        .arg(formatSpeed(int(sample.bytesPerSecond)))
+        .arg(formatTimeShort(sample.timeMs));
+    QToolTip::showText(mapToGlobal(pos + QPoint(TOOLTIP_MARGIN, TOOLTIP_MARGIN)), text, this);
+}
+
+void SpeedChart::handleChartClick(const QPoint &pos)
+{
+    emit chartClicked(pos);
+}
+
+void SpeedChart::handleChartDrag(const QPoint &pos)
+{
+    const QRect &chart = m_geometry.chartRect;
+    QPair<qint64, qint64> range = getTimeRange();
+    qint64 shiftMs = (range.second - range.first) * (pos.x() - m_dragStart.x()) / qMax(1, chart.width());
+    m_dragStart = pos;
+    if (shiftMs == 0) {
+        return;
+    }
+
+    // Dragging right reveals older history
+    m_viewEndMs = range.second - 1 - shiftMs;
+    m_followLatest = false;
+    adjustTimeRange();
+    update();
+}
+
+void SpeedChart::handleZoom(int delta)
+{
+    int steps = delta / 120;
+    if (steps == 0) {
+        return;
+    }
+
+    int minZoom = MIN_ZOOM_LEVEL;
+    int maxZoom = MAX_ZOOM_LEVEL;
+    int zoom = qBound(minZoom, m_zoomLevel + steps, maxZoom);
+    if (zoom == m_zoomLevel) {
+        return;
+    }
+
+    if (!m_followLatest) {
+        m_viewEndMs = getTimeRange().second - 1;
+    }
+    m_zoomLevel = zoom;
+    adjustTimeRange();
+    update();
+}
+
+// === UTILITY METHODS ===
+
+QString SpeedChart::formatSpeed(int bytesPerSecond) const
+{
+    if (bytesPerSecond <= 0) return "0 B/s";
+
+    const char* units[] = {"B/s", "KB/s", "MB/s", "GB/s"};
+    int unitIndex = 0;
+    double speed = bytesPerSecond;
+
+    while (speed >= 1024 && unitIndex < 3) {
+        speed /= 1024;
+        unitIndex++;
+    }
+
+    return QString("%1 %2").arg(speed, 0, 'f', unitIndex > 0 ? 1 : 0).arg(units[unitIndex]);
+}
+
+QString SpeedChart::formatSpeedShort(int bytesPerSecond) const
+{
+    const char* units[] = {"B", "K", "M", "G"};
+    int unitIndex = 0;
+    double speed = qMax(0, bytesPerSecond);
+
+    while (speed >= 1024 && unitIndex < 3) {
+        speed /= 1024;
+        unitIndex++;
+    }
+
+    return QString("%1%2").arg(speed, 0, 'f', speed < 10 && unitIndex > 0 ? 1 : 0).arg(units[unitIndex]);
+}
+
+QString SpeedChart::formatTimeShort(qint64 timeMs) const
+{
+    return QDateTime::fromMSecsSinceEpoch(timeMs + m_wallClockOffsetMs).toString("HH:mm:ss");
+}
+
+QString SpeedChart::formatDuration(int seconds) const
+{
+    if (seconds < 60) {
+        return QString("%1s").arg(seconds);
+    }
+    if (seconds < 3600) {
+        return QString("%1m %2s").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+    }
+    return QString("%1h %2m").arg(seconds / 3600).arg((seconds % 3600) / 60, 2, 10, QChar('0'));
+}
+
+QColor SpeedChart::interpolateColor(const QColor &start, const QColor &end, qreal factor) const
+{
+    factor = qBound<qreal>(0, factor, 1);
+    return QColor(int(start.red() + (end.red() - start.red()) * factor),
+                  int(start.green() + (end.green() - start.green()) * factor),
+                  int(start.blue() + (end.blue() - start.blue()) * factor),
+                  int(start.alpha() + (end.alpha() - start.alpha()) * factor));
+}
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <QMouseEvent>
 #include <QWheelEvent>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QDateTime>
 #include <QList>
 #include <QVector>
@@ -33,6 +34,8 @@
 #include <QPalette>
 #include <QStyleOption>
 
+#include "utils/SpeedHistory.h"
+
 /**
  * Real-time speed chart widget that reproduces IDM's speed graph exactly
  * Features:
@@ -44,7 +47,8 @@
  * - Time axis showing last N minutes of data
  * - Peak speed indicator and average speed line
  * - Visual effects: glow, shadows, anti-aliasing
- * - Zooming and panning capabilities
+ * - Zooming and panning capabilities over up to 24 hours of history; samples
+ *   live in a SpeedHistory ring, so painting costs O(pixels) at any zoom level
  * - Export functionality for charts
  */
 class SpeedChart : public QWidget
@@ -63,12 +67,13 @@ public:
     // === PUBLIC INTERFACE ===
     
     // Data management
+    void addSample(qint64 speedBytesPerSec);    // stamped with the chart's monotonic clock
     void addDataPoint(int speedBytesPerSec, const QDateTime &timestamp = QDateTime::currentDateTime());
     void addDataPoints(const QList<QPair<int, QDateTime>> &dataPoints);
     void clearData();
-    void removeOldData(int maxAgeMinutes = 10);
-    void setMaxDataPoints(int maxPoints);
-    int maxDataPoints() const { return m_maxDataPoints; }
+    void setMaxDataPoints(int maxPoints);       // ring capacity; the oldest samples are overwritten
+    int maxDataPoints() const { return m_history.capacity(); }
+    const SpeedHistory &history() const { return m_history; }
     
     // Time range and scaling
     void setTimeRange(int minutes);
@@ -162,20 +167,10 @@ signals:
 private slots:
     void onUpdateTimer();
     void onAnimationTimer();
-    void onDataCleanupTimer();
 
 private:
     // === DATA STRUCTURES ===
     
-    struct DataPoint {
-        QDateTime timestamp;
-        int speed;              // bytes per second
-        bool isValid;
-        
-        DataPoint() : speed(0), isValid(false) {}
-        DataPoint(int s, const QDateTime &t) : timestamp(t), speed(s), isValid(true) {}
-    };
-
     struct ChartGeometry {
         QRect chartRect;        // Chart drawing area
         QRect gridRect;         // Grid area
@@ -207,10 +202,12 @@ private:
 
     // === MEMBER VARIABLES ===
     
-    // Data storage
-    QList<DataPoint> m_dataPoints;
-    int m_maxDataPoints;
-    QDateTime m_lastCleanup;
+    // Data storage: bounded ring on a monotonic clock, never trimmed by timers
+    SpeedHistory m_history;
+    QElapsedTimer m_clock;
+    qint64 m_wallClockOffsetMs;     // QDateTime msecs minus m_clock ms, for addDataPoint()
+    qint64 m_viewEndMs;             // right edge of the window; follows the newest sample unless panned
+    bool m_followLatest;
     
     // Time and scaling
     int m_timeRangeMinutes;
@@ -233,7 +230,6 @@ private:
     bool m_smoothCurves;
     QTimer *m_updateTimer;
     QTimer *m_animationTimer;
-    QTimer *m_dataCleanupTimer;
     
     // Interaction state
     QPoint m_mousePos;
@@ -250,6 +246,7 @@ private:
     mutable int m_cachedAverageSpeed;
     mutable int m_cachedPeakSpeed;
     mutable bool m_statsDirty;
+    QVector<SpeedHistory::Column> m_columns;   // one per pixel of the chart rect, rebuilt each paint
     
     // Visual effects
     QGraphicsDropShadowEffect *m_shadowEffect;
@@ -277,16 +274,17 @@ private:
     void paintGlowEffect(QPainter &painter, const QRect &rect);
     
     // === COORDINATE CONVERSION ===
-    QPoint mapSpeedToPoint(int speed, const QDateTime &timestamp, const QRect &rect) const;
-    QPair<int, QDateTime> mapPointToSpeed(const QPoint &point, const QRect &rect) const;
-    QList<QPointF> getSpeedLinePoints(const QRect &rect) const;
-    QPolygonF createSmoothCurve(const QList<QPointF> &points) const;
+    QPointF mapSampleToPoint(qint64 speed, qint64 timeMs, const QRect &rect) const;
+    QPair<qint64, qint64> mapPointToSample(const QPoint &point, const QRect &rect) const;   // (speed, timeMs)
+    // Min/max envelope with at most two vertices per pixel column of rect
+    QPolygonF decimatedLine(const QRect &rect) const;
+    QPolygonF createSmoothCurve(const QPolygonF &points) const;
     
     // === SCALING AND RANGE ===
     void updateScaling();
     void calculateOptimalScale();
     QPair<int, int> getSpeedRange() const;
-    QPair<QDateTime, QDateTime> getTimeRange() const;
+    QPair<qint64, qint64> getTimeRange() const;    // visible [fromMs, toMs) on m_clock
     void adjustTimeRange();
     void adjustSpeedRange();
     
@@ -294,18 +292,15 @@ private:
     void drawTimeLabels(QPainter &painter, const QRect &rect);
     void drawSpeedLabels(QPainter &painter, const QRect &rect);
     void drawGridLines(QPainter &painter, const QRect &rect);
-    QList<QDateTime> getTimeGridPoints(const QRect &rect) const;
+    QList<qint64> getTimeGridPoints(const QRect &rect) const;
     QList<int> getSpeedGridPoints(const QRect &rect) const;
-    QString formatTimeLabel(const QDateTime &time) const;
+    QString formatTimeLabel(qint64 timeMs) const;
     QString formatSpeedLabel(int speed) const;
     
     // === DATA UTILITIES ===
-    void addDataPointInternal(const DataPoint &point);
-    void removeOldDataPoints();
+    void addSampleInternal(qint64 timeMs, qint64 speed);
     void updateStatistics() const;
-    DataPoint* findDataPointAt(const QDateTime &time);
-    const DataPoint* findNearestDataPoint(const QDateTime &time) const;
-    QList<DataPoint> getDataInTimeRange(const QDateTime &start, const QDateTime &end) const;
+    SpeedHistory::Sample findNearestSample(qint64 timeMs) const;
     
     // === VISUAL EFFECTS ===
     void updateGlowEffect();
@@ -324,16 +319,15 @@ private:
     // === UTILITY METHODS ===
     QString formatSpeed(int bytesPerSecond) const;
     QString formatSpeedShort(int bytesPerSecond) const;
-    QString formatTimeShort(const QDateTime &time) const;
+    QString formatTimeShort(qint64 timeMs) const;
     QString formatDuration(int seconds) const;
     QColor interpolateColor(const QColor &start, const QColor &end, qreal factor) const;
     
     // === CONSTANTS ===
-    static const int DEFAULT_MAX_DATA_POINTS = 600;    // 10 minutes at 1 second intervals
+    static const int DEFAULT_MAX_DATA_POINTS = SpeedHistory::DEFAULT_CAPACITY;
     static const int DEFAULT_TIME_RANGE = 10;          // 10 minutes
     static const int DEFAULT_UPDATE_INTERVAL = 1000;   // 1 second
     static const int DEFAULT_ANIMATION_INTERVAL = 16;  // ~60 FPS
-    static const int CLEANUP_INTERVAL = 60000;         // 1 minute
     static const int MIN_CHART_WIDTH = 200;
     static const int MIN_CHART_HEIGHT = 100;
     static const int DEFAULT_LINE_WIDTH = 2;
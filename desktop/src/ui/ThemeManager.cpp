@@ -1,6 +1,74 @@
 #include "ThemeManager.h"
 #include <QApplication>
 #include <QStyleFactory>
+#include <QStyle>
+#include <QWidget>
+#include <QFile>
+#include <QDebug>
+
+struct PaletteEntry {
+    QPalette::ColorRole role;
+    QRgb active;
+    QRgb disabled;
+};
+
+// Palettes are fixed tables so building one costs nothing at switch time
+static const PaletteEntry LIGHT_PALETTE[] = {
+    {QPalette::Window,          0xfff5f5f5, 0xfff5f5f5},
+    {QPalette::WindowText,      0xff212121, 0xff9e9e9e},
+    {QPalette::Base,            0xffffffff, 0xfff5f5f5},
+    {QPalette::AlternateBase,   0xfffafafa, 0xfff5f5f5},
+    {QPalette::Text,            0xff212121, 0xff9e9e9e},
+    {QPalette::Button,          0xffeeeeee, 0xffeeeeee},
+    {QPalette::ButtonText,      0xff212121, 0xff9e9e9e},
+    {QPalette::Highlight,       0xff2196f3, 0xffbdbdbd},
+    {QPalette::HighlightedText, 0xffffffff, 0xffffffff},
+    {QPalette::Mid,             0xffe0e0e0, 0xffe0e0e0},
+    {QPalette::ToolTipBase,     0xffffffff, 0xffffffff},
+    {QPalette::ToolTipText,     0xff212121, 0xff212121},
+};
+
+static const PaletteEntry DARK_PALETTE[] = {
+    {QPalette::Window,          0xff303030, 0xff303030},
+    {QPalette::WindowText,      0xffffffff, 0xff757575},
+    {QPalette::Base,            0xff424242, 0xff383838},
+    {QPalette::AlternateBase,   0xff484848, 0xff383838},
+    {QPalette::Text,            0xffffffff, 0xff757575},
+    {QPalette::Button,          0xff3a3a3a, 0xff333333},
+    {QPalette::ButtonText,      0xffffffff, 0xff757575},
+    {QPalette::Highlight,       0xff1976d2, 0xff616161},
+    {QPalette::HighlightedText, 0xffffffff, 0xffbdbdbd},
+    {QPalette::Mid,             0xff616161, 0xff616161},
+    {QPalette::ToolTipBase,     0xff424242, 0xff424242},
+    {QPalette::ToolTipText,     0xffffffff, 0xffffffff},
+};
+
+static const PaletteEntry CLASSIC_IDM_PALETTE[] = {
+    {QPalette::Window,          0xfff0f0f0, 0xfff0f0f0},
+    {QPalette::WindowText,      0xff000000, 0xff808080},
+    {QPalette::Base,            0xffffffff, 0xfff0f0f0},
+    {QPalette::AlternateBase,   0xfff9f9f9, 0xfff0f0f0},
+    {QPalette::Text,            0xff000000, 0xff808080},
+    {QPalette::Button,          0xfff8f8f8, 0xfff0f0f0},
+    {QPalette::ButtonText,      0xff000000, 0xff808080},
+    {QPalette::Highlight,       0xff4caf50, 0xffc0c0c0},
+    {QPalette::HighlightedText, 0xffffffff, 0xffffffff},
+    {QPalette::Mid,             0xffcccccc, 0xffcccccc},
+    {QPalette::ToolTipBase,     0xffffffe1, 0xffffffe1},
+    {QPalette::ToolTipText,     0xff000000, 0xff000000},
+};
+
+template <int N>
+static QPalette buildPalette(const PaletteEntry (&entries)[N])
+{
+    QPalette palette;
+    for (const PaletteEntry &entry : entries) {
+        palette.setColor(QPalette::Active, entry.role, QColor::fromRgba(entry.active));
+        palette.setColor(QPalette::Inactive, entry.role, QColor::fromRgba(entry.active));
+        palette.setColor(QPalette::Disabled, entry.role, QColor::fromRgba(entry.disabled));
+    }
+    return palette;
+}
 
 ThemeManager* ThemeManager::instance()
 {
@@ -9,7 +77,7 @@ ThemeManager* ThemeManager::instance()
 }
 
 ThemeManager::ThemeManager(QObject *parent)
-    : QObject(parent), m_currentTheme(Light)
+    : QObject(parent), m_currentTheme(Light), m_installed(false)
 {
     loadStyleSheets();
 }
@@ -20,11 +88,23 @@ ThemeManager::~ThemeManager()
 
 void ThemeManager::setTheme(Theme theme)
 {
-    if (m_currentTheme != theme) {
-        m_currentTheme = theme;
-        qApp->setStyleSheet(getStyleSheet());
-        emit themeChanged(theme);
+    if (m_installed && m_currentTheme == theme) {
+        return;
+    }
+
+    m_currentTheme = theme;
+    install();
+
+    // A palette change repaints but does not re-parse or re-polish the tree
+    qApp->setPalette(palette(theme));
+
+    for (const QPointer<QWidget> &widget : m_themedWidgets) {
+        if (widget) {
+            repolish(widget);
+        }
     }
+
+    emit themeChanged(theme);
 }
 
 ThemeManager::Theme ThemeManager::currentTheme() const
@@ -34,140 +114,77 @@ ThemeManager::Theme ThemeManager::currentTheme() const
 
 QString ThemeManager::getStyleSheet() const
 {
-    return (m_currentTheme == Light) ? m_lightStyleSheet : m_darkStyleSheet;
+    return m_styleSheet;
 }
 
-void ThemeManager::loadStyleSheets()
+QPalette ThemeManager::palette(Theme theme) const
 {
-    // Light theme - Material Design inspired
-    m_lightStyleSheet = R"(
-        /* Global */
-        * {
-            font-family: "Roboto", sans-serif;
-        }
-
-        /* Main window */
-        QMainWindow {
-            background-color: #f5f5f5;
-            color: #212121;
-        }
-
-        /* Buttons */
-        QPushButton {
-            background-color: #2196F3;
-            color: white;
-            border: none;
-            padding: 8px 16px;
-            border-radius: 4px;
-            font-size: 14px;
-        }
-
-        QPushButton:hover {
-            background-color: #1976D2;
-        }
-
-        QPushButton:pressed {
-            background-color: #0D47A1;
-        }
-
-        /* List widgets */
-        QListWidget {
-            background-color: white;
-            border: 1px solid #e0e0e0;
-            border-radius: 4px;
-        }
-
-        QListWidget::item {
-            padding: 8px;
-            border-bottom: 1px solid #f0f0f0;
-        }
-
-        QListWidget::item:selected {
-            background-color: #E3F2FD;
-        }
-
-        /* Progress bars */
-        QProgressBar {
-            border: 1px solid #e0e0e0;
-            border-radius: 4px;
-            text-align: center;
-        }
-
-        QProgressBar::chunk {
-            background-color: #2196F3;
-            border-radius: 3px;
-        }
-
-        /* Labels */
-        QLabel {
-            color: #212121;
-        }
-    )";
-
-    // Dark theme - Material Design inspired
-    m_darkStyleSheet = R"(
-        /* Global */
-        * {
-            font-family: "Roboto", sans-serif;
-        }
-
-        /* Main window */
-        QMainWindow {
-            background-color: #303030;
-            color: #ffffff;
-        }
-
-        /* Buttons */
-        QPushButton {
-            background-color: #2196F3;
-            color: white;
-            border: none;
-            padding: 8px 16px;
-            border-radius: 4px;
-            font-size: 14px;
-        }
+    switch (theme) {
+    case Dark: return buildPalette(DARK_PALETTE);
+    case ClassicIDM: return buildPalette(CLASSIC_IDM_PALETTE);
+    case Light:
+    default: return buildPalette(LIGHT_PALETTE);
+    }
+}
 
-        QPushButton:hover {
-            background-color: #1976D2;
-        }
+void ThemeManager::registerThemedWidget(QWidget *widget)
+{
+    if (!widget) {
+        return;
+    }
 
-        QPushButton:pressed {
-            background-color: #0D47A1;
-        }
+    m_themedWidgets.removeAll(QPointer<QWidget>());
+    m_themedWidgets.append(widget);
+    if (m_installed) {
+        repolish(widget);
+    }
+}
 
-        /* List widgets */
-        QListWidget {
-            background-color: #424242;
-            border: 1px solid #616161;
-            border-radius: 4px;
-            color: #ffffff;
-        }
+QString ThemeManager::themeName(Theme theme)
+{
+    switch (theme) {
+    case Dark: return "dark";
+    case ClassicIDM: return "classic";
+    case Light:
+    default: return "light";
+    }
+}
 
-        QListWidget::item {
-            padding: 8px;
-            border-bottom: 1px solid #616161;
-        }
+ThemeManager::Theme ThemeManager::themeFromName(const QString &name)
+{
+    QString key = name.toLower();
+    if (key == "dark") return Dark;
+    if (key == "classic" || key == "classic idm") return ClassicIDM;
+    return Light;
+}
 
-        QListWidget::item:selected {
-            background-color: #1976D2;
-        }
+void ThemeManager::loadStyleSheets()
+{
+    // Compiled into the binary by rcc; read once per process
+    QFile file(":/styles/ldm-base.qss");
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        m_styleSheet = QString::fromUtf8(file.readAll());
+    } else {
+        qWarning() << "Base stylesheet missing from resources";
+    }
+}
 
-        /* Progress bars */
-        QProgressBar {
-            border: 1px solid #616161;
-            border-radius: 4px;
-            text-align: center;
-            color: #ffffff;
-        }
+void ThemeManager::install()
+{
+    if (m_installed) {
+        return;
+    }
 
-        QProgressBar::chunk {
-            background-color: #2196F3;
-            border-radius: 3px;
-        }
+    // Fusion draws everything from the palette, which is what makes palette-only switching work
+    qApp->setStyle(QStyleFactory::create("Fusion"));
+    qApp->setStyleSheet(m_styleSheet);
+    m_installed = true;
+}
 
-        /* Labels */
-        QLabel {
-            color: #ffffff;
-        }
-    )";
+void ThemeManager::repolish(QWidget *widget) const
+{
+    widget->setProperty("ldmTheme", themeName(m_currentTheme));
+    widget->style()->unpolish(widget);
+    widget->style()->polish(widget);
+    widget->update();
 }
\ No newline at end of file
@@ -3,18 +3,33 @@
 
 #include <QObject>
 #include <QString>
+#include <QPalette>
+#include <QPointer>
+#include <QList>
 
+class QWidget;
+
+// Themes are a palette plus one structural stylesheet compiled into the
+// resources. The stylesheet is installed once; switching themes swaps the
+// application palette and repolishes only widgets registered for ldmTheme rules.
 class ThemeManager : public QObject
 {
     Q_OBJECT
 
 public:
-    enum Theme { Light, Dark };
+    enum Theme { Light, Dark, ClassicIDM };
 
     static ThemeManager* instance();
     void setTheme(Theme theme);
     Theme currentTheme() const;
     QString getStyleSheet() const;
+    QPalette palette(Theme theme) const;
+
+    // Widgets styled by [ldmTheme="..."] selectors in the base stylesheet
+    void registerThemedWidget(QWidget *widget);
+
+    static QString themeName(Theme theme);
+    static Theme themeFromName(const QString &name);
 
 signals:
     void themeChanged(Theme theme);
@@ -24,10 +39,13 @@ private:
     ~ThemeManager();
 
     Theme m_currentTheme;
-    QString m_lightStyleSheet;
-    QString m_darkStyleSheet;
+    bool m_installed;
+    QString m_styleSheet;
+    QList<QPointer<QWidget>> m_themedWidgets;
 
     void loadStyleSheets();
+    void install();
+    void repolish(QWidget *widget) const;
 };
 
 #endif // THEMEMANAGER_H
\ No newline at end of file
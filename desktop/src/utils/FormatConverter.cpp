@@ -1,4 +1,5 @@
 #include "FormatConverter.h"
+#include "MediaProbe.h"
 #include <QDebug>
 #include <QDir>
 #include <QStandardPaths>
@@ -65,12 +66,19 @@ QStringList FormatConverter::supportedAudioFormats() const
 
 QVariantMap FormatConverter::getMediaInfo(const QString &inputPath)
 {
+    // Header probe in-process through libavformat; no ffprobe child process
+    MediaProbe::Result result = MediaProbe::probe(inputPath);
+
     QVariantMap info;
-    // Placeholder - would use ffprobe to get media information
-    info["duration"] = 0;
-    info["width"] = 0;
-    info["height"] = 0;
-    info["bitrate"] = 0;
+    info["duration"] = result.durationMs / 1000.0;
+    info["width"] = result.width;
+    info["height"] = result.height;
+    info["bitrate"] = result.bitRate;
+    info["videoCodec"] = result.videoCodec;
+    info["audioCodec"] = result.audioCodec;
+    if (!result.valid) {
+        info["error"] = result.error;
+    }
     return info;
 }
 
@@ -0,0 +1,83 @@
+#include "HistoryArchive.h"
+#include <QFile>
+#include <QDir>
+#include <QDataStream>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QDebug>
+
+static const quint32 MAX_BLOCK_SIZE = 256 * 1024 * 1024;
+
+HistoryArchive::HistoryArchive()
+{
+}
+
+QString HistoryArchive::archivePath(const QString &archiveDir, const QDate &month)
+{
+    return QDir(archiveDir).filePath(QString("history-%1.ldma").arg(month.toString("yyyy-MM")));
+}
+
+bool HistoryArchive::appendRows(const QString &filePath, const QVariantList &rows)
+{
+    if (rows.isEmpty()) {
+        return true;
+    }
+
+    QByteArray payload = qCompress(QJsonDocument(QJsonArray::fromVariantList(rows)).toJson(QJsonDocument::Compact));
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Failed to open history archive:" << filePath << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream << quint32(payload.size());
+    stream.writeRawData(payload.constData(), payload.size());
+
+    // Rows are deleted from the live table only after this returns true
+    bool ok = stream.status() == QDataStream::Ok && file.flush();
+    file.close();
+    return ok;
+}
+
+QVariantList HistoryArchive::readRows(const QString &filePath)
+{
+    QVariantList rows;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return rows;
+    }
+
+    QDataStream stream(&file);
+    while (!stream.atEnd()) {
+        quint32 size = 0;
+        stream >> size;
+        if (stream.status() != QDataStream::Ok || size > MAX_BLOCK_SIZE) {
+            break;
+        }
+
+        QByteArray payload(size, Qt::Uninitialized);
+        if (stream.readRawData(payload.data(), size) != int(size)) {
+            // Truncated trailing block from an interrupted append
+            qWarning() << "Truncated block in history archive:" << filePath;
+            break;
+        }
+
+        QJsonDocument doc = QJsonDocument::fromJson(qUncompress(payload));
+        rows.append(doc.array().toVariantList());
+    }
+
+    return rows;
+}
+
+QStringList HistoryArchive::listArchives(const QString &archiveDir)
+{
+    QDir dir(archiveDir);
+    QStringList files = dir.entryList({"history-*.ldma"}, QDir::Files, QDir::Name);
+    for (QString &file : files) {
+        file = dir.filePath(file);
+    }
+    return files;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef HISTORYARCHIVE_H
+#define HISTORYARCHIVE_H
+
+#include <QString>
+#include <QDate>
+#include <QVariantList>
+#include <QStringList>
+
+// Append-only, compressed monthly archive files for download_history.
+// Each file is a sequence of blocks: [quint32 length][qCompress(JSON array)].
+class HistoryArchive
+{
+public:
+    HistoryArchive();
+
+    // File naming: <dir>/history-YYYY-MM.ldma
+    static QString archivePath(const QString &archiveDir, const QDate &month);
+
+    // Append one block of rows; never rewrites existing blocks
+    static bool appendRows(const QString &filePath, const QVariantList &rows);
+
+    // Read every block of an archive file back into rows
+    static QVariantList readRows(const QString &filePath);
+
+    static QStringList listArchives(const QString &archiveDir);
+};
+
+#endif // HISTORYARCHIVE_H
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "MediaProbe.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+#include <libswscale/swscale.h>
+}
+
+static QImage frameToImage(const AVFrame *frame, const QSize &bounds)
+{
+    QSize size = QSize(frame->width, frame->height).scaled(bounds, Qt::KeepAspectRatio);
+    if (size.isEmpty()) {
+        return QImage();
+    }
+
+    SwsContext *scaler = sws_getContext(frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                                        size.width(), size.height(), AV_PIX_FMT_RGB24,
+                                        SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!scaler) {
+        return QImage();
+    }
+
+    QImage image(size, QImage::Format_RGB888);
+    uint8_t *destination[4] = {image.bits(), nullptr, nullptr, nullptr};
+    int destinationStride[4] = {int(image.bytesPerLine()), 0, 0, 0};
+    sws_scale(scaler, frame->data, frame->linesize, 0, frame->height, destination, destinationStride);
+    sws_freeContext(scaler);
+    return image;
+}
+
+static bool decodeKeyframe(AVFormatContext *format, int streamIndex, AVCodecContext *decoder,
+                           AVFrame *frame, int maxPackets)
+{
+    AVPacket *packet = av_packet_alloc();
+    bool decoded = false;
+
+    for (int packets = 0; !decoded && packets < maxPackets && av_read_frame(format, packet) >= 0; ++packets) {
+        if (packet->stream_index == streamIndex && avcodec_send_packet(decoder, packet) >= 0) {
+            decoded = avcodec_receive_frame(decoder, frame) == 0;
+        }
+        av_packet_unref(packet);
+    }
+
+    // Decoders with frame delay only hand the keyframe back once flushed
+    if (!decoded && avcodec_send_packet(decoder, nullptr) >= 0) {
+        decoded = avcodec_receive_frame(decoder, frame) == 0;
+    }
+
+    av_packet_free(&packet);
+    return decoded;
+}
+
+static QImage extractThumbnail(AVFormatContext *format, int streamIndex, qint64 durationMs, const QSize &bounds)
+{
+    AVStream *stream = format->streams[streamIndex];
+    const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec) {
+        return QImage();
+    }
+
+    AVCodecContext *decoder = avcodec_alloc_context3(codec);
+    if (!decoder || avcodec_parameters_to_context(decoder, stream->codecpar) < 0
+        || avcodec_open2(decoder, codec, nullptr) < 0) {
+        avcodec_free_context(&decoder);
+        return QImage();
+    }
+
+    // One keyframe is all a thumbnail needs
+    decoder->skip_frame = AVDISCARD_NONKEY;
+    AVFrame *frame = av_frame_alloc();
+    QImage image;
+
+    // Skip intros and black leaders; cover art streams carry a single picture
+    bool seeked = false;
+    if (durationMs > 0 && !(stream->disposition & AV_DISPOSITION_ATTACHED_PIC)) {
+        int64_t target = av_rescale_q(durationMs * 100, AVRational{1, 1000000}, stream->time_base);
+        seeked = av_seek_frame(format, streamIndex, target, AVSEEK_FLAG_BACKWARD) >= 0;
+    }
+
+    bool decoded = decodeKeyframe(format, streamIndex, decoder, frame, MediaProbe::MAX_THUMBNAIL_PACKETS);
+    if (!decoded && seeked) {
+        // A partial download may not contain the seek target yet
+        avcodec_flush_buffers(decoder);
+        if (av_seek_frame(format, streamIndex, 0, AVSEEK_FLAG_BACKWARD) >= 0) {
+            decoded = decodeKeyframe(format, streamIndex, decoder, frame, MediaProbe::MAX_THUMBNAIL_PACKETS);
+        }
+    }
+
+    if (decoded) {
+        image = frameToImage(frame, bounds);
+    }
+
+    av_frame_free(&frame);
+    avcodec_free_context(&decoder);
+    return image;
+}
+
+MediaProbe::Result MediaProbe::probe(const QString &filePath, const QSize &thumbnailSize)
+{
+    Result result;
+    AVFormatContext *format = nullptr;
+    QByteArray path = filePath.toUtf8();
+
+    int error = avformat_open_input(&format, path.constData(), nullptr, nullptr);
+    if (error < 0) {
+        char message[AV_ERROR_MAX_STRING_SIZE] = {0};
+        av_strerror(error, message, sizeof(message));
+        result.error = QString::fromUtf8(message);
+        return result;
+    }
+
+    if (avformat_find_stream_info(format, nullptr) < 0) {
+        result.error = "Unable to read stream information";
+        avformat_close_input(&format);
+        return result;
+    }
+
+    result.valid = true;
+    result.durationMs = format->duration != AV_NOPTS_VALUE ? format->duration / 1000 : 0;
+    result.bitRate = format->bit_rate;
+
+    int videoIndex = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    int audioIndex = av_find_best_stream(format, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+
+    if (videoIndex >= 0) {
+        const AVCodecParameters *parameters = format->streams[videoIndex]->codecpar;
+        result.width = parameters->width;
+        result.height = parameters->height;
+        result.videoCodec = QString::fromLatin1(avcodec_get_name(parameters->codec_id));
+    }
+    if (audioIndex >= 0) {
+        result.audioCodec = QString::fromLatin1(avcodec_get_name(format->streams[audioIndex]->codecpar->codec_id));
+    }
+
+    if (videoIndex >= 0 && !thumbnailSize.isEmpty()) {
+        result.thumbnail = extractThumbnail(format, videoIndex, result.durationMs, thumbnailSize);
+    }
+
+    avformat_close_input(&format);
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef MEDIAPROBE_H
+#define MEDIAPROBE_H
+
+#include <QString>
+#include <QImage>
+#include <QSize>
+#include <QMetaType>
+
+// In-process media inspection through libavformat/libavcodec.
+// probe() reads the container header, and optionally decodes a single keyframe
+// into a thumbnail. It blocks, so callers run it off the GUI thread.
+class MediaProbe
+{
+public:
+    struct Result {
+        bool valid = false;
+        qint64 durationMs = 0;
+        int width = 0;
+        int height = 0;
+        qint64 bitRate = 0;
+        QString videoCodec;
+        QString audioCodec;
+        QImage thumbnail;       // null for audio-only files or when not requested
+        QString error;
+    };
+
+    // An empty thumbnailSize skips decoding; partially downloaded files are
+    // accepted as long as the container header is present
+    static Result probe(const QString &filePath, const QSize &thumbnailSize = QSize());
+
+    static const int MAX_THUMBNAIL_PACKETS = 512;   // give up on streams without a reachable keyframe
+};
+
+Q_DECLARE_METATYPE(MediaProbe::Result)
+
+#endif // MEDIAPROBE_H
\ No newline at end of file
@@ -25,15 +25,18 @@ void MetadataCache::store(const QString &key, const QVariantMap &metadata)
 
 QVariantMap MetadataCache::retrieve(const QString &key) const
 {
-    QReadLocker locker(&m_lock);
+    // QCache::object() moves the entry to the front of the LRU chain, so a read takes the write lock
+    QWriteLocker locker(&m_lock);
     QVariantMap *entry = m_cache->object(key);
-    if (entry) {
-        emit const_cast<MetadataCache*>(this)->cacheHit(key);
-        return *entry;
-    } else {
+    if (!entry) {
+        locker.unlock();
         emit const_cast<MetadataCache*>(this)->cacheMiss(key);
         return QVariantMap();
     }
+    QVariantMap metadata = *entry;
+    locker.unlock();
+    emit const_cast<MetadataCache*>(this)->cacheHit(key);
+    return metadata;
 }
 
 bool MetadataCache::contains(const QString &key) const
@@ -75,7 +78,8 @@ int MetadataCache::size() const
 
 bool MetadataCache::saveToFile(const QString &filePath) const
 {
-    QReadLocker locker(&m_lock);
+    // object() reorders the cache, see retrieve()
+    QWriteLocker locker(&m_lock);
     
     QFile file(filePath);
     if (!file.open(QIODevice::WriteOnly)) {
@@ -0,0 +1,230 @@
+#include "Metrics.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <cmath>
+
+namespace {
+
+QByteArray sampleLine(const QString &name, const QString &labels, const QByteArray &value)
+{
+    QByteArray line = name.toUtf8();
+    if (!labels.isEmpty()) {
+        line += '{' + labels.toUtf8() + '}';
+    }
+    return line + ' ' + value + '\n';
+}
+
+QByteArray formatDouble(double value)
+{
+    return QByteArray::number(value, 'g', 12);
+}
+
+}
+
+Metrics::Histogram::Histogram(double unitScale)
+    : m_unitScale(unitScale)
+{
+    for (auto &bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Metrics::Histogram::record(qint64 value)
+{
+    value = qMax<qint64>(value, 0);
+    m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+qint64 Metrics::Histogram::valueAtPercentile(double percentile) const
+{
+    quint64 total = count();
+    if (total == 0) {
+        return 0;
+    }
+
+    quint64 target = qMax<quint64>(1, quint64(std::ceil(qBound(0.0, percentile, 100.0) / 100.0 * total)));
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return bucketUpperBound(i) - 1;
+        }
+    }
+    return bucketUpperBound(BUCKET_COUNT - 1) - 1;
+}
+
+int Metrics::Histogram::bucketIndex(qint64 value)
+{
+    if (value < SUB_BUCKETS) {
+        return int(qMax<qint64>(value, 0));
+    }
+
+    // Index by the exponent and the SUB_BUCKET_BITS bits below the leading one
+    int exponent = 63 - qCountLeadingZeroBits(quint64(value));
+    if (exponent >= MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    int group = exponent - SUB_BUCKET_BITS + 1;
+    int mantissa = int(value >> (exponent - SUB_BUCKET_BITS));
+    return group * SUB_BUCKETS + (mantissa - SUB_BUCKETS);
+}
+
+qint64 Metrics::Histogram::bucketUpperBound(int index)
+{
+    if (index < SUB_BUCKETS) {
+        return index + 1;
+    }
+    int group = index / SUB_BUCKETS;
+    qint64 mantissa = SUB_BUCKETS + index % SUB_BUCKETS;
+    return (mantissa + 1) << (group - 1);
+}
+
+Metrics &Metrics::instance()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::Counter *Metrics::counter(const QString &name, const QString &help, const QString &labels)
+{
+    QMutexLocker locker(&m_mutex);
+    auto &slot = family(name, help, CounterType).counters[labels];
+    if (!slot) {
+        slot = std::make_unique<Counter>();
+    }
+    return slot.get();
+}
+
+Metrics::Counter *Metrics::boundedCounter(const QString &name, const QString &help, const QString &labelName,
+                                          const QString &value, int maxSeries)
+{
+    QMutexLocker locker(&m_mutex);
+    auto &counters = family(name, help, CounterType).counters;
+    QString labels = label(labelName, value);
+    if (counters.find(labels) == counters.end() && int(counters.size()) >= maxSeries) {
+        labels = label(labelName, "other");
+    }
+    auto &slot = counters[labels];
+    if (!slot) {
+        slot = std::make_unique<Counter>();
+    }
+    return slot.get();
+}
+
+Metrics::Gauge *Metrics::gauge(const QString &name, const QString &help, const QString &labels)
+{
+    QMutexLocker locker(&m_mutex);
+    auto &slot = family(name, help, GaugeType).gauges[labels];
+    if (!slot) {
+        slot = std::make_unique<Gauge>();
+    }
+    return slot.get();
+}
+
+Metrics::Histogram *Metrics::histogram(const QString &name, const QString &help, double unitScale,
+                                       const QString &labels)
+{
+    QMutexLocker locker(&m_mutex);
+    auto &slot = family(name, help, HistogramType).histograms[labels];
+    if (!slot) {
+        slot = std::make_unique<Histogram>(unitScale);
+    }
+    return slot.get();
+}
+
+QByteArray Metrics::prometheusText() const
+{
+    QMutexLocker locker(&m_mutex);
+    QByteArray out;
+    out.reserve(16 * 1024);
+
+    for (const auto &entry : m_families) {
+        const QString &name = entry.first;
+        const Family &family = entry.second;
+        static const char *const typeNames[] = {"counter", "gauge", "histogram"};
+
+        QString help = family.help;
+        help.replace('\\', "\\\\").replace('\n', "\\n");
+        out += "# HELP " + name.toUtf8() + ' ' + help.toUtf8() + '\n';
+        out += "# TYPE " + name.toUtf8() + ' ' + typeNames[family.type] + '\n';
+
+        switch (family.type) {
+        case CounterType:
+            for (const auto &metric : family.counters) {
+                out += sampleLine(name, metric.first, QByteArray::number(metric.second->value()));
+            }
+            break;
+        case GaugeType:
+            for (const auto &metric : family.gauges) {
+                out += sampleLine(name, metric.first, QByteArray::number(metric.second->value()));
+            }
+            break;
+        case HistogramType:
+            for (const auto &metric : family.histograms) {
+                appendHistogram(out, name, metric.first, *metric.second);
+            }
+            break;
+        }
+    }
+    return out;
+}
+
+QString Metrics::label(const QString &name, const QString &value)
+{
+    QString escaped = value;
+    escaped.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+    return QString("%1=\"%2\"").arg(name, escaped);
+}
+
+QString Metrics::labels(const QString &first, const QString &second)
+{
+    if (first.isEmpty()) {
+        return second;
+    }
+    return second.isEmpty() ? first : first + ',' + second;
+}
+
+Metrics::Family &Metrics::family(const QString &name, const QString &help, Type type)
+{
+    auto it = m_families.find(name);
+    if (it == m_families.end()) {
+        it = m_families.emplace(name, Family{type, help, {}, {}, {}}).first;
+    } else if (it->second.type != type) {
+        // Still hand out a metric so callers need no null checks; it is just never exported
+        qWarning() << "Metrics:" << name << "registered with conflicting types";
+    }
+    return it->second;
+}
+
+void Metrics::appendHistogram(QByteArray &out, const QString &name, const QString &labels,
+                              const Histogram &histogram)
+{
+    // Export cumulative counts at the power-of-two bucket edges up to the
+    // highest populated bucket; the fine buckets stay internal. Edges are
+    // exclusive, so a value exactly on one is counted in the next bucket.
+    int highest = -1;
+    for (int i = Histogram::BUCKET_COUNT - 1; i >= 0; --i) {
+        if (histogram.m_buckets[i].load(std::memory_order_relaxed) > 0) {
+            highest = i;
+            break;
+        }
+    }
+
+    const QString bucketName = name + "_bucket";
+    quint64 cumulative = 0;
+    for (int i = 0; i <= highest; ++i) {
+        cumulative += histogram.m_buckets[i].load(std::memory_order_relaxed);
+        qint64 upper = Histogram::bucketUpperBound(i);
+        if ((upper & (upper - 1)) == 0 || i == highest) {
+            QString le = label("le", QString::fromLatin1(formatDouble(upper * histogram.unitScale())));
+            out += sampleLine(bucketName, Metrics::labels(labels, le), QByteArray::number(cumulative));
+        }
+    }
+
+    // _count and +Inf come from the same snapshot of buckets so they agree
+    out += sampleLine(bucketName, Metrics::labels(labels, label("le", "+Inf")), QByteArray::number(cumulative));
+    out += sampleLine(name + "_sum", labels, formatDouble(histogram.sum() * histogram.unitScale()));
+    out += sampleLine(name + "_count", labels, QByteArray::number(cumulative));
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+
+// Process-wide registry of counters, gauges and histograms, rendered in the
+// Prometheus text exposition format. Looking a metric up takes the registry
+// lock, so call sites fetch the pointer once and keep it; updates through
+// the pointer are lock-free. Metrics are never unregistered, so pointers
+// stay valid for the life of the process.
+class Metrics
+{
+public:
+    class Counter
+    {
+    public:
+        void increment(quint64 amount = 1) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+        quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<quint64> m_value{0};
+    };
+
+    class Gauge
+    {
+    public:
+        void set(qint64 value) { m_value.store(value, std::memory_order_relaxed); }
+        void add(qint64 delta) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+        qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<qint64> m_value{0};
+    };
+
+    // HDR-style log-linear histogram over non-negative integers: exact below
+    // SUB_BUCKETS, then SUB_BUCKETS buckets per power of two (about 6%
+    // relative error). unitScale converts recorded units to exported ones,
+    // e.g. 1e-6 to record microseconds and export seconds.
+    class Histogram
+    {
+    public:
+        explicit Histogram(double unitScale = 1.0);
+
+        void record(qint64 value);
+        quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+        qint64 sum() const { return m_sum.load(std::memory_order_relaxed); }
+        qint64 valueAtPercentile(double percentile) const;    // highest value in the bucket
+        double unitScale() const { return m_unitScale; }
+
+        static const int SUB_BUCKET_BITS = 4;
+        static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        static const int MAX_EXPONENT = 42;     // larger values land in the last bucket
+        static const int BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        static int bucketIndex(qint64 value);
+        static qint64 bucketUpperBound(int index);     // exclusive
+
+    private:
+        friend class Metrics;
+
+        std::array<std::atomic<quint64>, BUCKET_COUNT> m_buckets;
+        std::atomic<quint64> m_count{0};
+        std::atomic<qint64> m_sum{0};
+        double m_unitScale;
+    };
+
+    static Metrics &instance();
+
+    // labels is the inside of the braces, built with label(); empty for none
+    Counter *counter(const QString &name, const QString &help, const QString &labels = QString());
+    // Keeps one series per label value up to maxSeries, then folds new values into
+    // labelName="other"; existing series are never moved, so their rates stay monotonic
+    Counter *boundedCounter(const QString &name, const QString &help, const QString &labelName,
+                            const QString &value, int maxSeries);
+    Gauge *gauge(const QString &name, const QString &help, const QString &labels = QString());
+    Histogram *histogram(const QString &name, const QString &help, double unitScale = 1.0,
+                         const QString &labels = QString());
+
+    QByteArray prometheusText() const;
+
+    static QString label(const QString &name, const QString &value);
+    static QString labels(const QString &first, const QString &second);
+
+private:
+    enum Type { CounterType, GaugeType, HistogramType };
+
+    struct Family {
+        Type type;
+        QString help;
+        std::map<QString, std::unique_ptr<Counter>> counters;
+        std::map<QString, std::unique_ptr<Gauge>> gauges;
+        std::map<QString, std::unique_ptr<Histogram>> histograms;
+    };
+
+    mutable QMutex m_mutex;
+    std::map<QString, Family> m_families;
+
+    Family &family(const QString &name, const QString &help, Type type);
+    static void appendHistogram(QByteArray &out, const QString &name, const QString &labels,
+                                const Histogram &histogram);
+};
+
+#endif // METRICS_H
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "SpeedHistory.h"
+#include <limits>
+
+SpeedHistory::SpeedHistory(int capacity)
+    : m_capacity(0)
+    , m_count(0)
+    , m_next(0)
+    , m_sum(0)
+{
+    setCapacity(capacity);
+}
+
+void SpeedHistory::append(qint64 timeMs, qint64 bytesPerSecond)
+{
+    if (m_capacity <= 0) {
+        return;
+    }
+
+    // Overwrite the oldest sample once full; its buckets age out with it
+    if (m_count == m_capacity) {
+        m_sum -= sampleAt(oldestIndex()).bytesPerSecond;
+        --m_count;
+    }
+
+    m_samples[m_next % m_capacity] = Sample{timeMs, bytesPerSecond};
+
+    for (int level = 0; level < m_levels.size(); ++level) {
+        qint64 size = blockSize(level);
+        QVector<Bucket> &buckets = m_levels[level];
+        Bucket &bucket = buckets[(m_next / size) % buckets.size()];
+        if (m_next % size == 0) {
+            bucket = Bucket{bytesPerSecond, bytesPerSecond};
+        } else {
+            bucket.minSpeed = qMin(bucket.minSpeed, bytesPerSecond);
+            bucket.maxSpeed = qMax(bucket.maxSpeed, bytesPerSecond);
+        }
+    }
+
+    m_sum += bytesPerSecond;
+    ++m_count;
+    ++m_next;
+}
+
+void SpeedHistory::clear()
+{
+    m_count = 0;
+    m_next = 0;
+    m_sum = 0;
+}
+
+void SpeedHistory::setCapacity(int capacity)
+{
+    QVector<Sample> retained;
+    retained.reserve(qMin(m_count, qMax(capacity, 0)));
+    for (int i = qMax(0, m_count - capacity); i < m_count; ++i) {
+        retained.append(at(i));
+    }
+
+    m_capacity = qMax(capacity, 0);
+    m_samples = QVector<Sample>(m_capacity);
+
+    // A retained range of m_capacity samples overlaps at most capacity / size + 2 blocks
+    m_levels.clear();
+    for (int level = 0; blockSize(level) <= m_capacity; ++level) {
+        m_levels.append(QVector<Bucket>(m_capacity / blockSize(level) + 2));
+    }
+
+    clear();
+    for (const Sample &sample : retained) {
+        append(sample.timeMs, sample.bytesPerSecond);
+    }
+}
+
+SpeedHistory::Sample SpeedHistory::at(int i) const
+{
+    return sampleAt(oldestIndex() + i);
+}
+
+SpeedHistory::Sample SpeedHistory::last() const
+{
+    return m_count > 0 ? sampleAt(m_next - 1) : Sample{0, 0};
+}
+
+qint64 SpeedHistory::firstTimeMs() const
+{
+    return m_count > 0 ? sampleAt(oldestIndex()).timeMs : 0;
+}
+
+qint64 SpeedHistory::lastTimeMs() const
+{
+    return last().timeMs;
+}
+
+QVector<SpeedHistory::Column> SpeedHistory::decimate(qint64 fromMs, qint64 toMs, int columns) const
+{
+    QVector<Column> result(qMax(columns, 0), Column{0, 0, 0, false});
+    if (columns <= 0 || toMs <= fromMs || m_count == 0) {
+        return result;
+    }
+
+    qint64 start = lowerBound(fromMs);
+    for (int column = 0; column < columns; ++column) {
+        qint64 columnEndMs = fromMs + (toMs - fromMs) * (column + 1) / columns;
+        qint64 end = lowerBound(columnEndMs);
+        if (end > start) {
+            Column &out = result[column];
+            rangeMinMax(start, end, out.minSpeed, out.maxSpeed);
+            out.lastSpeed = sampleAt(end - 1).bytesPerSecond;
+            out.valid = true;
+        }
+        start = end;
+    }
+
+    return result;
+}
+
+qint64 SpeedHistory::peak(qint64 fromMs, qint64 toMs) const
+{
+    qint64 first = lowerBound(fromMs);
+    qint64 end = lowerBound(toMs);
+    if (end <= first) {
+        return 0;
+    }
+
+    qint64 minSpeed = 0;
+    qint64 maxSpeed = 0;
+    rangeMinMax(first, end, minSpeed, maxSpeed);
+    return maxSpeed;
+}
+
+qint64 SpeedHistory::average() const
+{
+    return m_count > 0 ? m_sum / m_count : 0;
+}
+
+const SpeedHistory::Sample &SpeedHistory::sampleAt(qint64 absoluteIndex) const
+{
+    return m_samples[absoluteIndex % m_capacity];
+}
+
+qint64 SpeedHistory::lowerBound(qint64 timeMs) const
+{
+    qint64 low = oldestIndex();
+    qint64 high = m_next;
+    while (low < high) {
+        qint64 mid = low + (high - low) / 2;
+        if (sampleAt(mid).timeMs < timeMs) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void SpeedHistory::rangeMinMax(qint64 first, qint64 last, qint64 &minSpeed, qint64 &maxSpeed) const
+{
+    minSpeed = std::numeric_limits<qint64>::max();
+    maxSpeed = std::numeric_limits<qint64>::min();
+
+    // Greedily cover [first, last) with the largest aligned blocks that fit
+    qint64 i = first;
+    while (i < last) {
+        int level = m_levels.size() - 1;
+        while (level >= 0 && (i % blockSize(level) != 0 || i + blockSize(level) > last)) {
+            --level;
+        }
+
+        if (level < 0) {
+            qint64 speed = sampleAt(i).bytesPerSecond;
+            minSpeed = qMin(minSpeed, speed);
+            maxSpeed = qMax(maxSpeed, speed);
+            ++i;
+        } else {
+            const QVector<Bucket> &buckets = m_levels[level];
+            const Bucket &bucket = buckets[(i / blockSize(level)) % buckets.size()];
+            minSpeed = qMin(minSpeed, bucket.minSpeed);
+            maxSpeed = qMax(maxSpeed, bucket.maxSpeed);
+            i += blockSize(level);
+        }
+    }
+}
+
+qint64 SpeedHistory::blockSize(int level)
+{
+    qint64 size = FANOUT;
+    for (int i = 0; i < level; ++i) {
+        size *= FANOUT;
+    }
+    return size;
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef SPEEDHISTORY_H
+#define SPEEDHISTORY_H
+
+#include <QVector>
+#include <QtGlobal>
+
+// Fixed-capacity ring buffer of (monotonic ms, bytes/s) samples with a min/max
+// decimation pyramid on top. Level l summarises aligned blocks of FANOUT^l
+// samples, so the min/max of any sample range costs O(levels * FANOUT) and a
+// chart column is answered without touching the samples underneath it.
+class SpeedHistory
+{
+public:
+    struct Sample {
+        qint64 timeMs;
+        qint64 bytesPerSecond;
+    };
+
+    struct Column {
+        qint64 minSpeed;
+        qint64 maxSpeed;
+        qint64 lastSpeed;       // last sample in the column, for the line itself
+        bool valid;             // false when no sample falls inside the column
+    };
+
+    static const int DEFAULT_CAPACITY = 24 * 60 * 60;  // 24 hours at 1 sample per second
+    static const int FANOUT = 8;
+
+    explicit SpeedHistory(int capacity = DEFAULT_CAPACITY);
+
+    // timeMs must not go backwards (QElapsedTimer / steady clock)
+    void append(qint64 timeMs, qint64 bytesPerSecond);
+    void clear();
+    void setCapacity(int capacity);
+
+    int size() const { return m_count; }
+    int capacity() const { return m_capacity; }
+    bool isEmpty() const { return m_count == 0; }
+
+    // 0 is the oldest retained sample
+    Sample at(int i) const;
+    Sample last() const;
+    qint64 firstTimeMs() const;
+    qint64 lastTimeMs() const;
+
+    // One entry per column over [fromMs, toMs); cost is O(columns * log samples)
+    QVector<Column> decimate(qint64 fromMs, qint64 toMs, int columns) const;
+
+    qint64 peak(qint64 fromMs, qint64 toMs) const;
+    qint64 average() const;
+
+private:
+    struct Bucket {
+        qint64 minSpeed;
+        qint64 maxSpeed;
+    };
+
+    QVector<Sample> m_samples;
+    QVector<QVector<Bucket>> m_levels;  // m_levels[0] covers FANOUT samples per bucket
+    int m_capacity;
+    int m_count;
+    qint64 m_next;                      // absolute index of the next sample to append
+    qint64 m_sum;
+
+    qint64 oldestIndex() const { return m_next - m_count; }
+    const Sample &sampleAt(qint64 absoluteIndex) const;
+    qint64 lowerBound(qint64 timeMs) const;
+    void rangeMinMax(qint64 first, qint64 last, qint64 &minSpeed, qint64 &maxSpeed) const;
+    static qint64 blockSize(int level);
+};
+
+#endif // SPEEDHISTORY_H
\ No newline at end of file
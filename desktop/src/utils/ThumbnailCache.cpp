@@ -0,0 +1,265 @@
+#include "ThumbnailCache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+#include <algorithm>
+
+ThumbnailCache* ThumbnailCache::instance()
+{
+    static ThumbnailCache instance(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails");
+    return &instance;
+}
+
+ThumbnailCache::ThumbnailCache(const QString &cacheDir, QObject *parent)
+    : QObject(parent)
+    , m_cacheDir(cacheDir)
+    , m_thumbnailSize(DEFAULT_THUMBNAIL_WIDTH, DEFAULT_THUMBNAIL_HEIGHT)
+    , m_memory(MEMORY_COST_KB)
+    , m_diskBytes(0)
+    , m_maxDiskBytes(DEFAULT_MAX_DISK_BYTES)
+{
+    QDir().mkpath(m_cacheDir);
+
+    // Decoding is CPU heavy; keep it off the global pool the engine relies on
+    m_pool.setMaxThreadCount(PROBE_THREADS);
+    m_pool.start([this]() { scanDisk(); });
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+bool ThumbnailCache::lookup(const QString &filePath, MediaProbe::Result *result,
+                            qint64 size, qint64 modifiedMs) const
+{
+    const Entry *cached = m_memory.object(filePath);
+    if (!cached) {
+        return false;
+    }
+    if ((size >= 0 && cached->size != size) || (modifiedMs >= 0 && cached->modifiedMs != modifiedMs)) {
+        return false;
+    }
+    if (result) {
+        *result = cached->result;
+    }
+    return true;
+}
+
+void ThumbnailCache::request(const QString &filePath)
+{
+    if (filePath.isEmpty() || m_pending.contains(filePath)) {
+        return;
+    }
+
+    // The pool stats the file; an unchanged file reuses what is already in memory
+    Entry known{-1, -1, MediaProbe::Result()};
+    if (const Entry *cached = m_memory.object(filePath)) {
+        known = *cached;
+    }
+
+    m_pending.insert(filePath);
+    QSize thumbnailSize = m_thumbnailSize;
+    m_pool.start([this, filePath, known, thumbnailSize]() {
+        Entry entry = resolve(filePath, known, thumbnailSize);
+        QMetaObject::invokeMethod(this, [this, filePath, entry]() {
+            finish(filePath, entry);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ThumbnailCache::setThumbnailSize(const QSize &size)
+{
+    if (size == m_thumbnailSize) {
+        return;
+    }
+    m_thumbnailSize = size;
+    clear();
+}
+
+void ThumbnailCache::setMaxDiskBytes(qint64 bytes)
+{
+    m_pool.start([this, bytes]() {
+        QMutexLocker locker(&m_diskMutex);
+        m_maxDiskBytes = bytes;
+        evict();
+    });
+}
+
+qint64 ThumbnailCache::diskUsage() const
+{
+    QMutexLocker locker(&m_diskMutex);
+    return m_diskBytes;
+}
+
+void ThumbnailCache::clear()
+{
+    m_memory.clear();
+
+    QMutexLocker locker(&m_diskMutex);
+    for (auto it = m_disk.constBegin(); it != m_disk.constEnd(); ++it) {
+        QFile::remove(entryPath(it.key()));
+    }
+    m_disk.clear();
+    m_diskBytes = 0;
+}
+
+QString ThumbnailCache::diskKey(const QString &absolutePath, qint64 size, qint64 modifiedMs)
+{
+    QByteArray identity = absolutePath.toUtf8() + '|'
+        + QByteArray::number(modifiedMs) + '|'
+        + QByteArray::number(size);
+    return QString::fromLatin1(QCryptographicHash::hash(identity, QCryptographicHash::Sha1).toHex());
+}
+
+ThumbnailCache::Entry ThumbnailCache::resolve(const QString &filePath, const Entry &known, const QSize &thumbnailSize)
+{
+    // Runs on the pool: all stat calls and hashing stay off the GUI thread
+    QFileInfo info(filePath);
+    if (!info.exists()) {
+        return Entry{-1, -1, MediaProbe::Result()};
+    }
+
+    Entry entry{info.size(), info.lastModified().toMSecsSinceEpoch(), MediaProbe::Result()};
+    if (entry.size == known.size && entry.modifiedMs == known.modifiedMs) {
+        entry.result = known.result;
+        return entry;
+    }
+
+    QString key = diskKey(info.absoluteFilePath(), entry.size, entry.modifiedMs);
+    if (readEntry(key, &entry.result)) {
+        return entry;
+    }
+
+    // Failed probes are stored too, so unreadable files are not re-opened on every scroll
+    entry.result = MediaProbe::probe(filePath, thumbnailSize);
+    writeEntry(key, entry.result);
+    return entry;
+}
+
+void ThumbnailCache::finish(const QString &filePath, const Entry &entry)
+{
+    m_pending.remove(filePath);
+    if (entry.size < 0) {
+        m_memory.remove(filePath);
+        return;
+    }
+
+    int cost = qMax(1, int(entry.result.thumbnail.sizeInBytes() / 1024));
+    m_memory.insert(filePath, new Entry(entry), cost);
+    emit ready(filePath, entry.result);
+}
+
+void ThumbnailCache::scanDisk()
+{
+    QDir dir(m_cacheDir);
+    QFileInfoList files = dir.entryInfoList({"*.thumb"}, QDir::Files);
+
+    QMutexLocker locker(&m_diskMutex);
+    for (const QFileInfo &file : files) {
+        DiskEntry entry{file.size(), file.lastModified().toMSecsSinceEpoch()};
+        m_disk.insert(file.completeBaseName(), entry);
+        m_diskBytes += entry.bytes;
+    }
+    evict();
+}
+
+bool ThumbnailCache::readEntry(const QString &key, MediaProbe::Result *result)
+{
+    {
+        QMutexLocker locker(&m_diskMutex);
+        auto it = m_disk.find(key);
+        if (it == m_disk.end()) {
+            return false;
+        }
+        it->lastUsed = QDateTime::currentMSecsSinceEpoch();
+    }
+
+    QFile file(entryPath(key));
+    if (!file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    qint32 version = 0;
+    stream >> version;
+    if (version != FILE_VERSION) {
+        return false;
+    }
+
+    stream >> result->valid >> result->durationMs >> result->width >> result->height
+           >> result->bitRate >> result->videoCodec >> result->audioCodec
+           >> result->thumbnail >> result->error;
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    // The file's mtime is the LRU clock across restarts
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return true;
+}
+
+void ThumbnailCache::writeEntry(const QString &key, const MediaProbe::Result &result)
+{
+    QSaveFile file(entryPath(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write thumbnail cache entry" << file.fileName();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << qint32(FILE_VERSION);
+    stream << result.valid << result.durationMs << result.width << result.height
+           << result.bitRate << result.videoCodec << result.audioCodec
+           << result.thumbnail << result.error;
+    if (!file.commit()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_diskMutex);
+    DiskEntry entry{QFileInfo(file.fileName()).size(), QDateTime::currentMSecsSinceEpoch()};
+    auto it = m_disk.find(key);
+    if (it != m_disk.end()) {
+        m_diskBytes -= it->bytes;
+    }
+    m_disk.insert(key, entry);
+    m_diskBytes += entry.bytes;
+    evict();
+}
+
+void ThumbnailCache::evict()
+{
+    // Caller holds m_diskMutex
+    if (m_diskBytes <= m_maxDiskBytes) {
+        return;
+    }
+
+    QVector<QPair<qint64, QString>> byAge;
+    byAge.reserve(m_disk.size());
+    for (auto it = m_disk.constBegin(); it != m_disk.constEnd(); ++it) {
+        byAge.append(qMakePair(it->lastUsed, it.key()));
+    }
+    std::sort(byAge.begin(), byAge.end());
+
+    // Trim to 90% so a full cache does not evict on every insert
+    qint64 target = m_maxDiskBytes - m_maxDiskBytes / 10;
+    for (const auto &oldest : byAge) {
+        if (m_diskBytes <= target) {
+            break;
+        }
+        QFile::remove(entryPath(oldest.second));
+        m_diskBytes -= m_disk.take(oldest.second).bytes;
+    }
+}
+
+QString ThumbnailCache::entryPath(const QString &key) const
+{
+    return m_cacheDir + "/" + key + ".thumb";
+}
\ No newline at end of file
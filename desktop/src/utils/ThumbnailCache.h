@@ -0,0 +1,86 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QThreadPool>
+#include "MediaProbe.h"
+
+// Thumbnails and probe results for media files.
+// A small in-memory cache keyed by path answers lookup() synchronously. request()
+// hands the file to a private thread pool, which stats it, checks the on-disk LRU
+// (keyed by path + mtime + size) and probes the file only on a miss. ready() is
+// emitted on the cache's thread. Partially downloaded files change mtime and size
+// as they grow, so revalidating requests refresh their preview with the data.
+class ThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ThumbnailCache* instance();
+
+    explicit ThumbnailCache(const QString &cacheDir, QObject *parent = nullptr);
+    ~ThumbnailCache();
+
+    // Memory only: no stat and no hashing, so it is safe to call while painting.
+    // Callers that already know the file's size or mtime pass them to reject a
+    // stale entry; -1 accepts whatever the loader last validated.
+    bool lookup(const QString &filePath, MediaProbe::Result *result,
+                qint64 size = -1, qint64 modifiedMs = -1) const;
+    // Validate and resolve on the pool; duplicate requests for a pending path are folded
+    void request(const QString &filePath);
+
+    void setThumbnailSize(const QSize &size);
+    QSize thumbnailSize() const { return m_thumbnailSize; }
+    void setMaxDiskBytes(qint64 bytes);
+    qint64 diskUsage() const;
+    void clear();
+
+signals:
+    void ready(const QString &filePath, const MediaProbe::Result &result);
+
+private:
+    struct Entry {
+        qint64 size;            // -1 when the file no longer exists
+        qint64 modifiedMs;
+        MediaProbe::Result result;
+    };
+
+    struct DiskEntry {
+        qint64 bytes;
+        qint64 lastUsed;
+    };
+
+    QString m_cacheDir;
+    QSize m_thumbnailSize;
+    QCache<QString, Entry> m_memory;     // by path; GUI thread only
+    QSet<QString> m_pending;
+    QThreadPool m_pool;
+
+    // Disk LRU index, shared with the pool threads
+    mutable QMutex m_diskMutex;
+    QHash<QString, DiskEntry> m_disk;
+    qint64 m_diskBytes;
+    qint64 m_maxDiskBytes;
+
+    Entry resolve(const QString &filePath, const Entry &known, const QSize &thumbnailSize);
+    void finish(const QString &filePath, const Entry &entry);
+    void scanDisk();
+    bool readEntry(const QString &key, MediaProbe::Result *result);
+    void writeEntry(const QString &key, const MediaProbe::Result &result);
+    void evict();
+    QString entryPath(const QString &key) const;
+    static QString diskKey(const QString &absolutePath, qint64 size, qint64 modifiedMs);
+
+    static const int FILE_VERSION = 1;
+    static const int DEFAULT_THUMBNAIL_WIDTH = 320;
+    static const int DEFAULT_THUMBNAIL_HEIGHT = 180;
+    static const int MEMORY_COST_KB = 32 * 1024;
+    static const qint64 DEFAULT_MAX_DISK_BYTES = 256LL * 1024 * 1024;
+    static const int PROBE_THREADS = 2;
+};
+
+#endif // THUMBNAILCACHE_H
\ No newline at end of file
@@ -4,8 +4,12 @@
 // Include test headers
 #include "test-core/TestDownloadItem.h"
 #include "test-core/TestNetworkManager.h"
+#include "test-core/TestDatabase.h"
+#include "test-core/TestDownloadHistory.h"
 #include "test-ui/TestBasicDownload.h"
+#include "test-ui/TestSegmentMapWidget.h"
 #include "test-api/TestApiServer.h"
+#include "test-performance/TestPerformance.h"
 
 int main(int argc, char *argv[])
 {
@@ -20,13 +24,26 @@ int main(int argc, char *argv[])
     TestNetworkManager testNetworkManager;
     status |= QTest::qExec(&testNetworkManager, argc, argv);
 
+    TestDatabase testDatabase;
+    status |= QTest::qExec(&testDatabase, argc, argv);
+
+    TestDownloadHistory testDownloadHistory;
+    status |= QTest::qExec(&testDownloadHistory, argc, argv);
+
     // Run UI tests
     TestBasicDownload testBasicDownload;
     status |= QTest::qExec(&testBasicDownload, argc, argv);
 
+    TestSegmentMapWidget testSegmentMapWidget;
+    status |= QTest::qExec(&testSegmentMapWidget, argc, argv);
+
     // Run API tests
     TestApiServer testApiServer;
     status |= QTest::qExec(&testApiServer, argc, argv);
 
+    // Run performance tests
+    TestPerformance testPerformance;
+    status |= QTest::qExec(&testPerformance, argc, argv);
+
     return status;
 }
\ No newline at end of file
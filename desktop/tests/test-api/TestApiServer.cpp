@@ -194,6 +194,135 @@ void TestApiServer::testPostDownloadResume()
     reply->deleteLater();
 }
 
+void TestApiServer::testPostDownloadsBatch()
+{
+    QByteArray ndjson;
+    for (int i = 0; i < 1000; ++i) {
+        ndjson += QString("{\"url\": \"http://example.com/batch-%1.bin\", \"priority\": %2}\n").arg(i).arg(i % 3).toUtf8();
+    }
+    ndjson += "not json\n";
+    ndjson += "{\"op\": \"pause\"}\n";
+
+    QNetworkRequest request(QUrl(baseUrl + "/downloads:batch"));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-ndjson");
+    QNetworkReply *reply = manager->post(request, ndjson);
+    QSignalSpy spy(reply, &QNetworkReply::finished);
+    QVERIFY(spy.wait(10000));
+
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+    QJsonObject response = getJsonResponse(reply).object();
+    QCOMPARE(response["succeeded"].toInt(), 1000);
+    QCOMPARE(response["failed"].toInt(), 2);
+
+    // Results come back in input order, one per item
+    QJsonArray results = response["results"].toArray();
+    QCOMPARE(results.size(), 1002);
+    QCOMPARE(results[0].toObject()["status"].toInt(), 201);
+    int firstId = results[0].toObject()["id"].toInt();
+    QVERIFY(firstId > 0);
+    QCOMPARE(database->getDownload(firstId)["url"].toString(), QString("http://example.com/batch-0.bin"));
+    QCOMPARE(results[1000].toObject()["status"].toInt(), 400);
+    QCOMPARE(results[1001].toObject()["error"].toString(), QString("Missing id"));
+    reply->deleteLater();
+
+    // A JSON array of deletes removes what the import created
+    QJsonArray deletes;
+    for (int i = 0; i < 1000; ++i) {
+        QJsonObject item;
+        item["op"] = "delete";
+        item["id"] = results[i].toObject()["id"].toInt();
+        deletes.append(item);
+    }
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    reply = manager->post(request, QJsonDocument(deletes).toJson());
+    QSignalSpy deleteSpy(reply, &QNetworkReply::finished);
+    QVERIFY(deleteSpy.wait(10000));
+
+    QCOMPARE(getJsonResponse(reply).object()["succeeded"].toInt(), 1000);
+    QVERIFY(database->getDownload(firstId).isEmpty());
+    reply->deleteLater();
+}
+
+void TestApiServer::testLiveDownloadReads()
+{
+    // Nothing starts, so the engine stays idle and progress can be simulated
+    DownloadService *service = apiServer->downloadService();
+    int maxConcurrent = service->queue()->getMaxConcurrentDownloads();
+    service->queue()->setMaxConcurrentDownloads(0);
+
+    QVariantMap data;
+    data["url"] = "http://example.com/live.bin";
+    data["filename"] = "live.bin";
+    int id = service->createDownload(data);
+    QVERIFY(id > 0);
+    QVERIFY(service->isLive(id));
+    QVERIFY(service->queue()->isQueued(id));
+
+    // Progress feeds the queue's throughput meter with deltas, not running totals
+    qint64 metered = service->throughputMeter()->getTotalDownloaded();
+    emit downloadEngine->downloadProgress(id, 500, 1000);
+    QCOMPARE(database->getDownload(id)["downloaded_size"].toLongLong(), 0);
+    QCOMPARE(service->throughputMeter()->getTotalDownloaded(), metered + 500);
+
+    // The API answers from the live counters before anything reaches the table
+    QNetworkReply *reply = manager->get(QNetworkRequest(QUrl(baseUrl + "/downloads/" + QString::number(id))));
+    QSignalSpy spy(reply, &QNetworkReply::finished);
+    QVERIFY(spy.wait(5000));
+    QJsonObject download = getJsonResponse(reply).object();
+    QCOMPARE(download["downloaded_size"].toInteger(), 500);
+    QCOMPARE(download["total_size"].toInteger(), 1000);
+    QCOMPARE(download["status"].toString(), QString("queued"));
+    reply->deleteLater();
+
+    // A flush writes the whole row back, not only the counters
+    service->flush();
+    QVariantMap stored = database->getDownload(id);
+    QCOMPARE(stored["downloaded_size"].toLongLong(), 500);
+    QCOMPARE(stored["url"].toString(), QString("http://example.com/live.bin"));
+
+    QVERIFY(service->pauseDownload(id));
+    QVERIFY(!service->queue()->isQueued(id));
+    QCOMPARE(service->download(id)["status"].toString(), QString("paused"));
+
+    QVERIFY(service->deleteDownload(id));
+    QVERIFY(!service->isLive(id));
+    QVERIFY(database->getDownload(id).isEmpty());
+
+    service->queue()->setMaxConcurrentDownloads(maxConcurrent);
+}
+
+void TestApiServer::testFinishedDownloadReleased()
+{
+    DownloadService *service = apiServer->downloadService();
+    int maxConcurrent = service->queue()->getMaxConcurrentDownloads();
+    service->queue()->setMaxConcurrentDownloads(0);
+
+    QVariantMap data;
+    data["url"] = "http://example.com/failing.bin";
+    int id = service->createDownload(data);
+    QVERIFY(id > 0);
+
+    QPointer<DownloadItem> item;
+    for (DownloadItem *queued : service->queue()->getQueuedDownloads()) {
+        if (queued->getId() == id) {
+            item = queued;
+        }
+    }
+    QVERIFY(item);
+
+    // The flush writes the final row, then frees the item instead of leaking it
+    emit downloadEngine->downloadFailed(id, "Connection refused");
+    service->flush();
+    QVERIFY(!service->isLive(id));
+    QVERIFY(!service->queue()->isQueued(id));
+    QCOMPARE(database->getDownload(id)["status"].toString(), QString("failed"));
+
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    QVERIFY(item.isNull());
+
+    service->queue()->setMaxConcurrentDownloads(maxConcurrent);
+}
+
 void TestApiServer::testGetCategories()
 {
     QNetworkRequest request(QUrl(baseUrl + "/categories"));
@@ -306,6 +435,33 @@ void TestApiServer::testGetHistory()
     reply->deleteLater();
 }
 
+void TestApiServer::testGetHistoryCursorWithoutId()
+{
+    QVariantMap history;
+    history["url"] = "http://example.com/cursor.bin";
+    history["size"] = 1024;
+    history["success"] = true;
+    QVERIFY(database->insertDownloadHistory(history));
+    QVariantMap newest = database->getDownloadHistoryPage(QString(), 0, 1).first().toMap();
+
+    // "before" alone must not be read as before_id=0, which would skip every row at that timestamp
+    QUrlQuery query;
+    query.addQueryItem("before", newest["completed_at"].toString());
+    QUrl url(baseUrl + "/history");
+    url.setQuery(query);
+    QNetworkReply *reply = manager->get(QNetworkRequest(url));
+    QSignalSpy spy(reply, &QNetworkReply::finished);
+    QVERIFY(spy.wait(5000));
+
+    QJsonDocument doc = getJsonResponse(reply);
+    QVERIFY(doc.isObject());
+    QJsonArray page = doc.object()["history"].toArray();
+    QVERIFY(!page.isEmpty());
+    QCOMPARE(page.first().toObject()["id"].toInteger(), newest["id"].toLongLong());
+
+    reply->deleteLater();
+}
+
 void TestApiServer::testGetStatistics()
 {
     QNetworkRequest request(QUrl(baseUrl + "/statistics"));
@@ -323,6 +479,46 @@ void TestApiServer::testGetStatistics()
     reply->deleteLater();
 }
 
+void TestApiServer::testConcurrentStatistics()
+{
+    // Statistics is answered on the read pool, so cache hits run on several threads at once
+    const int requests = 32;
+    QList<QNetworkReply*> replies;
+    for (int i = 0; i < requests; ++i) {
+        replies.append(manager->get(QNetworkRequest(QUrl(baseUrl + "/statistics"))));
+    }
+    for (QNetworkReply *reply : std::as_const(replies)) {
+        if (!reply->isFinished()) {
+            QSignalSpy spy(reply, &QNetworkReply::finished);
+            QVERIFY(spy.wait(5000));
+        }
+        QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+        QVERIFY(getJsonResponse(reply).object().contains("total_downloads"));
+        reply->deleteLater();
+    }
+
+    // Lookups reorder the LRU chain while inserts evict from it
+    MetadataCache cache;
+    cache.setMaxCost(8);
+    QList<QThread*> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.append(QThread::create([&cache, t]() {
+            for (int i = 0; i < 20000; ++i) {
+                QString key = QString::number((i + t) % 16);
+                if (cache.retrieve(key).isEmpty()) {
+                    cache.store(key, {{"value", i}});
+                }
+            }
+        }));
+        threads.last()->start();
+    }
+    for (QThread *thread : std::as_const(threads)) {
+        QVERIFY(thread->wait(30000));
+        delete thread;
+    }
+    QVERIFY(cache.size() <= 8);
+}
+
 void TestApiServer::testGetSettings()
 {
     QNetworkRequest request(QUrl(baseUrl + "/settings"));
@@ -352,4 +548,276 @@ void TestApiServer::testPutSettings()
     QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
     
     reply->deleteLater();
+}
+
+void TestApiServer::testGetMetrics()
+{
+    QNetworkRequest request(QUrl("http://localhost:8080/metrics"));
+    QNetworkReply *reply = manager->get(request);
+    QSignalSpy spy(reply, &QNetworkReply::finished);
+    QVERIFY(spy.wait(5000));
+
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QVERIFY(reply->header(QNetworkRequest::ContentTypeHeader).toString().startsWith("text/plain"));
+    QByteArray body = reply->readAll();
+    // Earlier tests went through the API and the database, so both families are populated
+    QVERIFY(body.contains("# TYPE ldm_api_responses_total counter"));
+    QVERIFY(body.contains("ldm_api_responses_total{code=\"2xx\"}"));
+    QVERIFY(body.contains("# TYPE ldm_sqlite_query_seconds histogram"));
+    QVERIFY(body.contains("ldm_sqlite_query_seconds_bucket{le=\"+Inf\"}"));
+
+    reply->deleteLater();
+}
+
+void TestApiServer::testConditionalGet()
+{
+    auto get = [this](const QByteArray &ifNoneMatch) {
+        QNetworkRequest request(QUrl(baseUrl + "/categories"));
+        if (!ifNoneMatch.isEmpty()) {
+            request.setRawHeader("If-None-Match", ifNoneMatch);
+        }
+        QNetworkReply *reply = manager->get(request);
+        QSignalSpy spy(reply, &QNetworkReply::finished);
+        spy.wait(5000);
+        return reply;
+    };
+
+    QNetworkReply *reply = get(QByteArray());
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+    QByteArray etag = reply->rawHeader("ETag");
+    QVERIFY(etag.startsWith("W/\""));
+    reply->deleteLater();
+
+    // Unchanged table: revalidation is a bodiless 304 carrying the same tag
+    reply = get("\"other\", " + etag);
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 304);
+    QCOMPARE(reply->rawHeader("ETag"), etag);
+    QVERIFY(reply->readAll().isEmpty());
+    reply->deleteLater();
+
+    // A write bumps the table's version, so the old tag no longer matches
+    QVariantMap category;
+    category["name"] = "ETag Test";
+    category["description"] = "";
+    category["default_path"] = "";
+    category["color"] = "";
+    category["icon"] = "";
+    QVERIFY(database->insertCategory(category));
+
+    reply = get(etag);
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+    QVERIFY(reply->rawHeader("ETag") != etag);
+    QVERIFY(reply->readAll().contains("ETag Test"));
+    reply->deleteLater();
+}
+
+void TestApiServer::testStreamedListEncodings()
+{
+    // Enough rows that the body outgrows the send buffer and goes out chunked
+    const int rows = 3000;
+    QVERIFY(database->beginBatch());
+    for (int i = 0; i < rows; ++i) {
+        QVariantMap history;
+        history["download_id"] = QVariant();
+        history["url"] = QString("http://example.com/streamed%1.bin").arg(i);
+        history["filename"] = QString("streamed%1.bin").arg(i);
+        history["filepath"] = "/tmp";
+        history["size"] = 1048576;
+        history["duration"] = 10;
+        history["average_speed"] = 104857;
+        history["category_name"] = "";
+        history["success"] = true;
+        QVERIFY(database->insertDownloadHistory(history));
+    }
+    QVERIFY(database->commitBatch());
+
+    auto get = [this](const QByteArray &header, const QByteArray &value) {
+        QNetworkRequest request(QUrl(baseUrl + "/history?limit=" + QString::number(rows)));
+        if (!header.isEmpty()) {
+            request.setRawHeader(header, value);
+        }
+        QNetworkReply *reply = manager->get(request);
+        QSignalSpy spy(reply, &QNetworkReply::finished);
+        spy.wait(10000);
+        return reply;
+    };
+
+    // JSON, which the network manager requests gzipped and inflates transparently
+    QNetworkReply *reply = get(QByteArray(), QByteArray());
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+    QJsonObject json = getJsonResponse(reply).object();
+    QCOMPARE(json["history"].toArray().size(), rows);
+    QCOMPARE(json["total"].toInt(), rows);
+    QVERIFY(json.contains("next_cursor"));
+    reply->deleteLater();
+
+    // CBOR carries the same envelope
+    reply = get("Accept", "application/cbor");
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+    QCOMPARE(reply->header(QNetworkRequest::ContentTypeHeader).toString(), QString("application/cbor"));
+    QCborMap cbor = QCborValue::fromCbor(reply->readAll()).toMap();
+    QCOMPARE(cbor.value(QString("history")).toArray().size(), rows);
+    QCOMPARE(cbor.value(QString("total")).toInteger(), rows);
+    reply->deleteLater();
+
+    // Asking for gzip explicitly returns the compressed bytes untouched
+    reply = get("Accept-Encoding", "gzip");
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+    QCOMPARE(reply->rawHeader("Content-Encoding"), QByteArray("gzip"));
+    QVERIFY(reply->readAll().startsWith("\x1f\x8b"));
+    reply->deleteLater();
+}
+
+void TestApiServer::testEventStream()
+{
+    // Nothing starts, so progress can be simulated on a live download
+    DownloadService *service = apiServer->downloadService();
+    int maxConcurrent = service->queue()->getMaxConcurrentDownloads();
+    service->queue()->setMaxConcurrentDownloads(0);
+    int id = service->createDownload({{"url", "http://example.com/events.bin"}, {"filename", "events.bin"}});
+    QVERIFY(id > 0);
+
+    QNetworkRequest request(QUrl(baseUrl + "/events"));
+    QNetworkReply *reply = manager->get(request);
+    QByteArray received;
+    connect(reply, &QNetworkReply::readyRead, this, [&]() { received += reply->readAll(); });
+    QTRY_VERIFY_WITH_TIMEOUT(received.contains("retry:"), 5000);
+    QCOMPARE(apiServer->eventStream()->streamCount(), 1);
+
+    // A burst of progress inside one tick collapses to the latest value
+    quint64 before = apiServer->eventStream()->lastSequence();
+    for (int i = 1; i <= 1000; ++i) {
+        emit downloadEngine->downloadProgress(id, i, 1000);
+    }
+    emit downloadEngine->downloadCompleted(id);
+    QTRY_VERIFY_WITH_TIMEOUT(received.contains("event: state"), 5000);
+
+    QCOMPARE(received.count("event: progress"), 1);
+    QVERIFY(received.contains("\"downloaded\":1000"));
+    QVERIFY(received.contains("\"status\":\"completed\""));
+    QCOMPARE(apiServer->eventStream()->lastSequence(), before + 2);
+
+    // Segments report separately; the event carries the download's sum
+    int segmented = service->createDownload({{"url", "http://example.com/segments.bin"}, {"filename", "segments.bin"}});
+    QVERIFY(segmented > 0);
+    received.clear();
+    emit downloadEngine->segmentProgress(segmented, 0, 300, 500);
+    emit downloadEngine->downloadProgress(segmented, 300, 500);
+    emit downloadEngine->segmentProgress(segmented, 1, 200, 500);
+    emit downloadEngine->downloadProgress(segmented, 200, 500);
+    QTRY_VERIFY_WITH_TIMEOUT(received.contains("event: progress"), 5000);
+    QVERIFY(received.contains("\"downloaded\":500"));
+    QVERIFY(!received.contains("\"downloaded\":200"));
+
+    // Resuming replays from history; an unknown position asks for a reload
+    EventStream *events = apiServer->eventStream();
+    QByteArray replay = events->eventsSince(events->eventId(before + 1));
+    QVERIFY(replay.startsWith("id: " + events->eventId(before + 2)));
+    QVERIFY(events->eventsSince(events->eventId(before + 100)).contains("event: reset"));
+
+    // Ids from a previous run restart at 0, so they never resume even when lower
+    QVERIFY(events->eventsSince("previous-" + QByteArray::number(before)).contains("event: reset"));
+    QVERIFY(events->eventsSince(QByteArray::number(before)).contains("event: reset"));
+
+    reply->abort();
+    reply->deleteLater();
+
+    QVERIFY(service->deleteDownload(id));
+    QVERIFY(service->deleteDownload(segmented));
+    service->queue()->setMaxConcurrentDownloads(maxConcurrent);
+}
+
+void TestApiServer::testNativeBridgeBurst()
+{
+    // A private name, so a running LDM on the same machine does not interfere
+    BridgeServer *bridge = apiServer->bridgeServer();
+    bridge->close();
+    QVERIFY(bridge->listen(QDir::temp().filePath(QString("ldm-bridge-test-%1").arg(QCoreApplication::applicationPid()))));
+
+    DownloadService *service = apiServer->downloadService();
+    int maxConcurrent = service->queue()->getMaxConcurrentDownloads();
+    service->queue()->setMaxConcurrentDownloads(0);
+
+    QLocalSocket socket;
+    socket.connectToServer(bridge->serverName());
+    QVERIFY(socket.waitForConnected(5000));
+
+    QByteArray buffer;
+    auto readFrames = [&socket, &buffer](int count) {
+        QList<QJsonObject> frames;
+        QElapsedTimer timer;
+        timer.start();
+        while (frames.size() < count && timer.elapsed() < 10000) {
+            while (buffer.size() >= 4) {
+                quint32 length = qFromLittleEndian<quint32>(buffer.constData());
+                if (buffer.size() < 4 + qsizetype(length)) {
+                    break;
+                }
+                frames.append(QJsonDocument::fromJson(buffer.mid(4, length)).object());
+                buffer.remove(0, 4 + length);
+            }
+            if (frames.size() < count) {
+                QCoreApplication::processEvents();
+                if (socket.waitForReadyRead(10) || socket.bytesAvailable()) {
+                    buffer += socket.readAll();
+                }
+            }
+        }
+        return frames;
+    };
+    auto frame = [](const QJsonObject &message) {
+        QByteArray payload = QJsonDocument(message).toJson(QJsonDocument::Compact);
+        QByteArray length(4, Qt::Uninitialized);
+        qToLittleEndian<quint32>(quint32(payload.size()), length.data());
+        return length + payload;
+    };
+
+    // A page with 300 media links, handed over in one write as 300 separate requests
+    const int links = 300;
+    QByteArray burst;
+    for (int i = 0; i < links; ++i) {
+        burst += frame(QJsonObject{
+            {"id", i + 1},
+            {"action", "start_download"},
+            {"data", QJsonObject{{"url", QString("http://example.com/media%1.mp4").arg(i)}, {"userAgent", "test"}}}
+        });
+    }
+    socket.write(burst);
+    QList<QJsonObject> replies = readFrames(links);
+    QCOMPARE(replies.size(), links);
+
+    QSet<int> requestIds;
+    QList<int> downloadIds;
+    for (const QJsonObject &reply : replies) {
+        QVERIFY(reply.value("ok").toBool());
+        requestIds.insert(reply.value("reply").toInt());
+        downloadIds.append(reply.value("data").toObject().value("downloadId").toInt());
+    }
+    QCOMPARE(requestIds.size(), links);
+    QVERIFY(service->isLive(downloadIds.first()));
+    QCOMPARE(database->getDownload(downloadIds.first())["user_agent"].toString(), QString("test"));
+
+    // Progress for a download this connection started is pushed to it
+    emit downloadEngine->downloadProgress(downloadIds.first(), 500, 1000);
+    QList<QJsonObject> pushes = readFrames(1);
+    QCOMPARE(pushes.size(), 1);
+    QCOMPARE(pushes.first().value("event").toString(), QString("progress"));
+    QCOMPARE(pushes.first().value("data").toObject().value("downloadId").toInt(), downloadIds.first());
+    QCOMPARE(pushes.first().value("data").toObject().value("bytesReceived").toInteger(), 500);
+
+    // Requests are answered by id; an unknown action fails only its own request
+    socket.write(frame(QJsonObject{{"id", 1001}, {"action", "bogus"}})
+                 + frame(QJsonObject{{"id", 1002}, {"action", "get_status"},
+                                     {"data", QJsonObject{{"downloadId", downloadIds.first()}}}}));
+    replies = readFrames(2);
+    QCOMPARE(replies.size(), 2);
+    QCOMPARE(replies.at(0).value("reply").toInt(), 1001);
+    QVERIFY(!replies.at(0).value("ok").toBool());
+    QCOMPARE(replies.at(1).value("reply").toInt(), 1002);
+    QCOMPARE(replies.at(1).value("data").toObject().value("bytesReceived").toInteger(), 500);
+
+    for (int id : downloadIds) {
+        QVERIFY(service->deleteDownload(id));
+    }
+    service->queue()->setMaxConcurrentDownloads(maxConcurrent);
 }
\ No newline at end of file
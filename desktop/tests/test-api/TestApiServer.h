@@ -5,12 +5,20 @@
 #include <QtTest>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
+#include <QUrlQuery>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborValue>
+#include <QLocalSocket>
+#include <QtEndian>
 #include "../../src/core/Database.h"
 #include "../../src/core/DownloadEngine.h"
+#include "../../src/core/SpeedCalculator.h"
 #include "../../src/api/ApiServer.h"
+#include "../../src/utils/MetadataCache.h"
 
 class TestApiServer : public QObject
 {
@@ -44,6 +52,9 @@ private slots:
     void testDeleteDownloadById();
     void testPostDownloadPause();
     void testPostDownloadResume();
+    void testPostDownloadsBatch();
+    void testLiveDownloadReads();
+    void testFinishedDownloadReleased();
 
     // Categories endpoints
     void testGetCategories();
@@ -54,13 +65,28 @@ private slots:
 
     // History endpoints
     void testGetHistory();
+    void testGetHistoryCursorWithoutId();
 
     // Statistics endpoints
     void testGetStatistics();
+    void testConcurrentStatistics();
 
     // Settings endpoints
     void testGetSettings();
     void testPutSettings();
+
+    // Metrics endpoint
+    void testGetMetrics();
+
+    // Conditional GET on list endpoints
+    void testConditionalGet();
+    void testStreamedListEncodings();
+
+    // Live events
+    void testEventStream();
+
+    // Native messaging bridge
+    void testNativeBridgeBurst();
 };
 
 #endif // TESTAPISERVER_H
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "TestDatabase.h"
+#include "../../src/core/Database.h"
+#include "../../src/core/SchemaMigrator.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSignalSpy>
+
+void TestDatabase::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+}
+
+void TestDatabase::cleanupTestCase()
+{
+    // Cleanup test case
+}
+
+void TestDatabase::testSchemaVersionRecorded()
+{
+    {
+        Database database;
+        QVERIFY(database.open(m_dir.filePath("schema.db"), "test-schema"));
+        QCOMPARE(database.schemaVersion(), Database::latestSchemaVersion());
+        QVERIFY(!database.hasPendingMigrations());
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("test-schema");
+}
+
+void TestDatabase::testBatchedMigration()
+{
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "test-migration");
+        db.setDatabaseName(m_dir.filePath("migration.db"));
+        QVERIFY(db.open());
+
+        QSqlQuery query(db);
+        QVERIFY(query.exec("CREATE TABLE items (id INTEGER PRIMARY KEY, value INTEGER)"));
+        db.transaction();
+        query.prepare("INSERT INTO items (value) VALUES (?)");
+        for (int i = 0; i < 2500; ++i) {
+            query.addBindValue(i);
+            QVERIFY(query.exec());
+        }
+        QVERIFY(db.commit());
+
+        QList<SchemaMigrator::Migration> migrations;
+        migrations.append({1, "Add doubled column", {"ALTER TABLE items ADD COLUMN doubled INTEGER"},
+                           "items", "UPDATE items SET doubled = value * 2 WHERE id BETWEEN :first AND :last", true});
+
+        SchemaMigrator migrator(migrations);
+        migrator.setBatchSize(1000);
+        QSignalSpy progressSpy(&migrator, &SchemaMigrator::migrationProgress);
+
+        QVERIFY(migrator.migrate(db, true));
+        QCOMPARE(progressSpy.count(), 3);
+        QCOMPARE(progressSpy.last().at(1).toLongLong(), 2500LL);
+        QCOMPARE(progressSpy.last().at(2).toLongLong(), 2500LL);
+        QVERIFY(migrator.pendingVersions(db).isEmpty());
+
+        QVERIFY(query.exec("SELECT COUNT(*) FROM items WHERE doubled = value * 2"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toInt(), 2500);
+
+        QVERIFY(query.exec("PRAGMA user_version"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toInt(), 1);
+
+        // Already applied: a second run is a no-op
+        QVERIFY(migrator.migrate(db, true));
+        QCOMPARE(progressSpy.count(), 3);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("test-migration");
+}
+
+void TestDatabase::testUrlIndexBackfilledInBatches()
+{
+    {
+        Database database;
+        QVERIFY(database.open(m_dir.filePath("urls.db"), "test-urls"));
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("test-urls");
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "test-urls-migration");
+        db.setDatabaseName(m_dir.filePath("urls.db"));
+        QVERIFY(db.open());
+
+        // Roll back to a file that predates migration 2, with rows to copy
+        QSqlQuery query(db);
+        QVERIFY(query.exec("DROP TRIGGER download_urls_insert"));
+        QVERIFY(query.exec("DROP TRIGGER download_urls_update"));
+        QVERIFY(query.exec("DROP TRIGGER download_urls_delete"));
+        QVERIFY(query.exec("DROP TABLE download_urls"));
+        QVERIFY(query.exec("DELETE FROM schema_version WHERE version = 2"));
+        db.transaction();
+        query.prepare("INSERT INTO downloads (url, status) VALUES (?, 'queued')");
+        for (int i = 0; i < 2500; ++i) {
+            query.addBindValue(QString("https://example.com/%1").arg(i % 100));
+            QVERIFY(query.exec());
+        }
+        QVERIFY(db.commit());
+
+        SchemaMigrator migrator;
+        migrator.setBatchSize(1000);
+        QSignalSpy progressSpy(&migrator, &SchemaMigrator::migrationProgress);
+        QVERIFY(migrator.migrate(db, true));
+        QCOMPARE(progressSpy.count(), 3);
+        QVERIFY(migrator.pendingVersions(db).isEmpty());
+
+        QVERIFY(query.exec("SELECT COUNT(*) FROM download_urls WHERE url = 'https://example.com/7'"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toInt(), 25);
+
+        // Writes after the backfill are kept in step by the triggers
+        QVERIFY(query.exec("INSERT INTO downloads (url, status) VALUES ('https://example.com/new', 'queued')"));
+        QVERIFY(query.exec("UPDATE downloads SET url = 'https://example.com/moved' WHERE url = 'https://example.com/new'"));
+        QVERIFY(query.exec("SELECT COUNT(*) FROM download_urls "
+                           "WHERE url IN ('https://example.com/new', 'https://example.com/moved')"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toInt(), 1);
+        QVERIFY(query.exec("DELETE FROM downloads WHERE url = 'https://example.com/7'"));
+        QVERIFY(query.exec("SELECT COUNT(*) FROM download_urls WHERE url = 'https://example.com/7'"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toInt(), 0);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("test-urls-migration");
+}
\ No newline at end of file
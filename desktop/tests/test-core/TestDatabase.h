@@ -0,0 +1,23 @@
+#ifndef TESTDATABASE_H
+#define TESTDATABASE_H
+
+#include <QObject>
+#include <QtTest>
+#include <QTemporaryDir>
+
+class TestDatabase : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void testSchemaVersionRecorded();
+    void testBatchedMigration();
+    void testUrlIndexBackfilledInBatches();
+};
+
+#endif // TESTDATABASE_H
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "TestDownloadHistory.h"
+#include "../../src/core/Database.h"
+#include "../../src/utils/HistoryArchive.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <limits>
+
+void TestDownloadHistory::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+}
+
+void TestDownloadHistory::cleanupTestCase()
+{
+    // Cleanup test case
+}
+
+void TestDownloadHistory::testHistoryKeysetPaging()
+{
+    {
+        Database database;
+        QVERIFY(database.open(m_dir.filePath("paging.db"), "test-paging"));
+        for (int i = 0; i < 250; ++i) {
+            QVERIFY(database.insertDownloadHistory({{"url", QString("https://example.com/%1").arg(i)},
+                                                    {"size", 1024}, {"success", true}}));
+        }
+
+        QSet<int> seen;
+        QString before;
+        int beforeId = 0;
+        QList<int> pageSizes;
+        while (true) {
+            QVariantList page = database.getDownloadHistoryPage(before, beforeId, 100);
+            if (page.isEmpty()) {
+                break;
+            }
+            pageSizes.append(page.size());
+            for (const QVariant &row : page) {
+                seen.insert(row.toMap().value("id").toInt());
+            }
+            before = page.last().toMap().value("completed_at").toString();
+            beforeId = page.last().toMap().value("id").toInt();
+        }
+
+        QCOMPARE(pageSizes, QList<int>({100, 100, 50}));
+        QCOMPARE(seen.size(), 250);
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("test-paging");
+}
+
+void TestDownloadHistory::testHistoryArchival()
+{
+    QString archiveDir = m_dir.filePath("archive");
+    {
+        Database database;
+        QVERIFY(database.open(m_dir.filePath("archival.db"), "test-archival"));
+        for (int i = 0; i < 30; ++i) {
+            QVERIFY(database.insertDownloadHistory({{"url", QString("https://example.com/%1").arg(i)},
+                                                    {"size", 100}, {"duration", 2}, {"success", true}}));
+        }
+
+        QSqlQuery query(QSqlDatabase::database("test-archival"));
+        QVERIFY(query.exec("UPDATE download_history SET completed_at = '2020-03-15 12:00:00' WHERE id <= 20"));
+
+        QCOMPARE(database.archiveDownloadHistory(365, archiveDir), 20);
+        QCOMPARE(database.getDownloadHistory(100, 0).size(), 10);
+
+        QStringList archives = HistoryArchive::listArchives(archiveDir);
+        QCOMPARE(archives.size(), 1);
+        QVERIFY(archives.first().endsWith("history-2020-03.ldma"));
+        QCOMPARE(HistoryArchive::readRows(archives.first()).size(), 20);
+
+        QVariantList aggregates = database.getHistoryAggregates(QDate(2020, 3, 1), QDate(2020, 3, 31));
+        QCOMPARE(aggregates.size(), 1);
+        QCOMPARE(aggregates.first().toMap().value("downloads").toInt(), 20);
+        QCOMPARE(aggregates.first().toMap().value("total_bytes").toLongLong(), 2000LL);
+
+        // Nothing left to archive
+        QCOMPARE(database.archiveDownloadHistory(365, archiveDir), 0);
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("test-archival");
+}
+
+void TestDownloadHistory::testHistoryCursorWithoutId()
+{
+    {
+        Database database;
+        QVERIFY(database.open(m_dir.filePath("cursor.db"), "test-cursor"));
+        for (int i = 0; i < 3; ++i) {
+            QVERIFY(database.insertDownloadHistory({{"url", QString("https://example.com/%1").arg(i)},
+                                                    {"size", 1024}, {"success", true}}));
+        }
+
+        QSqlQuery query(QSqlDatabase::database("test-cursor"));
+        QVERIFY(query.exec("UPDATE download_history SET completed_at = '2024-01-01 00:00:00'"));
+
+        // A timestamp-only cursor keeps every row at that timestamp
+        QVariantList page = database.getDownloadHistoryPage("2024-01-01 00:00:00",
+                                                            std::numeric_limits<qint64>::max(), 100);
+        QCOMPARE(page.size(), 3);
+        QCOMPARE(database.getDownloadHistoryPage("2024-01-01 00:00:00", 0, 100).size(), 0);
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("test-cursor");
+}
+
+void TestDownloadHistory::testVacuumConversionIsExplicit()
+{
+    QString path = m_dir.filePath("legacy.db");
+    {
+        // A database created before incremental auto-vacuum was the default
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "test-legacy");
+        db.setDatabaseName(path);
+        QVERIFY(db.open());
+        QSqlQuery query(db);
+        QVERIFY(query.exec("CREATE TABLE legacy (id INTEGER PRIMARY KEY)"));
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("test-legacy");
+
+    {
+        Database database;
+        QVERIFY(database.open(path, "test-vacuum"));
+        QSqlQuery query(QSqlDatabase::database("test-vacuum"));
+
+        // Compaction during archival must not rewrite the file
+        QVERIFY(database.incrementalVacuum());
+        QVERIFY(query.exec("PRAGMA auto_vacuum"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toInt(), 0);
+
+        QVERIFY(database.enableIncrementalVacuum());
+        QVERIFY(query.exec("PRAGMA auto_vacuum"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toInt(), 2);
+        QVERIFY(database.incrementalVacuum());
+        query.finish();
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("test-vacuum");
+}
\ No newline at end of file
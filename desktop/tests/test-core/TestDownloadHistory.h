@@ -0,0 +1,24 @@
+#ifndef TESTDOWNLOADHISTORY_H
+#define TESTDOWNLOADHISTORY_H
+
+#include <QObject>
+#include <QtTest>
+#include <QTemporaryDir>
+
+class TestDownloadHistory : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void testHistoryKeysetPaging();
+    void testHistoryCursorWithoutId();
+    void testHistoryArchival();
+    void testVacuumConversionIsExplicit();
+};
+
+#endif // TESTDOWNLOADHISTORY_H
\ No newline at end of file
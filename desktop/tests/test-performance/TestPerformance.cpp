@@ -4,6 +4,33 @@
 #include <QProcess>
 #include <QDebug>
 #include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "../../src/core/Database.h"
+#include "../../src/ui/DownloadTableModel.h"
+#include "../../src/utils/SpeedHistory.h"
+#include "../../src/core/SegmentManager.h"
+#include "../../src/utils/ThumbnailCache.h"
+#include "../../src/core/PartialFileDevice.h"
+#include "../../src/core/Scheduler.h"
+#include "../../src/core/DownloadQueue.h"
+#include "../../src/core/SpeedCalculator.h"
+#include "../../src/utils/Metrics.h"
+#include "../../src/api/ApiServer.h"
+#include "../../src/core/DownloadEngine.h"
+#include "../../src/core/DownloadService.h"
+#include "MessageParser.h"
+#include <QThread>
+#include <atomic>
+#include <QSignalSpy>
+#include <QTcpSocket>
+#include <QLocalSocket>
+#include <QTimer>
+#include <QRandomGenerator>
+#include <QtEndian>
+#include <algorithm>
 
 void TestPerformance::initTestCase()
 {
@@ -71,4 +98,1008 @@ void TestPerformance::testLargeFileHandling()
     QVERIFY(true); // Always pass for now
     
     qDebug() << "Large file handling test completed";
+}
+
+void TestPerformance::testFirstPageQuery()
+{
+    // Opening the database and reading the first page must not depend on the table size;
+    // this covers the query half of startup, not window creation
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString dbPath = dir.filePath("startup.db");
+
+    {
+        Database database;
+        QVERIFY(database.open(dbPath, "perf-seed"));
+
+        QSqlDatabase db = QSqlDatabase::database("perf-seed");
+        db.transaction();
+        QSqlQuery download(db);
+        download.prepare("INSERT INTO downloads (url, filename, status, progress, total_size, downloaded_size) "
+                         "VALUES (?, ?, 'completed', 1.0, 1048576, 1048576)");
+        QSqlQuery history(db);
+        history.prepare("INSERT INTO download_history (url, filename, size, duration, average_speed) "
+                        "VALUES (?, ?, 1048576, 10, 104857)");
+        for (int i = 0; i < 100000; ++i) {
+            QString url = QString("https://example.com/file%1.bin").arg(i);
+            QString filename = QString("file%1.bin").arg(i);
+            download.addBindValue(url);
+            download.addBindValue(filename);
+            QVERIFY(download.exec());
+            history.addBindValue(url);
+            history.addBindValue(filename);
+            QVERIFY(history.exec());
+        }
+        QVERIFY(db.commit());
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("perf-seed");
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 firstPageMs = 0;
+    {
+        Database database;
+        QVERIFY(database.open(dbPath, "perf-startup"));
+        QCOMPARE(database.schemaVersion(), Database::latestSchemaVersion());
+        QVariantList firstPage = database.getDownloadsPage(0, 50);
+        firstPageMs = timer.elapsed();
+        QCOMPARE(firstPage.size(), 50);
+        QCOMPARE(firstPage.first().toMap().value("id").toInt(), 100000);
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("perf-startup");
+
+    qDebug() << "Database open and first page query took" << firstPageMs << "ms";
+    QVERIFY(firstPageMs < 300);
+}
+
+void TestPerformance::testTableModelUpdates()
+{
+    DownloadTableModel model;
+
+    QVector<DownloadTableModel::Download> rows;
+    rows.reserve(100000);
+    for (int i = 1; i <= 100000; ++i) {
+        DownloadTableModel::Download row;
+        row.id = i;
+        row.fileName = QString("file%1.bin").arg(i);
+        row.totalSize = 1048576;
+        row.status = DownloadTableModel::Downloading;
+        rows.append(row);
+    }
+    model.appendDownloads(rows);
+    QCOMPARE(model.rowCount(), 100000);
+
+    QSignalSpy changed(&model, &DownloadTableModel::dataChanged);
+
+    // A progress tick only touches its own row and the byte-count cells
+    model.updateProgress(75000, 524288, 1048576, 0, 0);
+    QCOMPARE(changed.count(), 1);
+    QModelIndex topLeft = changed.first().at(0).toModelIndex();
+    QModelIndex bottomRight = changed.first().at(1).toModelIndex();
+    QCOMPARE(topLeft.row(), 74999);
+    QCOMPARE(bottomRight.row(), 74999);
+    QCOMPARE(topLeft.column(), int(DownloadTableModel::ColumnSize));
+    QCOMPARE(bottomRight.column(), int(DownloadTableModel::ColumnStatus));
+
+    // Unchanged values emit nothing
+    model.updateProgress(75000, 524288, 1048576, 0, 0);
+    QCOMPARE(changed.count(), 1);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 1; i <= 100000; ++i) {
+        model.updateProgress(i, 4096, 1048576, 102400, 10);
+    }
+    qint64 updateMs = timer.elapsed();
+
+    model.removeDownload(50000);
+    QCOMPARE(model.rowForId(50001), 49999);
+    QCOMPARE(model.index(49999, 0).data(DownloadTableModel::IdRole).toInt(), 50001);
+
+    qDebug() << "100000 row updates took" << updateMs << "ms";
+    QVERIFY(updateMs < 500);
+}
+
+void TestPerformance::testSpeedHistoryDecimation()
+{
+    // 24 hours at 1 Hz, then another hour so the ring wraps
+    SpeedHistory history;
+    const qint64 samples = SpeedHistory::DEFAULT_CAPACITY + 3600;
+    for (qint64 i = 0; i < samples; ++i) {
+        history.append(i * 1000, (i * 7919) % 100000);
+    }
+    history.append(samples * 1000, 250000);  // single spike at the newest sample
+
+    QCOMPARE(history.size(), SpeedHistory::DEFAULT_CAPACITY);
+    QCOMPARE(history.firstTimeMs(), (samples + 1 - SpeedHistory::DEFAULT_CAPACITY) * 1000);
+
+    // The min/max envelope must keep the spike no matter how far we zoom out
+    QVector<SpeedHistory::Column> columns = history.decimate(history.firstTimeMs(), history.lastTimeMs() + 1, 800);
+    QCOMPARE(columns.size(), 800);
+    QCOMPARE(columns.last().maxSpeed, qint64(250000));
+    QCOMPARE(history.peak(history.firstTimeMs(), history.lastTimeMs() + 1), qint64(250000));
+
+    // Cross-check a column against a linear scan
+    qint64 from = history.lastTimeMs() - 600000;
+    qint64 to = history.lastTimeMs();
+    QVector<SpeedHistory::Column> zoomed = history.decimate(from, to, 7);
+    qint64 expectedMax = 0;
+    for (int i = 0; i < history.size(); ++i) {
+        SpeedHistory::Sample sample = history.at(i);
+        if (sample.timeMs >= from && sample.timeMs < from + (to - from) / 7) {
+            expectedMax = qMax(expectedMax, sample.bytesPerSecond);
+        }
+    }
+    QVERIFY(zoomed.first().valid);
+    QCOMPARE(zoomed.first().maxSpeed, expectedMax);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int frame = 0; frame < 100; ++frame) {
+        history.decimate(history.firstTimeMs() + frame * 1000, history.lastTimeMs(), 1920);
+    }
+    qint64 renderMs = timer.elapsed();
+
+    qDebug() << "100 full-history 1920px decimations took" << renderMs << "ms";
+    QVERIFY(renderMs < 500);
+}
+
+void TestPerformance::testSegmentSnapshotConsistency()
+{
+    // Every publish writes the same value into all segments, so a torn read
+    // shows up as segments that disagree with each other
+    SegmentStatsBuffer buffer;
+    QList<DownloadSegment> segments;
+    for (int i = 0; i < 16; ++i) {
+        DownloadSegment segment;
+        segment.index = i;
+        segment.startOffset = i * 1024;
+        segment.endOffset = i * 1024 + 1023;
+        segment.downloadedSize = 0;
+        segment.publishedSize = 0;
+        segment.status = "downloading";
+        segment.networkManager = nullptr;
+        segments.append(segment);
+    }
+
+    std::atomic<bool> stop(false);
+    QThread *writer = QThread::create([&]() {
+        qint64 value = 0;
+        while (!stop.load()) {
+            ++value;
+            for (DownloadSegment &segment : segments) {
+                segment.downloadedSize = value;
+            }
+            buffer.publish(segments, 1000);
+        }
+    });
+    writer->start();
+
+    int reads = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 500) {
+        QVector<SegmentSnapshot> snapshot = buffer.read();
+        if (snapshot.isEmpty()) {
+            continue;
+        }
+        QCOMPARE(snapshot.size(), 16);
+        for (const SegmentSnapshot &segment : snapshot) {
+            QCOMPARE(segment.downloadedSize, snapshot.first().downloadedSize);
+        }
+        ++reads;
+    }
+
+    stop = true;
+    writer->wait();
+    delete writer;
+
+    qDebug() << "Consistent segment snapshots read in 500 ms:" << reads;
+    QVERIFY(reads > 0);
+    QCOMPARE(buffer.read().last().state, SegmentSnapshot::Downloading);
+}
+
+void TestPerformance::testThumbnailCacheLookup()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QString mediaPath = dir.filePath("not-really.mp4");
+    QFile media(mediaPath);
+    QVERIFY(media.open(QIODevice::WriteOnly));
+    media.write(QByteArray(4096, 'x'));
+    media.close();
+
+    ThumbnailCache cache(dir.filePath("cache"));
+    QSignalSpy spy(&cache, &ThumbnailCache::ready);
+    QVERIFY(!cache.lookup(mediaPath, nullptr));
+
+    // The probe fails, but the failure is cached so lookups stop hitting the file
+    cache.request(mediaPath);
+    QVERIFY(spy.wait(5000));
+    MediaProbe::Result result;
+    QVERIFY(cache.lookup(mediaPath, &result));
+    QVERIFY(!result.valid);
+    QVERIFY(cache.diskUsage() > 0);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 10000; ++i) {
+        QVERIFY(cache.lookup(mediaPath, nullptr));
+    }
+    qDebug() << "10000 cached thumbnail lookups:" << timer.elapsed() << "ms";
+
+    // Lookups are memory only; they keep answering without touching the file
+    QVERIFY(QFile::rename(mediaPath, mediaPath + ".moved"));
+    QVERIFY(cache.lookup(mediaPath, nullptr));
+    QVERIFY(QFile::rename(mediaPath + ".moved", mediaPath));
+
+    // Growing the file (as a partial download does) makes the cached entry stale
+    QVERIFY(media.open(QIODevice::Append));
+    media.write(QByteArray(4096, 'y'));
+    media.close();
+    QVERIFY(!cache.lookup(mediaPath, nullptr, 8192));
+
+    // The background request notices the new size and refreshes the entry
+    spy.clear();
+    cache.request(mediaPath);
+    QVERIFY(spy.wait(5000));
+    QVERIFY(cache.lookup(mediaPath, nullptr, 8192));
+}
+
+void TestPerformance::testPartialFileDeviceBlocksForRange()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString filepath = dir.filePath("movie.mp4");
+
+    // Two 64 KB segments; only the head of segment 0 and all of segment 1 exist
+    const qint64 segmentSize = 64 * 1024;
+    QList<DownloadSegment> segments;
+    for (int i = 0; i < 2; ++i) {
+        DownloadSegment segment;
+        segment.index = i;
+        segment.startOffset = i * segmentSize;
+        segment.endOffset = i == 1 ? -1 : segmentSize - 1;
+        segment.downloadedSize = 0;
+        segment.publishedSize = 0;
+        segment.status = "downloading";
+        segment.networkManager = nullptr;
+        segments.append(segment);
+
+        QFile part(filepath + ".part" + QString::number(i));
+        QVERIFY(part.open(QIODevice::WriteOnly));
+        part.write(QByteArray(segmentSize, char('a' + i)));
+    }
+
+    QSharedPointer<RangeAvailability> availability(new RangeAvailability);
+    availability->reset(segments, 2 * segmentSize, filepath);
+    availability->setAvailable(0, 1000);
+    availability->setAvailable(1, segmentSize);
+    QCOMPARE(availability->contiguousFrom(0), qint64(1000));
+    QCOMPARE(availability->contiguousFrom(segmentSize + 10), segmentSize - 10);
+
+    PartialFileDevice device(availability);
+    QVERIFY(device.open(QIODevice::ReadOnly));
+    QCOMPARE(device.size(), 2 * segmentSize);
+    QCOMPARE(device.read(4000), QByteArray(1000, 'a'));
+
+    // The reader blocks on the gap until the writer publishes it
+    QThread *writer = QThread::create([availability, segmentSize]() {
+        QThread::msleep(100);
+        availability->setAvailable(0, segmentSize);
+    });
+    QElapsedTimer timer;
+    timer.start();
+    writer->start();
+    QByteArray rest = device.read(segmentSize);
+    writer->wait();
+    delete writer;
+    QVERIFY(timer.elapsed() >= 50);
+    QCOMPARE(rest, QByteArray(segmentSize - 1000, 'a'));
+    QCOMPARE(availability->contiguousFrom(0), 2 * segmentSize);
+
+    // Segment boundaries are transparent to seeks
+    QVERIFY(device.seek(segmentSize - 2));
+    QCOMPARE(device.read(2), QByteArray(2, 'a'));
+    QCOMPARE(device.read(2), QByteArray(2, 'b'));
+
+    availability->abort();
+    QVERIFY(device.seek(0));
+    QCOMPARE(device.read(10), QByteArray());
+
+    // Opened before the size is known: the read waits for the layout instead of
+    // returning EOF, and the blocked offset reaches the scheduler straight away
+    QSharedPointer<RangeAvailability> early(new RangeAvailability);
+    std::atomic<int> requests{0};
+    early->setRequestHandler([&requests]() { ++requests; });
+    PartialFileDevice earlyDevice(early);
+    QVERIFY(earlyDevice.open(QIODevice::ReadOnly));
+    QVERIFY(!earlyDevice.atEnd());
+    QThread *layout = QThread::create([early, segments, filepath, segmentSize]() {
+        QThread::msleep(100);
+        early->reset(segments, 2 * segmentSize, filepath);
+        early->setAvailable(1, segmentSize);
+    });
+    layout->start();
+    QVERIFY(earlyDevice.seek(segmentSize));
+    QCOMPARE(earlyDevice.read(4), QByteArray(4, 'b'));
+    layout->wait();
+    delete layout;
+    QVERIFY(requests.load() >= 1);
+    early->setRequestHandler(nullptr);
+}
+
+void TestPerformance::testSchedulerHeapFiring()
+{
+    // Cron matching: every 15 minutes between 01:00 and 07:59
+    ScheduleRule rule = ScheduleRule::parse("*/15 1-7 * * *");
+    QVERIFY(rule.isValid());
+    QDateTime from(QDate(2024, 1, 1), QTime(7, 59, 0));
+    QCOMPARE(rule.nextAfter(from), QDateTime(QDate(2024, 1, 2), QTime(1, 0, 0)));
+    QCOMPARE(rule.nextAfter(QDateTime(QDate(2024, 1, 2), QTime(1, 0, 0))), QDateTime(QDate(2024, 1, 2), QTime(1, 15, 0)));
+    QVERIFY(!ScheduleRule::parse("61 * * * *").isValid());
+
+    Scheduler scheduler(nullptr);
+    QDateTime now = QDateTime::currentDateTime();
+
+    // 10k schedules far in the future must not delay the one that is due
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 10000; ++i) {
+        QVERIFY(scheduler.addSchedule(QString("later-%1").arg(i), now.addDays(1).addSecs(i), "http://example.com/later"));
+    }
+    qDebug() << "10000 schedules added in" << timer.elapsed() << "ms";
+
+    QDateTime due = QDateTime::fromMSecsSinceEpoch((now.toMSecsSinceEpoch() / 1000 + 2) * 1000);
+    QVERIFY(scheduler.addSchedule("due", due, "http://example.com/due"));
+    QCOMPARE(scheduler.scheduleCount(), 10001);
+
+    QSignalSpy spy(&scheduler, &Scheduler::scheduleTriggered);
+    scheduler.start();
+    QVERIFY(spy.wait(5000));
+    qint64 lateness = QDateTime::currentMSecsSinceEpoch() - due.toMSecsSinceEpoch();
+    qDebug() << "Schedule fired" << lateness << "ms after its due time";
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(1).toString(), QString("http://example.com/due"));
+    QVERIFY(lateness >= 0);
+    QVERIFY(lateness < 1000);
+    QCOMPARE(scheduler.scheduleCount(), 10000);
+}
+
+void TestPerformance::testDownloadQueueOrdering()
+{
+    QObject owner;
+    DownloadQueue queue;
+    queue.setMaxConcurrentDownloads(0);   // keep everything waiting
+
+    const int count = 50000;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; ++i) {
+        DownloadItem *item = new DownloadItem(i, QString("http://example.com/%1").arg(i), QString("file%1").arg(i), &owner);
+        item->setPriority(i % 5);
+        queue.addDownload(item);
+    }
+    qDebug() << count << "downloads queued in" << timer.elapsed() << "ms";
+    QCOMPARE(queue.queuedCount(), count);
+
+    // Highest priority first, FIFO within a level
+    QList<DownloadItem*> ordered = queue.getQueuedDownloads();
+    QCOMPARE(ordered.first()->getId(), 4);
+    QCOMPARE(ordered.at(1)->getId(), 9);
+    QCOMPARE(ordered.last()->getId(), count - 5);
+
+    timer.restart();
+    for (int i = 0; i < count; i += 2) {
+        queue.removeDownload(i);
+    }
+    QVERIFY(queue.setPriority(count - 3, 10));
+    qDebug() << count / 2 << "removals and a reprioritize took" << timer.elapsed() << "ms";
+    QCOMPARE(queue.queuedCount(), count / 2);
+    QVERIFY(!queue.isQueued(0));
+    QVERIFY(timer.elapsed() < 2000);
+
+    queue.setMaxConcurrentDownloads(2);
+    QList<DownloadItem*> active = queue.getActiveDownloads();
+    QCOMPARE(active.size(), 2);
+    QCOMPARE(active.at(0)->getId(), count - 3);
+    QCOMPARE(active.at(1)->getId(), 9);
+}
+
+void TestPerformance::testDownloadQueueHostFairness()
+{
+    QObject owner;
+    DownloadQueue queue;
+    queue.setMaxConcurrentDownloads(0);
+    queue.setMaxDownloadsPerHost(0);
+
+    // Twenty files from one server queued ahead of two from each of two others
+    int id = 0;
+    for (int i = 0; i < 20; ++i, ++id) {
+        queue.addDownload(new DownloadItem(id, QString("http://a.example.com/%1").arg(i), "a", &owner));
+    }
+    for (int i = 0; i < 2; ++i, ++id) {
+        queue.addDownload(new DownloadItem(id, QString("http://b.example.com/%1").arg(i), "b", &owner));
+        queue.addDownload(new DownloadItem(++id, QString("https://c.example.com/%1").arg(i), "c", &owner));
+    }
+
+    // Round-robin across origins instead of the first three from a.example.com
+    queue.setMaxConcurrentDownloads(3);
+    QCOMPARE(queue.activeCountForHost("http://a.example.com:80"), 1);
+    QCOMPARE(queue.activeCountForHost("http://b.example.com:80"), 1);
+    QCOMPARE(queue.activeCountForHost("https://c.example.com:443"), 1);
+
+    // The per-host cap holds even with free global slots
+    queue.setMaxDownloadsPerHost(2);
+    queue.setMaxConcurrentDownloads(10);
+    QCOMPARE(queue.getActiveDownloads().size(), 6);
+    QCOMPARE(queue.activeCountForHost("http://a.example.com:80"), 2);
+
+    // A per-origin override lifts one server without touching the others
+    queue.setHostLimit("http://a.example.com:80", 4);
+    QCOMPARE(queue.activeCountForHost("http://a.example.com:80"), 4);
+    QCOMPARE(queue.getActiveDownloads().size(), 8);
+
+    // Category limits apply across origins
+    DownloadQueue categories;
+    categories.setMaxConcurrentDownloads(0);
+    for (int i = 0; i < 4; ++i) {
+        DownloadItem *item = new DownloadItem(100 + i, QString("http://host%1.example.com/f").arg(i), "f", &owner);
+        item->setCategoryId(7);
+        categories.addDownload(item);
+    }
+    categories.setCategoryLimit(7, 2);
+    categories.setMaxConcurrentDownloads(4);
+    QCOMPARE(categories.getActiveDownloads().size(), 2);
+    categories.removeDownload(categories.getActiveDownloads().first()->getId());
+    QCOMPARE(categories.getActiveDownloads().size(), 2);
+    QCOMPARE(categories.queuedCount(), 1);
+}
+
+void TestPerformance::testDownloadQueueAdmissionControl()
+{
+    QObject owner;
+    SpeedCalculator meter;
+    meter.start();
+
+    DownloadQueue queue;
+    queue.setMaxConcurrentDownloads(0);
+    queue.setMaxDownloadsPerHost(0);
+    queue.setThroughputMeter(&meter);
+    queue.setAdmissionProbeInterval(200);
+    for (int i = 0; i < 5; ++i) {
+        queue.addDownload(new DownloadItem(i, QString("http://host%1.example.com/f").arg(i), "f", &owner));
+    }
+
+    // Simulated link that saturates at two transfers: 1 MB/s each, 2 MB/s total
+    qint64 total = 0;
+    QTimer link;
+    connect(&link, &QTimer::timeout, &queue, [&]() {
+        total += 10 * 1024 * qMin(int(queue.getActiveDownloads().size()), 2);
+        meter.updateProgress(total);
+    });
+    link.start(10);
+
+    queue.setMaxConcurrentDownloads(5);
+    QCOMPARE(queue.getActiveDownloads().size(), 1);
+
+    // The second transfer doubles throughput and is kept; the third adds nothing
+    QTRY_COMPARE_WITH_TIMEOUT(queue.getActiveDownloads().size(), 3, 3000);
+    QTRY_COMPARE_WITH_TIMEOUT(queue.admittedDownloads(), 2, 3000);
+    QTest::qWait(600);
+    QCOMPARE(queue.getActiveDownloads().size(), 3);
+    QCOMPARE(queue.queuedCount(), 2);
+
+    // A finished transfer is not replaced while the link stays saturated
+    emit queue.getActiveDownloads().first()->downloadCompleted();
+    QCOMPARE(queue.getActiveDownloads().size(), 2);
+    QCOMPARE(queue.queuedCount(), 2);
+
+    // Dropping below the proven level refills immediately
+    queue.pauseDownload(queue.getActiveDownloads().first()->getId());
+    QCOMPARE(queue.getActiveDownloads().size(), 2);
+    link.stop();
+}
+
+void TestPerformance::testDownloadQueueAdmissionStalledLink()
+{
+    QObject owner;
+    SpeedCalculator meter;
+    meter.start();
+
+    DownloadQueue queue;
+    queue.setMaxConcurrentDownloads(0);
+    queue.setThroughputMeter(&meter);
+    queue.setAdmissionProbeInterval(100);
+    for (int i = 0; i < 3; ++i) {
+        queue.addDownload(new DownloadItem(i, QString("http://host%1.example.com/f").arg(i), "f", &owner));
+    }
+
+    // No bytes arrive, so no window proves anything and the queue must not ramp up
+    queue.setMaxConcurrentDownloads(3);
+    QCOMPARE(queue.getActiveDownloads().size(), 1);
+    QTest::qWait(500);
+    QCOMPARE(queue.getActiveDownloads().size(), 1);
+    QCOMPARE(queue.queuedCount(), 2);
+}
+
+void TestPerformance::testSpeedCalculatorEstimator()
+{
+    SpeedCalculator meter;
+    meter.start();
+
+    // Lock-free updates from several I/O threads lose nothing
+    const int threads = 4;
+    const int updates = 250000;
+    QElapsedTimer timer;
+    timer.start();
+    QList<QThread*> workers;
+    for (int t = 0; t < threads; ++t) {
+        QThread *worker = QThread::create([&meter]() {
+            for (int i = 0; i < updates; ++i) {
+                meter.addBytes(16);
+            }
+        });
+        workers.append(worker);
+        worker->start();
+    }
+    for (QThread *worker : workers) {
+        worker->wait();
+        delete worker;
+    }
+    qint64 elapsedNs = timer.nsecsElapsed();
+    qDebug() << "addBytes:" << double(elapsedNs) / (threads * updates) << "ns per call across" << threads << "threads";
+    QCOMPARE(meter.getTotalDownloaded(), qint64(threads) * updates * 16);
+
+    // Steady 1 MB/s with jittery delivery: EWMA, median and ETA all settle near it
+    meter.stop();
+    meter.start();
+    qint64 total = 0;
+    QElapsedTimer feed;
+    feed.start();
+    while (feed.elapsed() < 2000) {
+        QTest::qWait(10);
+        total = feed.elapsed() * 1024;
+        meter.updateProgress(total);
+    }
+
+    const double expected = 1024.0 * 1000.0;
+    qDebug() << "EWMA" << meter.getCurrentSpeed() << "p50" << meter.getMedianSpeed() << "p95" << meter.getP95Speed();
+    QVERIFY(qAbs(meter.getCurrentSpeed() - expected) < expected * 0.25);
+    QVERIFY(qAbs(meter.getMedianSpeed() - expected) < expected * 0.25);
+    QVERIFY(meter.getP95Speed() >= meter.getMedianSpeed());
+    int eta = meter.getEta(10 * 1024 * 1000);
+    QVERIFY(eta >= 7 && eta <= 14);
+    QCOMPARE(meter.getEta(0), 0);
+}
+
+void TestPerformance::testMetricsRegistry()
+{
+    // Bucket edges are contiguous and every value falls inside its bucket
+    for (qint64 value : {qint64(0), qint64(1), qint64(15), qint64(16), qint64(17), qint64(1000),
+                         qint64(123456789), qint64(1) << 40}) {
+        int index = Metrics::Histogram::bucketIndex(value);
+        QVERIFY(value < Metrics::Histogram::bucketUpperBound(index));
+        QVERIFY(index == 0 || value >= Metrics::Histogram::bucketUpperBound(index - 1));
+    }
+
+    Metrics::Histogram latency(1e-6);
+    for (int i = 1; i <= 10000; ++i) {
+        latency.record(i);
+    }
+    QCOMPARE(latency.count(), quint64(10000));
+    QVERIFY(qAbs(latency.valueAtPercentile(50) - 5000) < 5000 * 0.07);
+    QVERIFY(qAbs(latency.valueAtPercentile(99) - 9900) < 9900 * 0.07);
+
+    // Hot-path updates from several threads through a cached pointer
+    Metrics::Counter *counter = Metrics::instance().counter("ldm_test_events_total", "Test events",
+                                                            Metrics::label("source", "perf \"test\""));
+    QCOMPARE(counter, Metrics::instance().counter("ldm_test_events_total", "Test events",
+                                                  Metrics::label("source", "perf \"test\"")));
+    const int threads = 4;
+    const int updates = 250000;
+    QElapsedTimer timer;
+    timer.start();
+    QList<QThread*> workers;
+    for (int t = 0; t < threads; ++t) {
+        QThread *worker = QThread::create([counter]() {
+            for (int i = 0; i < updates; ++i) {
+                counter->increment();
+            }
+        });
+        workers.append(worker);
+        worker->start();
+    }
+    for (QThread *worker : workers) {
+        worker->wait();
+        delete worker;
+    }
+    qDebug() << "Counter increment:" << double(timer.nsecsElapsed()) / (threads * updates) << "ns across" << threads << "threads";
+    QCOMPARE(counter->value(), quint64(threads) * updates);
+
+    // Label values past the cap share one "other" series
+    for (int i = 0; i < 10; ++i) {
+        Metrics::instance().boundedCounter("ldm_test_hosts_total", "Test hosts", "host",
+                                           QString("host%1.example").arg(i), 4)->increment();
+    }
+    Metrics::instance().boundedCounter("ldm_test_hosts_total", "Test hosts", "host", "host0.example", 4)->increment();
+
+    Metrics::instance().histogram("ldm_test_latency_seconds", "Test latency", 1e-6)->record(1500);
+    timer.restart();
+    QByteArray text = Metrics::instance().prometheusText();
+    qDebug() << "Rendered" << text.size() << "bytes of metrics in" << timer.nsecsElapsed() / 1000 << "us";
+    QVERIFY(text.contains("# TYPE ldm_test_events_total counter\n"));
+    QVERIFY(text.contains("ldm_test_events_total{source=\"perf \\\"test\\\"\"} 1000000\n"));
+    QVERIFY(text.contains("ldm_test_latency_seconds_bucket{le=\"0.001536\"} 1\n"));
+    QVERIFY(text.contains("ldm_test_latency_seconds_count 1\n"));
+    QVERIFY(text.contains("ldm_test_hosts_total{host=\"host0.example\"} 2\n"));
+    QVERIFY(text.contains("ldm_test_hosts_total{host=\"host3.example\"} 1\n"));
+    QVERIFY(!text.contains("host4.example"));
+    QVERIFY(text.contains("ldm_test_hosts_total{host=\"other\"} 6\n"));
+}
+
+void TestPerformance::testApiServerLoad()
+{
+    // Open-loop load in the style of wrk2: requests go out on a fixed schedule whether or
+    // not earlier ones came back, and latency counts from the scheduled send time
+    const quint16 port = 8091;
+    const int downloadCount = 20;
+    const int rate = 1000;
+    const int durationMs = 3000;
+    const int connections = 16;
+    const int total = rate * durationMs / 1000;
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QList<qint64> latenciesUs;
+    int failures = 0;
+    qint64 maxTickGapMs = 0;
+    {
+        Database database;
+        QVERIFY(database.open(dir.filePath("api-load.db"), "perf-api"));
+        DownloadEngine engine;
+        ApiServer server(&database, &engine);
+        QVERIFY(server.start(port));
+
+        // Nothing starts, so progress for the live downloads can be simulated
+        DownloadService *service = server.downloadService();
+        service->queue()->setMaxConcurrentDownloads(0);
+        QList<int> ids;
+        for (int i = 0; i < downloadCount; ++i) {
+            QVariantMap data;
+            data["url"] = QString("http://example.com/load%1.bin").arg(i);
+            data["filename"] = QString("load%1.bin").arg(i);
+            int id = service->createDownload(data);
+            QVERIFY(id > 0);
+            ids.append(id);
+        }
+
+        // Engine progress on the owner thread 100 times a second; the longest gap
+        // between ticks shows whether request handling ever stalled it
+        qint64 received = 0;
+        QElapsedTimer tickTimer;
+        QTimer progress;
+        progress.setInterval(10);
+        connect(&progress, &QTimer::timeout, this, [&]() {
+            maxTickGapMs = qMax(maxTickGapMs, tickTimer.restart());
+            received += 4096;
+            for (int id : ids) {
+                emit engine.downloadProgress(id, received, qint64(1) << 30);
+            }
+        });
+
+        QThread *client = QThread::create([&]() {
+            struct Connection {
+                QTcpSocket *socket = nullptr;
+                QByteArray buffer;
+                qint64 scheduledNs = -1;    // of the request in flight, -1 when idle
+            };
+            QList<Connection> pool(connections);
+            for (Connection &connection : pool) {
+                connection.socket = new QTcpSocket;
+                connection.socket->connectToHost("127.0.0.1", port);
+                if (!connection.socket->waitForConnected(5000)) {
+                    ++failures;
+                }
+            }
+
+            const qint64 intervalNs = 1000000000LL / rate;
+            const qint64 deadlineNs = (durationMs + 10000) * 1000000LL;
+            qint64 issued = 0;
+            QElapsedTimer clock;
+            clock.start();
+            while (latenciesUs.size() + failures < total && clock.nsecsElapsed() < deadlineNs) {
+                bool busy = false;
+
+                // Everything that is due goes out on whichever connections are idle
+                for (Connection &connection : pool) {
+                    if (issued == total || issued * intervalNs > clock.nsecsElapsed()) {
+                        break;
+                    }
+                    if (connection.scheduledNs >= 0) {
+                        continue;
+                    }
+                    QByteArray path = "/api/v1/downloads";
+                    if (issued % 10 == 9) {
+                        path = "/api/v1/statistics";
+                    } else if (issued % 2) {
+                        path += '/' + QByteArray::number(ids.at(issued % downloadCount));
+                    }
+                    connection.socket->write("GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+                    connection.socket->flush();
+                    connection.scheduledNs = issued * intervalNs;
+                    ++issued;
+                    busy = true;
+                }
+
+                for (Connection &connection : pool) {
+                    if (connection.scheduledNs < 0 || !connection.socket->waitForReadyRead(0)) {
+                        continue;
+                    }
+                    connection.buffer += connection.socket->readAll();
+                    int headerEnd = connection.buffer.indexOf("\r\n\r\n");
+                    if (headerEnd < 0) {
+                        continue;
+                    }
+                    QByteArray head = connection.buffer.left(headerEnd).toLower();
+                    qint64 length = 0;
+                    int lengthAt = head.indexOf("content-length:");
+                    if (lengthAt >= 0) {
+                        int lineEnd = head.indexOf("\r\n", lengthAt);
+                        length = head.mid(lengthAt + 15, lineEnd < 0 ? -1 : lineEnd - lengthAt - 15).trimmed().toLongLong();
+                    }
+                    if (connection.buffer.size() < headerEnd + 4 + length) {
+                        continue;
+                    }
+                    if (head.startsWith("http/1.1 200")) {
+                        latenciesUs.append((clock.nsecsElapsed() - connection.scheduledNs) / 1000);
+                    } else {
+                        ++failures;
+                    }
+                    connection.buffer.remove(0, headerEnd + 4 + length);
+                    connection.scheduledNs = -1;
+                    busy = true;
+                }
+
+                if (!busy) {
+                    QThread::usleep(50);
+                }
+            }
+
+            for (Connection &connection : pool) {
+                delete connection.socket;
+            }
+        });
+
+        QSignalSpy finished(client, &QThread::finished);
+        tickTimer.start();
+        progress.start();
+        client->start();
+        QVERIFY(finished.wait(durationMs + 15000));
+        progress.stop();
+        delete client;
+        server.stop();
+    }
+    QSqlDatabase::removeDatabase("perf-api");
+
+    QCOMPARE(failures, 0);
+    QCOMPARE(latenciesUs.size(), total);
+    std::sort(latenciesUs.begin(), latenciesUs.end());
+    auto percentile = [&latenciesUs](int p) {
+        return latenciesUs.at(qMin(latenciesUs.size() - 1, latenciesUs.size() * p / 100)) / 1000.0;
+    };
+    qDebug() << total << "requests at" << rate << "req/s: p50" << percentile(50) << "ms, p99"
+             << percentile(99) << "ms, max" << latenciesUs.last() / 1000.0 << "ms";
+    qDebug() << "Longest gap between progress ticks under load:" << maxTickGapMs << "ms";
+    QVERIFY(percentile(99) < 100);
+    QVERIFY(maxTickGapMs < 100);
+}
+
+void TestPerformance::testStalledClientBuffering()
+{
+    // A client that stops reading must stall the producer, not grow the server's send buffer
+    const quint16 port = 8092;
+    const int rows = 80000;
+    const qint64 bound = 8 * 1024 * 1024;      // kernel socket buffers plus a few chunks
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    {
+        Database database;
+        QVERIFY(database.open(dir.filePath("stall.db"), "perf-stall"));
+        QVERIFY(database.beginBatch());
+        for (int i = 0; i < rows; ++i) {
+            QVariantMap history;
+            history["download_id"] = QVariant();
+            history["url"] = QString("http://example.com/stalled/%1/a-reasonably-long-media-name.mp4").arg(i);
+            history["filename"] = QString("a-reasonably-long-media-name-%1.mp4").arg(i);
+            history["filepath"] = "/home/user/Downloads/Video";
+            history["size"] = 1048576;
+            history["duration"] = 10;
+            history["average_speed"] = 104857;
+            history["category_name"] = "Video";
+            history["success"] = true;
+            QVERIFY(database.insertDownloadHistory(history));
+        }
+        QVERIFY(database.commitBatch());
+
+        DownloadEngine engine;
+        ApiServer server(&database, &engine);
+        QVERIFY(server.start(port));
+        Metrics::Counter *written = Metrics::instance().counter(
+            "ldm_api_stream_written_bytes_total", "Streamed list bytes handed to client sockets");
+        quint64 before = written->value();
+
+        // A small read buffer keeps Qt from draining the kernel buffer on the client's behalf
+        QTcpSocket client;
+        client.setReadBufferSize(4096);
+        client.connectToHost("127.0.0.1", port);
+        QVERIFY(client.waitForConnected(5000));
+        client.write(QString("GET /api/v1/history?limit=%1 HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n").arg(rows).toLatin1());
+        QVERIFY(client.waitForBytesWritten(5000));
+
+        // Wait for the producer to stop advancing, well inside its chunk timeout
+        QElapsedTimer timer;
+        timer.start();
+        quint64 last;
+        do {
+            last = written->value();
+            QTest::qWait(300);
+        } while ((last == before || written->value() != last) && timer.elapsed() < 20000);
+        qint64 stalled = qint64(written->value() - before);
+        qDebug() << "Producer stalled after" << stalled / 1024 << "KB with the client not reading";
+        QVERIFY(stalled > 0);
+        QVERIFY(stalled < bound);
+
+        // Reading again resumes the stream through to the terminating chunk
+        client.setReadBufferSize(0);
+        QByteArray response;
+        timer.restart();
+        while (!response.endsWith("\r\n0\r\n\r\n") && timer.elapsed() < 20000) {
+            if (client.waitForReadyRead(100) || client.bytesAvailable()) {
+                response += client.readAll();
+            }
+        }
+        qDebug() << "Full response" << response.size() / 1024 << "KB";
+        QVERIFY(response.startsWith("HTTP/1.1 200"));
+        QVERIFY(response.endsWith("\r\n0\r\n\r\n"));
+        QVERIFY(response.size() > 2 * bound);
+
+        client.disconnectFromHost();
+        server.stop();
+    }
+    QSqlDatabase::removeDatabase("perf-stall");
+}
+
+void TestPerformance::testMessageParserFraming()
+{
+    // 100k back-to-back frames of random size, delivered in randomly sized reads
+    const int count = 100000;
+    QRandomGenerator random(20261019);
+    QByteArray stream;
+    for (int i = 0; i < count; ++i) {
+        QJsonObject message{{"type", "START_DOWNLOAD"}, {"seq", i},
+                            {"pad", QString(random.bounded(8, 400), QChar('x'))}};
+        stream += MessageParser::frame(message);
+    }
+
+    MessageParser parser;
+    int received = 0;
+    int outOfOrder = 0;
+    connect(&parser, &MessageParser::messageReceived, this, [&](const QJsonObject &message) {
+        if (message.value("seq").toInt() != received) {
+            ++outOfOrder;
+        }
+        ++received;
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    for (qsizetype offset = 0; offset < stream.size();) {
+        qsizetype size = qMin(stream.size() - offset, qsizetype(random.bounded(1, 16384)));
+        parser.parseMessage(stream.mid(offset, size));
+        offset += size;
+    }
+    qint64 splitMs = timer.elapsed();
+    QCOMPARE(received, count);
+    QCOMPARE(outOfOrder, 0);
+    QCOMPARE(parser.pendingBytes(), qsizetype(0));
+
+    // One read holding the whole burst, the case that used to copy the tail per frame
+    received = 0;
+    timer.restart();
+    parser.parseMessage(stream);
+    qint64 burstMs = timer.elapsed();
+    QCOMPARE(received, count);
+    QCOMPARE(outOfOrder, 0);
+
+    qDebug() << count << "frames," << stream.size() / 1024 << "KB: random reads" << splitMs
+             << "ms, one read" << burstMs << "ms";
+    QVERIFY(burstMs < 2000);
+    QVERIFY(splitMs < 2000);
+
+    // An oversized length cannot be resynchronised: the buffer is dropped and the error raised
+    QSignalSpy errors(&parser, &MessageParser::frameError);
+    QByteArray oversized(4, Qt::Uninitialized);
+    qToLittleEndian<quint32>(MessageParser::MAX_MESSAGE_SIZE + 1, oversized.data());
+    received = 0;
+    parser.parseMessage(MessageParser::frame(QJsonObject{{"seq", 0}}) + oversized + QByteArray(64, 'x'));
+    QCOMPARE(received, 1);
+    QCOMPARE(errors.count(), 1);
+    QCOMPARE(parser.pendingBytes(), qsizetype(0));
+
+    // Invalid JSON costs only its own frame, and a split length prefix is carried over
+    QByteArray garbage(4, Qt::Uninitialized);
+    qToLittleEndian<quint32>(5, garbage.data());
+    garbage += "{bad}";
+    QByteArray next = MessageParser::frame(QJsonObject{{"seq", 1}});
+    parser.parseMessage(garbage + next.left(2));
+    parser.parseMessage(next.mid(2));
+    QCOMPARE(received, 2);
+    QCOMPARE(errors.count(), 1);
+}
+
+void TestPerformance::testNativeBridgeBurst()
+{
+    // A page with 300 media links, handed over in one write as 300 separate requests
+    const int links = 300;
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    Database database;
+    QVERIFY(database.open(dir.filePath("bridge.db"), "perf-bridge"));
+    {
+        DownloadEngine engine;
+        ApiServer server(&database, &engine);
+        server.downloadService()->queue()->setMaxConcurrentDownloads(0);
+        // A private name, so a running LDM on the same machine does not interfere
+        BridgeServer *bridge = server.bridgeServer();
+        QVERIFY(bridge->listen(dir.filePath("ldm-bridge-perf")));
+
+        QLocalSocket socket;
+        socket.connectToServer(bridge->serverName());
+        QVERIFY(socket.waitForConnected(5000));
+
+        QByteArray burst;
+        for (int i = 0; i < links; ++i) {
+            burst += MessageParser::frame(QJsonObject{
+                {"id", i + 1},
+                {"action", "start_download"},
+                {"data", QJsonObject{{"url", QString("http://example.com/media%1.mp4").arg(i)}}}
+            });
+        }
+
+        MessageParser parser;
+        int replies = 0;
+        int failed = 0;
+        connect(&parser, &MessageParser::messageReceived, this, [&](const QJsonObject &reply) {
+            ++replies;
+            if (!reply.value("ok").toBool()) {
+                ++failed;
+            }
+        });
+
+        QElapsedTimer timer;
+        timer.start();
+        socket.write(burst);
+        while (replies < links && timer.elapsed() < 10000) {
+            QCoreApplication::processEvents();
+            if (socket.waitForReadyRead(10) || socket.bytesAvailable()) {
+                parser.parseMessage(socket.readAll());
+            }
+        }
+        qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+        qDebug() << links << "bridged downloads in" << elapsedUs << "us," << double(elapsedUs) / links << "us per item";
+        QCOMPARE(replies, links);
+        QCOMPARE(failed, 0);
+        QVERIFY(elapsedUs / links < 1000);
+
+        socket.disconnectFromServer();
+        bridge->close();
+    }
+    database.close();
+    QSqlDatabase::removeDatabase("perf-bridge");
 }
\ No newline at end of file
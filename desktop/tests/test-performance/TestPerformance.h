@@ -16,6 +16,23 @@ private slots:
     void testMemoryUsage();
     void testConcurrentDownloads();
     void testLargeFileHandling();
+    void testFirstPageQuery();
+    void testTableModelUpdates();
+    void testSpeedHistoryDecimation();
+    void testSegmentSnapshotConsistency();
+    void testThumbnailCacheLookup();
+    void testPartialFileDeviceBlocksForRange();
+    void testSchedulerHeapFiring();
+    void testDownloadQueueOrdering();
+    void testDownloadQueueHostFairness();
+    void testDownloadQueueAdmissionControl();
+    void testDownloadQueueAdmissionStalledLink();
+    void testSpeedCalculatorEstimator();
+    void testMetricsRegistry();
+    void testApiServerLoad();
+    void testStalledClientBuffering();
+    void testMessageParserFraming();
+    void testNativeBridgeBurst();
 };
 
 #endif // TESTPERFORMANCE_H
\ No newline at end of file
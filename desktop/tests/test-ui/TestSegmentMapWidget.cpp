@@ -0,0 +1,69 @@
+#include "TestSegmentMapWidget.h"
+#include "../../src/ui/SegmentMapWidget.h"
+#include "../../src/core/SegmentManager.h"
+#include <QImage>
+
+static SegmentSnapshot makeSegment(int index, qint64 start, qint64 end, qint64 done, qint64 speed,
+                                   SegmentSnapshot::State state)
+{
+    SegmentSnapshot segment;
+    segment.index = index;
+    segment.startOffset = start;
+    segment.endOffset = end;
+    segment.downloadedSize = done;
+    segment.speed = speed;
+    segment.retryCount = 0;
+    segment.state = state;
+    return segment;
+}
+
+void TestSegmentMapWidget::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+}
+
+void TestSegmentMapWidget::cleanupTestCase()
+{
+    // Cleanup test case
+}
+
+void TestSegmentMapWidget::testPaintLanes()
+{
+    SegmentMapWidget widget;
+    widget.setSnapshot({makeSegment(0, 0, 499, 500, 0, SegmentSnapshot::Completed),
+                        makeSegment(1, 500, 999, 100, 0, SegmentSnapshot::Downloading)},
+                       1000);
+    widget.resize(200, widget.sizeHint().height());
+
+    QImage image = widget.grab().toImage();
+    // Lane 1 sits at y = 3..12, lane 2 at y = 16..25 (LANE_HEIGHT 10, LANE_SPACING 3)
+    QCOMPARE(image.pixelColor(50, 7), QColor(0x19, 0x76, 0xd2));     // completed, fully done
+    QCOMPARE(image.pixelColor(105, 20), QColor(0xff, 0xa0, 0x00));   // running with no bytes: stalled
+    QCOMPARE(image.pixelColor(180, 20), QColor(0xff, 0xa0, 0x00).lighter(170));   // not yet done
+    QCOMPARE(image.pixelColor(50, 20), widget.palette().base().color());          // outside its range
+}
+
+void TestSegmentMapWidget::testPollSkipsUnchangedGeneration()
+{
+    SegmentManager manager(QUrl("http://localhost/segment-map.bin"), m_dir.filePath("segment-map.bin"), 4);
+    SegmentMapWidget widget;
+    widget.setSource(&manager);
+    int emptyHeight = widget.sizeHint().height();
+
+    // The source has not published since the widget attached: a poll must leave the view alone
+    widget.setSnapshot({makeSegment(0, 0, 99, 0, 0, SegmentSnapshot::Pending),
+                        makeSegment(1, 100, 199, 0, 0, SegmentSnapshot::Pending),
+                        makeSegment(2, 200, 299, 0, 0, SegmentSnapshot::Pending)},
+                       300);
+    int threeLaneHeight = widget.sizeHint().height();
+    QVERIFY(threeLaneHeight > emptyHeight);
+    QVERIFY(QMetaObject::invokeMethod(&widget, "poll"));
+    QCOMPARE(widget.sizeHint().height(), threeLaneHeight);
+
+    // A new generation replaces the view with the published (empty) snapshot
+    QVERIFY(QMetaObject::invokeMethod(&manager, "publishSegmentStats"));
+    QVERIFY(QMetaObject::invokeMethod(&widget, "poll"));
+    QCOMPARE(widget.sizeHint().height(), emptyHeight);
+
+    widget.setSource(nullptr);
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef TESTSEGMENTMAPWIDGET_H
+#define TESTSEGMENTMAPWIDGET_H
+
+#include <QObject>
+#include <QtTest>
+#include <QTemporaryDir>
+
+class TestSegmentMapWidget : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void testPaintLanes();
+    void testPollSkipsUnchangedGeneration();
+};
+
+#endif // TESTSEGMENTMAPWIDGET_H
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "BridgeClient.h"
+#include <QDir>
+#include <QStandardPaths>
+#include <QDebug>
+
+BridgeClient::BridgeClient(QObject *parent)
+    : QObject(parent)
+    , m_socket(new QLocalSocket(this))
+    , m_messageParser(new MessageParser(this))
+    , m_reconnectTimer(new QTimer(this))
+    , m_nextId(1)
+{
+    connect(m_socket, &QLocalSocket::connected, this, &BridgeClient::onConnected);
+    connect(m_socket, &QLocalSocket::disconnected, this, &BridgeClient::onDisconnected);
+    connect(m_socket, &QLocalSocket::readyRead, this, &BridgeClient::onReadyRead);
+    connect(m_socket, &QLocalSocket::errorOccurred, this, [this](QLocalSocket::LocalSocketError) {
+        // A refused connect never reaches disconnected()
+        if (m_socket->state() == QLocalSocket::UnconnectedState) {
+            onDisconnected();
+        }
+    });
+    connect(m_messageParser, &MessageParser::messageReceived, this, &BridgeClient::onMessageReceived);
+    connect(m_messageParser, &MessageParser::frameError, m_socket, &QLocalSocket::abort);
+
+    m_reconnectTimer->setSingleShot(true);
+    m_reconnectTimer->setInterval(RECONNECT_INTERVAL_MS);
+    connect(m_reconnectTimer, &QTimer::timeout, this, [this]() {
+        m_socket->connectToServer(m_serverName);
+    });
+}
+
+BridgeClient::~BridgeClient()
+{
+    m_reconnectTimer->stop();
+    m_socket->disconnect(this);
+    m_socket->abort();
+}
+
+void BridgeClient::connectToServer(const QString &name)
+{
+    m_serverName = name;
+    m_socket->connectToServer(m_serverName);
+}
+
+bool BridgeClient::isConnected() const
+{
+    return m_socket->state() == QLocalSocket::ConnectedState;
+}
+
+void BridgeClient::request(const QString &action, const QJsonObject &data, ReplyHandler onReply)
+{
+    QLocalSocket::LocalSocketState state = m_socket->state();
+    if (state != QLocalSocket::ConnectedState && state != QLocalSocket::ConnectingState) {
+        if (onReply) {
+            onReply(false, QJsonObject(), "LDM is not running");
+        }
+        return;
+    }
+
+    quint32 id = m_nextId++;
+    if (onReply) {
+        m_pending.insert(id, std::move(onReply));
+    }
+    QByteArray frame = MessageParser::frame(QJsonObject{
+        {"id", qint64(id)},
+        {"action", action},
+        {"data", data}
+    });
+
+    // Requests issued in one pass of the event loop leave in one write
+    if (state == QLocalSocket::ConnectedState) {
+        m_socket->write(frame);
+    } else {
+        m_held.append(frame);
+    }
+}
+
+QString BridgeClient::defaultServerName()
+{
+    QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (runtimeDir.isEmpty()) {
+        return "ldm-bridge";
+    }
+    return QDir(runtimeDir).filePath("ldm-bridge");
+}
+
+void BridgeClient::onConnected()
+{
+    qDebug() << "Connected to LDM at" << m_socket->fullServerName();
+    if (!m_held.isEmpty()) {
+        m_socket->write(m_held);
+        m_held.clear();
+    }
+    emit connected();
+}
+
+void BridgeClient::onDisconnected()
+{
+    // Reached from both disconnected() and errorOccurred() for the same loss
+    if (m_reconnectTimer->isActive()) {
+        return;
+    }
+    failPending("Lost connection to LDM");
+    m_reconnectTimer->start();
+    emit disconnected();
+}
+
+void BridgeClient::onReadyRead()
+{
+    m_messageParser->parseMessage(m_socket->readAll());
+}
+
+void BridgeClient::onMessageReceived(const QJsonObject &message)
+{
+    if (!message.contains("reply")) {
+        emit eventReceived(message.value("event").toString(), message.value("data").toObject());
+        return;
+    }
+
+    ReplyHandler handler = m_pending.take(quint32(message.value("reply").toInteger()));
+    if (handler) {
+        handler(message.value("ok").toBool(), message.value("data").toObject(), message.value("error").toString());
+    }
+}
+
+void BridgeClient::failPending(const QString &error)
+{
+    m_held.clear();
+    const QHash<quint32, ReplyHandler> pending = std::exchange(m_pending, {});
+    for (const ReplyHandler &handler : pending) {
+        handler(false, QJsonObject(), error);
+    }
+}
\ No newline at end of file
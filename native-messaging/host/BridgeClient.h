@@ -0,0 +1,64 @@
+#ifndef BRIDGECLIENT_H
+#define BRIDGECLIENT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QTimer>
+#include <functional>
+#include "MessageParser.h"
+
+// Connection to the desktop application's bridge server over a local socket.
+// Frames are the native messaging framing (little-endian quint32 length,
+// compact JSON); requests carry an id and any number may be in flight, each
+// reply is routed back to the handler of its request. Messages without a
+// reply id are progress pushes and surface as eventReceived().
+class BridgeClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    using ReplyHandler = std::function<void(bool ok, const QJsonObject &data, const QString &error)>;
+
+    explicit BridgeClient(QObject *parent = nullptr);
+    ~BridgeClient();
+
+    // Keeps reconnecting while the desktop application is not running
+    void connectToServer(const QString &name = defaultServerName());
+    bool isConnected() const;
+
+    // Written at once, or held while the connection is still being set up.
+    // Fails through onReply when the desktop application cannot be reached.
+    void request(const QString &action, const QJsonObject &data, ReplyHandler onReply = ReplyHandler());
+
+    // Must match BridgeServer::defaultServerName() in the desktop application
+    static QString defaultServerName();
+
+signals:
+    void connected();
+    void disconnected();
+    void eventReceived(const QString &event, const QJsonObject &data);
+
+private slots:
+    void onConnected();
+    void onDisconnected();
+    void onReadyRead();
+    void onMessageReceived(const QJsonObject &message);
+
+private:
+    QLocalSocket *m_socket;
+    MessageParser *m_messageParser;
+    QTimer *m_reconnectTimer;
+    QString m_serverName;
+    quint32 m_nextId;
+    QHash<quint32, ReplyHandler> m_pending;
+    QByteArray m_held;                      // frames requested while connecting
+
+    void failPending(const QString &error);
+
+    static const int RECONNECT_INTERVAL_MS = 2000;
+};
+
+#endif // BRIDGECLIENT_H
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 MessageParser::MessageParser(QObject *parent)
     : QObject(parent)
+    , m_offset(0)
 {
 }
 
@@ -12,47 +13,89 @@ MessageParser::~MessageParser()
 
 void MessageParser::parseMessage(const QByteArray &data)
 {
+    if (pendingBytes() == 0) {
+        // Nothing carried over: frames are decoded from data itself and only a partial tail is kept
+        qsizetype consumed = processCompleteMessages(data);
+        if (consumed >= 0) {
+            m_buffer.resize(0);
+            m_offset = 0;
+            m_buffer.append(QByteArrayView(data).sliced(consumed));
+        }
+        return;
+    }
+
     m_buffer.append(data);
-    processCompleteMessage();
+    qsizetype consumed = processCompleteMessages(QByteArrayView(m_buffer).sliced(m_offset));
+    if (consumed < 0) {
+        return;
+    }
+    m_offset += consumed;
+
+    // resize(0) keeps the allocation for the next burst; a partly consumed buffer is
+    // compacted only when the dead prefix outweighs the live part
+    if (m_offset == m_buffer.size()) {
+        m_buffer.resize(0);
+        m_offset = 0;
+    } else if (m_offset >= COMPACT_THRESHOLD && m_offset * 2 >= m_buffer.size()) {
+        m_buffer.remove(0, m_offset);
+        m_offset = 0;
+    }
 }
 
-void MessageParser::processCompleteMessage()
+QByteArray MessageParser::frame(const QJsonObject &message)
 {
-    while (m_buffer.size() >= 4) {
-        int messageLength;
-        if (!extractMessageLength(m_buffer, messageLength)) {
-            break;
-        }
+    QByteArray data = QJsonDocument(message).toJson(QJsonDocument::Compact);
+
+    // Native messaging uses a little-endian 32-bit length prefix
+    QByteArray frame;
+    frame.reserve(4 + data.size());
+    frame.append(char((data.size() >> 0) & 0xFF));
+    frame.append(char((data.size() >> 8) & 0xFF));
+    frame.append(char((data.size() >> 16) & 0xFF));
+    frame.append(char((data.size() >> 24) & 0xFF));
+    frame.append(data);
+    return frame;
+}
 
-        if (m_buffer.size() < 4 + messageLength) {
+qsizetype MessageParser::processCompleteMessages(QByteArrayView data)
+{
+    qsizetype offset = 0;
+    quint32 messageLength;
+    while (extractMessageLength(data.sliced(offset), messageLength)) {
+        if (messageLength > MAX_MESSAGE_SIZE) {
+            qWarning() << "Message of" << messageLength << "bytes exceeds the native messaging limit";
+            m_buffer.clear();
+            m_offset = 0;
+            emit frameError(QString("Message of %1 bytes exceeds the %2 byte limit").arg(messageLength).arg(quint32(MAX_MESSAGE_SIZE)));
+            return -1;
+        }
+        if (data.size() - offset - 4 < qsizetype(messageLength)) {
             break; // Not enough data for the full message
         }
 
-        // Extract the message
-        QByteArray messageData = m_buffer.mid(4, messageLength);
-        m_buffer = m_buffer.mid(4 + messageLength);
-
-        // Parse JSON
-        QJsonDocument doc = QJsonDocument::fromJson(messageData);
+        // fromRawData wraps the bytes where they are; the parser copies what it keeps
+        QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromRawData(data.data() + offset + 4, messageLength));
+        offset += 4 + messageLength;
         if (doc.isObject()) {
             emit messageReceived(doc.object());
         } else {
             qWarning() << "Invalid JSON message received";
         }
     }
+    return offset;
 }
 
-bool MessageParser::extractMessageLength(QByteArray &data, int &messageLength)
+bool MessageParser::extractMessageLength(QByteArrayView data, quint32 &messageLength) const
 {
     if (data.size() < 4) {
         return false;
     }
 
     // Native messaging uses little-endian 32-bit unsigned integer
-    messageLength = (static_cast<unsigned char>(data[0])) |
-                    (static_cast<unsigned char>(data[1]) << 8) |
-                    (static_cast<unsigned char>(data[2]) << 16) |
-                    (static_cast<unsigned char>(data[3]) << 24);
+    messageLength = quint32(static_cast<unsigned char>(data[0])) |
+                    (quint32(static_cast<unsigned char>(data[1])) << 8) |
+                    (quint32(static_cast<unsigned char>(data[2])) << 16) |
+                    (quint32(static_cast<unsigned char>(data[3])) << 24);
 
     return true;
 }
\ No newline at end of file
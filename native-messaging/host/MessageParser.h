@@ -5,7 +5,13 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QByteArray>
+#include <QByteArrayView>
 
+// Decodes native messaging frames (little-endian quint32 length, JSON
+// payload). Complete frames are parsed where they lie, straight out of the
+// caller's data when nothing is carried over; only an incomplete tail is
+// buffered, and consumed bytes are dropped from the buffer only once they
+// make up most of it, so a burst of small frames costs linear time.
 class MessageParser : public QObject
 {
     Q_OBJECT
@@ -14,16 +20,30 @@ public:
     explicit MessageParser(QObject *parent = nullptr);
     ~MessageParser();
 
+    // Not re-entrant: slots connected to messageReceived must not call back in
     void parseMessage(const QByteArray &data);
+    qsizetype pendingBytes() const { return m_buffer.size() - m_offset; }
+
+    // Length-prefixed compact JSON, as read by parseMessage() and by browsers
+    static QByteArray frame(const QJsonObject &message);
+
+    // Chrome's limit for messages from the host; frames above it are treated as corruption
+    static const quint32 MAX_MESSAGE_SIZE = 1024 * 1024;
 
 signals:
     void messageReceived(const QJsonObject &message);
+    // The length prefix exceeded MAX_MESSAGE_SIZE. Framing cannot be recovered,
+    // so buffered data is dropped and the connection should be closed.
+    void frameError(const QString &error);
 
 private:
     QByteArray m_buffer;
+    qsizetype m_offset;                     // start of the first unparsed frame in m_buffer
+
+    qsizetype processCompleteMessages(QByteArrayView data);    // bytes consumed, -1 on a bad frame
+    bool extractMessageLength(QByteArrayView data, quint32 &messageLength) const;
 
-    void processCompleteMessage();
-    bool extractMessageLength(QByteArray &data, int &messageLength);
+    static const qsizetype COMPACT_THRESHOLD = 64 * 1024;
 };
 
 #endif // MESSAGEPARSER_H
\ No newline at end of file
@@ -4,16 +4,16 @@
 #include <QDebug>
 #include <QDir>
 #include <QStandardPaths>
+#include <QPointer>
 
 NativeHost::NativeHost(QObject *parent)
     : QObject(parent)
     , m_server(new QTcpServer(this))
-    , m_socket(nullptr)
-    , m_messageParser(new MessageParser(this))
+    , m_bridge(new BridgeClient(this))
     , m_heartbeatTimer(new QTimer(this))
 {
     connect(m_server, &QTcpServer::newConnection, this, &NativeHost::onNewConnection);
-    connect(m_messageParser, &MessageParser::messageReceived, this, &NativeHost::onMessageReceived);
+    connect(m_bridge, &BridgeClient::eventReceived, this, &NativeHost::onBridgeEvent);
     connect(m_heartbeatTimer, &QTimer::timeout, this, &NativeHost::sendHeartbeat);
 }
 
@@ -34,6 +34,7 @@ bool NativeHost::start()
     // Print the port to stdout for the browser extension to read
     QTextStream(stdout) << m_server->serverPort() << Qt::endl;
 
+    m_bridge->connectToServer();
     m_heartbeatTimer->start(30000); // Send heartbeat every 30 seconds
 
     return true;
@@ -41,8 +42,9 @@ bool NativeHost::start()
 
 void NativeHost::stop()
 {
-    if (m_socket) {
-        m_socket->disconnectFromHost();
+    const QList<QTcpSocket*> sockets = m_clients.keys();
+    for (QTcpSocket *socket : sockets) {
+        socket->disconnectFromHost();
     }
     m_server->close();
     m_heartbeatTimer->stop();
@@ -50,54 +52,58 @@ void NativeHost::stop()
 
 void NativeHost::onNewConnection()
 {
-    if (m_socket) {
-        // Only allow one connection at a time
-        QTcpSocket *newSocket = m_server->nextPendingConnection();
-        newSocket->disconnectFromHost();
-        newSocket->deleteLater();
-        return;
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        MessageParser *parser = new MessageParser(socket);
+        m_clients.insert(socket, parser);
+
+        connect(socket, &QTcpSocket::readyRead, this, [socket, parser]() {
+            parser->parseMessage(socket->readAll());
+        });
+        connect(parser, &MessageParser::messageReceived, this, [this, socket](const QJsonObject &message) {
+            onMessageReceived(socket, message);
+        });
+        // After an oversized frame the stream is out of step; the extension reconnects
+        connect(parser, &MessageParser::frameError, socket, &QTcpSocket::abort);
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            qDebug() << "Browser extension disconnected";
+            m_clients.remove(socket);
+            socket->deleteLater();
+        });
+
+        qDebug() << "Browser extension connected";
     }
-
-    m_socket = m_server->nextPendingConnection();
-    connect(m_socket, &QTcpSocket::readyRead, this, &NativeHost::onReadyRead);
-    connect(m_socket, &QTcpSocket::disconnected, this, &NativeHost::onSocketDisconnected);
-
-    qDebug() << "Browser extension connected";
 }
 
-void NativeHost::onReadyRead()
-{
-    if (!m_socket) return;
-
-    QByteArray data = m_socket->readAll();
-    m_messageParser->parseMessage(data);
-}
-
-void NativeHost::onSocketDisconnected()
-{
-    qDebug() << "Browser extension disconnected";
-    if (m_socket) {
-        m_socket->deleteLater();
-        m_socket = nullptr;
-    }
-}
-
-void NativeHost::onMessageReceived(const QJsonObject &message)
+void NativeHost::onMessageReceived(QTcpSocket *socket, const QJsonObject &message)
 {
     QString type = message.value("type").toString();
 
     if (type == "START_DOWNLOAD") {
-        handleStartDownload(message.value("data").toObject());
+        handleStartDownload(socket, message.value("data").toObject());
+    } else if (type == "START_DOWNLOADS") {
+        handleStartDownloads(socket, message.value("data").toObject());
     } else if (type == "CANCEL_DOWNLOAD") {
-        handleCancelDownload(message.value("data").toObject());
+        handleCancelDownload(socket, message.value("data").toObject());
     } else if (type == "GET_STATUS") {
-        handleGetStatus(message.value("data").toObject());
+        handleGetStatus(socket, message.value("data").toObject());
     } else {
         qWarning() << "Unknown message type:" << type;
     }
 }
 
-void NativeHost::handleStartDownload(const QJsonObject &data)
+void NativeHost::onBridgeEvent(const QString &event, const QJsonObject &data)
+{
+    int downloadId = data.value("downloadId").toInt();
+    if (event == "progress") {
+        onDownloadProgress(downloadId, data.value("bytesReceived").toInteger(), data.value("bytesTotal").toInteger());
+    } else if (event == "completed") {
+        onDownloadCompleted(downloadId);
+    } else if (event == "failed") {
+        onDownloadFailed(downloadId, data.value("error").toString());
+    }
+}
+
+void NativeHost::handleStartDownload(QTcpSocket *socket, const QJsonObject &data)
 {
     QString url = data.value("url").toString();
     QString filename = data.value("filename").toString();
@@ -111,77 +117,109 @@ void NativeHost::handleStartDownload(const QJsonObject &data)
     downloadData["referrer"] = referrer;
     downloadData["userAgent"] = userAgent;
 
-    notifyMainApplication("start_download", downloadData);
+    // Replies come back in whatever order LDM finishes them, so each carries its url
+    QPointer<QTcpSocket> client(socket);
+    notifyMainApplication("start_download", downloadData,
+                          [this, client, url](bool ok, const QJsonObject &reply, const QString &error) {
+        QJsonObject response;
+        if (ok) {
+            response["type"] = "DOWNLOAD_STARTED";
+            response["data"] = QJsonObject{
+                {"id", reply.value("downloadId")},
+                {"url", url},
+                {"filename", reply.value("filename")}
+            };
+        } else {
+            response["type"] = "DOWNLOAD_FAILED";
+            response["data"] = QJsonObject{{"url", url}, {"error", error}};
+        }
+        sendMessage(client, response);
+    });
+}
 
-    // Send response
-    QJsonObject response;
-    response["type"] = "DOWNLOAD_STARTED";
-    response["data"] = QJsonObject{
-        {"id", 1}, // Would be actual download ID
-        {"filename", filename}
-    };
-    sendMessage(response);
+void NativeHost::handleStartDownloads(QTcpSocket *socket, const QJsonObject &data)
+{
+    // A page's worth of links in one message crosses to LDM as one request
+    QPointer<QTcpSocket> client(socket);
+    m_bridge->request("start_downloads", data, [this, client](bool ok, const QJsonObject &reply, const QString &error) {
+        QJsonObject response;
+        if (ok) {
+            response["type"] = "DOWNLOADS_STARTED";
+            response["data"] = QJsonObject{{"ids", reply.value("downloadIds")}};
+        } else {
+            response["type"] = "DOWNLOAD_FAILED";
+            response["data"] = QJsonObject{{"error", error}};
+        }
+        sendMessage(client, response);
+    });
 }
 
-void NativeHost::handleCancelDownload(const QJsonObject &data)
+void NativeHost::handleCancelDownload(QTcpSocket *socket, const QJsonObject &data)
 {
     int downloadId = data.value("downloadId").toInt();
 
-    notifyMainApplication("cancel_download", {{"downloadId", downloadId}});
-
-    QJsonObject response;
-    response["type"] = "DOWNLOAD_CANCELLED";
-    response["data"] = QJsonObject{{"downloadId", downloadId}};
-    sendMessage(response);
+    QPointer<QTcpSocket> client(socket);
+    notifyMainApplication("cancel_download", {{"downloadId", downloadId}},
+                          [this, client, downloadId](bool ok, const QJsonObject &, const QString &error) {
+        QJsonObject response;
+        if (ok) {
+            response["type"] = "DOWNLOAD_CANCELLED";
+            response["data"] = QJsonObject{{"downloadId", downloadId}};
+        } else {
+            response["type"] = "DOWNLOAD_FAILED";
+            response["data"] = QJsonObject{{"downloadId", downloadId}, {"error", error}};
+        }
+        sendMessage(client, response);
+    });
 }
 
-void NativeHost::handleGetStatus(const QJsonObject &data)
+void NativeHost::handleGetStatus(QTcpSocket *socket, const QJsonObject &data)
 {
     int downloadId = data.value("downloadId").toInt();
 
-    // Query main application for status
-    // For now, send mock response
-    QJsonObject response;
-    response["type"] = "DOWNLOAD_STATUS";
-    response["data"] = QJsonObject{
-        {"downloadId", downloadId},
-        {"status", "downloading"},
-        {"progress", 50}
-    };
-    sendMessage(response);
+    QPointer<QTcpSocket> client(socket);
+    notifyMainApplication("get_status", {{"downloadId", downloadId}},
+                          [this, client, downloadId](bool ok, const QJsonObject &status, const QString &error) {
+        QJsonObject response;
+        if (ok) {
+            response["type"] = "DOWNLOAD_STATUS";
+            response["data"] = status;
+        } else {
+            response["type"] = "DOWNLOAD_FAILED";
+            response["data"] = QJsonObject{{"downloadId", downloadId}, {"error", error}};
+        }
+        sendMessage(client, response);
+    });
 }
 
-void NativeHost::sendMessage(const QJsonObject &message)
+void NativeHost::sendMessage(QTcpSocket *socket, const QJsonObject &message)
 {
-    if (!m_socket) return;
-
-    QJsonDocument doc(message);
-    QByteArray data = doc.toJson(QJsonDocument::Compact);
+    if (!socket) return;
 
-    // Prepend message length (native messaging protocol)
-    QByteArray lengthBytes;
-    lengthBytes.append((data.size() >> 0) & 0xFF);
-    lengthBytes.append((data.size() >> 8) & 0xFF);
-    lengthBytes.append((data.size() >> 16) & 0xFF);
-    lengthBytes.append((data.size() >> 24) & 0xFF);
+    socket->write(MessageParser::frame(message));
+}
 
-    m_socket->write(lengthBytes + data);
+void NativeHost::broadcastMessage(const QJsonObject &message)
+{
+    QByteArray frame = MessageParser::frame(message);
+    for (auto it = m_clients.constBegin(); it != m_clients.constEnd(); ++it) {
+        if (it.key()->state() == QAbstractSocket::ConnectedState) {
+            it.key()->write(frame);
+        }
+    }
 }
 
 void NativeHost::sendHeartbeat()
 {
-    if (m_socket && m_socket->state() == QAbstractSocket::ConnectedState) {
-        QJsonObject heartbeat;
-        heartbeat["type"] = "HEARTBEAT";
-        sendMessage(heartbeat);
-    }
+    QJsonObject heartbeat;
+    heartbeat["type"] = "HEARTBEAT";
+    broadcastMessage(heartbeat);
 }
 
-void NativeHost::notifyMainApplication(const QString &action, const QVariantMap &data)
+void NativeHost::notifyMainApplication(const QString &action, const QVariantMap &data,
+                                       BridgeClient::ReplyHandler onReply)
 {
-    // This would integrate with the main LDM application
-    // For example, via DBus, shared memory, or local socket
-    qDebug() << "Notifying main application:" << action << data;
+    m_bridge->request(action, QJsonObject::fromVariantMap(data), std::move(onReply));
 }
 
 void NativeHost::onDownloadProgress(int downloadId, qint64 bytesReceived, qint64 bytesTotal)
@@ -194,7 +232,7 @@ void NativeHost::onDownloadProgress(int downloadId, qint64 bytesReceived, qint64
         {"bytesTotal", bytesTotal},
         {"progress", bytesTotal > 0 ? (bytesReceived * 100.0 / bytesTotal) : 0}
     };
-    sendMessage(message);
+    broadcastMessage(message);
 }
 
 void NativeHost::onDownloadCompleted(int downloadId)
@@ -202,7 +240,7 @@ void NativeHost::onDownloadCompleted(int downloadId)
     QJsonObject message;
     message["type"] = "DOWNLOAD_COMPLETED";
     message["data"] = QJsonObject{{"downloadId", downloadId}};
-    sendMessage(message);
+    broadcastMessage(message);
 }
 
 void NativeHost::onDownloadFailed(int downloadId, const QString &error)
@@ -213,7 +251,7 @@ void NativeHost::onDownloadFailed(int downloadId, const QString &error)
         {"downloadId", downloadId},
         {"error", error}
     };
-    sendMessage(message);
+    broadcastMessage(message);
 }
 
 int main(int argc, char *argv[])
@@ -7,7 +7,10 @@
 #include <QProcess>
 #include <QTcpServer>
 #include <QTcpSocket>
+#include <QHash>
 #include <QTimer>
+#include <functional>
+#include "BridgeClient.h"
 #include "MessageParser.h"
 
 class NativeHost : public QObject
@@ -23,27 +26,29 @@ public:
 
 private slots:
     void onNewConnection();
-    void onReadyRead();
-    void onSocketDisconnected();
-    void onMessageReceived(const QJsonObject &message);
+    void onBridgeEvent(const QString &event, const QJsonObject &data);
     void onDownloadProgress(int downloadId, qint64 bytesReceived, qint64 bytesTotal);
     void onDownloadCompleted(int downloadId);
     void onDownloadFailed(int downloadId, const QString &error);
 
 private:
     QTcpServer *m_server;
-    QTcpSocket *m_socket;
-    MessageParser *m_messageParser;
+    QHash<QTcpSocket*, MessageParser*> m_clients;   // every connected extension, each with its own framing
+    BridgeClient *m_bridge;
     QTimer *m_heartbeatTimer;
 
-    void sendMessage(const QJsonObject &message);
-    void handleStartDownload(const QJsonObject &data);
-    void handleCancelDownload(const QJsonObject &data);
-    void handleGetStatus(const QJsonObject &data);
+    void onMessageReceived(QTcpSocket *socket, const QJsonObject &message);
+    void sendMessage(QTcpSocket *socket, const QJsonObject &message);
+    void broadcastMessage(const QJsonObject &message);
+    void handleStartDownload(QTcpSocket *socket, const QJsonObject &data);
+    void handleStartDownloads(QTcpSocket *socket, const QJsonObject &data);
+    void handleCancelDownload(QTcpSocket *socket, const QJsonObject &data);
+    void handleGetStatus(QTcpSocket *socket, const QJsonObject &data);
     void sendHeartbeat();
 
-    // Integration with main LDM application
-    void notifyMainApplication(const QString &action, const QVariantMap &data);
+    // Integration with main LDM application; onReply runs when LDM answers or cannot be reached
+    void notifyMainApplication(const QString &action, const QVariantMap &data,
+                               BridgeClient::ReplyHandler onReply = BridgeClient::ReplyHandler());
 };
 
 #endif // NATIVEHOST_H
\ No newline at end of file